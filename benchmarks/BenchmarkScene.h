@@ -0,0 +1,29 @@
+#ifndef BENCHMARKSCENE_H
+#define BENCHMARKSCENE_H
+
+#include <QColor>
+#include <QPoint>
+#include <QString>
+#include <vector>
+#include "Entity.h"
+
+// Generated level shared by the benchmarks: a 1000-wide grid of entities
+inline std::vector<Entity> generateEntities(int count)
+{
+    std::vector<Entity> entities;
+    entities.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        int id = i + 1;
+        // Mostly default names, some shared prop names and some unique ones
+        QString name = (i % 10 == 0) ? QString("Tree (Copy)")
+                     : (i % 10 == 1) ? QString("Marker %1 east").arg(i)
+                                     : QString("Entity_%1").arg(id);
+        Entity entity(id, name, QPoint((i % 1000) * 20, (i / 1000) * 20));
+        entity.setSize(20 + i % 40, 20 + i % 30);
+        entity.setColor(QColor(i % 256, (i * 7) % 256, (i * 13) % 256));
+        entities.push_back(entity);
+    }
+    return entities;
+}
+
+#endif // BENCHMARKSCENE_H
@@ -0,0 +1,124 @@
+// Scene compression benchmark: saves and loads a generated level as a plain
+// and as a compressed file and reports size ratio and save/load speed, then
+// compares zlib levels on the raw codec.
+//
+// Usage: CompressionBenchmark [entities]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include "SceneCodec.h"
+#include "SceneFile.h"
+#include "BenchmarkScene.h"
+
+// Best of a few runs, in milliseconds
+template <typename Fn>
+static double bestOf(int repetitions, Fn fn)
+{
+    double best = 0.0;
+    for (int rep = 0; rep < repetitions; ++rep) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!fn()) {
+            return -1.0;
+        }
+        double ms = timer.nsecsElapsed() / 1e6;
+        if (rep == 0 || ms < best) {
+            best = ms;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int count = 200000;
+    if (argc > 1) {
+        count = std::max(1, atoi(argv[1]));
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        return 1;
+    }
+
+    std::vector<Entity> entities = generateEntities(count);
+    const int repetitions = 3;
+
+    QTextStream out(stdout);
+    out << "Compression benchmark: " << count << " entities\n\n";
+    out << "file          bytes   ratio   save ms   load ms\n";
+
+    struct Mode {
+        const char *label;
+        SceneCodec::Compression compression;
+    };
+    const Mode modes[] = {
+        { "plain", SceneCodec::Compression::None },
+        { "zlib", SceneCodec::Compression::Zlib },
+    };
+
+    qint64 plainBytes = 0;
+    for (const Mode &mode : modes) {
+        QString path = dir.filePath(QString("level_%1.json").arg(mode.label));
+        double saveMs = bestOf(repetitions, [&]() {
+            return SceneFile::save(path, SceneParts(entities, count + 1), mode.compression);
+        });
+        double loadMs = bestOf(repetitions, [&]() {
+            SceneData scene;
+            return SceneFile::load(path, &scene) && static_cast<int>(scene.entities.size()) == count;
+        });
+        if (saveMs < 0.0 || loadMs < 0.0) {
+            out << mode.label << ": save/load failed\n";
+            return 1;
+        }
+
+        qint64 bytes = QFileInfo(path).size();
+        if (mode.compression == SceneCodec::Compression::None) {
+            plainBytes = bytes;
+        }
+        out << qSetFieldWidth(5) << Qt::left << mode.label << Qt::right
+            << qSetFieldWidth(14) << bytes
+            << qSetFieldWidth(8) << (double(plainBytes) / bytes)
+            << qSetFieldWidth(10) << saveMs
+            << qSetFieldWidth(10) << loadMs
+            << qSetFieldWidth(0) << "\n";
+    }
+
+    // Codec only, on the compact JSON that compressed saves contain
+    QByteArray json = SceneFile::toJson(SceneParts(entities, count + 1), QJsonDocument::Compact);
+    double megabytes = json.size() / (1024.0 * 1024.0);
+    out << "\ncodec on " << megabytes << " MB of compact JSON\n";
+    out << "level   ratio   compress MB/s   decompress MB/s\n";
+
+    for (int level : { 1, SceneCodec::DEFAULT_LEVEL, 9 }) {
+        QByteArray packed;
+        double compressMs = bestOf(repetitions, [&]() {
+            packed = SceneCodec::compress(json, level);
+            return !packed.isEmpty();
+        });
+        double decompressMs = bestOf(repetitions, [&]() {
+            QByteArray raw;
+            return SceneCodec::decompress(packed, &raw) && raw == json;
+        });
+        if (compressMs < 0.0 || decompressMs < 0.0) {
+            out << "level " << level << ": round trip failed\n";
+            return 1;
+        }
+
+        out << qSetFieldWidth(5) << level
+            << qSetFieldWidth(8) << (double(json.size()) / packed.size())
+            << qSetFieldWidth(16) << (megabytes / (compressMs / 1000.0))
+            << qSetFieldWidth(18) << (megabytes / (decompressMs / 1000.0))
+            << qSetFieldWidth(0) << "\n";
+    }
+
+    return 0;
+}
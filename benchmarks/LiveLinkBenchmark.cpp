@@ -0,0 +1,260 @@
+// Live link benchmark and test client: connects to a LiveLinkServer, keeps
+// a mirror of the scene from the frames it receives and reports the
+// edit-to-receive latency of every delta (p50/p99/max), frame sizes and
+// whether the mirror matches the editor at the end.
+//
+// By default it runs an editor canvas in-process and drags entities around
+// at one edit per millisecond. With --connect it attaches to a running
+// editor (Tools > Live Link) instead and reports once per second until the
+// editor closes the connection.
+//
+// Usage: LiveLinkBenchmark [edits] [--connect [server name]]
+
+#include <QApplication>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QLocalSocket>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "Canvas.h"
+#include "LiveLinkProtocol.h"
+#include "LiveLinkServer.h"
+#include "RuntimeScene.h"
+
+static quint64 nowUs()
+{
+    using namespace std::chrono;
+    return static_cast<quint64>(duration_cast<microseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+// What the game would keep: the last known record of every entity
+struct MirrorEntity {
+    qint32 x = 0;
+    qint32 y = 0;
+    qint32 width = 0;
+    qint32 height = 0;
+    quint32 color = 0;
+};
+
+class Client
+{
+public:
+    explicit Client(QLocalSocket *socket)
+        : m_socket(socket)
+    {
+        QObject::connect(socket, &QLocalSocket::readyRead, socket, [this]() { read(); });
+    }
+
+    QHash<int, MirrorEntity> mirror;
+    std::vector<qint64> latencyUs;  // One per delta
+    quint64 snapshots = 0;
+    quint64 deltas = 0;
+    quint64 upserts = 0;
+    quint64 removals = 0;
+    quint64 bytes = 0;
+    quint32 lastSequence = 0;
+    bool sequenceGap = false;
+    bool malformed = false;
+
+private:
+    void read()
+    {
+        m_buffer += m_socket->readAll();
+        const uchar *data = reinterpret_cast<const uchar *>(m_buffer.constData());
+        qsizetype at = 0;
+        while (m_buffer.size() - at >= qsizetype(LiveLinkProtocol::FRAME_HEADER_SIZE)) {
+            quint32 size = RuntimeScene::readU32(data + at + LiveLinkProtocol::F_SIZE);
+            if (m_buffer.size() - at < qsizetype(size) + 4) {
+                break;  // Rest of the frame still in flight
+            }
+            frame(data + at, size + 4);
+            at += size + 4;
+        }
+        m_buffer.remove(0, at);
+    }
+
+    void frame(const uchar *frame, quint32 frameSize)
+    {
+        quint64 receivedUs = nowUs();
+        bytes += frameSize;
+        quint32 sequence = RuntimeScene::readU32(frame + LiveLinkProtocol::F_SEQUENCE);
+        sequenceGap = sequenceGap || sequence != lastSequence + 1;
+        lastSequence = sequence;
+        
+        const uchar *body = frame + LiveLinkProtocol::FRAME_HEADER_SIZE;
+        quint32 bodySize = frameSize - LiveLinkProtocol::FRAME_HEADER_SIZE;
+        if (frame[LiveLinkProtocol::F_TYPE] == LiveLinkProtocol::SNAPSHOT) {
+            ++snapshots;
+            RuntimeScene scene;
+            if (!scene.open(body, bodySize)) {
+                malformed = true;
+                return;
+            }
+            mirror.clear();
+            for (quint32 i = 0; i < scene.entityCount(); ++i) {
+                RuntimeScene::EntityView entity = scene.entity(i);
+                mirror.insert(entity.id(), {entity.x(), entity.y(), entity.width(), entity.height(), entity.color()});
+            }
+            return;
+        }
+        
+        ++deltas;
+        latencyUs.push_back(qint64(receivedUs - LiveLinkProtocol::readU64(frame + LiveLinkProtocol::F_EDIT_TIME)));
+        quint32 removedCount = RuntimeScene::readU32(body);
+        quint32 upsertCount = RuntimeScene::readU32(body + 4);
+        const uchar *p = body + 8;
+        for (quint32 i = 0; i < removedCount; ++i, p += 4) {
+            mirror.remove(RuntimeScene::readI32(p));
+        }
+        for (quint32 i = 0; i < upsertCount; ++i) {
+            MirrorEntity entity{RuntimeScene::readI32(p + RuntimeScene::E_X), RuntimeScene::readI32(p + RuntimeScene::E_Y),
+                                RuntimeScene::readI32(p + RuntimeScene::E_WIDTH),
+                                RuntimeScene::readI32(p + RuntimeScene::E_HEIGHT),
+                                RuntimeScene::readU32(p + RuntimeScene::E_COLOR)};
+            mirror.insert(RuntimeScene::readI32(p + RuntimeScene::E_ID), entity);
+            p += RuntimeScene::ENTITY_SIZE +
+                 LiveLinkProtocol::paddedNameSize(RuntimeScene::readU32(p + RuntimeScene::E_NAME));
+        }
+        removals += removedCount;
+        upserts += upsertCount;
+        malformed = malformed || p != body + bodySize;
+    }
+
+    QLocalSocket *m_socket;
+    QByteArray m_buffer;
+};
+
+static qint64 percentile(std::vector<qint64> values, double p)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static void report(QTextStream &out, const Client &client)
+{
+    out << "  frames:        " << client.snapshots << " snapshot(s), " << client.deltas << " delta(s), "
+        << client.bytes / 1024 << " KiB\n";
+    out << "  per delta:     " << (client.deltas ? double(client.upserts) / client.deltas : 0.0) << " upserts, "
+        << (client.deltas ? double(client.bytes) / (client.snapshots + client.deltas) : 0.0) << " bytes avg\n";
+    out << "  latency:       p50 " << percentile(client.latencyUs, 0.50) / 1000.0 << " ms, p99 "
+        << percentile(client.latencyUs, 0.99) / 1000.0 << " ms, max "
+        << (client.latencyUs.empty() ? 0 : *std::max_element(client.latencyUs.begin(), client.latencyUs.end())) / 1000.0
+        << " ms\n";
+    if (client.sequenceGap || client.malformed) {
+        out << "  ERROR:         " << (client.malformed ? "malformed frame" : "sequence gap") << "\n";
+    }
+    out.flush();
+}
+
+// Attach to a running editor; report every second until it disconnects
+static int runConnected(const QString &serverName)
+{
+    QTextStream out(stdout);
+    QLocalSocket socket;
+    socket.connectToServer(serverName);
+    if (!socket.waitForConnected(2000)) {
+        out << "Cannot connect to '" << serverName << "': " << socket.errorString() << "\n";
+        return 1;
+    }
+    out << "Connected to '" << serverName << "'\n";
+    out.flush();
+    
+    Client client(&socket);
+    QTimer ticker;
+    QObject::connect(&ticker, &QTimer::timeout, [&]() {
+        out << client.mirror.size() << " entities mirrored\n";
+        report(out, client);
+        client.latencyUs.clear();
+    });
+    ticker.start(1000);
+    QObject::connect(&socket, &QLocalSocket::disconnected, qApp, &QCoreApplication::quit);
+    QCoreApplication::exec();
+    return client.malformed || client.sequenceGap ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Canvas is a widget; run without a display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    int edits = 20000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--connect") == 0) {
+            bool hasName = i + 1 < argc;
+            return runConnected(hasName ? QString(argv[i + 1]) : QString(LiveLinkProtocol::DEFAULT_SERVER_NAME));
+        }
+        edits = std::max(1, atoi(argv[i]));
+    }
+
+    const int entityCount = 2000;
+    QTextStream out(stdout);
+    out << "Live link benchmark: " << edits << " edits to " << entityCount << " entities, one per ms, "
+        << LiveLinkServer::FRAME_MS << " ms frames\n\n";
+
+    Canvas canvas;
+    for (int i = 0; i < entityCount; ++i) {
+        canvas.addEntityAt(QPoint((i % 50) * 70, (i / 50) * 70));
+    }
+
+    LiveLinkServer server(&canvas);
+    QString serverName = QString("qleveleditor-livelink-bench-%1").arg(QCoreApplication::applicationPid());
+    if (!server.start(serverName)) {
+        out << "Cannot listen: " << server.errorString() << "\n";
+        return 1;
+    }
+
+    QLocalSocket socket;
+    socket.connectToServer(serverName);
+    Client client(&socket);
+
+    // A few entities dragged at a time, like a user moving a selection
+    int done = 0;
+    QTimer editor;
+    QObject::connect(&editor, &QTimer::timeout, [&]() {
+        if (server.clientCount() == 0) {
+            return;  // Not connected yet
+        }
+        int index = (done / 64) % entityCount;
+        Entity *entity = canvas.getEntity(index);
+        entity->setPosition(entity->position() + QPoint(1, done % 2));
+        canvas.notifyEntityChanged(index);
+        if (++done == edits) {
+            editor.stop();
+            QTimer::singleShot(LiveLinkServer::FRAME_MS * 4, qApp, &QCoreApplication::quit);  // Last frame
+        }
+    });
+    editor.start(1);
+
+    QElapsedTimer timer;
+    timer.start();
+    QCoreApplication::exec();
+
+    out << "Received in " << timer.elapsed() << " ms\n";
+    report(out, client);
+
+    // The mirror must end up where the editor is
+    int mismatches = 0;
+    for (int i = 0; i < canvas.entityCount(); ++i) {
+        const Entity *entity = canvas.getEntity(i);
+        auto it = client.mirror.constFind(entity->id());
+        if (it == client.mirror.constEnd() || it->x != entity->position().x() || it->y != entity->position().y() ||
+            it->width != entity->rect().width() || it->color != entity->color().rgba()) {
+            ++mismatches;
+        }
+    }
+    out << "  mirror:        " << client.mirror.size() << " entities, " << mismatches << " mismatch(es)\n";
+    return mismatches == 0 && !client.malformed && !client.sequenceGap ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+// Scene loading benchmark: parses a generated JSON level with 1..N threads
+// and reports throughput (entities/s, MB/s) and scaling versus one thread.
+//
+// Usage: LoadBenchmark [entities]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include "SceneFile.h"
+#include "BenchmarkScene.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int count = 200000;
+    if (argc > 1) {
+        count = std::max(1, atoi(argv[1]));
+    }
+
+    std::vector<Entity> entities = generateEntities(count);
+    QByteArray data = SceneFile::toJson(SceneParts(entities, count + 1));
+    double megabytes = data.size() / (1024.0 * 1024.0);
+
+    QTextStream out(stdout);
+    out << "Load benchmark: " << count << " entities, " << megabytes << " MB of JSON\n\n";
+    out << "threads      ms    entities/s        MB/s   speedup\n";
+
+    const int repetitions = 3;
+    double baselineMs = 0.0;
+    // 1, 2, 4, ... up to the number of cores
+    int maxThreads = std::max(1, QThread::idealThreadCount());
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    for (int threads : threadCounts) {
+        double bestMs = 0.0;
+        for (int rep = 0; rep < repetitions; ++rep) {
+            SceneData scene;
+            QElapsedTimer timer;
+            timer.start();
+            bool ok = SceneFile::fromJson(data, &scene, threads);
+            double ms = timer.nsecsElapsed() / 1e6;
+            if (!ok || static_cast<int>(scene.entities.size()) != count) {
+                out << "load failed with " << threads << " threads\n";
+                return 1;
+            }
+            if (rep == 0 || ms < bestMs) {
+                bestMs = ms;
+            }
+        }
+        if (threads == 1) {
+            baselineMs = bestMs;
+        }
+
+        out << qSetFieldWidth(7) << threads
+            << qSetFieldWidth(8) << bestMs
+            << qSetFieldWidth(14) << (count / (bestMs / 1000.0))
+            << qSetFieldWidth(12) << (megabytes / (bestMs / 1000.0))
+            << qSetFieldWidth(10) << (baselineMs / bestMs)
+            << qSetFieldWidth(0) << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+// Undo history benchmark: 1M push/undo/redo cycles of MoveEntityCommand,
+// comparing plain heap allocation against the UndoHistory command arena.
+//
+// Usage: UndoBenchmark [cycles]
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "Canvas.h"
+#include "MoveEntityCommand.h"
+#include "UndoHistory.h"
+
+// The history is bounded here so a million cycles trim and recycle commands
+static const int UNDO_LIMIT = 1000;
+
+// Count every heap allocation made by the process
+static std::atomic<quint64> g_heapAllocations{0};
+
+void *operator new(std::size_t size)
+{
+    g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+struct RunResult {
+    double totalMs = 0.0;
+    quint64 heapAllocations = 0;
+    std::vector<qint64> cycleNs;
+};
+
+static RunResult runCycles(Canvas *canvas, UndoHistory *history, int cycles, bool useArena)
+{
+    RunResult result;
+    result.cycleNs.reserve(cycles);
+
+    QElapsedTimer total;
+    QElapsedTimer cycle;
+    quint64 allocationsBefore = g_heapAllocations.load();
+    total.start();
+
+    for (int i = 0; i < cycles; ++i) {
+        cycle.start();
+        QPoint from(i % 500, 100);
+        QPoint to(from.x() + 20, 120);
+        MoveEntityCommand *command = useArena
+            ? history->create<MoveEntityCommand>(canvas, 0, from, to)
+            : new MoveEntityCommand(canvas, 0, from, to);
+        history->push(command);
+        history->undo();
+        history->redo();
+        result.cycleNs.push_back(cycle.nsecsElapsed());
+    }
+
+    result.totalMs = total.nsecsElapsed() / 1e6;
+    result.heapAllocations = g_heapAllocations.load() - allocationsBefore;
+    return result;
+}
+
+static qint64 percentile(std::vector<qint64> values, double p)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static void report(QTextStream &out, const char *label, const RunResult &result, int cycles)
+{
+    out << label << "\n";
+    out << "  total:            " << result.totalMs << " ms\n";
+    out << "  per cycle:        " << (result.totalMs * 1e6 / cycles) << " ns (p50 "
+        << percentile(result.cycleNs, 0.50) << " ns, p99 "
+        << percentile(result.cycleNs, 0.99) << " ns)\n";
+    out << "  heap allocations: " << result.heapAllocations << " ("
+        << double(result.heapAllocations) / cycles << " per cycle)\n";
+}
+
+int main(int argc, char *argv[])
+{
+    // Canvas is a widget; run without a display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    int cycles = 1000000;
+    if (argc > 1) {
+        cycles = std::max(1, atoi(argv[1]));
+    }
+
+    QTextStream out(stdout);
+    out << "Undo benchmark: " << cycles << " push/undo/redo cycles, undo limit "
+        << UNDO_LIMIT << "\n\n";
+
+    Canvas canvas;
+    canvas.addEntityAt(QPoint(0, 100));
+
+    {
+        UndoHistory history;
+        history.setUndoLimit(UNDO_LIMIT);
+        canvas.setUndoStack(&history);
+        RunResult heap = runCycles(&canvas, &history, cycles, false);
+        report(out, "Heap-allocated commands", heap, cycles);
+        canvas.setUndoStack(nullptr);
+    }
+
+    {
+        UndoHistory history;
+        history.setUndoLimit(UNDO_LIMIT);
+        canvas.setUndoStack(&history);
+        RunResult arena = runCycles(&canvas, &history, cycles, true);
+        report(out, "Arena-allocated commands", arena, cycles);
+
+        CommandArena::Stats stats = history.arena().stats();
+        out << "  arena blocks:     " << stats.allocations << " allocated, "
+            << stats.recycled << " recycled, " << stats.liveBlocks << " live\n";
+        out << "  arena slabs:      " << stats.slabAllocations << " ("
+            << stats.reservedBytes / 1024 << " KiB reserved)\n";
+        canvas.setUndoStack(nullptr);
+    }
+
+    return 0;
+}
@@ -1,13 +1,13 @@
 #ifndef ADDENTITYCOMMAND_H
 #define ADDENTITYCOMMAND_H
 
-#include <QUndoCommand>
+#include "EditorCommand.h"
 #include <QPoint>
 #include "Entity.h"
 
 class Canvas;
 
-class AddEntityCommand : public QUndoCommand
+class AddEntityCommand : public EditorCommand
 {
 public:
     AddEntityCommand(Canvas *canvas, const QPoint &position, QUndoCommand *parent = nullptr);
@@ -0,0 +1,77 @@
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include "SceneCodec.h"
+
+// Headless batch mode for build pipelines:
+//
+//   QtLevelEditorLite --batch <command> [options] <files or directories>...
+//
+// Directories are searched recursively for *.json scenes. Files are processed
+// concurrently on a pool of --jobs threads; each job holds at most one scene,
+// so memory stays bounded by the job count. Only QtCore is used (no widgets).
+// Prints one timed line per file and returns a non-zero exit code if any
+// file failed.
+//
+// "diff" and "merge" take exactly two and three scene files instead (see
+// SceneDiff). merge follows the git merge driver convention: it writes the
+// result over <ours> and exits with 1 when there were conflicts, so it can
+// be registered as `QtLevelEditorLite --batch merge %O %A %B`.
+class BatchProcessor
+{
+public:
+    enum class Command {
+        Validate,       // Report scene problems (see SceneValidator)
+        Compact,        // Fold journals into their scene files
+        Convert,        // Rewrite scenes in the current format, optionally (de)compressed
+        ExportWorld,    // Write each scene as a chunked world (see WorldStreamer)
+        ExportRuntime,  // Write each scene as a runtime blob (see RuntimeExport)
+        Diff,           // List entities added, removed and changed between two scenes
+        Merge           // Three-way merge of <base> <ours> <theirs>
+    };
+
+    struct Options {
+        Command command = Command::Validate;
+        QStringList inputs;
+        QString outputDir;   // "" = write next to / over the input (merge: output file)
+        int jobs = 0;        // 0 = one per core
+        bool compress = false;
+        bool decompress = false;
+        int chunkSize = 0;   // 0 = WorldStreamer default
+        int budgetMs = DEFAULT_BUDGET_MS;  // validate: time per file (loading included), 0 = none
+    };
+
+    struct FileResult {
+        bool ok = false;
+        int entityCount = 0;
+        qint64 elapsedMs = 0;
+        QStringList messages;  // Issues or the failure reason
+    };
+
+    static constexpr int DEFAULT_BUDGET_MS = 10000;
+
+    // Parse arguments (everything after "--batch") and run; returns the exit code
+    static int run(const QStringList &arguments, QTextStream &out);
+
+    static bool parseArguments(const QStringList &arguments, Options *options, QString *error);
+    static QString usage();
+
+    // Process one scene; `outputPath` is where converted/exported output goes
+    static FileResult processFile(const Options &options, const QString &inputPath, const QString &outputPath);
+
+private:
+    static int runDiff(const Options &options, QTextStream &out);
+    static int runMerge(const Options &options, QTextStream &out);
+
+    struct Job {
+        QString inputPath;
+        QString outputPath;
+    };
+
+    static QList<Job> collectJobs(const Options &options);
+};
+
+#endif // BATCHPROCESSOR_H
@@ -0,0 +1,42 @@
+#ifndef BRUSHCOMMAND_H
+#define BRUSHCOMMAND_H
+
+#include "EditorCommand.h"
+#include <QColor>
+#include <QPoint>
+#include <QSize>
+#include <QString>
+#include <vector>
+
+class Canvas;
+
+// One line, rectangle or fill brush stroke over entities.
+//
+// Created entities get consecutive ids, so they are stored as an id range
+// plus their positions; recolored entities are stored as (id, old color, old
+// prefab override bits).
+// No per-entity copies are kept, and undo/redo each apply the whole stroke
+// with a single batch of signals and one repaint.
+class BrushCommand : public EditorCommand
+{
+public:
+    BrushCommand(Canvas *canvas, int firstId, std::vector<QPoint> &&positions, const QSize &size,
+                 const QColor &color, int layerId, std::vector<int> &&recolorIds, std::vector<QRgb> &&oldColors,
+                 std::vector<quint8> &&oldOverrides, const QString &text, QUndoCommand *parent = nullptr);
+    
+    void undo() override;
+    void redo() override;
+
+private:
+    Canvas *m_canvas;
+    int m_firstId;                    // Ids m_firstId .. m_firstId + positions - 1
+    std::vector<QPoint> m_positions;  // Created entities
+    QSize m_size;
+    QRgb m_color;
+    int m_layerId;
+    std::vector<int> m_recolorIds;    // Recolored entities
+    std::vector<QRgb> m_oldColors;
+    std::vector<quint8> m_oldOverrides;
+};
+
+#endif // BRUSHCOMMAND_H
@@ -4,11 +4,30 @@
 #include <QWidget>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QSet>
+#include <QHash>
+#include <QPixmap>
 #include <vector>
 #include "Entity.h"
+#include "SceneCodec.h"
+#include "SnapIndex.h"
+#include "OverlapDetector.h"
+#include "SceneValidator.h"
+#include "PrefabLibrary.h"
+#include "TileLayer.h"
+#include "EntityBrush.h"
+#include "LayerStack.h"
+#include "GroupTree.h"
+#include "GroupBvh.h"
+#include "ComponentStore.h"
+#include "SceneDiff.h"
+#include "MinimapRaster.h"
 
-class QUndoStack;  // Forward declaration
-class MoveEntityCommand;  // Forward declaration
+class UndoHistory;  // Forward declaration
+class SceneJournal;
+class WorldStreamer;
+struct SceneData;
+struct EntityPropertyState;
 
 class Canvas : public QWidget
 {
@@ -21,14 +40,96 @@ public:
     int entityCount() const { return static_cast<int>(m_entities.size()); }
     Entity* getEntity(int index);
     const Entity* getEntity(int index) const;
+    const std::vector<Entity> &entities() const { return m_entities; }
     int selectedEntityIndex() const { return m_selectedEntityIndex; }
+    int nextEntityId() const { return m_nextEntityId; }
+    
+    // Index of the entity with the given id, or -1 if it isn't in memory.
+    // `hint` is checked first (commands pass the index they last saw)
+    int indexOfEntityId(int id, int hint = -1) const;
+    
+    // Same, for an undo command about to edit the entity: in an open world
+    // the chunk holding `position` is loaded first if it was evicted. -1 if
+    // the entity still can't be found; the command then reports the failure.
+    int residentIndexOf(int id, const QPoint &position, int hint = -1);
+    void reportCommandFailure(const QString &commandText);
     
     // Set selection from external source (like the list widget)
     void setSelectedEntityIndex(int index);
     
+    // Multi-selection: Ctrl+click toggles an entity, Shift+drag selects the
+    // entities inside a rectangle. The selected entity above is the primary
+    // one (inspector, dragging); it is always part of the set.
+    std::vector<int> selectedEntityIds() const;  // In draw order
+    bool isEntitySelected(int id) const { return m_selectedIds.contains(id); }
+    void selectEntityIds(const QSet<int> &ids);  // The topmost becomes the primary selection
+    
+    // Clipboard (see EntityClipboard). Paste centers the entities on the
+    // mouse, or the view, and puts them on the active layer.
+    void copySelection() const;
+    void cutSelection();
+    void paste();
+    void deleteSelection();
+    
+    // Consistency checks on the scene in memory (see SceneValidator)
+    SceneValidator::Report validateScene() const;
+    
     // Save/Load functionality
-    bool saveToFile(const QString &filePath) const;
-    bool loadFromFile(const QString &filePath);
+    bool saveToFile(const QString &filePath);
+    // Also replays a journal next to the file; `report` receives the checks
+    // on the loaded scene (see SceneValidator)
+    bool loadFromFile(const QString &filePath, SceneValidator::Report *report = nullptr);
+    
+    // Progressive loading (driven by SceneLoader). While streaming, the
+    // canvas can be panned and entities selected, but not edited.
+    bool attachLoadedScene(const QString &filePath, SceneData *scene);  // Journal replay + attach
+    void beginStreaming(const SceneData &scene);        // Installs everything but the entities
+    void appendEntities(const std::vector<Entity> &batch);
+    void endStreaming(std::vector<Entity> &&entities);  // Install final, file-ordered entities
+    void cancelStreaming();                             // Restore the previous scene
+    bool isStreaming() const { return m_streaming; }
+    
+    // View (the canvas is a window onto an unbounded scene)
+    QPoint mapToScene(const QPoint &widgetPos) const;
+    QRect visibleSceneRect() const;
+    QPoint viewOffset() const { return m_viewOffset; }
+    void setViewOffset(const QPoint &offset);
+    void centerOn(const QPoint &scenePos);
+    
+    // Downsampled scene image for the minimap; maintained from the first
+    // call on, rebuilt after bulk changes and updated per edit otherwise
+    MinimapRaster &minimap();
+    
+    // Journaled save: appends only the edits since the last save to
+    // "<file>.journal" when the file is already journaled, otherwise
+    // writes a full checkpoint first
+    bool saveJournaled(const QString &filePath);
+    
+    // Compression used when writing scene files (loading detects it)
+    void setSaveCompression(SceneCodec::Compression compression) { m_saveCompression = compression; }
+    SceneCodec::Compression saveCompression() const { return m_saveCompression; }
+    
+    // Chunked worlds: only the part of the level near the view is in memory
+    bool exportWorld(const QString &manifestPath) const;  // Write the current scene as a world
+    bool exportRuntime(const QString &filePath, QString *error = nullptr) const;  // Blob for the game (see RuntimeExport)
+    bool openWorld(const QString &manifestPath);
+    bool saveWorld();
+    bool isWorldOpen() const;
+    WorldStreamer *world() const { return m_world; }
+    
+    // Empty the scene (used when opening a world)
+    void resetScene(int nextEntityId, const PrefabLibrary &prefabs = PrefabLibrary(),
+                    const LayerStack &layers = LayerStack(), const GroupTree &groups = GroupTree());
+    
+    // Drop entities from memory without recording an edit (chunk eviction)
+    void unloadEntities(const QSet<int> &ids);
+    
+    // Hot reload: bring the scene up to date with a newer version of its file
+    // by applying only the entity differences. Entities with unsaved edits
+    // keep them (counted in `keptEdits`); new entities are appended. The
+    // selection, view and undo history stay. Returns what was applied.
+    SceneDiff::Result reloadChanges(const SceneData &scene, int *keptEdits = nullptr);
+    static constexpr int RELOAD_SIGNAL_LIMIT = 256;  // More changes than this reset the entity list
 
     // Grid controls
     void setGridVisible(bool visible);
@@ -39,21 +140,152 @@ public:
     // Snap-to-grid controls
     void setSnapToGrid(bool snap);
     bool isSnapToGrid() const { return m_snapToGrid; }
+    
+    // Editing tool for the left mouse button. Tile tools paint the active
+    // tile (right button erases); brush tools create or recolor grid-sized
+    // entities in the brush color (see EntityBrush). The group tool groups
+    // everything inside the dragged rectangle. Entities can't be selected
+    // while another tool is active.
+    enum class Tool { Select, PaintTiles, RectTiles, FillTiles, LineBrush, RectBrush, FillBrush, Group };
+    void setTool(Tool tool);
+    Tool tool() const { return m_tool; }
+    void setActiveTile(TileLayer::TileId id) { m_activeTile = id; }
+    TileLayer::TileId activeTile() const { return m_activeTile; }
+    void setBrushColor(const QColor &color) { m_brushColor = color; }
+    QColor brushColor() const { return m_brushColor; }
+    
+    // Tile layer drawn under the entities (its tile size is saved with the scene)
+    const TileLayer &tiles() const { return m_tiles; }
+    void applyTileChanges(const std::vector<TileLayer::Change> &changes, bool undo);  // TileEditCommand
+    
+    // Magnetic snapping to other entities' edges and centers while dragging
+    void setSnapToEntities(bool snap);
+    bool isSnapToEntities() const { return m_snapToEntities; }
+    
+    // Overlap analysis: highlight entities whose rects intersect another's
+    void setShowOverlaps(bool show);
+    bool isShowingOverlaps() const { return m_showOverlaps; }
+    std::vector<std::pair<int, int>> overlappingPairs();  // Entity id pairs
+    
+    // Comparison overlay: outlines what was added (green) or changed (orange)
+    // since a base scene and shows removed entities at their old place (red).
+    // Kept current as the scene is edited; loading another scene clears it.
+    SceneDiff::Result compareWith(SceneData &&base);
+    void clearComparison();
+    bool isComparing() const { return m_diffActive; }
 
     // Undo/Redo support methods
     int addEntityAt(const QPoint &position);  // Returns index of added entity
     void removeEntityAt(int index);
-    int insertEntity(const Entity &entity, int index);  // Returns index where inserted
-    void setUndoStack(QUndoStack *undoStack);
+    // Returns index where inserted; `components` are those it had when removed
+    int insertEntity(const Entity &entity, int index, const ComponentStore::Values &components = ComponentStore::Values());
+    void setUndoStack(UndoHistory *undoStack);
+    
+    // Call after modifying an entity in place (position, name, color, size)
+    void notifyEntityChanged(int index);
+
+    // Layers, drawn bottom to top. Entities on hidden or locked layers can't be
+    // picked; new entities go to the active layer. Every layer except the
+    // active one (and one being dragged on) is drawn from a cached image.
+    const LayerStack &layers() const { return m_layers; }
+    int activeLayer() const { return m_activeLayer; }
+    void setActiveLayer(int layerId);
+    int addLayer(const QString &name);
+    void removeLayer(int layerId);  // Its entities move to the default layer
+    void renameLayer(int layerId, const QString &name);
+    void setLayerVisible(int layerId, bool visible);
+    void setLayerLocked(int layerId, bool locked);
+    void moveLayer(int layerId, int position);  // 0 = bottom
+    void moveSelectedEntityToLayer(int layerId);
+    
+    // Groups. Dragging a grouped entity moves its outermost group (Alt drags
+    // the entity alone); the group follows the mouse as one offset and its
+    // members are moved once, on release. Group boxes form a BVH (GroupBvh)
+    // that culls drawing and picking. Grouping and ungrouping are undoable
+    // (see GroupCommand).
+    const GroupTree &groups() const { return m_groups; }
+    int groupEntitiesIn(const QRect &sceneRect);  // Group what lies inside; returns the group id, 0 if none
+    void ungroupSelected();                       // Dissolve the selected entity's outermost group
+    // Used by GroupCommand: create `group` around the given groups and
+    // entities (by id), or dissolve a group into its parent
+    void formGroup(const EntityGroup &group, const std::vector<int> &childGroupIds,
+                   const std::vector<int> &memberIds);
+    void dissolveGroup(int groupId);
+    bool translateGroup(int groupId, const QPoint &delta);  // Used by MoveGroupCommand; false if the group is gone
+    
+    // Components: typed, game-specific data attached to entities (see
+    // ComponentStore). Edits count as changes to the entity. Defining a type
+    // and adding, removing or editing a component are undoable (see
+    // ComponentCommand); the commands that remove entities keep their values.
+    // Worlds don't store components, so these edits are refused while one is open.
+    const ComponentStore &components() const { return m_components; }
+    int defineComponentType(const QString &name, const std::vector<ComponentField> &fields);  // 0 if rejected
+    bool addComponent(int index, int typeId);
+    bool removeComponent(int index, int typeId);
+    bool setComponentValue(int index, int typeId, int field, const QVariant &value);
+    // Used by the component commands: replace an entity's components (false
+    // if it isn't resident), define or remove a type
+    bool setEntityComponents(int entityId, const ComponentStore::Values &values);
+    bool setComponentTypeDefined(const ComponentType &type, bool defined);
+
+    // Bulk edits used by BrushCommand: one batch of signals and one repaint each
+    void addEntityBlock(int firstId, const std::vector<QPoint> &positions, const QSize &size, const QColor &color,
+                        int layerId);
+    void removeEntityBlock(int firstId, int count);  // Ids firstId .. firstId + count - 1
+    // `colors` holds one color per id, or a single color for all of them.
+    // `overrides` (one per id) restores prefab override bits on undo.
+    void setEntityColors(const std::vector<int> &ids, const std::vector<QRgb> &colors,
+                         const std::vector<quint8> *overrides = nullptr);
+    
+    // Inspector edits: set one property on a set of entities as one undo step
+    // (entities already holding the value are left out). Returns how many changed.
+    enum class EntityProperty { Name, Color, Width, Height };
+    int setEntityProperty(const QSet<int> &ids, EntityProperty property, const QVariant &value);
+    // Used by EditEntitiesCommand: write back one property (and its override bit), matched by id
+    void setEntityStates(int property, const std::vector<EntityPropertyState> &states);
+    
+    // Bulk edits used by PasteCommand and RemoveEntitiesCommand
+    void appendEntityBlock(const std::vector<Entity> &entities,  // Ids must be unused
+                           const QHash<int, ComponentStore::Values> &components = {});  // By entity id
+    std::vector<std::pair<int, Entity>> takeEntities(const QSet<int> &ids);  // (index, entity), ascending
+    void restoreEntities(const std::vector<std::pair<int, Entity>> &removed,
+                         const QHash<int, ComponentStore::Values> &components = {});  // By entity id
 
     // Duplication
     void duplicateSelectedEntity();  // Duplicate the currently selected entity
+    
+    // Prefabs: instances share a template and store only their overrides
+    const PrefabLibrary &prefabs() const { return m_prefabs; }
+    void mergePrefabs(const PrefabLibrary &prefabs);  // Add unknown prefabs (world chunks)
+    // The actions below are undoable
+    int makePrefab(int index);          // Turn an entity into a prefab and make it an instance; returns the prefab id
+    void revertToPrefab(int index);     // Drop an instance's overrides
+    void applyToPrefab(int index);      // Copy an instance's values into its prefab (updates all instances)
+    void updatePrefab(const Prefab &prefab);
+    // Used by PrefabCommand: install `prefab` (id -1 removes prefab `prefabId`),
+    // restore `entities` by id and refresh the other instances
+    void setPrefabState(int prefabId, const Prefab &prefab, const std::vector<Entity> &entities);
 
 signals:
     // Signals emitted when entities change (for updating the list)
     void entityAdded(int index);
-    void entityRemoved(int index);
+    void entityRemoved(int index, int entityId);
+    void entityChanged(int index);
+    void groupMoved(int groupId);                 // All members moved by one offset (no entityChanged each)
+    // Every edit and removal the canvas records, by id, including those
+    // without a per-entity signal (recolors, regrouping, layer removal)
+    void entityEdited(int entityId);
+    void entityErased(int entityId);
+    void entitiesAppended(int first, int count);  // Batch of entities added at the end
+    void sceneReset();                            // All entities replaced or cleared
+    void viewChanged(const QRect &visibleSceneRect);
     void entitySelectionChanged(int index);
+    void selectionSetChanged();  // Multi-selection membership changed
+    void layersChanged();
+    void componentTypesChanged();
+    void commandFailed(const QString &message);  // An undo/redo step could not be applied
+    void minimapChanged();  // At most once per canvas repaint
+    void journalCompacted(bool success);  // A background compaction rewrote the scene file
 
 private:
     
@@ -66,36 +298,205 @@ private:
     
     // Snap-to-grid settings
     bool m_snapToGrid;    // Whether to snap to grid
+    bool m_snapToEntities;
+    SnapIndex m_snapIndex;        // Edges of the other entities, built when a drag starts
+    QVector<QLine> m_snapGuides;  // Guide lines for the active snap targets
+    
+    // Overlap analysis (maintained only while shown)
+    bool m_showOverlaps;
+    bool m_overlapsDirty;         // Bulk change since the last rebuild
+    OverlapDetector m_overlaps;
+    
+    // Comparison overlay (see compareWith): ids of resident entities that
+    // were added or changed, and of base entities no longer in the scene
+    bool m_diffActive;
+    std::vector<Entity> m_diffBase;
+    ComponentStore m_diffBaseComponents;
+    QHash<int, int> m_diffBaseIndex;  // Id -> index in m_diffBase
+    QSet<int> m_diffAdded;
+    QSet<int> m_diffChanged;
+    QSet<int> m_diffRemoved;
 
     // Undo stack reference
-    QUndoStack *m_undoStack;  // Pointer to undo stack (for commands)
-
-    // Move command tracking (for undo/redo)
-    MoveEntityCommand *m_currentMoveCommand; 
+    UndoHistory *m_undoStack;  // Pointer to undo stack (for commands)
     
     // Container to store all entities on the canvas
     std::vector<Entity> m_entities;
     
+    // Edits since the last save, for journaled saves
+    SceneJournal *m_journal;
+    bool m_reloading;  // Applying changes that are already on disk (not journaled)
+    SceneCodec::Compression m_saveCompression;
+    
+    // Chunk streaming for open worlds
+    WorldStreamer *m_world;
+    
+    // Prefab templates referenced by instances in m_entities
+    PrefabLibrary m_prefabs;
+    
+    // Layers and the cached images of the layers that aren't being edited
+    struct LayerCache {
+        QPixmap pixmap;
+        QRect sceneRect;  // Scene area the pixmap covers
+        bool valid = false;
+    };
+    LayerStack m_layers;
+    int m_activeLayer;
+    QHash<int, LayerCache> m_layerCaches;
+    
+    // Entity groups and their bounding-volume hierarchy (rebuilt lazily
+    // after entities are added or removed)
+    GroupTree m_groups;
+    GroupBvh m_groupBvh;
+    bool m_groupBvhDirty;
+    
+    // Expanded pattern names ("Entity_42") of drawn entities, by id, so a
+    // repaint doesn't format them again. (id, ref) fixes the text, so entries
+    // never go stale; the cache is simply dropped when it grows too large.
+    struct CachedLabel {
+        NameRef ref;
+        QString text;
+    };
+    mutable QHash<int, CachedLabel> m_labelCache;
+    static constexpr int MAX_CACHED_LABELS = 65536;
+    
+    ComponentStore m_components;
+    
+    // Minimap raster (maintained only once requested)
+    MinimapRaster m_minimap;
+    bool m_minimapEnabled;
+    bool m_minimapDirty;  // Bulk change since the last rebuild
+    
+    // Tile layer and the tile edit in progress
+    TileLayer m_tiles;
+    Tool m_tool;
+    TileLayer::TileId m_activeTile;
+    bool m_isPaintingTiles;
+    TileLayer::TileId m_strokeTile;    // Tile being painted (0 when erasing)
+    QPoint m_strokeStartCell;
+    QPoint m_strokeLastCell;
+    std::vector<TileLayer::Change> m_strokeChanges;
+    
+    // Entity brush stroke in progress (grid cells)
+    QColor m_brushColor;
+    bool m_isBrushing;
+    QPoint m_brushStartCell;
+    QPoint m_brushLastCell;
+    
     // Counter for generating unique entity IDs
     int m_nextEntityId;
     
     // Selection state
     int m_selectedEntityIndex;  // -1 if nothing selected, otherwise index in m_entities
+    QSet<int> m_selectedIds;    // Ids of all selected entities (includes the primary one)
     
     // Dragging state
     bool m_isDragging;
-    QPoint m_dragStartPos;      // Mouse position when drag started
+    QPoint m_dragStartPos;      // Mouse position when drag started (scene coordinates)
     QPoint m_entityStartPos;    // Entity position when drag started
+    int m_dragGroupId;          // Group being dragged (0 when dragging a single entity)
+    QPoint m_groupStartPos;     // Top-left of the group's box when the drag started
+    QPoint m_groupDragOffset;   // Offset the group is drawn at until the drag ends
+    std::vector<int> m_dragGroupMembers;  // Entity indices in the dragged group, ascending
+    QSet<int> m_dragGroupLayers;          // Layers holding them (drawn live during the drag)
+    
+    // Group tool (or Shift+drag selection) rectangle being dragged out (scene coordinates)
+    bool m_isMarquee;
+    bool m_marqueeSelects;  // Selects instead of grouping
+    QPoint m_marqueeStart;
+    QPoint m_marqueeEnd;
+    
+    // View state: scene coordinate shown at the widget's top-left corner
+    QPoint m_viewOffset;
+    bool m_isPanning;
+    QPoint m_panStartPos;       // Mouse position when panning started (widget coordinates)
+    QPoint m_panStartOffset;
+    
+    // Progressive loading state
+    bool m_streaming;
+    std::vector<Entity> m_streamBackup;  // Scene shown before the load started
+    int m_streamBackupNextId;
+    PrefabLibrary m_streamBackupPrefabs;
+    TileLayer m_streamBackupTiles;
+    LayerStack m_streamBackupLayers;
+    GroupTree m_streamBackupGroups;
+    ComponentStore m_streamBackupComponents;
 
     // Helper function to find entity at a given point
     // Returns index in m_entities, or -1 if none found
-    int findEntityAt(const QPoint &pos) const;
+    int findEntityAt(const QPoint &pos);
 
     // Helper function to snap a point to the nearest grid point
     QPoint snapToGrid(const QPoint &point) const;
+    int floorToGrid(int value) const;
     
     // Delete the currently selected entity
     void deleteSelectedEntity();    
+    
+    // Multi-selection upkeep; selectOnly(-1) clears the selection
+    void selectOnly(int index);
+    void toggleSelected(int index);
+    void selectEntitiesIn(const QRect &sceneRect);  // Entities fully inside, on editable layers
+    int topmostSelectedIndex() const;
+    QSet<int> editableSelection() const;  // Selected ids not on hidden or locked layers
+    
+    // Record an edit for journaled saves and dirty world chunks. Instances
+    // that only followed their prefab pass journal = false: the prefab table
+    // carries the change.
+    void trackChanged(const Entity &entity, bool journal = true);
+    void trackAdded(int index);  // m_entities[index] was just inserted
+    void updateMinimapEntry(const Entity &entity);  // After a change or a layer shown/hidden
+    // `index` is where the entity sits before it is erased; -1 for batch removals
+    void trackRemoved(const Entity &entity, int index = -1);
+    
+    // Entities brought back by undo take their prefab's current fields
+    void refreshFromPrefab(Entity *entity) const;
+    static quint8 overrideBitOf(int property);  // Entity::Override bit of an EntityProperty
+    
+    // Apply a prefab action now or through the undo stack (see PrefabCommand)
+    void pushPrefabState(int prefabId, const Prefab &before, const Prefab &after,
+                         std::vector<Entity> &&entitiesBefore, std::vector<Entity> &&entitiesAfter,
+                         const QString &text);
+    // Likewise for one entity's components (see ComponentCommand); `field` is -1 unless a value is edited
+    void pushComponentState(int entityId, int typeId, int field, ComponentStore::Values &&after, const QString &text);
+    
+    // Tile tools: press starts an edit, moves extend it, release records it
+    void beginTileEdit(const QPoint &scenePos, Qt::MouseButton button);
+    void continueTileEdit(const QPoint &scenePos);
+    void finishTileEdit();
+    void trackTileChanges(const std::vector<TileLayer::Change> &changes);
+    static bool isTileTool(Tool tool);
+    
+    // Brush tools: the stroke is previewed while dragging and applied on release
+    void beginBrush(const QPoint &scenePos);
+    void finishBrush();
+    void applyBrushPlan(EntityBrush::Plan plan, const QString &text);
+    
+    // Layer drawing and cache upkeep
+    void drawEntity(QPainter &painter, const Entity &entity) const;
+    void drawLayer(QPainter &painter, int layerId, const QRect &cullRect) const;
+    void drawCachedLayer(QPainter &painter, int layerId, const QRect &visible);
+    void invalidateLayerCache(int layerId) { m_layerCaches[m_layers.resolve(layerId)].valid = false; }
+    void invalidateLayerCaches() { m_layerCaches.clear(); }
+    void installLayers(const LayerStack &layers);
+    void layersEdited();  // Journal, notify and repaint after a layer change
+    
+    // Group upkeep
+    void ensureGroupBvhCurrent();
+    void installGroups(const GroupTree &groups);
+    bool isInDraggedGroup(int index) const;
+    
+    void installComponents(const ComponentStore &components);
+    
+    // Rebuild the overlap index after bulk changes
+    void ensureOverlapsCurrent();
+    
+    // Comparison overlay upkeep and drawing
+    void updateComparison(const Entity &entity);
+    void drawComparison(QPainter &painter, const QRect &cullRect) const;
+    
+    // Give `target` the look of `source` (shares the prefab for instances)
+    void copyAppearance(const Entity &source, Entity *target) const;
 
 protected:
     // Override paintEvent to draw on the canvas
@@ -105,6 +506,8 @@ protected:
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
     
     // Keyboard events
     void keyPressEvent(QKeyEvent *event) override;    
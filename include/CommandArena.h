@@ -0,0 +1,54 @@
+#ifndef COMMANDARENA_H
+#define COMMANDARENA_H
+
+#include <QtGlobal>
+#include <cstddef>
+#include <vector>
+
+// Slab allocator for undo commands.
+// Memory is carved out of large slabs and returned blocks are kept on
+// per-size-class free lists, so pushing, trimming and re-pushing commands
+// reuses the same memory instead of going to the heap each time.
+// Not thread-safe: commands are created and destroyed on the GUI thread.
+class CommandArena
+{
+public:
+    struct Stats {
+        quint64 allocations = 0;      // Blocks handed out
+        quint64 recycled = 0;         // Blocks served from a free list
+        quint64 slabAllocations = 0;  // Heap allocations made by the arena
+        quint64 liveBlocks = 0;       // Blocks currently in use
+        std::size_t reservedBytes = 0;
+    };
+
+    explicit CommandArena(std::size_t slabSize = 64 * 1024);
+    ~CommandArena();
+
+    CommandArena(const CommandArena &) = delete;
+    CommandArena &operator=(const CommandArena &) = delete;
+
+    void *allocate(std::size_t size);
+    void release(void *ptr, std::size_t size);
+
+    Stats stats() const { return m_stats; }
+
+private:
+    static constexpr std::size_t GRANULE = 16;        // Size class step (and alignment)
+    static constexpr std::size_t NUM_CLASSES = 32;    // Pooled sizes up to 512 bytes
+
+    struct FreeNode {
+        FreeNode *next;
+    };
+
+    static std::size_t sizeClass(std::size_t size) { return (size + GRANULE - 1) / GRANULE; }
+    char *carve(std::size_t bytes);
+
+    std::size_t m_slabSize;
+    std::vector<char *> m_slabs;
+    char *m_cursor;
+    char *m_end;
+    FreeNode *m_freeLists[NUM_CLASSES + 1];
+    Stats m_stats;
+};
+
+#endif // COMMANDARENA_H
@@ -0,0 +1,38 @@
+#ifndef COMPONENTCOMMAND_H
+#define COMPONENTCOMMAND_H
+
+#include "EditorCommand.h"
+#include "ComponentStore.h"
+#include <QString>
+
+class Canvas;
+
+// Adding, removing or editing a component of one entity: the entity's
+// components (by id) before and after. Successive edits of the same field
+// (spin box steps) merge into one undo step.
+class ComponentCommand : public EditorCommand
+{
+public:
+    // `field` is the edited field for value edits, -1 for adding or removing
+    ComponentCommand(Canvas *canvas, int entityId, int typeId, int field, const ComponentStore::Values &before,
+                     const ComponentStore::Values &after, const QString &text, QUndoCommand *parent = nullptr);
+    
+    void undo() override;
+    void redo() override;
+    int id() const override { return COMMAND_ID; }
+    bool mergeWith(const QUndoCommand *other) override;
+
+    static constexpr int COMMAND_ID = 0x434F4D50;  // "COMP"
+
+private:
+    void apply(const ComponentStore::Values &values);
+
+    Canvas *m_canvas;
+    int m_entityId;
+    int m_typeId;
+    int m_field;
+    ComponentStore::Values m_before;
+    ComponentStore::Values m_after;
+};
+
+#endif // COMPONENTCOMMAND_H
@@ -0,0 +1,75 @@
+#ifndef COMPONENTREGISTRY_H
+#define COMPONENTREGISTRY_H
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QString>
+#include <QVariant>
+#include <vector>
+
+// One typed field of a component type
+struct ComponentField
+{
+    enum class Type { Int, Float, Bool, String, Color };
+
+    QString name;
+    Type type = Type::Int;
+    QVariant defaultValue;  // Already converted to `type`
+};
+
+// A game-specific component type, e.g. "Health" with an int "hp" field.
+// Types are data, defined per scene, so new properties need no code change.
+struct ComponentType
+{
+    int id = 0;
+    QString name;
+    std::vector<ComponentField> fields;
+
+    int fieldIndex(const QString &fieldName) const;  // -1 if unknown
+};
+
+// Component types of a scene, by id. Ids are never reused; names are unique.
+// Type and field names are identifiers (letters, digits and '_'), as the file
+// format joins them into "Type.field" column keys. The values themselves
+// live in ComponentStore.
+class ComponentRegistry
+{
+public:
+    ComponentRegistry();
+
+    // Returns the new type's id, 0 if a name is invalid, the type name is taken or a field name repeats
+    int add(const QString &name, const std::vector<ComponentField> &fields);
+    static bool isValidName(const QString &name);
+    // Undo of a definition: remove the type, or put it back under its id
+    bool insert(const ComponentType &type);  // False if its id or name is taken
+    bool remove(int id);
+
+    const ComponentType *find(int id) const;
+    int idOf(const QString &name) const { return m_idByName.value(name, 0); }
+    const std::vector<ComponentType> &types() const { return m_types; }  // In definition order
+    int size() const { return static_cast<int>(m_types.size()); }
+    bool isEmpty() const { return m_types.empty(); }
+    void clear();
+
+    // "hp:int=100, speed:float, tag:string" (type defaults to int)
+    static bool parseFields(const QString &spec, std::vector<ComponentField> *fields, QString *error);
+
+    // Field values: coercion to a field type and their JSON form
+    static QVariant convert(const QVariant &value, ComponentField::Type type);
+    static QJsonValue toJsonValue(const QVariant &value, ComponentField::Type type);
+    static QVariant fromJsonValue(const QJsonValue &value, ComponentField::Type type);
+    static QString typeName(ComponentField::Type type);
+    static bool typeFromName(const QString &name, ComponentField::Type *type);
+
+    QJsonArray toJson() const;
+    static ComponentRegistry fromJson(const QJsonArray &array);
+
+private:
+    std::vector<ComponentType> m_types;
+    QHash<int, int> m_indexById;
+    QHash<QString, int> m_idByName;
+    int m_nextId;
+};
+
+#endif // COMPONENTREGISTRY_H
@@ -0,0 +1,110 @@
+#ifndef COMPONENTSTORE_H
+#define COMPONENTSTORE_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+#include <QVariant>
+#include <map>
+#include <vector>
+#include "ComponentRegistry.h"
+
+// Component values of a scene, kept apart from Entity so entities without
+// components cost nothing and the geometric code never touches them.
+//
+// Entities with the same set of component types share an archetype: a table
+// with one row per entity and one contiguous, typed column per field. Adding
+// or removing a component moves the entity's row to the archetype of its new
+// set (rows are swap-removed, so row order isn't stable). Queries return the
+// archetypes that have every requested type, to be iterated column-wise.
+//
+// Entities are referred to by id; Canvas drops an entity's row when the
+// entity is removed (the command that removed it keeps the values for undo).
+class ComponentStore
+{
+public:
+    // Values of one field for every row; only the vector matching `type` is used
+    struct Column {
+        ComponentField::Type type = ComponentField::Type::Int;
+        std::vector<qint64> ints;      // Int, Bool, Color (ARGB)
+        std::vector<double> floats;    // Float
+        std::vector<QString> strings;  // String
+
+        int size() const { return static_cast<int>(ints.size() + floats.size() + strings.size()); }  // One is in use
+        QVariant at(int row) const;
+        void set(int row, const QVariant &value);  // Value already converted to `type`
+        void append(const QVariant &value);
+        void swapRemove(int row);
+    };
+
+    struct Archetype {
+        std::vector<int> typeIds;      // Sorted
+        std::vector<int> firstColumn;  // Per type: its first field's column
+        std::vector<Column> columns;
+        std::vector<int> entityIds;    // Entity of each row
+
+        int rowCount() const { return static_cast<int>(entityIds.size()); }
+        int typeIndex(int typeId) const;  // Position in typeIds, -1 if absent
+        const Column *column(int typeId, int field) const;
+        Column *column(int typeId, int field)
+        {
+            return const_cast<Column *>(static_cast<const Archetype *>(this)->column(typeId, field));
+        }
+    };
+
+    using Values = QHash<int, QVariantList>;  // One entity's components: type id -> field values
+
+    ComponentRegistry &registry() { return m_registry; }
+    const ComponentRegistry &registry() const { return m_registry; }
+
+    bool has(int entityId, int typeId) const;
+    bool hasAny(int entityId) const { return m_locations.contains(entityId); }
+    std::vector<int> componentsOf(int entityId) const;  // Type ids, sorted
+    bool add(int entityId, int typeId);                 // With the field defaults
+    bool remove(int entityId, int typeId);
+    QVariant value(int entityId, int typeId, int field) const;
+    bool setValue(int entityId, int typeId, int field, const QVariant &value);
+
+    // Whole rows (undo of removals, journal records, hot reload)
+    Values valuesOf(int entityId) const;
+    void setValues(int entityId, const Values &values);  // Replaces all; unknown types are dropped
+    Values take(int entityId);
+    void removeEntity(int entityId) { take(entityId); }
+
+    // Drop a type from the registry and its values from every entity
+    void removeType(int typeId);
+
+    // Archetypes having every type in `typeIds` (all archetypes for an empty set)
+    std::vector<const Archetype *> query(std::vector<int> typeIds) const;
+
+    int entityCount() const { return m_locations.size(); }
+    int archetypeCount() const { return static_cast<int>(m_archetypes.size()); }
+    bool isEmpty() const { return m_registry.isEmpty() && m_locations.isEmpty(); }  // Nothing worth saving
+    void clear();  // Types and values
+
+    // Scene file form: the registry plus one columnar entry per archetype
+    QJsonObject toJson() const;
+    static ComponentStore fromJson(const QJsonObject &json);
+
+    // One entity's components by type and field name (journal records)
+    QJsonObject valuesToJson(int entityId) const;
+    void setValuesJson(int entityId, const QJsonObject &json);
+
+private:
+    struct Location {
+        int archetype;
+        int row;
+    };
+
+    int archetypeFor(const std::vector<int> &typeIds);  // Created on first use
+    void insertRow(int entityId, int archetype, const Values &values);
+    Values rowValues(const Archetype &archetype, int row) const;
+    Values removeRow(const Location &location);
+
+    ComponentRegistry m_registry;
+    std::vector<Archetype> m_archetypes;
+    std::map<std::vector<int>, int> m_archetypeByTypes;
+    QHash<int, Location> m_locations;  // Entity id -> row
+};
+
+#endif // COMPONENTSTORE_H
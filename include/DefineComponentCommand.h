@@ -0,0 +1,24 @@
+#ifndef DEFINECOMPONENTCOMMAND_H
+#define DEFINECOMPONENTCOMMAND_H
+
+#include "EditorCommand.h"
+#include "ComponentRegistry.h"
+
+class Canvas;
+
+// Defining a component type. Undo removes the type again; by then the
+// components added with it have been undone too.
+class DefineComponentCommand : public EditorCommand
+{
+public:
+    DefineComponentCommand(Canvas *canvas, const ComponentType &type, QUndoCommand *parent = nullptr);
+    
+    void undo() override;
+    void redo() override;
+
+private:
+    Canvas *m_canvas;
+    ComponentType m_type;
+};
+
+#endif // DEFINECOMPONENTCOMMAND_H
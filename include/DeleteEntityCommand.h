@@ -1,12 +1,13 @@
 #ifndef DELETEENTITYCOMMAND_H
 #define DELETEENTITYCOMMAND_H
 
-#include <QUndoCommand>
+#include "EditorCommand.h"
 #include "Entity.h"
+#include "ComponentStore.h"
 
 class Canvas;
 
-class DeleteEntityCommand : public QUndoCommand
+class DeleteEntityCommand : public EditorCommand
 {
 public:
     DeleteEntityCommand(Canvas *canvas, int entityIndex, QUndoCommand *parent = nullptr);
@@ -17,8 +18,9 @@ public:
 private:
     Canvas *m_canvas;
     Entity m_entity;
-    int m_entityIndex;
-    bool m_firstRedo;
+    ComponentStore::Values m_components;  // As removed; restored with the entity
+    int m_entityId;
+    int m_entityIndex;  // Last known index, used as a lookup hint
 };
 
 #endif // DELETEENTITYCOMMAND_H
\ No newline at end of file
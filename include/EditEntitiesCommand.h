@@ -0,0 +1,49 @@
+#ifndef EDITENTITIESCOMMAND_H
+#define EDITENTITIESCOMMAND_H
+
+#include "EditorCommand.h"
+#include "NamePool.h"
+#include <QColor>
+#include <QString>
+#include <vector>
+
+class Canvas;
+
+// One entity's value of an edited property, and whether the entity
+// overrides its prefab there. Only the field of the edited property is used.
+struct EntityPropertyState
+{
+    int entityId;
+    PooledName name;   // Name
+    QRgb color = 0;    // Color
+    int size = 0;      // Width or Height
+    bool overridden = false;
+};
+
+// One inspector edit (name, color or size) applied to a set of entities.
+// Keeps only the edited property and its prefab override bit before and
+// after, so undo leaves what other actions changed since (group, layer,
+// prefab) alone. Successive size steps on the same entities (spin box
+// arrows) merge into one undo step.
+class EditEntitiesCommand : public EditorCommand
+{
+public:
+    EditEntitiesCommand(Canvas *canvas, int property, std::vector<EntityPropertyState> &&before,
+                        std::vector<EntityPropertyState> &&after, const QString &text,
+                        QUndoCommand *parent = nullptr);
+    
+    void undo() override;
+    void redo() override;
+    int id() const override { return COMMAND_ID; }
+    bool mergeWith(const QUndoCommand *other) override;
+
+    static constexpr int COMMAND_ID = 0x45444954;  // "EDIT"
+
+private:
+    Canvas *m_canvas;
+    int m_property;  // Canvas::EntityProperty
+    std::vector<EntityPropertyState> m_before;
+    std::vector<EntityPropertyState> m_after;  // Same ids, same order
+};
+
+#endif // EDITENTITIESCOMMAND_H
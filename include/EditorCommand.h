@@ -0,0 +1,33 @@
+#ifndef EDITORCOMMAND_H
+#define EDITORCOMMAND_H
+
+#include <QUndoCommand>
+#include <cstddef>
+
+class CommandArena;
+
+// Base class for all editor undo commands.
+// Commands created through UndoHistory::create() live in the history's
+// CommandArena; deleting them (QUndoStack trimming, clear, or a discarded
+// redo branch) hands the memory back to the arena for reuse. Commands created
+// with a plain `new` still work and use the global heap.
+class EditorCommand : public QUndoCommand
+{
+public:
+    explicit EditorCommand(QUndoCommand *parent = nullptr)
+        : QUndoCommand(parent) {}
+
+    static void *operator new(std::size_t size);
+    static void *operator new(std::size_t size, CommandArena *arena);
+    static void operator delete(void *ptr);
+    static void operator delete(void *ptr, CommandArena *arena);  // Used if a constructor throws
+
+private:
+    // Stored in front of every command so delete can find its arena
+    struct alignas(16) BlockHeader {
+        CommandArena *arena;
+        std::size_t size;
+    };
+};
+
+#endif // EDITORCOMMAND_H
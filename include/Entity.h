@@ -6,36 +6,76 @@
 #include <QString>
 #include <QColor>
 #include <QJsonObject>
+#include "NamePool.h"
+
+struct Prefab;
 
 class Entity
 {
 public:
+    // Fields a prefab instance sets itself instead of taking from its prefab
+    enum Override : quint8 {
+        OverrideName = 0x1,
+        OverrideColor = 0x2,
+        OverrideSize = 0x4
+    };
+    
+
     // Constructor
     Entity(int id, const QString &name, const QPoint &position);
+    Entity(int id, NameRef nameRef, const QPoint &position);
     
     // Getters
     int id() const { return m_id; }
-    QString name() const { return m_name; }
+    QString name() const { return NamePool::instance().resolve(m_nameRef, m_id); }
+    NameRef nameRef() const { return m_nameRef; }
     QPoint position() const { return m_position; }
     QRect rect() const { return m_rect; }
     QColor color() const { return m_color; }
     
+    // Prefab instancing (see PrefabLibrary). Setting a field on an instance
+    // overrides it (copy-on-write); other fields follow the prefab.
+    int prefabId() const { return m_prefabId; }
+    bool isPrefabInstance() const { return m_prefabId >= 0; }
+    quint8 overrides() const { return m_overrides; }
+    void setPrefab(int prefabId, quint8 overrides = 0);  // -1 detaches, keeping current values
+    void applyPrefab(const Prefab &prefab);              // Refresh the non-overridden fields
+    void clearOverrides() { m_overrides = 0; }
+    
+    // Layer the entity is drawn on (see LayerStack)
+    int layerId() const { return m_layerId; }
+    void setLayerId(int layerId) { m_layerId = layerId; }
+    
+    // Innermost group the entity belongs to (see GroupTree), 0 if ungrouped
+    int groupId() const { return m_groupId; }
+    void setGroupId(int groupId) { m_groupId = groupId; }
+    
     // Setters
     void setPosition(const QPoint &pos);
     void setName(const QString &name);
+    void setNameRef(NameRef nameRef);
     void setColor(const QColor &color);
     void setSize(int width, int height);
     
     // JSON serialization
-    QJsonObject toJson() const;
-    static Entity fromJson(const QJsonObject &json);
+    // With a name table, names are written/read as indices into the file's
+    // shared "names" array; without one the name is inlined as a string
+    QJsonObject toJson(NameTable *names = nullptr) const;
+    // Add the name toJson() would write to the table, so a writer can emit
+    // the table ahead of the entities
+    void registerName(NameTable *names) const;
+    static Entity fromJson(const QJsonObject &json, const NameTable *names = nullptr);
 
 private:
     int m_id;                    // Unique identifier
-    QString m_name;              // Display name
+    PooledName m_nameRef;        // Interned display name (see NamePool)
     QPoint m_position;           // Position on canvas
     QRect m_rect;                // Bounding rectangle (position + size)
     QColor m_color;              // Visual color
+    int m_prefabId;              // Prefab this entity instantiates, -1 if none
+    quint8 m_overrides;          // Override bits (only meaningful for instances)
+    int m_layerId;               // Layer id, 0 is the default layer
+    int m_groupId;               // Group id, 0 if ungrouped
     
     static const int DEFAULT_WIDTH = 60;
     static const int DEFAULT_HEIGHT = 60;
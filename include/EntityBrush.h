@@ -0,0 +1,57 @@
+#ifndef ENTITYBRUSH_H
+#define ENTITYBRUSH_H
+
+#include <QColor>
+#include <QHash>
+#include <QPoint>
+#include <QRect>
+#include <vector>
+#include "Entity.h"
+#include "LayerStack.h"
+
+// Plans bulk entity edits for the brush tools.
+//
+// The scene is treated as a grid of cellSize squares. A cell is "covered"
+// when its center lies inside an entity. Painting a set of cells recolors
+// the entities covering them and creates one cell-sized entity in every
+// uncovered cell. Filling either recolors the connected group of touching,
+// same-colored entities under the cursor, or paints the connected empty
+// cells around it (clipped to a bounds rect).
+//
+// Entities on hidden or locked layers are ignored (as if absent).
+// The brush only computes the edit; Canvas applies it as one undo command.
+class EntityBrush
+{
+public:
+    struct Plan {
+        std::vector<QPoint> newPositions;  // Top-left corners of entities to create
+        std::vector<int> recolorIndices;   // Existing entities to recolor (indices)
+        bool isEmpty() const { return newPositions.empty() && recolorIndices.empty(); }
+    };
+
+    EntityBrush(const std::vector<Entity> &entities, int cellSize, const LayerStack *layers = nullptr);
+
+    QPoint cellAt(const QPoint &scenePos) const;
+    QRect cellRect(const QPoint &cell) const;
+    QRect cellsIn(const QRect &sceneRect) const;
+
+    static std::vector<QPoint> lineCells(const QPoint &from, const QPoint &to);
+    static std::vector<QPoint> rectCells(const QRect &cells);
+
+    Plan paint(const std::vector<QPoint> &cells, const QColor &color) const;
+    Plan fill(const QPoint &cell, const QColor &color, const QRect &bounds) const;
+
+    static constexpr int MAX_CELLS = 100000;  // Larger brush areas are ignored
+
+private:
+    // Topmost entity covering each cell of `cells`
+    QHash<QPoint, int> coverage(const QRect &cells) const;
+    Plan recolorConnected(int seedIndex, const QColor &color) const;
+    bool isEditable(const Entity &entity) const { return !m_layers || m_layers->isEditable(entity.layerId()); }
+
+    const std::vector<Entity> &m_entities;
+    int m_cellSize;
+    const LayerStack *m_layers;
+};
+
+#endif // ENTITYBRUSH_H
@@ -0,0 +1,42 @@
+#ifndef ENTITYCLIPBOARD_H
+#define ENTITYCLIPBOARD_H
+
+#include <QByteArray>
+#include <vector>
+#include "ComponentStore.h"
+#include "Entity.h"
+
+class QMimeData;
+
+// Entities on the system clipboard.
+//
+// The editor's own format (MIME_TYPE) is binary: a header, a table of the
+// distinct names, then 24 bytes per entity (name index, rect, color), then
+// the component types in use and each entity's component values; zlib
+// compressed above COMPRESS_THRESHOLD. The same entities are also offered
+// as scene JSON text, so other tools can read a copy and text holding a
+// scene can be pasted. Copies are flattened: prefab instances carry their
+// resolved values, and group and layer membership is not kept.
+//
+// Components are keyed by the entities' ids in the clip (decoded entities
+// are numbered from 1); pasting matches their types by name.
+class EntityClipboard
+{
+public:
+    static constexpr const char *MIME_TYPE = "application/x-qleveleditor-entities";
+    static constexpr quint32 MAGIC = 0x514C4543;  // "QLEC"
+    static constexpr quint8 FORMAT_VERSION = 2;  // 2: components
+    static constexpr int COMPRESS_THRESHOLD = 4096;  // Raw bytes
+
+    static QByteArray encode(const std::vector<Entity> &entities, const ComponentStore &components = ComponentStore());
+    static bool decode(const QByteArray &data, std::vector<Entity> *entities, ComponentStore *components = nullptr);
+
+    // Caller owns the returned object (usually handed to QClipboard)
+    static QMimeData *toMimeData(const std::vector<Entity> &entities,
+                                 const ComponentStore &components = ComponentStore());
+    // Binary format first, then scene JSON in the text; false if neither holds entities
+    static bool fromMimeData(const QMimeData *mime, std::vector<Entity> *entities,
+                             ComponentStore *components = nullptr);
+};
+
+#endif // ENTITYCLIPBOARD_H
@@ -0,0 +1,48 @@
+#ifndef ENTITYSEARCHINDEX_H
+#define ENTITYSEARCHINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <vector>
+
+// Substring search over entity labels ("<id>: <name>"), case-insensitive.
+//
+// Each label is split into overlapping trigrams; every trigram keeps the
+// sorted ids of the labels containing it. A query intersects the lists of
+// its own trigrams, smallest first, and confirms the few survivors against
+// the label, so its cost follows the number of candidates rather than the
+// scene size. Queries shorter than a trigram scan the labels directly.
+class EntitySearchIndex
+{
+public:
+    EntitySearchIndex() = default;
+
+    static QString labelFor(int entityId, const QString &name);
+
+    // Add or relabel an entity; false when the label was already current
+    bool update(int entityId, const QString &label);
+    void remove(int entityId);
+    void clear();
+    int size() const { return m_labels.size(); }
+    QString label(int entityId) const { return m_labels.value(entityId).text; }
+
+    // Ids of matching entities, ascending, at most `limit` of them;
+    // `total` receives the number of matches before the limit
+    std::vector<int> find(const QString &text, int limit, int *total = nullptr) const;
+
+private:
+    using Trigram = quint64;
+    struct Label {
+        QString text;    // As displayed
+        QString folded;  // Case-folded, what is indexed
+    };
+
+    static std::vector<Trigram> trigramsOf(const QString &folded);
+    void addPostings(int entityId, const QString &folded);
+    void removePostings(int entityId, const QString &folded);
+
+    QHash<int, Label> m_labels;                      // Entity id -> label
+    QHash<Trigram, std::vector<int>> m_postings;     // Trigram -> sorted entity ids
+};
+
+#endif // ENTITYSEARCHINDEX_H
@@ -0,0 +1,98 @@
+#ifndef GROUPBVH_H
+#define GROUPBVH_H
+
+#include <QHash>
+#include <QPoint>
+#include <QRect>
+#include <vector>
+#include "Entity.h"
+#include "GroupTree.h"
+
+// Bounding-volume hierarchy over the entity groups, for culling and picking.
+//
+// Every group is one node whose box covers its members and its nested
+// groups, so a query that misses the box skips the whole group. Top-level
+// groups and ungrouped entities are the leaves of a binary tree built by
+// median splits along the longer axis. Each node keeps the rects of the
+// entities it holds directly: a moved entity refits only the boxes on its
+// path to the root, and a moved group shifts its subtree as one piece.
+//
+// Results are entity indices. Entities and groups are added and removed in
+// place (a new top-level entry joins the split leaf it enlarges least, and
+// later indices are shifted), so the owner rebuilds only after whole-scene
+// changes.
+class GroupBvh
+{
+public:
+    GroupBvh();
+
+    void build(const std::vector<Entity> &entities, const GroupTree &groups);
+    void clear();
+    int entityCount() const { return m_slots.size(); }
+
+    // An entity moved or was resized; false if it isn't indexed (rebuild needed)
+    bool update(int entityId, const QRect &rect);
+    // Shift a group with everything in it; only the boxes above it are refit
+    void translateGroup(int groupId, const QPoint &delta);
+
+    // Entity `index` was inserted (later entities shift up) or removed (later
+    // entities shift down)
+    void insert(int index, const Entity &entity);
+    void remove(int entityId, int index);
+    // An entity joined another group (NO_GROUP: none); false if it isn't indexed
+    bool setEntityGroup(int entityId, int groupId);
+    // Group structure, mirroring GroupTree
+    void addGroup(int groupId, int parentId);
+    void setGroupParent(int groupId, int parentId);
+    void removeGroup(int groupId, int parentId);  // Its members and child groups move to `parentId`
+
+    // Indices of the entities intersecting `area`, ascending (draw order)
+    void query(const QRect &area, std::vector<int> *indices) const;
+    // Indices of the entities in a group and its nested groups, ascending
+    std::vector<int> membersOf(int groupId) const;
+    QRect groupBounds(int groupId) const;
+
+    static constexpr int LEAF_SIZE = 8;  // Top-level entries per leaf before splitting
+
+private:
+    struct Item {
+        int index;  // Entity index
+        int entityId;
+        QRect rect;
+    };
+    struct Node {
+        QRect bounds;
+        int parent = -1;
+        int groupId = GroupTree::NO_GROUP;  // Group this node stands for (0 for split nodes)
+        std::vector<int> children;          // Child nodes
+        std::vector<Item> items;            // Entities held directly
+    };
+    struct Entry {  // Top-level leaf: a top-level group node or an ungrouped entity
+        QRect rect;
+        int node;  // -1 for an entity
+        Item item;
+    };
+    struct Slot {
+        int node;
+        int item;
+    };
+
+    int buildSplit(std::vector<Entry> &entries, int begin, int end);
+    QRect fitGroup(int node);
+    QRect computeBounds(const Node &node) const;
+    void refit(int node);
+
+    int chooseLeaf(const QRect &rect);
+    void attach(int node, int parent);  // Parent -1: a top-level entry, placed by chooseLeaf()
+    void detach(int node);
+    void addItem(int node, const Item &item);
+    Item takeItem(int entityId);        // Index -1 if the entity isn't indexed
+    void shiftIndices(int from, int delta);
+
+    std::vector<Node> m_nodes;
+    int m_root;
+    QHash<int, int> m_groupNodes;  // Group id -> node
+    QHash<int, Slot> m_slots;      // Entity id -> where its rect is kept
+};
+
+#endif // GROUPBVH_H
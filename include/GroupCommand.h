@@ -0,0 +1,30 @@
+#ifndef GROUPCOMMAND_H
+#define GROUPCOMMAND_H
+
+#include "EditorCommand.h"
+#include "GroupTree.h"
+#include <vector>
+
+class Canvas;
+
+// Groups entities, or ungroups them. Either way the command keeps the group,
+// the groups nested directly in it and its direct members (by id), so undoing
+// one direction is redoing the other and the group comes back under its id.
+class GroupCommand : public EditorCommand
+{
+public:
+    GroupCommand(Canvas *canvas, const EntityGroup &group, std::vector<int> &&childGroupIds,
+                 std::vector<int> &&memberIds, bool ungroup, QUndoCommand *parent = nullptr);
+    
+    void undo() override;
+    void redo() override;
+
+private:
+    Canvas *m_canvas;
+    EntityGroup m_group;
+    std::vector<int> m_childGroupIds;
+    std::vector<int> m_memberIds;
+    bool m_ungroup;
+};
+
+#endif // GROUPCOMMAND_H
@@ -0,0 +1,55 @@
+#ifndef GROUPTREE_H
+#define GROUPTREE_H
+
+#include <QHash>
+#include <QJsonArray>
+#include <QString>
+#include <vector>
+
+// A named group of entities. Groups nest: a group's parent is the group
+// that contains it (0 for top-level groups).
+struct EntityGroup
+{
+    int id = 0;
+    QString name;
+    int parentId = 0;
+};
+
+// Definitions of the entity groups of a scene. Membership is stored on the
+// entities (Entity::groupId names the innermost group); this only holds the
+// groups themselves and how they nest. See GroupBvh for the spatial side.
+class GroupTree
+{
+public:
+    GroupTree();
+
+    static constexpr int NO_GROUP = 0;
+
+    int add(const QString &name, int parentId = NO_GROUP);  // Returns the new id
+    void insert(const EntityGroup &group);  // Add or replace under group.id (undo/redo)
+    bool remove(int id);  // Child groups move up to its parent
+    bool rename(int id, const QString &name);
+    bool setParent(int id, int parentId);  // Refuses to create a cycle
+
+    const EntityGroup *find(int id) const;
+    bool contains(int id) const { return m_groups.contains(id); }
+    int parentOf(int id) const;
+    int rootOf(int id) const;                      // Outermost group containing `id` (itself if top-level)
+    bool isWithin(int id, int ancestorId) const;  // `id` is `ancestorId` or nested inside it
+    std::vector<int> childrenOf(int id) const;    // Direct child groups, by id
+    int depthOf(int id) const;                    // 0 for top-level groups
+
+    const QHash<int, EntityGroup> &groups() const { return m_groups; }
+    int size() const { return m_groups.size(); }
+    bool isEmpty() const { return m_groups.isEmpty(); }
+    void clear();
+
+    QJsonArray toJson() const;
+    static GroupTree fromJson(const QJsonArray &array);
+
+private:
+    QHash<int, EntityGroup> m_groups;
+    int m_nextId;
+};
+
+#endif // GROUPTREE_H
@@ -10,10 +10,17 @@
 #include <QVBoxLayout>
 #include <QFormLayout>
 #include <QGroupBox>
+#include <QComboBox>
+#include <QSet>
+#include <QTimer>
+#include <vector>
 
 class Canvas;  // Forward declaration
 
-
+// Properties of the selected entities. With several selected, fields whose
+// values differ show as mixed and an edit applies to all of them as one undo
+// step. Names commit when editing finishes; size edits are debounced, so
+// spinning through values doesn't rewrite a large selection on every step.
 class InspectorPanel : public QWidget
 {
     Q_OBJECT
@@ -25,24 +32,43 @@ public:
     void setCanvas(Canvas *canvas);    
 
 public slots:
-    // Called when selection changes in the canvas
-    // entityPtr can be nullptr if nothing selected
+    // Called when selection changes in the canvas (-1 if nothing selected)
     void onSelectionChanged(int entityIndex);
-    
-    // Called with actual entity pointer from canvas
-    void updateFromEntity(int id, const QString &name, const QColor &color, int width, int height);
 
 private slots:
-    // Property change handlers (for next step - add empty implementations for now)
-    void onNameChanged();
+    // Property change handlers
+    void onNameEdited();
     void onColorChanged();
     void onWidthChanged(int value);
     void onHeightChanged(int value);
+    void commitPendingEdits();  // Size edits waiting for the debounce timer
+    void refreshFromSelection();
+    
+    // Prefab actions on the selected entity
+    void onMakePrefab();
+    void onRevertToPrefab();
+    void onApplyToPrefab();
+    void onEntityChanged(int entityIndex);
+    
+    // Components of the selected entity
+    void onComponentTypesChanged();
+    void onAddComponent();
+    void onDefineComponentType();
 
 private:
     void setupUI();
     void clearDisplay();  // Clear all fields when nothing selected
     void blockSignals(bool block);  // Helper to block signals during programmatic updates
+    void scheduleRefresh();         // Coalesces the change signals of a bulk edit
+    void setSizeValue(QSpinBox *spin, int value, bool mixed);
+    void updatePrefabRow(int entityIndex);
+    
+    // Rebuilds the editors when the entity or its component set changed,
+    // otherwise only refreshes the shown values
+    void updateComponents(int entityIndex);
+    void clearComponentEditors();
+    QWidget *createFieldEditor(int typeId, int field, const QVariant &value);
+    void setEditorValue(QWidget *editor, const QVariant &value);
 
     
     // UI Elements
@@ -54,8 +80,40 @@ private:
     QSpinBox *m_widthSpin;
     QSpinBox *m_heightSpin;
     
+    // Prefab widgets
+    QLabel *m_prefabLabel;
+    QPushButton *m_makePrefabButton;
+    QPushButton *m_revertPrefabButton;
+    QPushButton *m_applyPrefabButton;
+    
+    // Component widgets
+    struct FieldEditor {
+        int typeId;
+        int field;
+        QWidget *editor;
+    };
+    QVBoxLayout *m_componentsLayout;     // One sub-box per component
+    QComboBox *m_componentTypeCombo;
+    QPushButton *m_addComponentButton;
+    QPushButton *m_defineComponentButton;
+    std::vector<QWidget *> m_componentBoxes;
+    std::vector<FieldEditor> m_fieldEditors;
+    std::vector<int> m_shownComponents;  // Type ids the editors were built for
+    int m_componentsEntityId;            // -1 when none are shown
+    
     // Current entity index (for tracking)
     int m_currentEntityIndex;
+    
+    QSet<int> m_editIds;  // Entities the property edits apply to
+    QTimer *m_commitTimer;
+    QTimer *m_refreshTimer;
+    int m_pendingWidth;   // -1 when no edit is pending
+    int m_pendingHeight;
+    
+    static constexpr int COMMIT_DELAY_MS = 250;
+    static constexpr int MIN_SIZE = 10;
+    static constexpr int MAX_SIZE = 500;
+    
     Canvas *m_canvas;  // Add canvas pointer
 };
 
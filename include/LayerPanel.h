@@ -0,0 +1,52 @@
+#ifndef LAYERPANEL_H
+#define LAYERPANEL_H
+
+#include <QWidget>
+
+class Canvas;
+class QListWidget;
+class QListWidgetItem;
+class QPushButton;
+
+// Lists the canvas layers, top layer first. The check box toggles a layer's
+// visibility, double-clicking renames it and the current row is the layer
+// new entities go to.
+class LayerPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit LayerPanel(QWidget *parent = nullptr);
+
+    void setCanvas(Canvas *canvas);
+
+private slots:
+    void refresh();  // Rebuild the list from the canvas layers
+    void onCurrentRowChanged(int row);
+    void onItemChanged(QListWidgetItem *item);
+    void onAddLayer();
+    void onRemoveLayer();
+    void onMoveUp();
+    void onMoveDown();
+    void onToggleLock();
+    void onMoveSelectedHere();
+
+private:
+    void setupUI();
+    int layerIdAt(int row) const;
+    int currentLayerId() const;
+    void moveCurrent(int step);
+
+    QListWidget *m_list;
+    QPushButton *m_addButton;
+    QPushButton *m_removeButton;
+    QPushButton *m_upButton;
+    QPushButton *m_downButton;
+    QPushButton *m_lockButton;
+    QPushButton *m_moveHereButton;
+
+    Canvas *m_canvas;
+    bool m_refreshing;  // Ignore item signals while the list is rebuilt
+};
+
+#endif // LAYERPANEL_H
@@ -0,0 +1,56 @@
+#ifndef LAYERSTACK_H
+#define LAYERSTACK_H
+
+#include <QHash>
+#include <QJsonArray>
+#include <QString>
+#include <vector>
+
+// A named drawing layer. Entities refer to layers by id.
+struct Layer
+{
+    int id = 0;
+    QString name;
+    bool visible = true;
+    bool locked = false;  // Locked layers are drawn but can't be picked or edited
+};
+
+// Ordered layers of a scene, bottom to top. Layer 0 ("Default") always
+// exists; entities whose layer is unknown are treated as being on it.
+class LayerStack
+{
+public:
+    LayerStack();
+
+    static constexpr int DEFAULT_LAYER = 0;
+
+    int add(const QString &name);  // New layer on top; returns its id
+    bool remove(int id);           // The default layer can't be removed
+    bool rename(int id, const QString &name);
+    bool setVisible(int id, bool visible);
+    bool setLocked(int id, bool locked);
+    bool moveTo(int id, int position);  // Position in draw order, 0 = bottom
+
+    const Layer *find(int id) const;
+    bool contains(int id) const { return m_rank.contains(id); }
+    int resolve(int id) const { return contains(id) ? id : DEFAULT_LAYER; }
+    int rankOf(int id) const;  // Draw position of the layer an entity with this id is on
+    bool isVisible(int id) const;
+    bool isEditable(int id) const;  // Visible and not locked
+
+    const std::vector<Layer> &layers() const { return m_layers; }
+    int size() const { return static_cast<int>(m_layers.size()); }
+    bool isDefault() const;  // Nothing worth saving: only an unchanged default layer
+
+    QJsonArray toJson() const;
+    static LayerStack fromJson(const QJsonArray &array);
+
+private:
+    void reindex();
+
+    std::vector<Layer> m_layers;  // Bottom to top
+    QHash<int, int> m_rank;       // Layer id -> index in m_layers
+    int m_nextId;
+};
+
+#endif // LAYERSTACK_H
@@ -0,0 +1,67 @@
+#ifndef LIVELINKPROTOCOL_H
+#define LIVELINKPROTOCOL_H
+
+#include <cstdint>
+#include "RuntimeScene.h"
+
+// Wire format of the editor's live link (see LiveLinkServer), for the game's
+// side of the socket: plain C++17, no Qt.
+//
+// The stream is a sequence of frames, all integers little-endian:
+//
+//   u32 size        Bytes that follow this field
+//   u8  type        SNAPSHOT or DELTA
+//   u8  reserved[3]
+//   u32 sequence    Increases by one per frame sent to this client
+//   u64 editTimeUs  When the oldest edit in the frame was made (µs since the
+//                   Unix epoch, system clock) - receive time minus this is
+//                   the edit-to-receive latency
+//   ...body
+//
+// SNAPSHOT replaces the whole scene: the body is a runtime scene blob
+// (RuntimeScene::open() reads it in place). A client always gets one first,
+// and again whenever it fell behind (see LiveLinkServer).
+//
+// DELTA changes the scene since the previous frame:
+//
+//   u32 removedCount, u32 upsertCount
+//   removedCount x i32 entity id
+//   upsertCount x { RuntimeScene entity record whose E_NAME field holds the
+//                   UTF-8 length of the name (NO_NAME if unnamed), then the
+//                   name bytes padded to a multiple of 4 }
+//
+// Removals apply before upserts; an upsert adds the entity if its id is
+// unknown and replaces all of its fields otherwise.
+class LiveLinkProtocol
+{
+public:
+    static constexpr const char *DEFAULT_SERVER_NAME = "qleveleditor-livelink";
+
+    enum FrameType : uint8_t {
+        SNAPSHOT = 1,
+        DELTA = 2
+    };
+
+    static constexpr uint32_t FRAME_HEADER_SIZE = 20;  // Including the size field
+
+    // Frame header fields
+    enum FrameOffset : uint32_t {
+        F_SIZE = 0,          // u32
+        F_TYPE = 4,          // u8
+        F_SEQUENCE = 8,      // u32
+        F_EDIT_TIME = 12     // u64
+    };
+
+    static uint64_t readU64(const unsigned char *p)
+    {
+        return uint64_t(RuntimeScene::readU32(p)) | (uint64_t(RuntimeScene::readU32(p + 4)) << 32);
+    }
+
+    // Bytes the name of an upsert takes after its record
+    static uint32_t paddedNameSize(uint32_t length)
+    {
+        return length == RuntimeScene::NO_NAME ? 0 : (length + 3) & ~3u;
+    }
+};
+
+#endif // LIVELINKPROTOCOL_H
@@ -0,0 +1,94 @@
+#ifndef LIVELINKSERVER_H
+#define LIVELINKSERVER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+
+class Canvas;
+class QLocalServer;
+class QLocalSocket;
+
+// Streams the canvas edits to running game instances over a local socket
+// (see LiveLinkProtocol.h for the wire format).
+//
+// Edits are collected as entity ids from the canvas bookkeeping
+// (Canvas::entityEdited / entityErased, which every edit path goes through)
+// and sent once per frame (FRAME_MS) as one delta holding the current state
+// of every touched entity, so an entity dragged across many mouse events
+// costs one record per frame. Bulk changes (loads, resets) send a snapshot
+// instead.
+//
+// Backpressure: a client whose socket has more than MAX_BUFFERED_BYTES
+// unsent is skipped rather than queued for. Once its buffer drains below
+// RESUME_BYTES it gets a fresh snapshot, which supersedes the deltas it
+// missed, so a slow game never grows the editor's memory or sees a gap. The
+// unsent part of the latest snapshot doesn't count against the limit, so a
+// scene larger than the limit doesn't send snapshots forever.
+class LiveLinkServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LiveLinkServer(Canvas *canvas, QObject *parent = nullptr);
+    ~LiveLinkServer() override;
+
+    bool start(const QString &name = QString());  // Default: LiveLinkProtocol::DEFAULT_SERVER_NAME
+    void stop();
+    bool isListening() const;
+    QString serverName() const;
+    QString errorString() const;
+    int clientCount() const { return m_clients.size(); }
+
+    static constexpr int FRAME_MS = 16;
+    static constexpr qint64 MAX_BUFFERED_BYTES = 4 * 1024 * 1024;
+    static constexpr qint64 RESUME_BYTES = 256 * 1024;
+
+signals:
+    void clientCountChanged(int count);
+
+private slots:
+    void onNewConnection();
+    void flush();
+
+private:
+    struct Client {
+        QLocalSocket *socket;
+        quint32 sequence = 0;
+        bool needsSnapshot = true;  // Skipped a frame (or new): next frame is a snapshot
+        qint64 queuedBytes = 0;     // Written to the socket so far
+        qint64 sentBytes = 0;       // Of those, sent on
+        qint64 snapshotEnd = 0;     // queuedBytes right after the latest snapshot
+        qint64 snapshotSize = 0;
+    };
+
+    void markChanged(int entityId);
+    void markRemoved(int entityId);
+    void markReset();
+    void scheduleFlush();
+
+    QByteArray encodeSnapshot() const;
+    QByteArray encodeDelta() const;
+    bool send(Client &client, quint8 type, const QByteArray &body, quint64 editTimeUs);
+    void sendSnapshot(Client &client);
+    static qint64 backlog(const Client &client);  // Unsent bytes, minus what is left of the latest snapshot
+    void onBytesWritten(QLocalSocket *socket, qint64 bytes);
+    void removeClient(QLocalSocket *socket);
+    static quint64 nowUs();
+
+    Canvas *m_canvas;
+    QLocalServer *m_server;
+    QList<Client> m_clients;
+    
+    // Pending since the last frame
+    QSet<int> m_changedIds;
+    QSet<int> m_removedIds;
+    bool m_resetPending;
+    quint64 m_firstEditUs;  // Oldest pending edit, 0 if none
+    QTimer m_frameTimer;
+};
+
+#endif // LIVELINKSERVER_H
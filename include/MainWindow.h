@@ -2,12 +2,22 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QUndoStack> 
+#include "EntitySearchIndex.h"
 
 class QDockWidget;
 class QListWidget;
+class QLineEdit;
+class QLabel;
 class Canvas;
 class InspectorPanel;
+class LayerPanel;
+class MinimapWidget;
+class UndoHistory;
+class SceneLoader;
+class SceneWatcher;
+class LiveLinkServer;
+class QProgressBar;
+class QPushButton;
 
 class MainWindow : public QMainWindow
 {
@@ -23,27 +33,82 @@ private slots:
     
     // Slots to update the list when entities change
     void onEntityAdded(int index);
-    void onEntityRemoved(int index);
+    void onEntityRemoved(int index, int entityId);
+    void onEntityChanged(int index);
     void onEntitySelectionChanged(int index);
+    void onEntitiesAppended(int first, int count);
+    void onSceneReset();
+    
+    // Object list search
+    void onObjectSearchChanged();
+    void onObjectSearchAccepted();  // Enter: jump to the first hit
+    
+    // Progressive scene loading
+    void onLoadProgress(int loaded, int total);
+    void onLoadFinished(bool success);
+    void onLoadCanceled();
+    
+    // Hot reload of the scene file when another program rewrites it
+    void onSceneFileChanged();
+    void onSceneReloadFailed();
+    
+    // Live link to a running game
+    void toggleLiveLink(bool enabled);
+    void onLiveLinkClientsChanged(int count);
 
     // File menu actions
     void onSaveScene();
+    void onSaveSceneAs();
     void onLoadScene();   
+    void toggleJournaledSaves();
+    void toggleCompressedSaves();
+    void onOpenWorld();
+    void onExportWorld();
+    void onExportRuntime();
+    void onCompareWithScene();
+    void onClearComparison();
        
     // View menu actions
     void toggleGridVisibility();
     void toggleSnapToGrid();
+    void onReportOverlaps();
 
 private:
     void setupObjectListPanel();
     void updateObjectList();
+    void indexEntity(int index);
+    bool isFilteringObjects() const;
+    void applyObjectFilter();  // Show only the entities matching the search box
+    void selectEntityId(int entityId);
+    void restoreUndoActions();  // Re-enable undo/redo once a background load ends
+    bool saveSceneTo(const QString &filePath);
     
     Canvas *m_canvas;
     QDockWidget *m_objectListDock;
     QListWidget *m_objectListWidget;
+    QLineEdit *m_objectSearchEdit;
+    QLabel *m_objectSearchStatus;
+    EntitySearchIndex m_searchIndex;  // Labels of all entities in memory
     InspectorPanel *m_inspectorPanel;  
     QDockWidget *m_inspectorDock;     
-    QUndoStack *m_undoStack; 
+    LayerPanel *m_layerPanel;
+    QDockWidget *m_layerDock;
+    MinimapWidget *m_minimap;
+    QDockWidget *m_minimapDock;
+    UndoHistory *m_undoStack; 
+    QAction *m_undoAction;  // Disabled while a scene loads in the background
+    QAction *m_redoAction;
+    
+    SceneLoader *m_sceneLoader;
+    QProgressBar *m_loadProgressBar;   // Shown in the status bar while loading
+    QPushButton *m_cancelLoadButton;
+    SceneWatcher *m_sceneWatcher;      // Watches m_currentFilePath
+    LiveLinkServer *m_liveLink;        // Streams edits to running games while enabled
+    
+    QString m_currentFilePath;  // Scene file last saved/loaded ("" if none)
+    bool m_journaledSaves;      // Save appends edits to a journal instead of rewriting
+    
+    static constexpr int MAX_SEARCH_RESULTS = 1000;  // Rows shown for a search
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
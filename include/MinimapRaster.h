@@ -0,0 +1,73 @@
+#ifndef MINIMAPRASTER_H
+#define MINIMAPRASTER_H
+
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+#include <vector>
+#include "Entity.h"
+#include "LayerStack.h"
+
+// Downsampled image of the entities for the minimap.
+//
+// The covered scene area is split into square cells of cellSize() scene
+// pixels, one image pixel each. Every cell keeps the summed color and the
+// count of the entities overlapping it, and the raster remembers each
+// entity's footprint, so moving, recoloring or removing an entity only
+// subtracts its old contribution and adds the new one. Only cells touched
+// since the last image() call are re-rasterized.
+//
+// The grid grows (doubling the cell size past MAX_CELLS cells per side)
+// when an entity lands outside it; that, and rebuild(), re-accumulate all
+// footprints.
+class MinimapRaster
+{
+public:
+    MinimapRaster();
+
+    // Entities on hidden layers are left out
+    void rebuild(const std::vector<Entity> &entities, const LayerStack &layers);
+    void clear();
+
+    void update(int entityId, const QRect &rect, const QColor &color);  // Add or change
+    void remove(int entityId);
+
+    bool isEmpty() const { return m_footprints.isEmpty(); }
+    QRect sceneRect() const;  // Area covered by image()
+    int cellSize() const { return m_cellSize; }
+
+    const QImage &image();  // Pixels of empty cells are transparent
+    bool hasChanges() const { return !m_dirty.isEmpty(); }
+
+    static constexpr int MIN_CELL_SIZE = 8;  // Scene pixels per image pixel, at least
+    static constexpr int MAX_CELLS = 512;    // Image edge, at most
+
+private:
+    struct Footprint {
+        QRect rect;
+        QRgb color;
+    };
+    struct Cell {
+        quint32 red = 0;
+        quint32 green = 0;
+        quint32 blue = 0;
+        quint32 count = 0;
+    };
+
+    QRect cellsOf(const QRect &sceneRect) const;  // Grid cells under a scene rect (clipped)
+    void accumulate(const Footprint &footprint, int sign);
+    void fit(const QRect &sceneRect);              // Grow the grid to cover a scene rect
+    void resize(const QRect &sceneRect);           // New grid over sceneRect, footprints re-added
+
+    QHash<int, Footprint> m_footprints;  // By entity id
+    int m_cellSize;
+    QPoint m_origin;     // Scene position of cell (0, 0)
+    QSize m_gridSize;    // In cells
+    std::vector<Cell> m_cells;
+    QImage m_image;
+    QRect m_dirty;       // Cells to re-rasterize
+};
+
+#endif // MINIMAPRASTER_H
@@ -0,0 +1,36 @@
+#ifndef MINIMAPWIDGET_H
+#define MINIMAPWIDGET_H
+
+#include <QWidget>
+
+class Canvas;
+
+// Overview of the whole scene: draws the canvas minimap raster scaled to
+// fit, with the visible area outlined. Clicking or dragging centers the
+// canvas view on that point.
+class MinimapWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MinimapWidget(QWidget *parent = nullptr);
+
+    void setCanvas(Canvas *canvas);
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    // Scene area shown and its placement in the widget (aspect ratio kept)
+    QRect shownSceneRect();
+    QRectF targetRect(const QRect &sceneRect) const;
+    void navigateTo(const QPoint &widgetPos);
+
+    Canvas *m_canvas;
+};
+
+#endif // MINIMAPWIDGET_H
@@ -1,29 +1,25 @@
 #ifndef MOVEENTITYCOMMAND_H
 #define MOVEENTITYCOMMAND_H
 
-#include <QUndoCommand>
+#include "EditorCommand.h"
 #include <QPoint>
 
 class Canvas;
 
-class MoveEntityCommand : public QUndoCommand
+class MoveEntityCommand : public EditorCommand
 {
 public:
     MoveEntityCommand(Canvas *canvas, int entityIndex, const QPoint &oldPos, const QPoint &newPos, QUndoCommand *parent = nullptr);
     
     void undo() override;
     void redo() override;
-    
-    // Update the new position (called while dragging)
-    void setNewPosition(const QPoint &newPos);
 
 private:
     Canvas *m_canvas;
-    int m_entityIndex;
+    int m_entityId;
+    int m_entityIndex;  // Last known index, used as a lookup hint
     QPoint m_oldPos;
     QPoint m_newPos;
-
-    friend class Canvas;  // Allow Canvas to access m_oldPos
 };
 
 #endif // MOVEENTITYCOMMAND_H
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef MOVEGROUPCOMMAND_H
+#define MOVEGROUPCOMMAND_H
+
+#include "EditorCommand.h"
+#include <QPoint>
+
+class Canvas;
+
+// Moves a group, with everything nested in it, by a fixed offset
+class MoveGroupCommand : public EditorCommand
+{
+public:
+    MoveGroupCommand(Canvas *canvas, int groupId, const QPoint &delta, QUndoCommand *parent = nullptr);
+    
+    void undo() override;
+    void redo() override;
+
+private:
+    Canvas *m_canvas;
+    int m_groupId;
+    QPoint m_delta;
+};
+
+#endif // MOVEGROUPCOMMAND_H
@@ -0,0 +1,143 @@
+#ifndef NAMEPOOL_H
+#define NAMEPOOL_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QJsonArray>
+#include <QReadWriteLock>
+#include <QAtomicInt>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+// Compact handle to an entity name (4 bytes instead of a QString per entity).
+// Literal refs index an interned string. Pattern refs (high bit set) index an
+// interned pattern like "Entity_%1" that is expanded with the owning entity's id,
+// so generated default names are never materialized.
+using NameRef = quint32;
+
+class PooledName;
+
+// Literal names are reference counted (see PooledName) and freed once no
+// entity, prefab or name table holds them; their slots are reused. Patterns
+// are few and stay interned. Reading a name takes no lock: strings live in
+// fixed chunks that never move.
+class NamePool
+{
+public:
+    static NamePool &instance();
+
+    static constexpr NameRef PATTERN_BIT = 0x80000000u;
+    static constexpr NameRef EMPTY = 0;  // The empty name, always interned
+    static bool isPattern(NameRef ref) { return (ref & PATTERN_BIT) != 0; }
+
+    // Intern a literal name; the returned handle holds a reference
+    PooledName intern(const QString &name);
+    // Intern a "%1" pattern (never freed)
+    NameRef internPattern(const QString &pattern);
+
+    // Handle of the default "Entity_%1" pattern
+    NameRef defaultPattern();
+
+    // Reference counting of literal names (no-ops for patterns and EMPTY)
+    void retain(NameRef ref);
+    void release(NameRef ref);
+
+    // Expand a handle back to the display string for entity `id`
+    QString resolve(NameRef ref, int id) const;
+
+    // Raw interned string behind a handle (the pattern text for pattern refs)
+    QString text(NameRef ref) const;
+
+    int size() const;  // Live strings, patterns included
+
+private:
+    struct Entry {
+        QString text;
+        QAtomicInt refs;
+    };
+
+    static constexpr int CHUNK_BITS = 12;
+    static constexpr quint32 CHUNK_SIZE = 1u << CHUNK_BITS;
+    static constexpr int MAX_CHUNKS = 1 << 14;  // 64M strings
+
+    NamePool();
+    quint32 allocate(const QString &str);  // Caller holds the write lock
+    Entry &entry(quint32 index) const
+    {
+        return m_chunks[index >> CHUNK_BITS].load(std::memory_order_acquire)[index & (CHUNK_SIZE - 1)];
+    }
+
+    mutable QReadWriteLock m_lock;
+    QHash<QString, quint32> m_lookup;          // literal -> index
+    QHash<QString, quint32> m_patternLookup;   // pattern -> index
+    std::atomic<Entry *> m_chunks[MAX_CHUNKS];
+    quint32 m_used = 0;                        // Slots handed out so far
+    std::vector<quint32> m_free;               // Released literal slots
+    NameRef m_defaultPattern = 0;
+    bool m_hasDefaultPattern = false;
+};
+
+// Owning handle to a pooled name: copies retain it, destruction releases it.
+// Converts to and from NameRef, so it can be stored wherever a NameRef was.
+class PooledName
+{
+public:
+    PooledName() : m_ref(NamePool::EMPTY) {}
+    PooledName(NameRef ref) : m_ref(ref) { NamePool::instance().retain(m_ref); }
+    PooledName(const PooledName &other) : PooledName(other.m_ref) {}
+    PooledName(PooledName &&other) noexcept : m_ref(other.m_ref) { other.m_ref = NamePool::EMPTY; }
+    ~PooledName() { NamePool::instance().release(m_ref); }
+
+    PooledName &operator=(const PooledName &other)
+    {
+        PooledName copy(other);
+        std::swap(m_ref, copy.m_ref);
+        return *this;
+    }
+    PooledName &operator=(PooledName &&other) noexcept
+    {
+        std::swap(m_ref, other.m_ref);
+        return *this;
+    }
+
+    operator NameRef() const { return m_ref; }
+
+private:
+    friend class NamePool;
+    struct Adopt {};
+    PooledName(NameRef ref, Adopt) : m_ref(ref) {}  // Takes over a reference
+
+    NameRef m_ref;
+};
+
+// Per-file name table so each distinct name is written to a scene file once.
+// Entities then refer to names by index into the table.
+class NameTable
+{
+public:
+    NameTable() = default;
+
+    // Writing: index of the ref's string in the table (added on first use)
+    int indexOf(NameRef ref);
+    QJsonArray toJson() const;
+
+    // Reading: build from a file's "names" array and map indices back to refs
+    static NameTable fromJson(const QJsonArray &array);
+    bool isValidIndex(int index) const { return index >= 0 && index < m_strings.size(); }
+    NameRef literalRef(int index) const;
+    NameRef patternRef(int index) const;
+
+private:
+    // A pattern-bit value, so unresolved slots hold no reference
+    static constexpr NameRef UNRESOLVED = 0xFFFFFFFFu;
+
+    QHash<NameRef, int> m_indexByRef;  // ref -> table index
+    QStringList m_strings;
+    mutable QVector<PooledName> m_literalRefs;  // lazily resolved refs per table slot (held while loading)
+    mutable QVector<NameRef> m_patternRefs;
+};
+
+#endif // NAMEPOOL_H
@@ -0,0 +1,70 @@
+#ifndef OVERLAPDETECTOR_H
+#define OVERLAPDETECTOR_H
+
+#include <QHash>
+#include <QRect>
+#include <QSet>
+#include <utility>
+#include <vector>
+#include "Entity.h"
+
+// Finds every pair of entities whose rectangles intersect, using a uniform
+// grid of CELL_SIZE cells (a spatial hash keyed by cell).
+//
+// Each box is listed in every cell it touches. A pair is reported only by the
+// cell holding the top-left corner of the two boxes' intersection, so a full
+// rebuild sweeps cells independently (on a thread pool for large scenes)
+// without duplicates. Adding, moving or removing an entity touches only the
+// cells under its old and new rects. Boxes spanning more than
+// MAX_CELLS_PER_BOX cells are kept in a separate list and tested against
+// everything instead.
+class OverlapDetector
+{
+public:
+    OverlapDetector();
+
+    // threadCount: 0 = one per core, 1 = sequential, N = at most N threads
+    void rebuild(const std::vector<Entity> &entities, int threadCount = 0);
+    void clear();
+
+    // Incremental maintenance (entity added, moved or resized / removed)
+    void update(int entityId, const QRect &rect);
+    void remove(int entityId);
+
+    int pairCount() const { return m_pairCount; }
+    bool isOverlapping(int entityId) const { return m_neighbors.contains(entityId); }
+    QSet<int> overlapsOf(int entityId) const { return m_neighbors.value(entityId); }
+
+    // All intersecting pairs as (smaller id, larger id), sorted
+    std::vector<std::pair<int, int>> pairs() const;
+
+    static constexpr int CELL_SHIFT = 8;
+    static constexpr int CELL_SIZE = 1 << CELL_SHIFT;  // Scene pixels per cell side
+    static constexpr int MAX_CELLS_PER_BOX = 64;
+    static constexpr int PARALLEL_THRESHOLD = 20000;   // Entities before rebuild() goes parallel
+
+private:
+    struct Box {
+        QRect rect;
+        int id;
+    };
+    using Cell = std::vector<Box>;
+
+    // Arithmetic shift: floor division, also for negative coordinates
+    static int cellOf(int coordinate) { return coordinate >> CELL_SHIFT; }
+    static quint64 cellKey(int cx, int cy) { return (quint64(quint32(cx)) << 32) | quint32(cy); }
+    static bool isLarge(const QRect &rect);
+    static bool ownsPair(const QRect &a, const QRect &b, int cx, int cy);
+
+    void insertBox(const Box &box);
+    void removeBox(const Box &box);
+    void addPair(int a, int b);
+
+    QHash<quint64, Cell> m_cells;        // Cell -> boxes touching it
+    std::vector<Box> m_large;            // Boxes too big for the grid
+    QHash<int, QRect> m_rects;           // Entity id -> rect currently indexed
+    QHash<int, QSet<int>> m_neighbors;   // Entity id -> ids it overlaps (only overlapping ids present)
+    int m_pairCount;
+};
+
+#endif // OVERLAPDETECTOR_H
@@ -0,0 +1,33 @@
+#ifndef PASTECOMMAND_H
+#define PASTECOMMAND_H
+
+#include "EditorCommand.h"
+#include "ComponentStore.h"
+#include "Entity.h"
+#include <QHash>
+#include <vector>
+
+class Canvas;
+
+// Pastes a set of entities (ids already assigned, consecutive) as one
+// batched insert; undo removes the id range in one pass. Component types
+// the scene lacked are defined first and removed again on undo.
+class PasteCommand : public EditorCommand
+{
+public:
+    PasteCommand(Canvas *canvas, std::vector<Entity> &&entities,
+                 const std::vector<ComponentType> &types = {},
+                 QHash<int, ComponentStore::Values> &&components = {},  // By entity id
+                 QUndoCommand *parent = nullptr);
+    
+    void undo() override;
+    void redo() override;
+
+private:
+    Canvas *m_canvas;
+    std::vector<Entity> m_entities;
+    std::vector<ComponentType> m_types;  // Ids reserved when the paste was made
+    QHash<int, ComponentStore::Values> m_components;
+};
+
+#endif // PASTECOMMAND_H
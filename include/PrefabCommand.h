@@ -0,0 +1,35 @@
+#ifndef PREFABCOMMAND_H
+#define PREFABCOMMAND_H
+
+#include "EditorCommand.h"
+#include "Entity.h"
+#include "PrefabLibrary.h"
+#include <QString>
+#include <vector>
+
+class Canvas;
+
+// One prefab action (make, revert, apply, update): the prefab and the
+// instances the action edited directly, before and after. A prefab with id -1
+// did not exist on that side (make prefab). Other instances follow the
+// restored prefab.
+class PrefabCommand : public EditorCommand
+{
+public:
+    PrefabCommand(Canvas *canvas, int prefabId, const Prefab &before, const Prefab &after,
+                  std::vector<Entity> &&entitiesBefore, std::vector<Entity> &&entitiesAfter, const QString &text,
+                  QUndoCommand *parent = nullptr);
+    
+    void undo() override;
+    void redo() override;
+
+private:
+    Canvas *m_canvas;
+    int m_prefabId;
+    Prefab m_before;
+    Prefab m_after;
+    std::vector<Entity> m_entitiesBefore;
+    std::vector<Entity> m_entitiesAfter;  // Same ids, same order
+};
+
+#endif // PREFABCOMMAND_H
@@ -0,0 +1,58 @@
+#ifndef PREFABLIBRARY_H
+#define PREFABLIBRARY_H
+
+#include <QColor>
+#include <QHash>
+#include <QJsonArray>
+#include <QList>
+#include <QSize>
+#include <vector>
+#include "Entity.h"
+#include "NamePool.h"
+
+// Shared template for prefab instances. Instances keep only the prefab id
+// and which fields they override; the rest comes from here.
+struct Prefab
+{
+    int id = -1;
+    PooledName nameRef;  // May be a pattern ("Tree_%1"), expanded per instance
+    QColor color;
+    QSize size;
+};
+
+// The prefabs of one scene. Stored once per file ("prefabs" array), so file
+// size scales with unique content rather than with the number of instances.
+class PrefabLibrary
+{
+public:
+    PrefabLibrary() = default;
+
+    // Adds the prefab under a new id (prefab.id is ignored) and returns it
+    int add(const Prefab &prefab);
+    bool update(const Prefab &prefab);  // Replace an existing prefab (same id)
+    void insert(const Prefab &prefab);  // Add or replace under prefab.id (undo/redo)
+    bool remove(int id);
+    void clear();
+
+    const Prefab *find(int id) const;
+    bool isEmpty() const { return m_prefabs.isEmpty(); }
+    int size() const { return m_prefabs.size(); }
+    QList<Prefab> prefabs() const;  // Sorted by id
+
+    // Add prefabs whose ids are not known yet (e.g. from a loaded chunk)
+    void merge(const PrefabLibrary &other);
+
+    // Refresh the non-overridden fields of every instance in one pass.
+    // Returns the number of instances touched.
+    int resolve(std::vector<Entity> *entities) const;
+    int resolve(std::vector<Entity> *entities, int prefabId) const;  // Instances of one prefab
+
+    QJsonArray toJson() const;
+    static PrefabLibrary fromJson(const QJsonArray &array);
+
+private:
+    QHash<int, Prefab> m_prefabs;
+    int m_nextId = 1;
+};
+
+#endif // PREFABLIBRARY_H
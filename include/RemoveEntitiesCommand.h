@@ -0,0 +1,33 @@
+#ifndef REMOVEENTITIESCOMMAND_H
+#define REMOVEENTITIESCOMMAND_H
+
+#include "EditorCommand.h"
+#include "Entity.h"
+#include "ComponentStore.h"
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <utility>
+#include <vector>
+
+class Canvas;
+
+// Removes a set of entities (cut, multi-selection delete) in one pass.
+// Undo puts each back at the index it was removed from, with its components.
+class RemoveEntitiesCommand : public EditorCommand
+{
+public:
+    RemoveEntitiesCommand(Canvas *canvas, const QSet<int> &entityIds, const QString &text,
+                          QUndoCommand *parent = nullptr);
+    
+    void undo() override;
+    void redo() override;
+
+private:
+    Canvas *m_canvas;
+    QSet<int> m_entityIds;
+    std::vector<std::pair<int, Entity>> m_removed;  // (index, entity) as taken by the last redo
+    QHash<int, ComponentStore::Values> m_components;  // Of the removed entities that had any, by id
+};
+
+#endif // REMOVEENTITIESCOMMAND_H
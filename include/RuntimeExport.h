@@ -0,0 +1,33 @@
+#ifndef RUNTIMEEXPORT_H
+#define RUNTIMEEXPORT_H
+
+#include <QByteArray>
+#include <QString>
+#include <vector>
+#include "Entity.h"
+
+// Writes scenes in the runtime format the game reads without parsing (see
+// RuntimeScene.h for the layout and the reader).
+//
+// Names are resolved (pattern names expanded) and stored once each. The
+// blob holds the entity fields only; components are not exported.
+// tests/RuntimeExportTest checks that every field round-trips through
+// RuntimeScene.
+class RuntimeExport
+{
+public:
+    static QByteArray build(const std::vector<Entity> &entities);
+
+    // Compare a blob with the entities it should hold; the first difference goes to `error` (tests)
+    static bool verify(const QByteArray &blob, const std::vector<Entity> &entities, QString *error = nullptr);
+
+    // build(), then write the file atomically
+    static bool save(const QString &filePath, const std::vector<Entity> &entities, QString *error = nullptr);
+
+    // One RuntimeScene::ENTITY_SIZE record; `nameField` goes to E_NAME (also used by LiveLinkServer)
+    static void writeEntity(const Entity &entity, quint32 nameField, uchar *record);
+
+    static constexpr int ALIGNMENT = 8;  // Section alignment
+};
+
+#endif // RUNTIMEEXPORT_H
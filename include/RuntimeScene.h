@@ -0,0 +1,177 @@
+#ifndef RUNTIMESCENE_H
+#define RUNTIMESCENE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Reader for runtime scene blobs (see RuntimeExport), meant to be copied
+// into the game as is: plain C++17, no Qt, no allocation.
+//
+// The blob is used in place, e.g. straight from an mmap()ed file: open()
+// validates the header and the name table once, after which every access is
+// an offset computation plus a little-endian load. Nothing is parsed or
+// copied; names are views into the blob (also NUL-terminated).
+//
+// Layout (all integers little-endian, offsets from the start of the blob,
+// sections 8-byte aligned):
+//
+//   Header       32 bytes   magic "QLRT", version, counts and section offsets
+//   Entities     ENTITY_SIZE bytes each, in draw order
+//   Name offsets (nameCount + 1) x u32, relative to the string data
+//   String data  UTF-8 names, each followed by a NUL
+class RuntimeScene
+{
+public:
+    static constexpr uint32_t MAGIC = 0x54524C51u;  // "QLRT"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr uint32_t HEADER_SIZE = 32;
+    static constexpr uint32_t ENTITY_SIZE = 44;
+    static constexpr uint32_t NO_NAME = 0xFFFFFFFFu;
+
+    // Header fields
+    enum HeaderOffset : uint32_t {
+        H_MAGIC = 0,            // u32
+        H_VERSION = 4,          // u16
+        H_ENTITY_SIZE = 6,      // u16, lets newer writers append fields
+        H_ENTITY_COUNT = 8,     // u32
+        H_ENTITIES = 12,        // u32 offset
+        H_NAME_COUNT = 16,      // u32
+        H_NAME_OFFSETS = 20,    // u32 offset
+        H_STRINGS = 24,         // u32 offset
+        H_TOTAL_SIZE = 28       // u32
+    };
+
+    // Entity record fields
+    enum EntityOffset : uint32_t {
+        E_ID = 0,               // i32
+        E_X = 4,                // i32, top-left corner
+        E_Y = 8,                // i32
+        E_WIDTH = 12,           // i32
+        E_HEIGHT = 16,          // i32
+        E_COLOR = 20,           // u32, 0xAARRGGBB
+        E_NAME = 24,            // u32 name index, NO_NAME if unnamed
+        E_PREFAB = 28,          // i32, -1 if not an instance
+        E_LAYER = 32,           // i32
+        E_GROUP = 36,           // i32, 0 if ungrouped
+        E_OVERRIDES = 40        // u8 override bits, then 3 bytes padding
+    };
+
+    // One entity record, valid as long as the blob is
+    class EntityView
+    {
+    public:
+        int32_t id() const { return readI32(m_record + E_ID); }
+        int32_t x() const { return readI32(m_record + E_X); }
+        int32_t y() const { return readI32(m_record + E_Y); }
+        int32_t width() const { return readI32(m_record + E_WIDTH); }
+        int32_t height() const { return readI32(m_record + E_HEIGHT); }
+        uint32_t color() const { return readU32(m_record + E_COLOR); }
+        uint32_t nameIndex() const { return readU32(m_record + E_NAME); }
+        std::string_view name() const { return m_scene->name(nameIndex()); }
+        int32_t prefabId() const { return readI32(m_record + E_PREFAB); }
+        int32_t layerId() const { return readI32(m_record + E_LAYER); }
+        int32_t groupId() const { return readI32(m_record + E_GROUP); }
+        uint8_t overrides() const { return m_record[E_OVERRIDES]; }
+
+    private:
+        friend class RuntimeScene;
+        EntityView(const RuntimeScene *scene, const unsigned char *record)
+            : m_scene(scene)
+            , m_record(record)
+        {
+        }
+
+        const RuntimeScene *m_scene;
+        const unsigned char *m_record;
+    };
+
+    RuntimeScene() = default;
+
+    // Check the blob and point the reader at it; false (and empty) if malformed
+    bool open(const void *data, size_t size)
+    {
+        *this = RuntimeScene();
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        if (!bytes || size < HEADER_SIZE || readU32(bytes + H_MAGIC) != MAGIC ||
+            readU16(bytes + H_VERSION) != VERSION || readU16(bytes + H_ENTITY_SIZE) < ENTITY_SIZE ||
+            readU32(bytes + H_TOTAL_SIZE) > size) {
+            return false;
+        }
+        
+        uint64_t limit = readU32(bytes + H_TOTAL_SIZE);
+        uint32_t entitySize = readU16(bytes + H_ENTITY_SIZE);
+        uint32_t entityCount = readU32(bytes + H_ENTITY_COUNT);
+        uint32_t entities = readU32(bytes + H_ENTITIES);
+        uint32_t nameCount = readU32(bytes + H_NAME_COUNT);
+        uint32_t nameOffsets = readU32(bytes + H_NAME_OFFSETS);
+        uint32_t strings = readU32(bytes + H_STRINGS);
+        if (entities < HEADER_SIZE || uint64_t(entities) + uint64_t(entityCount) * entitySize > limit ||
+            nameOffsets < HEADER_SIZE || uint64_t(nameOffsets) + (uint64_t(nameCount) + 1) * 4 > limit ||
+            strings < HEADER_SIZE || strings > limit) {
+            return false;
+        }
+        
+        // Name offsets must ascend, stay inside the string data and leave room for each NUL
+        uint64_t stringBytes = limit - strings;
+        uint32_t previous = 0;
+        for (uint32_t i = 0; i <= nameCount; ++i) {
+            uint32_t offset = readU32(bytes + nameOffsets + uint64_t(i) * 4);
+            if (offset < previous || offset > stringBytes || (i > 0 && offset == previous) ||
+                (i == 0 && offset != 0) || (i > 0 && bytes[strings + offset - 1] != 0)) {
+                return false;
+            }
+            previous = offset;
+        }
+        
+        m_data = bytes;
+        m_entitySize = entitySize;
+        m_entityCount = entityCount;
+        m_entities = entities;
+        m_nameCount = nameCount;
+        m_nameOffsets = nameOffsets;
+        m_strings = strings;
+        return true;
+    }
+
+    bool isOpen() const { return m_data != nullptr; }
+    uint32_t entityCount() const { return m_entityCount; }
+    uint32_t nameCount() const { return m_nameCount; }
+
+    // No bounds check beyond open(): index must be < entityCount()
+    EntityView entity(uint32_t index) const
+    {
+        return EntityView(this, m_data + m_entities + uint64_t(index) * m_entitySize);
+    }
+
+    // Empty for NO_NAME and out-of-range indices
+    std::string_view name(uint32_t index) const
+    {
+        if (index >= m_nameCount) {
+            return std::string_view();
+        }
+        const unsigned char *offsets = m_data + m_nameOffsets + uint64_t(index) * 4;
+        uint32_t begin = readU32(offsets);
+        uint32_t end = readU32(offsets + 4) - 1;  // Without the NUL
+        return std::string_view(reinterpret_cast<const char *>(m_data + m_strings + begin), end - begin);
+    }
+
+    // Little-endian loads (compile to plain loads on little-endian targets)
+    static uint16_t readU16(const unsigned char *p) { return uint16_t(p[0] | (p[1] << 8)); }
+    static uint32_t readU32(const unsigned char *p)
+    {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+    static int32_t readI32(const unsigned char *p) { return static_cast<int32_t>(readU32(p)); }
+
+private:
+    const unsigned char *m_data = nullptr;
+    uint32_t m_entitySize = 0;
+    uint32_t m_entityCount = 0;
+    uint32_t m_entities = 0;
+    uint32_t m_nameCount = 0;
+    uint32_t m_nameOffsets = 0;
+    uint32_t m_strings = 0;
+};
+
+#endif // RUNTIMESCENE_H
@@ -0,0 +1,85 @@
+#ifndef SCENECODEC_H
+#define SCENECODEC_H
+
+#include <QByteArray>
+#include <QIODevice>
+
+// Block-framed compression for scene files.
+//
+// A compressed file starts with the magic bytes "QLEZ", a format version and
+// three reserved bytes, followed by zlib blocks of at most BLOCK_SIZE raw
+// bytes (each prefixed by its packed size) and a zero-size terminator.
+// Writer and Reader are QIODevices that compress and decompress one block at
+// a time, so scene files stream through them without either side holding the
+// whole file. Reader checks for the magic bytes, so plain files pass through
+// unchanged.
+class SceneCodec
+{
+public:
+    enum class Compression {
+        None,
+        Zlib
+    };
+
+    static constexpr int BLOCK_SIZE = 256 * 1024;  // Raw bytes per block
+    static constexpr int DEFAULT_LEVEL = 6;        // zlib level (1 = fastest, 9 = smallest)
+    static constexpr char FORMAT_VERSION = 1;
+
+    // Compressing output device: buffers writes and emits a block to `device`
+    // every BLOCK_SIZE bytes. Opens itself write-only.
+    class Writer : public QIODevice
+    {
+    public:
+        explicit Writer(QIODevice *device, int level = DEFAULT_LEVEL);
+
+        bool isSequential() const override { return true; }
+        bool finish();  // Flush the last block and write the terminator
+
+    protected:
+        qint64 readData(char *, qint64) override { return -1; }
+        qint64 writeData(const char *data, qint64 size) override;
+
+    private:
+        bool writeBlock();
+
+        QIODevice *m_device;
+        int m_level;
+        QByteArray m_buffer;
+        bool m_headerWritten;
+        bool m_ok;
+    };
+
+    // Decompressing input device over `device`, one block at a time. Data
+    // without the magic bytes passes through unchanged. read() returns -1 on
+    // a corrupt or truncated stream. Opens itself read-only.
+    class Reader : public QIODevice
+    {
+    public:
+        explicit Reader(QIODevice *device);
+
+        bool isSequential() const override { return true; }
+
+    protected:
+        qint64 readData(char *data, qint64 maxSize) override;
+        qint64 writeData(const char *, qint64) override { return -1; }
+
+    private:
+        bool readBlock();
+
+        QIODevice *m_device;
+        QByteArray m_block;     // Current decompressed block
+        qsizetype m_blockPos;   // Bytes of m_block already handed out
+        bool m_started;         // Header checked
+        bool m_compressed;
+        bool m_finished;        // Terminator seen
+    };
+
+    // True if the data (at least the first 4 bytes of a file) is a compressed stream
+    static bool isCompressed(const QByteArray &head);
+
+    // Whole-buffer conveniences
+    static QByteArray compress(const QByteArray &data, int level = DEFAULT_LEVEL);
+    static bool decompress(const QByteArray &data, QByteArray *out);
+};
+
+#endif // SCENECODEC_H
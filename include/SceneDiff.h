@@ -0,0 +1,83 @@
+#ifndef SCENEDIFF_H
+#define SCENEDIFF_H
+
+#include <QString>
+#include <vector>
+#include "Entity.h"
+#include "SceneFile.h"
+
+// Structural comparison of scenes, keyed by entity id.
+//
+// diff() indexes one scene's ids in a hash table and walks the other, so it
+// runs in time linear in the entity count regardless of how the entities
+// were reordered. merge() combines two edited copies of a common base field
+// by field: a field edited on one side only takes that side's value, and a
+// field edited differently on both sides is a conflict that keeps ours.
+// Entities added on both sides under the same id (both branches handed out
+// the same next id) are kept, with theirs renumbered. Components count as
+// one field, compared by type name when both sides' stores are given.
+class SceneDiff
+{
+public:
+    enum Field : quint8 {
+        Name = 0x01,
+        Position = 0x02,
+        Size = 0x04,
+        Color = 0x08,
+        Layer = 0x10,
+        Group = 0x20,
+        Prefab = 0x40,
+        Components = 0x80
+    };
+
+    struct Change {
+        int entityId;
+        quint8 fields;  // Field bits that differ
+    };
+
+    struct Result {
+        std::vector<int> added;       // Ids only in the other scene, in its order
+        std::vector<int> removed;     // Ids only in the base scene, in its order
+        std::vector<Change> changed;  // In the other scene's order
+
+        bool isEmpty() const { return added.empty() && removed.empty() && changed.empty(); }
+        QString summary() const;  // "3 added, 1 removed, 2 changed"
+    };
+
+    struct Conflict {
+        enum Kind {
+            BothChanged,     // Same fields edited differently (ours kept)
+            ChangedRemoved,  // Ours edited it, theirs removed it (kept)
+            RemovedChanged   // Ours removed it, theirs edited it (theirs kept)
+        };
+        Kind kind;
+        int entityId;
+        quint8 fields;  // Conflicting fields (BothChanged) or fields edited on the kept side
+        QString message;
+    };
+
+    struct MergeResult {
+        SceneData scene;
+        std::vector<Conflict> conflicts;
+        int renumbered = 0;  // Entities theirs added under an id ours also added
+    };
+
+    static Result diff(const std::vector<Entity> &base, const std::vector<Entity> &other,
+                       const ComponentStore *baseComponents = nullptr, const ComponentStore *otherComponents = nullptr);
+
+    // Field bits in which two versions of an entity differ (0 if equal);
+    // Components only when both stores are given
+    static quint8 changedFields(const Entity &a, const Entity &b, const ComponentStore *aComponents = nullptr,
+                                const ComponentStore *bComponents = nullptr);
+    static bool componentsDiffer(const ComponentStore &a, int aId, const ComponentStore &b, int bId);
+    static QString fieldNames(quint8 fields);  // "position, color"
+
+    // Entity order follows ours, with entities only theirs added at the end.
+    // Layers and prefabs theirs added are merged in, renumbered when ours
+    // added a different one under the same id; a prefab only theirs edited
+    // takes theirs' definition. Component types theirs added are defined
+    // too. Groups and tiles are ours.
+    static MergeResult merge(const SceneData &base, const SceneData &ours, const SceneData &theirs);
+};
+
+#endif // SCENEDIFF_H
@@ -0,0 +1,98 @@
+#ifndef SCENEFILE_H
+#define SCENEFILE_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <QJsonDocument>
+#include <vector>
+#include "Entity.h"
+#include "PrefabLibrary.h"
+#include "TileLayer.h"
+#include "LayerStack.h"
+#include "GroupTree.h"
+#include "ComponentStore.h"
+#include "SceneCodec.h"
+
+// In-memory form of a scene file, independent of any widget
+struct SceneData
+{
+    std::vector<Entity> entities;
+    int nextEntityId = 1;
+    qint64 journalSeq = 0;  // Last journal record folded into this file (see SceneJournal)
+    PrefabLibrary prefabs;  // Templates referenced by prefab instances
+    TileLayer tiles;        // Run-length encoded tile layer ("tiles")
+    LayerStack layers;      // Entity layers, bottom to top ("layers")
+    GroupTree groups;       // Entity groups and their nesting ("groups")
+    ComponentStore components;  // Component types and values ("components")
+};
+
+// What SceneFile writes, by pointer, so callers that keep the parts of a
+// scene apart (Canvas, the journal) needn't copy them into a SceneData.
+// Null parts are left out of the file.
+struct SceneParts
+{
+    SceneParts(const std::vector<Entity> &entities, int nextEntityId, qint64 journalSeq = 0)
+        : entities(&entities)
+        , nextEntityId(nextEntityId)
+        , journalSeq(journalSeq)
+    {
+    }
+    SceneParts(const SceneData &scene)  // All of it
+        : entities(&scene.entities)
+        , nextEntityId(scene.nextEntityId)
+        , journalSeq(scene.journalSeq)
+        , prefabs(&scene.prefabs)
+        , tiles(&scene.tiles)
+        , layers(&scene.layers)
+        , groups(&scene.groups)
+        , components(&scene.components)
+    {
+    }
+
+    const std::vector<Entity> *entities;
+    int nextEntityId;
+    qint64 journalSeq;
+    const PrefabLibrary *prefabs = nullptr;
+    const TileLayer *tiles = nullptr;
+    const LayerStack *layers = nullptr;
+    const GroupTree *groups = nullptr;
+    const ComponentStore *components = nullptr;
+};
+
+// Reading and writing of the JSON scene format.
+//
+// Scenes are streamed: write() emits the name table first and then one entity
+// at a time, and read() splits the document as bytes arrive and converts
+// entities in batches of about LOAD_BATCH_SIZE bytes, so neither side builds
+// a QJsonDocument of the whole scene.
+class SceneFile
+{
+public:
+    static bool write(QIODevice *device, const SceneParts &scene,
+                      QJsonDocument::JsonFormat format = QJsonDocument::Indented);
+    // Batches are converted on a thread pool.
+    // threadCount: 0 = one per core, 1 = always sequential, N = at most N threads
+    static bool read(QIODevice *device, SceneData *scene, int threadCount = 0);
+
+    // Whole-buffer conveniences
+    static QByteArray toJson(const SceneParts &scene, QJsonDocument::JsonFormat format = QJsonDocument::Indented);
+
+    static bool fromJson(const QByteArray &data, SceneData *scene, int threadCount = 0);
+
+    // save() replaces the file atomically, so a crash never leaves a half-written level.
+    // Compressed files hold compact JSON; load() detects them by their magic bytes.
+    // Scenes with prefab instances must pass their prefab library; an empty
+    // or missing tile layer, a lone default layer, an empty group tree and a
+    // component store without types are left out of the file.
+    static bool save(const QString &filePath, const SceneParts &scene,
+                     SceneCodec::Compression compression = SceneCodec::Compression::None);
+    static bool load(const QString &filePath, SceneData *scene, int threadCount = 0);
+    
+    // How an existing file is stored (None if it can't be read)
+    static SceneCodec::Compression compressionOf(const QString &filePath);
+
+    static constexpr qsizetype LOAD_BATCH_SIZE = 256 * 1024;  // Entity JSON bytes per batch
+};
+
+#endif // SCENEFILE_H
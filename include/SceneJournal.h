@@ -0,0 +1,131 @@
+#ifndef SCENEJOURNAL_H
+#define SCENEJOURNAL_H
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QFutureWatcher>
+#include <vector>
+#include "Entity.h"
+#include "SceneCodec.h"
+#include "PrefabLibrary.h"
+#include "TileLayer.h"
+#include "LayerStack.h"
+#include "GroupTree.h"
+#include "ComponentStore.h"
+
+struct SceneData;
+
+// Append-only journal next to a scene file ("level.json.journal").
+//
+// Each journaled save appends one JSON line holding only the entities that
+// were added/changed or removed since the previous save, so saving costs
+// time proportional to the edit rather than the scene. Records carry an
+// increasing sequence number; the base file stores the last sequence it
+// already contains ("journal_seq"), and loading replays newer records on top
+// of it. A torn last line (crash mid-write) is ignored and trimmed.
+//
+// Once the journal grows large it is compacted in the background: a snapshot
+// is written as the new base file, then records it covers are dropped.
+class SceneJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SceneJournal(QObject *parent = nullptr);
+    ~SceneJournal() override;
+
+    static QString journalPathFor(const QString &scenePath);
+    static bool discard(const QString &scenePath);  // Remove a stale journal file
+
+    // Prefabs written with every record and base file (owned by Canvas)
+    void setPrefabLibrary(const PrefabLibrary *prefabs) { m_prefabs = prefabs; }
+    
+    // Tile layer written to base files; records carry only the edited chunks
+    void setTileLayer(const TileLayer *tiles) { m_tiles = tiles; }
+    
+    // Layer stack written with base files and with records once it has been edited
+    void setLayerStack(const LayerStack *layers) { m_layers = layers; }
+    
+    // Same for the group tree
+    void setGroupTree(const GroupTree *groups) { m_groups = groups; }
+    
+    // Component types go with every record once defined; values only for the
+    // changed entities (a component edit marks its entity changed)
+    void setComponentStore(const ComponentStore *components) { m_components = components; }
+    
+    // Change tracking, fed by Canvas for every edit
+    void markChanged(int entityId);
+    void markRemoved(int entityId);
+    void markPrefabsChanged() { m_prefabsChanged = true; }
+    void markTileChunksChanged(const QSet<QPoint> &chunks) { m_changedTileChunks.unite(chunks); }
+    void markLayersChanged() { m_layersChanged = true; }
+    void markGroupsChanged() { m_groupsChanged = true; }
+    void markComponentTypesChanged() { m_componentTypesChanged = true; }
+    bool isPending(int entityId) const { return m_changedIds.contains(entityId) || m_removedIds.contains(entityId); }
+    bool hasPendingChanges() const
+    {
+        return !m_changedIds.isEmpty() || !m_removedIds.isEmpty() || m_prefabsChanged ||
+               !m_changedTileChunks.isEmpty() || m_layersChanged || m_groupsChanged || m_componentTypesChanged;
+    }
+    void clearPending();
+
+    bool isAttachedTo(const QString &scenePath) const;
+    void detach();
+
+    // Write a full base file with an empty journal and attach to it
+    bool checkpoint(const QString &scenePath, const std::vector<Entity> &entities, int nextEntityId,
+                    SceneCodec::Compression compression = SceneCodec::Compression::None);
+
+    // Append pending changes as one record (requires an attached scene)
+    bool appendChanges(const std::vector<Entity> &entities, int nextEntityId);
+
+    // Apply journal records newer than the base file, then attach to the scene
+    bool replay(const QString &scenePath, SceneData *scene);
+    
+    // Same without attaching or touching the journal: a torn tail is skipped,
+    // not trimmed. The scene's journalSeq becomes the last applied record.
+    static bool replayReadOnly(const QString &scenePath, SceneData *scene);
+
+    // Kick off background compaction if the journal has grown past its budget
+    void compactIfNeeded(const std::vector<Entity> &entities, int nextEntityId);
+    void waitForCompaction();
+
+    static constexpr int MAX_RECORDS = 256;                  // Records before compaction
+    static constexpr qint64 MIN_COMPACT_BYTES = 256 * 1024;  // Journal size floor before compaction
+
+signals:
+    void compactionFinished(bool success);
+
+private slots:
+    void onCompactionFinished();
+
+private:
+    void finishCompaction();  // Drop records now covered by the compacted base file
+
+    QString m_scenePath;   // Attached scene ("" when detached)
+    qint64 m_seq;          // Sequence number of the last written record
+    int m_records;         // Records currently in the journal
+    qint64 m_journalBytes;
+    qint64 m_baseBytes;
+    SceneCodec::Compression m_compression;  // How the base file is stored
+
+    QSet<int> m_changedIds;
+    QSet<int> m_removedIds;
+    bool m_prefabsChanged;
+    const PrefabLibrary *m_prefabs;
+    QSet<QPoint> m_changedTileChunks;
+    const TileLayer *m_tiles;
+    bool m_layersChanged;
+    const LayerStack *m_layers;
+    bool m_groupsChanged;
+    const GroupTree *m_groups;
+    bool m_componentTypesChanged;
+    const ComponentStore *m_components;
+
+    QFutureWatcher<bool> *m_compactionWatcher;
+    QString m_compactingPath;
+    qint64 m_compactingSeq;  // Sequence covered by the running compaction, -1 if none
+};
+
+#endif // SCENEJOURNAL_H
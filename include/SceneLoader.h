@@ -0,0 +1,76 @@
+#ifndef SCENELOADER_H
+#define SCENELOADER_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <memory>
+#include <vector>
+#include "SceneFile.h"
+#include "SceneValidator.h"
+
+class Canvas;
+
+// Loads a scene without blocking the UI.
+// The file is parsed, its journal applied and the result validated on a
+// worker thread; the entities are then streamed into
+// the canvas in time-sliced batches on the GUI thread, starting with those
+// inside the current view, so the visible part of the level appears first
+// and the user can pan/select while the rest arrives. Once everything has
+// arrived the canvas switches to the file's draw order.
+class SceneLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SceneLoader(Canvas *canvas, QObject *parent = nullptr);
+
+    bool isLoading() const { return m_state != Idle; }
+    QString filePath() const { return m_filePath; }
+    
+    // Checks run on the last loaded scene (after journal replay)
+    const SceneValidator::Report &validationReport() const { return m_validation; }
+
+    static constexpr int BATCH_BUDGET_MS = 8;  // GUI time spent per batch
+    static constexpr int BATCH_SIZE = 2048;    // Entities handed to the canvas at a time
+
+public slots:
+    void load(const QString &filePath);
+    void cancel();
+
+signals:
+    void started();
+    void progressChanged(int loaded, int total);  // total is 0 while parsing
+    void finished(bool success);
+    void canceled();
+
+private slots:
+    void onParseFinished();
+    void streamNextBatch();
+
+private:
+    enum State { Idle, Parsing, Streaming };
+    
+    // What the worker hands back: the scene with its journal applied, and its checks
+    struct ParseResult
+    {
+        std::shared_ptr<SceneData> scene;
+        SceneValidator::Report validation;
+    };
+
+    Canvas *m_canvas;
+    State m_state;
+    QString m_filePath;
+    quint64 m_generation;  // Bumped on every load/cancel to drop stale parse results
+    quint64 m_parseGeneration;  // Generation of the parse in flight
+
+    QFutureWatcher<ParseResult> *m_parseWatcher;
+    std::shared_ptr<SceneData> m_scene;
+    std::vector<int> m_order;  // Indices into m_scene->entities, viewport first
+    size_t m_next;
+    SceneValidator::Report m_validation;
+    QTimer m_batchTimer;
+};
+
+#endif // SCENELOADER_H
@@ -0,0 +1,58 @@
+#ifndef SCENEVALIDATOR_H
+#define SCENEVALIDATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <vector>
+#include "Entity.h"
+
+struct SceneData;
+
+// One problem found in a scene
+struct ValidationIssue
+{
+    enum Kind {
+        InvalidId,        // Id <= 0
+        DuplicateId,      // Id shared with an earlier entity
+        NextIdTooSmall,   // next_entity_id would hand out an existing id (entityId: largest id)
+        NonPositiveSize,  // Width or height <= 0
+        InvalidColor,     // Color component outside 0-255
+        TimedOut          // Checks stopped at the time budget (entityId is -1)
+    };
+
+    Kind kind;
+    int entityId;
+    QString message;
+};
+
+// Consistency checks for scenes. Entity::fromJson accepts anything, so
+// scenes are checked on load and save and by "--batch validate".
+//
+// The entity store is split into chunks that are checked on a thread pool:
+// per-entity checks run inside each chunk, and each chunk also sorts its ids
+// so duplicates are found by merging the sorted runs. Chunks stop once the
+// time budget is used up; the report then covers the entities checked so far
+// and carries a TimedOut issue.
+class SceneValidator
+{
+public:
+    struct Report {
+        std::vector<ValidationIssue> issues;
+        int entityCount = 0;
+
+        bool isValid() const { return issues.empty(); }
+        QString summary(int maxIssues = 10) const;  // Human-readable, first few issues
+    };
+
+    // threadCount: 0 = one per core, 1 = sequential, N = at most N threads
+    // budgetMs: time after which checks stop, 0 = no limit
+    static Report validate(const std::vector<Entity> &entities, int nextEntityId, int threadCount = 0,
+                           int budgetMs = 0);
+    static Report validate(const SceneData &scene, int threadCount = 0, int budgetMs = 0);
+
+    static constexpr int PARALLEL_THRESHOLD = 50000;  // Entities before validation goes parallel
+    static constexpr int EDITOR_BUDGET_MS = 250;      // Load and save checks in the editor
+    static constexpr int DEADLINE_STRIDE = 4096;      // Entities checked between deadline polls
+};
+
+#endif // SCENEVALIDATOR_H
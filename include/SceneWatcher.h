@@ -0,0 +1,69 @@
+#ifndef SCENEWATCHER_H
+#define SCENEWATCHER_H
+
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <memory>
+#include "SceneFile.h"
+
+class QFileSystemWatcher;
+
+// Notices when another program rewrites the open scene file and parses the
+// new version on a worker thread (journal included, as a load would).
+//
+// Writers often replace a file in several steps (or atomically, through a
+// rename), so changes are handled once the file has been quiet for
+// SETTLE_MS. A change is only acted on when the file's size or modification
+// time differs from the last version seen; the editor's own saves are
+// registered with noteOwnWrite() so they don't come back as a reload.
+class SceneWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SceneWatcher(QObject *parent = nullptr);
+    ~SceneWatcher() override;
+
+    void watch(const QString &filePath);  // "" stops watching
+    QString filePath() const { return m_filePath; }
+    void noteOwnWrite();                  // The file on disk is what the editor has
+
+    // The scene parsed for the last sceneChanged() (null once taken)
+    std::shared_ptr<SceneData> takeScene() { return std::move(m_scene); }
+
+    static constexpr int SETTLE_MS = 150;
+
+signals:
+    void sceneChanged();  // A new version is parsed and ready (takeScene())
+    void reloadFailed();  // The new version couldn't be read
+
+private slots:
+    void onPathChanged();
+    void onSettled();
+    void onParseFinished();
+
+private:
+    struct Stamp {
+        QDateTime modified;
+        qint64 size = -1;
+        bool operator==(const Stamp &other) const { return modified == other.modified && size == other.size; }
+    };
+    static Stamp stampOf(const QString &filePath);
+    void rewatch();  // Re-add the file after it was replaced
+
+    QFileSystemWatcher *m_watcher;
+    QTimer m_settleTimer;
+    QString m_filePath;
+    Stamp m_known;          // Version the editor already has
+    quint64 m_generation;   // Bumped by watch() to drop results for another file
+    quint64 m_parseGeneration;
+    bool m_parsing;
+    bool m_changedWhileParsing;
+    QFutureWatcher<std::shared_ptr<SceneData>> *m_parseWatcher;
+    std::shared_ptr<SceneData> m_scene;
+};
+
+#endif // SCENEWATCHER_H
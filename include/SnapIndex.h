@@ -0,0 +1,56 @@
+#ifndef SNAPINDEX_H
+#define SNAPINDEX_H
+
+#include <QLine>
+#include <QRect>
+#include <QVector>
+#include <vector>
+#include "Entity.h"
+
+// Magnetic snapping to other entities' edges and centers.
+//
+// Built once when a drag starts: every entity contributes its left, center
+// and right x (and top, center and bottom y) to two sorted edge lists. Each
+// snap query is then a handful of binary searches, so dragging stays cheap
+// with very large scenes.
+class SnapIndex
+{
+public:
+    struct Result {
+        QPoint position;        // Adjusted top-left of the dragged rect
+        bool snappedX = false;
+        bool snappedY = false;
+        QVector<QLine> guides;  // Guide lines for the active snap targets (scene coordinates)
+    };
+
+    SnapIndex() = default;
+
+    // Index all entities except `excludedId` (the one being dragged)
+    void build(const std::vector<Entity> &entities, int excludedId);
+    void clear();
+    bool isEmpty() const { return m_xEdges.empty(); }
+
+    // Snap a rect of `size` whose top-left would be at `position`. Each axis
+    // snaps independently to the closest edge within `distance`.
+    Result snap(const QPoint &position, const QSize &size, int distance) const;
+
+    static constexpr int DEFAULT_SNAP_DISTANCE = 8;
+
+private:
+    struct Edge {
+        int coord;      // Edge position on this axis
+        int spanStart;  // Extent of the owning entity on the other axis (for guide lines)
+        int spanEnd;
+        bool operator<(const Edge &other) const { return coord < other.coord; }
+    };
+
+    // Closest edge to any of `features` within `distance`; returns its index
+    // and stores the offset to apply, or -1 if nothing is close enough
+    static int closest(const std::vector<Edge> &edges, const int *features, int featureCount,
+                       int distance, int *offset);
+
+    std::vector<Edge> m_xEdges;  // Vertical edges (left, center, right), sorted by x
+    std::vector<Edge> m_yEdges;  // Horizontal edges (top, center, bottom), sorted by y
+};
+
+#endif // SNAPINDEX_H
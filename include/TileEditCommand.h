@@ -0,0 +1,27 @@
+#ifndef TILEEDITCOMMAND_H
+#define TILEEDITCOMMAND_H
+
+#include "EditorCommand.h"
+#include "TileLayer.h"
+#include <QString>
+#include <vector>
+
+class Canvas;
+
+// One tile stroke, rectangle or fill. Stores only the cells it changed
+// (cell, old id, new id), so a fill over thousands of cells is one command.
+class TileEditCommand : public EditorCommand
+{
+public:
+    TileEditCommand(Canvas *canvas, std::vector<TileLayer::Change> &&changes, const QString &text,
+                    QUndoCommand *parent = nullptr);
+    
+    void undo() override;
+    void redo() override;
+
+private:
+    Canvas *m_canvas;
+    std::vector<TileLayer::Change> m_changes;
+};
+
+#endif // TILEEDITCOMMAND_H
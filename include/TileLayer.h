@@ -0,0 +1,114 @@
+#ifndef TILELAYER_H
+#define TILELAYER_H
+
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QPoint>
+#include <QRect>
+#include <QSet>
+#include <QVector>
+#include <vector>
+
+class QPainter;
+
+// Dense grid of tiles drawn underneath the entities.
+//
+// Cells are squares of tileSize() scene pixels, each holding a tile id
+// (0 = empty) that indexes the palette. Cells are stored in square
+// chunks of CHUNK_TILES x CHUNK_TILES ids, allocated on first paint and
+// dropped again once empty, so memory follows the painted area (2 bytes per
+// cell) rather than one Entity per tile. On disk each chunk is run-length
+// encoded, which makes large uniform areas nearly free.
+//
+// Every chunk caches an image with one pixel per cell; drawing scales the
+// visible chunk images up to the tile size, so the cost of a repaint depends
+// on the number of visible chunks rather than cells.
+class TileLayer
+{
+public:
+    using TileId = quint16;
+
+    // One edited cell, enough to undo or redo the edit
+    struct Change {
+        QPoint cell;
+        TileId before;
+        TileId after;
+    };
+
+    TileLayer();
+
+    // Saved with the scene and independent of the canvas grid; changing the
+    // size rescales the layer
+    void setTileSize(int size);
+    int tileSize() const { return m_tileSize; }
+
+    QPoint cellAt(const QPoint &scenePos) const;
+    QRect cellRect(const QPoint &cell) const;        // Scene rect of one cell
+    QRect cellsIn(const QRect &sceneRect) const;     // Cells covering a scene rect
+    static QPoint chunkOf(const QPoint &cell);
+
+    TileId tileAt(const QPoint &cell) const;
+
+    // Editing. Cells that actually change are appended to `changes` when given.
+    // Return the number of changed cells.
+    int setTile(const QPoint &cell, TileId id, std::vector<Change> *changes = nullptr);
+    int fillRect(const QRect &cells, TileId id, std::vector<Change> *changes = nullptr);
+    int paintLine(const QPoint &from, const QPoint &to, TileId id, std::vector<Change> *changes = nullptr);
+    // Fill the 4-connected region of equal tiles around `cell`, clipped to `bounds` (cells)
+    int floodFill(const QPoint &cell, TileId id, const QRect &bounds, std::vector<Change> *changes = nullptr);
+
+    // Replay recorded changes forwards (after) or backwards (before)
+    void apply(const std::vector<Change> &changes, bool undo);
+
+    void clear();
+    bool isEmpty() const { return m_chunks.isEmpty(); }
+    int chunkCount() const { return m_chunks.size(); }
+    qint64 filledCellCount() const;
+
+    // Palette: tile id N is drawn with palette()[N - 1]
+    const QVector<QColor> &palette() const { return m_palette; }
+    void setPalette(const QVector<QColor> &palette);
+    QColor tileColor(TileId id) const;
+    static QVector<QColor> defaultPalette();
+
+    // Blit the chunks intersecting `sceneRect` (painter in scene coordinates)
+    void draw(QPainter *painter, const QRect &sceneRect);
+
+    // Whole layer ("tiles" object of a scene file)
+    QJsonObject toJson() const;
+    static TileLayer fromJson(const QJsonObject &json);
+
+    // Selected chunks only (journal records); an empty chunk is written as an
+    // empty run list and removes the chunk when applied
+    QJsonArray chunksToJson(const QSet<QPoint> &chunks) const;
+    void applyChunksJson(const QJsonArray &chunks);
+
+    static constexpr int CHUNK_TILES = 32;   // Chunk edge in cells
+    static constexpr int DEFAULT_TILE_SIZE = 20;
+
+private:
+    struct Chunk {
+        std::vector<TileId> cells;  // CHUNK_TILES * CHUNK_TILES ids, row-major
+        int filled = 0;             // Non-empty cells
+        QImage image;               // One pixel per cell
+        bool imageStale = true;
+    };
+
+    static int localIndex(const QPoint &cell);
+    Chunk *chunkFor(const QPoint &chunk, bool create);
+    void releaseIfEmpty(const QPoint &chunk);
+    void rebuildImage(Chunk *chunk) const;
+
+    // Run-length encoding of one chunk: [count, id, count, id, ...]
+    static QJsonArray encodeRuns(const Chunk &chunk);
+    void decodeRuns(const QPoint &chunk, const QJsonArray &runs, int chunkTiles);
+
+    int m_tileSize;
+    QVector<QColor> m_palette;
+    QHash<QPoint, Chunk> m_chunks;
+};
+
+#endif // TILELAYER_H
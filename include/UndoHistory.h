@@ -0,0 +1,29 @@
+#ifndef UNDOHISTORY_H
+#define UNDOHISTORY_H
+
+#include <QUndoStack>
+#include <utility>
+#include "CommandArena.h"
+
+// Undo stack that owns the memory of its commands.
+// Use create<Command>(...) instead of `new Command(...)` so the command is
+// allocated from the history's arena and recycled when the stack trims it.
+class UndoHistory : public QUndoStack
+{
+public:
+    explicit UndoHistory(QObject *parent = nullptr);
+    ~UndoHistory() override;
+
+    template <typename Command, typename... Args>
+    Command *create(Args &&...args)
+    {
+        return new (&m_arena) Command(std::forward<Args>(args)...);
+    }
+
+    const CommandArena &arena() const { return m_arena; }
+
+private:
+    CommandArena m_arena;
+};
+
+#endif // UNDOHISTORY_H
@@ -0,0 +1,116 @@
+#ifndef WORLDSTREAMER_H
+#define WORLDSTREAMER_H
+
+#include <QObject>
+#include <QHash>
+#include <QPoint>
+#include <QRect>
+#include <QString>
+#include <QFutureWatcher>
+#include <memory>
+#include <vector>
+#include "Entity.h"
+
+class Canvas;
+class PrefabLibrary;
+class LayerStack;
+class GroupTree;
+struct SceneData;
+
+// Chunked world: a level split into square spatial chunks on disk.
+//
+// Layout: "level.world" is a JSON manifest (chunk size, next id, chunk list)
+// and "level.world.chunks/c_<x>_<y>.json" holds the entities whose top-left
+// corner lies in that chunk, in the normal scene format. Prefabs live in the
+// manifest and are copied into each chunk so chunk files stay self-contained.
+// Layers and groups live in the manifest only; entities carry their ids.
+//
+// While a world is open only chunks intersecting the view (plus a prefetch
+// margin) are loaded into the canvas, on a worker thread. When the resident
+// entity count exceeds the memory budget, clean chunks furthest from the
+// view are unloaded. Edits mark the chunks they touch dirty; dirty chunks
+// stay resident until the world is saved.
+class WorldStreamer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WorldStreamer(Canvas *canvas);
+    ~WorldStreamer() override;
+
+    // Partition a whole scene into a new world on disk
+    static bool exportWorld(const QString &manifestPath, const std::vector<Entity> &entities,
+                            int nextEntityId, int chunkSize = DEFAULT_CHUNK_SIZE,
+                            const PrefabLibrary *prefabs = nullptr, const LayerStack *layers = nullptr,
+                            const GroupTree *groups = nullptr);
+
+    bool open(const QString &manifestPath);
+    void close();
+    bool isOpen() const { return !m_manifestPath.isEmpty(); }
+    QString manifestPath() const { return m_manifestPath; }
+
+    // Write dirty chunks and the manifest
+    bool save();
+
+    void setMemoryBudget(int maxResidentEntities);
+    int residentChunkCount() const;
+    int residentEntityCount() const { return m_residentEntities; }
+    
+    // Load the chunk holding `scenePos` now, if it was evicted (undo/redo of
+    // an edit to one of its entities). False if the chunk can't be loaded.
+    bool ensureResident(const QPoint &scenePos);
+
+    // Edit tracking, fed by Canvas for every edit
+    void entityChanged(const Entity &entity);
+    void entityRemoved(const Entity &entity);
+
+    static constexpr int DEFAULT_CHUNK_SIZE = 1024;
+    static constexpr int DEFAULT_MEMORY_BUDGET = 250000;  // Resident entities
+
+signals:
+    void chunkLoaded(const QPoint &chunk);
+    void chunkEvicted(const QPoint &chunk);
+
+public slots:
+    // Load chunks near the view and evict far ones (connected to Canvas::viewChanged)
+    void updateResidency();
+
+private:
+    using LoadWatcher = QFutureWatcher<std::shared_ptr<SceneData>>;
+
+    struct ChunkState {
+        int diskCount = 0;      // Entities in the chunk file (from the manifest)
+        int residentCount = 0;  // Entities in memory assigned to this chunk
+        bool onDisk = false;
+        bool resident = false;
+        bool dirty = false;
+        quint64 lastUsed = 0;   // Residency tick when the view last needed it
+        LoadWatcher *loader = nullptr;
+    };
+
+    QPoint chunkOf(const QPoint &pos) const;
+    QRect wantedChunks() const;  // Chunk coordinates near the view
+    QString chunkPath(const QPoint &chunk) const;
+    static QString chunkPath(const QString &manifestPath, const QPoint &chunk);
+    static bool writeManifest(const QString &manifestPath, int chunkSize, int nextEntityId,
+                              const QHash<QPoint, int> &chunkCounts, const PrefabLibrary *prefabs,
+                              const LayerStack *layers, const GroupTree *groups);
+
+    void startLoad(const QPoint &chunk);
+    void finishLoad(const QPoint &chunk, LoadWatcher *watcher);
+    void waitForLoads();
+    void evictIfOverBudget();
+    void markDirty(const QPoint &chunk);
+
+    Canvas *m_canvas;
+    QString m_manifestPath;  // "" when no world is open
+    int m_chunkSize;
+    int m_memoryBudget;
+    quint64 m_tick;
+    int m_residentEntities;
+
+    QHash<QPoint, ChunkState> m_chunks;
+    QHash<int, QPoint> m_entityChunk;  // Resident entity id -> chunk it is stored in
+};
+
+#endif // WORLDSTREAMER_H
@@ -2,7 +2,7 @@
 #include "Canvas.h"
 
 AddEntityCommand::AddEntityCommand(Canvas *canvas, const QPoint &position, QUndoCommand *parent)
-    : QUndoCommand(parent)
+    : EditorCommand(parent)
     , m_canvas(canvas)
     , m_entity(-1, "Placeholder", QPoint(0, 0))  // Match declaration order
     , m_entityIndex(-1)
@@ -35,12 +35,19 @@ void AddEntityCommand::undo()
 {
     if (!m_canvas || m_entityIndex < 0) return;
     
-    // Store the entity before removing it
-    const Entity *entity = m_canvas->getEntity(m_entityIndex);
-    if (entity) {
-        m_entity = *entity;
+    // Look the entity up by id: indices shift as other entities are
+    // added, removed or streamed in and out of a world
+    int index = m_canvas->residentIndexOf(m_entity.id(), m_entity.position(), m_entityIndex);
+    if (index < 0) {
+        setObsolete(true);
+        m_canvas->reportCommandFailure(text());
+        return;
     }
     
+    // Store the entity before removing it
+    m_entity = *m_canvas->getEntity(index);
+    m_entityIndex = index;
+    
     // Remove the entity
     m_canvas->removeEntityAt(m_entityIndex);
 }
\ No newline at end of file
@@ -0,0 +1,429 @@
+#include "BatchProcessor.h"
+#include "RuntimeExport.h"
+#include "SceneDiff.h"
+#include "SceneFile.h"
+#include "SceneJournal.h"
+#include "SceneValidator.h"
+#include "WorldStreamer.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+// Load a scene the way the editor does: base file plus any journal records.
+// The journal is only read; commands that fold it in discard it afterwards.
+bool loadScene(const QString &path, SceneData *scene, int threadCount)
+{
+    return SceneFile::load(path, scene, threadCount) && SceneJournal::replayReadOnly(path, scene);
+}
+
+// Chunk files of an exported world ("level.world.chunks/c_0_0.json")
+bool isWorldChunk(const QString &path)
+{
+    return QFileInfo(path).dir().dirName().endsWith(".world.chunks");
+}
+
+} // namespace
+
+QString BatchProcessor::usage()
+{
+    return QStringLiteral(
+        "Usage: QtLevelEditorLite --batch <command> [options] <files or directories>...\n"
+        "\n"
+        "Commands:\n"
+        "  validate        Check scenes for duplicate ids, bad sizes/colors, etc.\n"
+        "  compact         Fold journals into their scene files, in place and in the\n"
+        "                  file's own format; scenes without a journal are left alone\n"
+        "  convert         Rewrite scenes in the current format (journals folded in)\n"
+        "  export-world    Write each scene as a chunked .world\n"
+        "  export-runtime  Write each scene as a .qlrt blob for the game (entity fields; no components)\n"
+        "  diff <base> <other>\n"
+        "                  List entities added, removed and changed (exit code 1 if any)\n"
+        "  merge <base> <ours> <theirs>\n"
+        "                  Three-way merge into <ours> (exit code 1 on conflicts)\n"
+        "\n"
+        "Options:\n"
+        "  --jobs N        Files processed at once (default: one per core)\n"
+        "  --output DIR    Write results into DIR instead of next to the input\n"
+        "                  (merge: the file to write instead of <ours>)\n"
+        "  --compress      convert: write compressed scenes\n"
+        "  --decompress    convert: write plain JSON scenes\n"
+        "  --chunk-size N  export-world: chunk size in pixels\n"
+        "  --budget MS     validate: time allowed per file, loading included\n"
+        "                  (default: 10000, 0 = no limit); files over it fail\n");
+}
+
+bool BatchProcessor::parseArguments(const QStringList &arguments, Options *options, QString *error)
+{
+    if (arguments.isEmpty()) {
+        *error = "No command given";
+        return false;
+    }
+    
+    QString command = arguments.first();
+    if (command == "validate") {
+        options->command = Command::Validate;
+    } else if (command == "compact") {
+        options->command = Command::Compact;
+    } else if (command == "convert") {
+        options->command = Command::Convert;
+    } else if (command == "export-world") {
+        options->command = Command::ExportWorld;
+    } else if (command == "export-runtime") {
+        options->command = Command::ExportRuntime;
+    } else if (command == "diff") {
+        options->command = Command::Diff;
+    } else if (command == "merge") {
+        options->command = Command::Merge;
+    } else {
+        *error = QString("Unknown command '%1'").arg(command);
+        return false;
+    }
+    
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString &arg = arguments[i];
+        bool hasValue = i + 1 < arguments.size();
+        bool ok = true;
+        if (arg == "--jobs" && hasValue) {
+            options->jobs = arguments[++i].toInt(&ok);
+            ok = ok && options->jobs > 0;
+        } else if (arg == "--output" && hasValue) {
+            options->outputDir = arguments[++i];
+        } else if (arg == "--chunk-size" && hasValue) {
+            options->chunkSize = arguments[++i].toInt(&ok);
+            ok = ok && options->chunkSize > 0;
+        } else if (arg == "--budget" && hasValue) {
+            options->budgetMs = arguments[++i].toInt(&ok);
+            ok = ok && options->budgetMs >= 0;
+        } else if (arg == "--compress") {
+            options->compress = true;
+        } else if (arg == "--decompress") {
+            options->decompress = true;
+        } else if (arg.startsWith("--")) {
+            *error = QString("Unknown or incomplete option '%1'").arg(arg);
+            return false;
+        } else {
+            options->inputs << arg;
+        }
+        if (!ok) {
+            *error = QString("Invalid value for '%1'").arg(arg);
+            return false;
+        }
+    }
+    
+    if (options->compress && options->decompress) {
+        *error = "--compress and --decompress are mutually exclusive";
+        return false;
+    }
+    if (options->inputs.isEmpty()) {
+        *error = "No input files or directories";
+        return false;
+    }
+    if (options->command == Command::Compact &&
+        (!options->outputDir.isEmpty() || options->compress || options->decompress)) {
+        *error = "compact rewrites scenes in place; --output, --compress and --decompress do not apply";
+        return false;
+    }
+    if (options->command == Command::Diff && options->inputs.size() != 2) {
+        *error = "diff takes two scene files: <base> <other>";
+        return false;
+    }
+    if (options->command == Command::Merge && options->inputs.size() != 3) {
+        *error = "merge takes three scene files: <base> <ours> <theirs>";
+        return false;
+    }
+    return true;
+}
+
+QList<BatchProcessor::Job> BatchProcessor::collectJobs(const Options &options)
+{
+    // Outputs mirror the input layout below --output (or replace the input)
+    auto outputFor = [&options](const QString &file, const QString &relative) {
+        QString path = options.outputDir.isEmpty() ? file : QDir(options.outputDir).filePath(relative);
+        if (options.command == Command::ExportWorld) {
+            path = QFileInfo(path).path() + "/" + QFileInfo(path).completeBaseName() + ".world";
+        } else if (options.command == Command::ExportRuntime) {
+            path = QFileInfo(path).path() + "/" + QFileInfo(path).completeBaseName() + ".qlrt";
+        }
+        return path;
+    };
+    
+    QList<Job> jobs;
+    for (const QString &input : options.inputs) {
+        QFileInfo info(input);
+        if (info.isDir()) {
+            QDir root(input);
+            QDirIterator it(input, QStringList() << "*.json", QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                QString file = it.next();
+                if (isWorldChunk(file)) {
+                    continue;  // Part of a world, not a scene of its own
+                }
+                jobs.append({ file, outputFor(file, root.relativeFilePath(file)) });
+            }
+        } else {
+            jobs.append({ input, outputFor(input, info.fileName()) });
+        }
+    }
+    std::sort(jobs.begin(), jobs.end(), [](const Job &a, const Job &b) { return a.inputPath < b.inputPath; });
+    return jobs;
+}
+
+BatchProcessor::FileResult BatchProcessor::processFile(const Options &options, const QString &inputPath,
+                                                       const QString &outputPath)
+{
+    FileResult result;
+    QElapsedTimer timer;
+    timer.start();
+    
+    // With several jobs the cores are already busy: parse each file sequentially
+    int threadCount = options.jobs == 1 ? 0 : 1;
+    
+    // Compacting a scene without a journal would only rewrite it
+    if (options.command == Command::Compact && !QFileInfo::exists(SceneJournal::journalPathFor(inputPath))) {
+        result.ok = true;
+        result.messages << "no journal";
+        result.elapsedMs = timer.elapsed();
+        return result;
+    }
+    
+    SceneData scene;
+    if (!loadScene(inputPath, &scene, threadCount)) {
+        result.messages << "cannot read scene";
+        result.elapsedMs = timer.elapsed();
+        return result;
+    }
+    result.entityCount = static_cast<int>(scene.entities.size());
+    
+    bool inPlace = QFileInfo(outputPath).absoluteFilePath() == QFileInfo(inputPath).absoluteFilePath();
+    if (options.command != Command::Validate && !inPlace && !QDir().mkpath(QFileInfo(outputPath).path())) {
+        result.messages << "cannot create output directory";
+        result.elapsedMs = timer.elapsed();
+        return result;
+    }
+    
+    switch (options.command) {
+    case Command::Validate: {
+        int remainingMs = options.budgetMs > 0 ? static_cast<int>(qMax<qint64>(1, options.budgetMs - timer.elapsed()))
+                                               : 0;
+        SceneValidator::Report report = SceneValidator::validate(scene, threadCount, remainingMs);
+        for (const ValidationIssue &issue : report.issues) {
+            result.messages << issue.message;
+        }
+        result.ok = report.isValid();
+        break;
+    }
+    case Command::Compact: {
+        // Same format as before. The base file records the last folded-in
+        // record, so a crash before the journal is removed replays nothing twice.
+        result.ok = SceneFile::save(inputPath, scene, SceneFile::compressionOf(inputPath)) &&
+                    SceneJournal::discard(inputPath);
+        if (!result.ok) {
+            result.messages << "cannot write " + inputPath;
+        }
+        break;
+    }
+    case Command::Convert: {
+        SceneCodec::Compression compression = SceneFile::compressionOf(inputPath);
+        if (options.compress) {
+            compression = SceneCodec::Compression::Zlib;
+        } else if (options.decompress) {
+            compression = SceneCodec::Compression::None;
+        }
+        // The journal is folded in, so the written file starts a fresh sequence
+        SceneParts converted(scene);
+        converted.journalSeq = 0;
+        result.ok = SceneFile::save(outputPath, converted, compression);
+        if (result.ok && inPlace) {
+            result.ok = SceneJournal::discard(inputPath);
+        }
+        if (!result.ok) {
+            result.messages << "cannot write " + outputPath;
+        }
+        break;
+    }
+    case Command::ExportRuntime: {
+        QString error;
+        result.ok = RuntimeExport::save(outputPath, scene.entities, &error);
+        if (!result.ok) {
+            result.messages << error;
+        } else if (scene.components.entityCount() > 0) {
+            result.messages << "components are not exported";
+        }
+        break;
+    }
+    case Command::Diff:
+    case Command::Merge:
+        result.messages << "not a per-file command";  // Handled by runDiff() / runMerge()
+        break;
+    case Command::ExportWorld: {
+        int chunkSize = options.chunkSize > 0 ? options.chunkSize : WorldStreamer::DEFAULT_CHUNK_SIZE;
+        result.ok = WorldStreamer::exportWorld(outputPath, scene.entities, scene.nextEntityId, chunkSize,
+                                               &scene.prefabs, &scene.layers, &scene.groups);
+        if (!result.ok) {
+            result.messages << "cannot write " + outputPath;
+            break;
+        }
+        if (!scene.tiles.isEmpty()) {
+            result.messages << "the tile layer is not exported";
+        }
+        if (scene.components.entityCount() > 0) {
+            result.messages << "components are not exported";
+        }
+        break;
+    }
+    }
+    
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
+
+int BatchProcessor::run(const QStringList &arguments, QTextStream &out)
+{
+    Options options;
+    QString error;
+    if (!parseArguments(arguments, &options, &error)) {
+        out << error << "\n\n" << usage();
+        out.flush();
+        return 2;
+    }
+    if (options.command == Command::Diff) {
+        return runDiff(options, out);
+    }
+    if (options.command == Command::Merge) {
+        return runMerge(options, out);
+    }
+    
+    QList<Job> jobs = collectJobs(options);
+    if (jobs.isEmpty()) {
+        out << "No scene files found\n";
+        out.flush();
+        return 1;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    // A dedicated pool caps how many scenes are in memory at once
+    QThreadPool pool;
+    pool.setMaxThreadCount(options.jobs > 0 ? options.jobs : QThread::idealThreadCount());
+    
+    std::function<FileResult(const Job &)> process = [options](const Job &job) {
+        return processFile(options, job.inputPath, job.outputPath);
+    };
+    QFuture<FileResult> future = QtConcurrent::mapped(&pool, jobs, process);
+    
+    // Report in input order as results become available
+    int failed = 0;
+    for (int i = 0; i < jobs.size(); ++i) {
+        FileResult result = future.resultAt(i);
+        if (!result.ok) {
+            ++failed;
+        }
+        out << (result.ok ? "ok    " : "FAIL  ") << jobs[i].inputPath
+            << "  (" << result.entityCount << " entities, " << result.elapsedMs << " ms)\n";
+        for (const QString &message : result.messages) {
+            out << "      " << message << "\n";
+        }
+        out.flush();
+    }
+    
+    out << jobs.size() << " file(s), " << failed << " failed, " << timer.elapsed() << " ms total with "
+        << pool.maxThreadCount() << " job(s)\n";
+    out.flush();
+    return failed == 0 ? 0 : 1;
+}
+
+int BatchProcessor::runDiff(const Options &options, QTextStream &out)
+{
+    QElapsedTimer timer;
+    timer.start();
+    
+    SceneData base;
+    SceneData other;
+    for (int i = 0; i < 2; ++i) {
+        if (!loadScene(options.inputs[i], i == 0 ? &base : &other, 0)) {
+            out << "FAIL  cannot read scene " << options.inputs[i] << "\n";
+            out.flush();
+            return 2;
+        }
+    }
+    
+    SceneDiff::Result diff = SceneDiff::diff(base.entities, other.entities, &base.components, &other.components);
+    
+    // One line per entity: "+" added, "-" removed, "~" changed (with the fields)
+    QHash<int, int> otherIndex;
+    otherIndex.reserve(static_cast<int>(other.entities.size()));
+    for (int i = 0; i < static_cast<int>(other.entities.size()); ++i) {
+        otherIndex.insert(other.entities[i].id(), i);
+    }
+    for (int id : diff.added) {
+        out << "+ " << id << "  " << other.entities[otherIndex.value(id)].name() << "\n";
+    }
+    if (!diff.removed.empty()) {
+        QSet<int> removed(diff.removed.begin(), diff.removed.end());
+        for (const Entity &entity : base.entities) {
+            if (removed.contains(entity.id())) {
+                out << "- " << entity.id() << "  " << entity.name() << "\n";
+            }
+        }
+    }
+    for (const SceneDiff::Change &change : diff.changed) {
+        out << "~ " << change.entityId << "  " << other.entities[otherIndex.value(change.entityId)].name()
+            << "  (" << SceneDiff::fieldNames(change.fields) << ")\n";
+    }
+    
+    out << diff.summary() << ", " << timer.elapsed() << " ms\n";
+    out.flush();
+    return diff.isEmpty() ? 0 : 1;
+}
+
+int BatchProcessor::runMerge(const Options &options, QTextStream &out)
+{
+    QElapsedTimer timer;
+    timer.start();
+    
+    SceneData scenes[3];  // base, ours, theirs
+    for (int i = 0; i < 3; ++i) {
+        if (!loadScene(options.inputs[i], &scenes[i], 0)) {
+            out << "FAIL  cannot read scene " << options.inputs[i] << "\n";
+            out.flush();
+            return 2;
+        }
+    }
+    
+    SceneDiff::MergeResult merge = SceneDiff::merge(scenes[0], scenes[1], scenes[2]);
+    
+    // Ours' journal is folded in, so the written file starts a fresh sequence
+    const QString &oursPath = options.inputs[1];
+    QString outputPath = options.outputDir.isEmpty() ? oursPath : options.outputDir;
+    bool inPlace = QFileInfo(outputPath).absoluteFilePath() == QFileInfo(oursPath).absoluteFilePath();
+    const SceneData &scene = merge.scene;
+    bool ok = SceneFile::save(outputPath, scene, SceneFile::compressionOf(oursPath));
+    if (ok && inPlace) {
+        ok = SceneJournal::discard(oursPath);
+    }
+    if (!ok) {
+        out << "FAIL  cannot write " << outputPath << "\n";
+        out.flush();
+        return 2;
+    }
+    
+    for (const SceneDiff::Conflict &conflict : merge.conflicts) {
+        out << "CONFLICT  " << conflict.message << "\n";
+    }
+    out << "Merged into " << outputPath << "  (" << scene.entities.size() << " entities, "
+        << merge.conflicts.size() << " conflict(s), " << merge.renumbered << " renumbered, "
+        << timer.elapsed() << " ms)\n";
+    out.flush();
+    return merge.conflicts.empty() ? 0 : 1;
+}
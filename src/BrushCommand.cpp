@@ -0,0 +1,35 @@
+#include "BrushCommand.h"
+#include "Canvas.h"
+
+BrushCommand::BrushCommand(Canvas *canvas, int firstId, std::vector<QPoint> &&positions, const QSize &size,
+                           const QColor &color, int layerId, std::vector<int> &&recolorIds, std::vector<QRgb> &&oldColors,
+                           std::vector<quint8> &&oldOverrides, const QString &text, QUndoCommand *parent)
+    : EditorCommand(parent)
+    , m_canvas(canvas)
+    , m_firstId(firstId)
+    , m_positions(std::move(positions))
+    , m_size(size)
+    , m_color(color.rgb())
+    , m_layerId(layerId)
+    , m_recolorIds(std::move(recolorIds))
+    , m_oldColors(std::move(oldColors))
+    , m_oldOverrides(std::move(oldOverrides))
+{
+    setText(text);
+}
+
+void BrushCommand::redo()
+{
+    if (!m_canvas) return;
+    
+    m_canvas->addEntityBlock(m_firstId, m_positions, m_size, QColor(m_color), m_layerId);
+    m_canvas->setEntityColors(m_recolorIds, {m_color});
+}
+
+void BrushCommand::undo()
+{
+    if (!m_canvas) return;
+    
+    m_canvas->setEntityColors(m_recolorIds, m_oldColors, &m_oldOverrides);
+    m_canvas->removeEntityBlock(m_firstId, static_cast<int>(m_positions.size()));
+}
@@ -2,13 +2,31 @@
 #include "AddEntityCommand.h"
 #include "DeleteEntityCommand.h"  
 #include "MoveEntityCommand.h" 
+#include "TileEditCommand.h"
+#include "BrushCommand.h"
+#include "MoveGroupCommand.h"
+#include "PasteCommand.h"
+#include "RemoveEntitiesCommand.h"
+#include "EditEntitiesCommand.h"
+#include "PrefabCommand.h"
+#include "GroupCommand.h"
+#include "ComponentCommand.h"
+#include "DefineComponentCommand.h"
+#include "EntityClipboard.h"
+#include "EntityBrush.h"
+#include "UndoHistory.h"
+#include "SceneFile.h"
+#include "SceneJournal.h"
+#include "RuntimeExport.h"
+#include "WorldStreamer.h"
+#include <QClipboard>
+#include <QCursor>
+#include <QGuiApplication>
 #include <QKeyEvent>
-#include <QJsonDocument>
-#include <QJsonArray>
-#include <QJsonObject>
-#include <QFile>
-#include <QTextStream>
-#include <QUndoStack>
+#include <QResizeEvent>
+#include <QWheelEvent>
+#include <algorithm>
+#include <iterator>
 
 Canvas::Canvas(QWidget *parent)
     : QWidget(parent)
@@ -16,11 +34,34 @@ Canvas::Canvas(QWidget *parent)
     , m_gridVisible(true)
     , m_gridSize(20)
     , m_snapToGrid(false)
+    , m_snapToEntities(false)
+    , m_showOverlaps(false)
+    , m_overlapsDirty(true)
+    , m_diffActive(false)
     , m_undoStack(nullptr)
-    , m_currentMoveCommand(nullptr)  // Initialize to nullptr
+    , m_journal(new SceneJournal(this))
+    , m_reloading(false)
+    , m_saveCompression(SceneCodec::Compression::None)
+    , m_world(new WorldStreamer(this))
+    , m_activeLayer(LayerStack::DEFAULT_LAYER)
+    , m_groupBvhDirty(true)
+    , m_minimapEnabled(false)
+    , m_minimapDirty(true)
+    , m_tool(Tool::Select)
+    , m_activeTile(1)
+    , m_isPaintingTiles(false)
+    , m_strokeTile(0)
+    , m_brushColor(QColor(100, 150, 255))
+    , m_isBrushing(false)
     , m_nextEntityId(1)
     , m_selectedEntityIndex(-1)
     , m_isDragging(false)
+    , m_dragGroupId(GroupTree::NO_GROUP)
+    , m_isMarquee(false)
+    , m_marqueeSelects(false)
+    , m_isPanning(false)
+    , m_streaming(false)
+    , m_streamBackupNextId(1)
 {
     // Enable mouse tracking for drag operations
     setMouseTracking(true);
@@ -30,6 +71,63 @@ Canvas::Canvas(QWidget *parent)
     
     // Set a minimum size
     setMinimumSize(400, 300);
+    
+    // Journal records carry the prefab definitions, layers and edited tile chunks
+    m_journal->setPrefabLibrary(&m_prefabs);
+    m_journal->setTileLayer(&m_tiles);
+    m_journal->setLayerStack(&m_layers);
+    m_journal->setGroupTree(&m_groups);
+    m_journal->setComponentStore(&m_components);
+    connect(m_journal, &SceneJournal::compactionFinished, this, &Canvas::journalCompacted);
+    
+    // Open worlds load and evict chunks as the view moves
+    connect(this, &Canvas::viewChanged, m_world, &WorldStreamer::updateResidency);
+    
+    // Resets invalidate the overlap index; appended batches and single edits
+    // update it in place
+    connect(this, &Canvas::sceneReset, this, [this]() { m_overlapsDirty = true; });
+    connect(this, &Canvas::entitiesAppended, this, [this](int first, int count) {
+        if (first == 0) {
+            m_overlapsDirty = true;  // Whole scene (re)installed
+        } else if (m_showOverlaps && !m_overlapsDirty) {
+            for (int i = first; i < first + count; ++i) {
+                m_overlaps.update(m_entities[i].id(), m_entities[i].rect());
+            }
+        }
+    });
+    
+    // Same for the layer caches (single edits invalidate only their layer)
+    connect(this, &Canvas::sceneReset, this, &Canvas::invalidateLayerCaches);
+    connect(this, &Canvas::entitiesAppended, this, &Canvas::invalidateLayerCaches);
+    
+    // The group hierarchy follows single edits and appended batches in place
+    // and is rebuilt on next use after whole-scene changes. Streamed batches
+    // (loader slices, world chunks) skip trackAdded, so they are inserted here.
+    connect(this, &Canvas::sceneReset, this, [this]() { m_groupBvhDirty = true; });
+    connect(this, &Canvas::entitiesAppended, this, [this](int first, int count) {
+        if (first == 0) {
+            m_groupBvhDirty = true;
+        } else if (!m_groupBvhDirty) {
+            for (int i = first; i < first + count; ++i) {
+                if (!m_groupBvh.update(m_entities[i].id(), m_entities[i].rect())) {
+                    m_groupBvh.insert(i, m_entities[i]);
+                }
+            }
+        }
+    });
+    
+    // The minimap is rebuilt after whole-scene changes; appended batches
+    // (streamed ones skip trackChanged) are added entity by entity
+    connect(this, &Canvas::sceneReset, this, [this]() { m_minimapDirty = true; });
+    connect(this, &Canvas::entitiesAppended, this, [this](int first, int count) {
+        if (first == 0) {
+            m_minimapDirty = true;
+            return;
+        }
+        for (int i = first; i < first + count; ++i) {
+            updateMinimapEntry(m_entities[i]);
+        }
+    });
 }
 
 void Canvas::paintEvent(QPaintEvent *event)
@@ -41,56 +139,324 @@ void Canvas::paintEvent(QPaintEvent *event)
     // Draw the background
     painter.fillRect(rect(), m_backgroundColor);
     
+    if (m_showOverlaps) {
+        ensureOverlapsCurrent();
+    }
+    ensureGroupBvhCurrent();
+    
+    // Everything below is drawn in scene coordinates
+    QRect visible = visibleSceneRect();
+    painter.translate(-m_viewOffset);
+    
+    // Tiles first: one cached image per visible chunk
+    m_tiles.draw(&painter, visible);
+    
     // Draw grid if visible
     if (m_gridVisible) {
         painter.setPen(QPen(QColor(220, 220, 220), 1));
-        for (int x = 0; x < width(); x += m_gridSize) {
-            painter.drawLine(x, 0, x, height());
+        int firstX = floorToGrid(visible.left());
+        int firstY = floorToGrid(visible.top());
+        for (int x = firstX; x <= visible.right(); x += m_gridSize) {
+            painter.drawLine(x, visible.top(), x, visible.bottom());
         }
-        for (int y = 0; y < height(); y += m_gridSize) {
-            painter.drawLine(0, y, width(), y);
+        for (int y = firstY; y <= visible.bottom(); y += m_gridSize) {
+            painter.drawLine(visible.left(), y, visible.right(), y);
         }
     }
     
-    // Draw all entities as rectangles
-    for (size_t i = 0; i < m_entities.size(); ++i) {
-        const Entity &entity = m_entities[i];
-        bool isSelected = (static_cast<int>(i) == m_selectedEntityIndex);
-        
-        // Set the brush (fill color) from entity's color
-        painter.setBrush(QBrush(entity.color()));
+    // Draw entities layer by layer, skipping those outside the view
+    // (margin covers the selection highlight and thick borders).
+    // Layers not being edited come from their cached image.
+    QRect cullRect = visible.adjusted(-4, -4, 4, 4);
+    const Entity *selected = getEntity(m_selectedEntityIndex);
+    bool draggingGroup = m_isDragging && m_dragGroupId != GroupTree::NO_GROUP;
+    int dragLayer = (m_isDragging && selected) ? m_layers.resolve(selected->layerId()) : -1;
+    for (const Layer &layer : m_layers.layers()) {
+        if (!layer.visible) {
+            continue;
+        }
+        if (layer.id == m_activeLayer || layer.id == dragLayer ||
+            (draggingGroup && m_dragGroupLayers.contains(layer.id))) {
+            drawLayer(painter, layer.id, cullRect);
+        } else {
+            drawCachedLayer(painter, layer.id, visible);
+        }
+    }
+    
+    // Mark entities that overlap another one
+    if (m_showOverlaps) {
+        painter.setPen(QPen(QColor(220, 0, 0), 2, Qt::DashLine));
+        painter.setBrush(QColor(220, 0, 0, 40));
+        std::vector<int> inView;
+        m_groupBvh.query(cullRect, &inView);
+        for (int index : inView) {
+            const Entity &entity = m_entities[index];
+            if (m_overlaps.isOverlapping(entity.id()) && m_layers.isVisible(entity.layerId())) {
+                painter.drawRect(entity.rect());
+            }
+        }
+    }
+    
+    // Rest of a multi-selection: the yellow highlight only
+    if (m_selectedIds.size() > 1) {
+        painter.setBrush(Qt::NoBrush);
+        painter.setPen(QPen(QColor(255, 200, 0), 2));
+        std::vector<int> inView;
+        m_groupBvh.query(cullRect, &inView);
+        for (int index : inView) {
+            const Entity &entity = m_entities[index];
+            if (index != m_selectedEntityIndex && m_selectedIds.contains(entity.id()) &&
+                m_layers.isVisible(entity.layerId())) {
+                QPoint offset = isInDraggedGroup(index) ? m_groupDragOffset : QPoint();
+                painter.drawRect(entity.rect().translated(offset).adjusted(-2, -2, 2, 2));
+            }
+        }
+    }
+    
+    // Differences from the scene being compared with
+    if (m_diffActive) {
+        drawComparison(painter, cullRect);
+    }
+    
+    // Selected entity: thicker border plus a yellow highlight, above all layers
+    if (selected && m_layers.isVisible(selected->layerId())) {
+        QPoint offset = isInDraggedGroup(m_selectedEntityIndex) ? m_groupDragOffset : QPoint();
+        painter.setBrush(Qt::NoBrush);
+        painter.setPen(QPen(selected->color().darker(120), 4));
+        painter.drawRect(selected->rect().translated(offset));
+        painter.setPen(QPen(QColor(255, 200, 0), 3));  // Yellow highlight
+        painter.drawRect(selected->rect().translated(offset).adjusted(-2, -2, 2, 2));  // Slightly larger
         
-        // Set the pen (border) - thicker and darker if selected
-        QColor borderColor = entity.color().darker(120);
-        int borderWidth = isSelected ? 4 : 2;
-        painter.setPen(QPen(borderColor, borderWidth));
+        // Dashed box around the group a drag would move
+        int group = m_groups.rootOf(selected->groupId());
+        if (group != GroupTree::NO_GROUP) {
+            QRect bounds = m_groupBvh.groupBounds(group);
+            if (draggingGroup && group == m_dragGroupId) {
+                bounds.translate(m_groupDragOffset);
+            }
+            painter.setPen(QPen(QColor(255, 200, 0), 1, Qt::DashLine));
+            painter.drawRect(bounds.adjusted(-6, -6, 6, 6));
+        }
+    }
+    
+    // Rectangle being dragged out with the group tool or to select
+    if (m_isMarquee) {
+        painter.setPen(QPen(QColor(40, 40, 40), 1, Qt::DashLine));
+        painter.setBrush(QColor(255, 200, 0, 40));
+        painter.drawRect(QRect(m_marqueeStart, m_marqueeEnd).normalized());
+    }
+    
+    // Outline of the tile rectangle being dragged out
+    if (m_isPaintingTiles && m_tool == Tool::RectTiles) {
+        QRect cells = QRect(m_strokeStartCell, m_strokeLastCell).normalized();
+        QRect area = m_tiles.cellRect(cells.topLeft()).united(m_tiles.cellRect(cells.bottomRight()));
+        QColor fill = m_strokeTile ? m_tiles.tileColor(m_strokeTile) : QColor(255, 255, 255);
+        fill.setAlpha(90);
+        painter.setPen(QPen(QColor(40, 40, 40), 1, Qt::DashLine));
+        painter.setBrush(fill);
+        painter.drawRect(area);
+    }
+    
+    // Cells covered by the entity brush stroke being dragged out
+    if (m_isBrushing) {
+        EntityBrush brush(m_entities, m_gridSize);
+        QColor fill = m_brushColor;
+        fill.setAlpha(90);
+        painter.setPen(QPen(m_brushColor.darker(150), 1, Qt::DashLine));
+        painter.setBrush(fill);
+        if (m_tool == Tool::LineBrush) {
+            for (const QPoint &cell : EntityBrush::lineCells(m_brushStartCell, m_brushLastCell)) {
+                painter.drawRect(brush.cellRect(cell));
+            }
+        } else {
+            QRect cells = QRect(m_brushStartCell, m_brushLastCell).normalized();
+            painter.drawRect(brush.cellRect(cells.topLeft()).united(brush.cellRect(cells.bottomRight())));
+        }
+    }
+    
+    // Draw snap guides on top of everything
+    if (!m_snapGuides.isEmpty()) {
+        painter.setPen(QPen(QColor(255, 0, 160), 1, Qt::DashLine));
+        painter.drawLines(m_snapGuides);
+    }
+    
+    // Edits since the last frame reach the minimap in one repaint
+    if (m_minimapEnabled && (m_minimapDirty || m_minimap.hasChanges())) {
+        emit minimapChanged();
+    }
+}
+
+void Canvas::drawEntity(QPainter &painter, const Entity &entity) const
+{
+    // Fill with the entity's color and a darker border
+    painter.setBrush(QBrush(entity.color()));
+    painter.setPen(QPen(entity.color().darker(120), 2));
+    painter.drawRect(entity.rect());
+    
+    // Draw the entity name as text
+    painter.setPen(QPen(Qt::black, 1));
+    NameRef ref = entity.nameRef();
+    if (!NamePool::isPattern(ref)) {
+        painter.drawText(entity.rect(), Qt::AlignCenter, NamePool::instance().text(ref));
+        return;
+    }
+    auto it = m_labelCache.find(entity.id());
+    if (it == m_labelCache.end() || it->ref != ref) {
+        if (m_labelCache.size() >= MAX_CACHED_LABELS) {
+            m_labelCache.clear();
+        }
+        it = m_labelCache.insert(entity.id(), {ref, entity.name()});
+    }
+    painter.drawText(entity.rect(), Qt::AlignCenter, it->text);
+}
+
+void Canvas::drawLayer(QPainter &painter, int layerId, const QRect &cullRect) const
+{
+    // The hierarchy skips groups outside the area without visiting their members
+    std::vector<int> inView;
+    m_groupBvh.query(cullRect, &inView);
+    for (int index : inView) {
+        const Entity &entity = m_entities[index];
+        if (m_layers.resolve(entity.layerId()) == layerId && !isInDraggedGroup(index)) {
+            drawEntity(painter, entity);
+        }
+    }
+    
+    // A group being dragged is drawn at its drag offset
+    if (m_isDragging && m_dragGroupId != GroupTree::NO_GROUP && m_dragGroupLayers.contains(layerId)) {
+        painter.save();
+        painter.translate(m_groupDragOffset);
+        QRect shifted = cullRect.translated(-m_groupDragOffset);
+        for (int index : m_dragGroupMembers) {
+            const Entity &entity = m_entities[index];
+            if (m_layers.resolve(entity.layerId()) == layerId && entity.rect().intersects(shifted)) {
+                drawEntity(painter, entity);
+            }
+        }
+        painter.restore();
+    }
+}
+
+void Canvas::drawCachedLayer(QPainter &painter, int layerId, const QRect &visible)
+{
+    LayerCache &cache = m_layerCaches[layerId];
+    if (!cache.valid || !cache.sceneRect.contains(visible)) {
+        // Render a margin around the view so small pans reuse the image
+        QRect area = visible.adjusted(-visible.width() / 4, -visible.height() / 4,
+                                      visible.width() / 4, visible.height() / 4);
+        qreal ratio = devicePixelRatioF();
+        cache.pixmap = QPixmap(area.size() * ratio);
+        cache.pixmap.setDevicePixelRatio(ratio);
+        cache.pixmap.fill(Qt::transparent);
         
-        // Draw the rectangle
-        painter.drawRect(entity.rect());
+        QPainter cachePainter(&cache.pixmap);
+        cachePainter.translate(-area.topLeft());
+        drawLayer(cachePainter, layerId, area.adjusted(-4, -4, 4, 4));
         
-        // Draw selection highlight (yellow border) for selected entity
-        if (isSelected) {
-            painter.setPen(QPen(QColor(255, 200, 0), 3));  // Yellow highlight
-            painter.setBrush(Qt::NoBrush);
-            painter.drawRect(entity.rect().adjusted(-2, -2, 2, 2));  // Slightly larger
+        cache.sceneRect = area;
+        cache.valid = true;
+    }
+    painter.drawPixmap(cache.sceneRect.topLeft(), cache.pixmap);
+}
+
+void Canvas::drawComparison(QPainter &painter, const QRect &cullRect) const
+{
+    QPen addedPen(QColor(0, 170, 60), 2);
+    QPen changedPen(QColor(255, 140, 0), 2);
+    QPen oldPlacePen(QColor(255, 140, 0), 1, Qt::DashLine);
+    painter.setBrush(Qt::NoBrush);
+    
+    std::vector<int> inView;
+    m_groupBvh.query(cullRect, &inView);
+    for (int index : inView) {
+        const Entity &entity = m_entities[index];
+        bool added = m_diffAdded.contains(entity.id());
+        if ((!added && !m_diffChanged.contains(entity.id())) || !m_layers.isVisible(entity.layerId())) {
+            continue;
         }
+        QPoint offset = isInDraggedGroup(index) ? m_groupDragOffset : QPoint();
+        painter.setPen(added ? addedPen : changedPen);
+        painter.drawRect(entity.rect().translated(offset).adjusted(-1, -1, 1, 1));
         
-        // Draw the entity name as text
-        painter.setPen(QPen(Qt::black, 1));
-        painter.drawText(entity.rect(), Qt::AlignCenter, entity.name());
+        // Moved or resized: also outline where it was
+        if (!added) {
+            const Entity &before = m_diffBase[m_diffBaseIndex.value(entity.id())];
+            if (before.rect() != entity.rect().translated(offset)) {
+                painter.setPen(oldPlacePen);
+                painter.drawRect(before.rect());
+            }
+        }
+    }
+    
+    // Removed entities, where they were in the base scene
+    painter.setPen(QPen(QColor(220, 0, 0), 1, Qt::DashLine));
+    painter.setBrush(QColor(220, 0, 0, 30));
+    for (int id : m_diffRemoved) {
+        QRect rect = m_diffBase[m_diffBaseIndex.value(id)].rect();
+        if (rect.intersects(cullRect)) {
+            painter.drawRect(rect);
+        }
     }
 }
 
-int Canvas::findEntityAt(const QPoint &pos) const
+int Canvas::findEntityAt(const QPoint &pos)
 {
-    // Check entities in reverse order (top to bottom visually)
-    // so entities drawn on top are selected first
-    for (int i = static_cast<int>(m_entities.size()) - 1; i >= 0; --i) {
-        if (m_entities[i].rect().contains(pos)) {
-            return i;
+    // Topmost hit: the highest layer wins, then the entity drawn last
+    // within it. Hidden and locked layers are skipped. Only entities the
+    // hierarchy finds under the point are tested.
+    ensureGroupBvhCurrent();
+    std::vector<int> candidates;
+    m_groupBvh.query(QRect(pos, QSize(1, 1)), &candidates);
+    
+    int found = -1;
+    int foundRank = -1;
+    for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+        int i = *it;
+        const Entity &entity = m_entities[i];
+        if (!entity.rect().contains(pos) || !m_layers.isEditable(entity.layerId())) {
+            continue;
         }
+        int rank = m_layers.rankOf(entity.layerId());
+        if (rank > foundRank) {
+            found = i;
+            foundRank = rank;
+        }
+    }
+    return found;  // -1 if no entity at this position
+}
+
+int Canvas::floorToGrid(int value) const
+{
+    // Floor division so grid lines line up for negative scene coordinates too
+    int cell = value / m_gridSize;
+    if (value < 0 && cell * m_gridSize != value) {
+        --cell;
+    }
+    return cell * m_gridSize;
+}
+
+QPoint Canvas::mapToScene(const QPoint &widgetPos) const
+{
+    return widgetPos + m_viewOffset;
+}
+
+QRect Canvas::visibleSceneRect() const
+{
+    return rect().translated(m_viewOffset);
+}
+
+void Canvas::setViewOffset(const QPoint &offset)
+{
+    if (m_viewOffset != offset) {
+        m_viewOffset = offset;
+        update();
+        emit viewChanged(visibleSceneRect());
     }
-    return -1;  // No entity at this position
+}
+
+void Canvas::centerOn(const QPoint &scenePos)
+{
+    setViewOffset(scenePos - rect().center());
 }
 
 QPoint Canvas::snapToGrid(const QPoint &point) const
@@ -108,30 +474,61 @@ QPoint Canvas::snapToGrid(const QPoint &point) const
 
 void Canvas::mouseMoveEvent(QMouseEvent *event)
 {
-    if (m_isDragging && m_selectedEntityIndex >= 0 && 
+    if (m_isPanning) {
+        // Dragging the view moves it opposite to the mouse
+        setViewOffset(m_panStartOffset - (event->pos() - m_panStartPos));
+    } else if (m_isPaintingTiles) {
+        continueTileEdit(mapToScene(event->pos()));
+    } else if (m_isBrushing) {
+        QPoint cell = EntityBrush(m_entities, m_gridSize).cellAt(mapToScene(event->pos()));
+        if (cell != m_brushLastCell) {
+            m_brushLastCell = cell;
+            update();  // Stroke preview
+        }
+    } else if (m_isMarquee) {
+        m_marqueeEnd = mapToScene(event->pos());
+        update();
+    } else if (m_isDragging && m_dragGroupId != GroupTree::NO_GROUP) {
+        // Only the drag offset changes; members move once, on release
+        QPoint topLeft = m_groupStartPos + (mapToScene(event->pos()) - m_dragStartPos);
+        if (m_snapToGrid) {
+            topLeft = snapToGrid(topLeft);
+        }
+        if (topLeft - m_groupStartPos != m_groupDragOffset) {
+            m_groupDragOffset = topLeft - m_groupStartPos;
+            update();
+        }
+    } else if (m_isDragging && m_selectedEntityIndex >= 0 && 
         m_selectedEntityIndex < static_cast<int>(m_entities.size())) {
         
         // Calculate how far the mouse has moved
-        QPoint delta = event->pos() - m_dragStartPos;
+        QPoint delta = mapToScene(event->pos()) - m_dragStartPos;
         
         // Update entity position
-        QPoint newPos = m_entityStartPos + delta;
+        QPoint rawPos = m_entityStartPos + delta;
+        QPoint newPos = rawPos;
         
         // Snap to grid if enabled
         if (m_snapToGrid) {
             newPos = snapToGrid(newPos);
         }
         
-        // Update entity position
-        m_entities[m_selectedEntityIndex].setPosition(newPos);
-        
-        // Update move command if it exists
-        if (m_currentMoveCommand) {
-            m_currentMoveCommand->setNewPosition(newPos);
+        // Entity edges win over the grid on the axes they snap
+        if (m_snapToEntities) {
+            QSize size = m_entities[m_selectedEntityIndex].rect().size();
+            SnapIndex::Result snap = m_snapIndex.snap(rawPos, size, SnapIndex::DEFAULT_SNAP_DISTANCE);
+            if (snap.snappedX) {
+                newPos.setX(snap.position.x());
+            }
+            if (snap.snappedY) {
+                newPos.setY(snap.position.y());
+            }
+            m_snapGuides = snap.guides;
         }
         
-        // Request a repaint to show the entity moving
-        update();
+        // Update entity position and repaint to show the entity moving
+        m_entities[m_selectedEntityIndex].setPosition(newPos);
+        notifyEntityChanged(m_selectedEntityIndex);
     }
     
     QWidget::mouseMoveEvent(event);
@@ -139,22 +536,61 @@ void Canvas::mouseMoveEvent(QMouseEvent *event)
 
 void Canvas::mouseReleaseEvent(QMouseEvent *event)
 {
-    if (event->button() == Qt::LeftButton) {
-        if (m_isDragging && m_currentMoveCommand) {
-            // Check if position actually changed
-            QPoint finalPos = m_entities[m_selectedEntityIndex].position();
-            if (finalPos != m_currentMoveCommand->m_oldPos) {
-                // Position changed - push command to undo stack
-                if (m_undoStack) {
-                    m_undoStack->push(m_currentMoveCommand);
-                }
+    if (event->button() == Qt::MiddleButton) {
+        m_isPanning = false;
+    } else if (m_isPaintingTiles) {
+        if (event->button() == Qt::LeftButton || event->button() == Qt::RightButton) {
+            finishTileEdit();
+        }
+    } else if (m_isBrushing) {
+        if (event->button() == Qt::LeftButton) {
+            finishBrush();
+        }
+    } else if (m_isMarquee) {
+        if (event->button() == Qt::LeftButton) {
+            m_isMarquee = false;
+            QRect area = QRect(m_marqueeStart, m_marqueeEnd).normalized();
+            if (m_marqueeSelects) {
+                selectEntitiesIn(area);
             } else {
-                // No change - discard command
-                delete m_currentMoveCommand;
+                groupEntitiesIn(area);
+            }
+            update();
+        }
+    } else if (event->button() == Qt::LeftButton && m_isDragging && m_dragGroupId != GroupTree::NO_GROUP) {
+        // Drop the group: its members move now, as one command
+        int groupId = m_dragGroupId;
+        QPoint offset = m_groupDragOffset;
+        m_isDragging = false;
+        m_dragGroupId = GroupTree::NO_GROUP;
+        m_groupDragOffset = QPoint();
+        m_dragGroupMembers.clear();
+        m_dragGroupLayers.clear();
+        if (offset.isNull()) {
+            update();
+        } else if (m_undoStack) {
+            m_undoStack->push(m_undoStack->create<MoveGroupCommand>(this, groupId, offset));
+        } else {
+            translateGroup(groupId, offset);
+        }
+    } else if (event->button() == Qt::LeftButton) {
+        if (m_isDragging && m_undoStack &&
+            m_selectedEntityIndex >= 0 && m_selectedEntityIndex < static_cast<int>(m_entities.size())) {
+            // Only record a command if the position actually changed,
+            // so plain clicks never allocate anything
+            QPoint finalPos = m_entities[m_selectedEntityIndex].position();
+            if (finalPos != m_entityStartPos) {
+                m_undoStack->push(m_undoStack->create<MoveEntityCommand>(
+                    this, m_selectedEntityIndex, m_entityStartPos, finalPos));
             }
-            m_currentMoveCommand = nullptr;
         }
         m_isDragging = false;
+        
+        if (!m_snapGuides.isEmpty()) {
+            m_snapGuides.clear();
+            update();
+        }
+        m_snapIndex.clear();
     }
     
     QWidget::mouseReleaseEvent(event);
@@ -162,8 +598,44 @@ void Canvas::mouseReleaseEvent(QMouseEvent *event)
 
 void Canvas::mousePressEvent(QMouseEvent *event)
 {
-    if (event->button() == Qt::LeftButton) {
-        QPoint clickPos = event->pos();
+    if (event->button() == Qt::MiddleButton) {
+        // Middle-drag pans the view (also allowed while a scene is streaming in)
+        m_isPanning = true;
+        m_panStartPos = event->pos();
+        m_panStartOffset = m_viewOffset;
+    } else if (event->button() == Qt::LeftButton && m_streaming) {
+        // Scene still loading: selection only, no edits
+        setSelectedEntityIndex(findEntityAt(mapToScene(event->pos())));
+    } else if (isTileTool(m_tool) &&
+               (event->button() == Qt::LeftButton || event->button() == Qt::RightButton)) {
+        beginTileEdit(mapToScene(event->pos()), event->button());
+    } else if (m_tool == Tool::Group) {
+        if (event->button() == Qt::LeftButton) {
+            m_isMarquee = true;
+            m_marqueeSelects = false;
+            m_marqueeStart = mapToScene(event->pos());
+            m_marqueeEnd = m_marqueeStart;
+            update();
+        }
+    } else if (m_tool != Tool::Select) {
+        if (event->button() == Qt::LeftButton) {
+            beginBrush(mapToScene(event->pos()));
+        }
+    } else if (event->button() == Qt::LeftButton && event->modifiers() & Qt::ShiftModifier) {
+        // Shift+drag selects everything inside the rectangle
+        m_isMarquee = true;
+        m_marqueeSelects = true;
+        m_marqueeStart = mapToScene(event->pos());
+        m_marqueeEnd = m_marqueeStart;
+        update();
+    } else if (event->button() == Qt::LeftButton && event->modifiers() & Qt::ControlModifier) {
+        // Ctrl+click adds an entity to the selection or takes it out
+        int entityIndex = findEntityAt(mapToScene(event->pos()));
+        if (entityIndex >= 0) {
+            toggleSelected(entityIndex);
+        }
+    } else if (event->button() == Qt::LeftButton) {
+        QPoint clickPos = mapToScene(event->pos());
 
         // Snap click position to grid if enabled
         if (m_snapToGrid) {
@@ -175,36 +647,48 @@ void Canvas::mousePressEvent(QMouseEvent *event)
         
         if (entityIndex >= 0) {
             // Clicked on an entity - select it and start dragging
-            m_selectedEntityIndex = entityIndex;
+            selectOnly(entityIndex);
             m_isDragging = true;
             m_dragStartPos = clickPos;
             m_entityStartPos = m_entities[entityIndex].position();
-            emit entitySelectionChanged(m_selectedEntityIndex);
             
-            // Create move command if undo stack available
-            if (m_undoStack) {
-                QPoint currentPos = m_entities[entityIndex].position();
-                m_currentMoveCommand = new MoveEntityCommand(this, entityIndex, currentPos, currentPos);
+            // Grouped entities drag their outermost group unless Alt is held
+            // (world chunks may hold only part of a group, so not in worlds)
+            m_dragGroupId = m_groups.rootOf(m_entities[entityIndex].groupId());
+            if (event->modifiers() & Qt::AltModifier || isWorldOpen()) {
+                m_dragGroupId = GroupTree::NO_GROUP;
+            }
+            if (m_dragGroupId != GroupTree::NO_GROUP) {
+                m_groupStartPos = m_groupBvh.groupBounds(m_dragGroupId).topLeft();
+                m_groupDragOffset = QPoint();
+                m_dragGroupMembers = m_groupBvh.membersOf(m_dragGroupId);
+                m_dragGroupLayers.clear();
+                for (int index : m_dragGroupMembers) {
+                    m_dragGroupLayers.insert(m_layers.resolve(m_entities[index].layerId()));
+                }
+            } else if (m_snapToEntities) {
+                m_snapIndex.build(m_entities, m_entities[entityIndex].id());
             }
+        } else if (!m_layers.isEditable(m_activeLayer)) {
+            // Nothing is added to a hidden or locked layer
+            setSelectedEntityIndex(-1);
         } else {
             // Clicked on empty space - create new entity using command if undo stack available
             if (m_undoStack) {
                 // Create command and push to undo stack (redo() will be called automatically)
-                AddEntityCommand *command = new AddEntityCommand(this, clickPos);
-                m_undoStack->push(command);
+                m_undoStack->push(m_undoStack->create<AddEntityCommand>(this, clickPos));
             } else {
                 // Fallback: create directly if no undo stack (backward compatibility)
-                QString entityName = QString("Entity_%1").arg(m_nextEntityId);
-                Entity newEntity(m_nextEntityId, entityName, clickPos);
+                Entity newEntity(m_nextEntityId, NamePool::instance().defaultPattern(), clickPos);
+                newEntity.setLayerId(m_activeLayer);
                 
                 int newIndex = static_cast<int>(m_entities.size());
                 m_entities.push_back(newEntity);
-                
-                m_selectedEntityIndex = newIndex;
+                trackAdded(newIndex);
                 m_isDragging = false;
                 
                 emit entityAdded(newIndex);
-                emit entitySelectionChanged(m_selectedEntityIndex);
+                selectOnly(newIndex);
                 
                 m_nextEntityId++;
                 update();
@@ -227,15 +711,17 @@ void Canvas::deleteSelectedEntity()
     }
     
     int removedIndex = m_selectedEntityIndex;
+    int removedId = m_entities[removedIndex].id();
     
     // Remove the selected entity from the vector
-    m_entities.erase(m_entities.begin() + m_selectedEntityIndex);
+    trackRemoved(m_entities[removedIndex], removedIndex);
+    m_entities.erase(m_entities.begin() + removedIndex);
     
     // Clear selection
     m_selectedEntityIndex = -1;
     
     // Emit signal
-    emit entityRemoved(removedIndex);
+    emit entityRemoved(removedIndex, removedId);
     emit entitySelectionChanged(-1);
     
     // Request a repaint to remove the deleted entity
@@ -258,280 +744,2236 @@ const Entity* Canvas::getEntity(int index) const
     return &m_entities[index];
 }
 
-void Canvas::setSelectedEntityIndex(int index)
+int Canvas::indexOfEntityId(int id, int hint) const
 {
-    // Validate index
-    if (index < -1 || index >= static_cast<int>(m_entities.size())) {
-        index = -1;
+    if (hint >= 0 && hint < entityCount() && m_entities[hint].id() == id) {
+        return hint;
     }
-    
-    if (m_selectedEntityIndex != index) {
-        m_selectedEntityIndex = index;
-        update();  // Repaint to show new selection
-        emit entitySelectionChanged(m_selectedEntityIndex);
+    for (int i = 0; i < entityCount(); ++i) {
+        if (m_entities[i].id() == id) {
+            return i;
+        }
     }
+    return -1;
 }
 
-void Canvas::keyPressEvent(QKeyEvent *event)
+int Canvas::residentIndexOf(int id, const QPoint &position, int hint)
 {
-    if (event->key() == Qt::Key_Delete || event->key() == Qt::Key_Backspace) {
-        if (m_selectedEntityIndex >= 0 && m_selectedEntityIndex < static_cast<int>(m_entities.size())) {
-            if (m_undoStack) {
-                // Use command for undoable delete
-                DeleteEntityCommand *command = new DeleteEntityCommand(this, m_selectedEntityIndex);
-                m_undoStack->push(command);
-            } else {
-                // Fallback: direct delete
-                deleteSelectedEntity();
-            }
-        }
-        event->accept();
-    } else if (event->key() == Qt::Key_D && event->modifiers() & Qt::ControlModifier) {
-        // Ctrl+D: Duplicate selected entity
-        duplicateSelectedEntity();
-        event->accept();
-    } else {
-        QWidget::keyPressEvent(event);
+    int index = indexOfEntityId(id, hint);
+    if (index < 0 && m_world->isOpen() && m_world->ensureResident(position)) {
+        index = indexOfEntityId(id);
     }
+    return index;
 }
 
-bool Canvas::saveToFile(const QString &filePath) const
+void Canvas::reportCommandFailure(const QString &commandText)
 {
-    // Create root JSON object
-    QJsonObject root;
-    root["version"] = "1.0";
-    root["next_entity_id"] = m_nextEntityId;
-    
-    // Create JSON array of entities
-    QJsonArray entitiesArray;
-    for (const Entity &entity : m_entities) {
-        entitiesArray.append(entity.toJson());
+    emit commandFailed(QString("Could not apply \"%1\": the entity is no longer in the scene").arg(commandText));
+}
+
+void Canvas::setSelectedEntityIndex(int index)
+{
+    // Selecting from outside (list, search) replaces a multi-selection
+    selectOnly(index);
+}
+
+void Canvas::selectOnly(int index)
+{
+    // Validate index
+    if (index < -1 || index >= static_cast<int>(m_entities.size())) {
+        index = -1;
     }
-    root["entities"] = entitiesArray;
     
-    // Write to file
-    QJsonDocument doc(root);
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        return false;
+    QSet<int> ids;
+    if (index >= 0) {
+        ids.insert(m_entities[index].id());
     }
+    bool setChanged = ids != m_selectedIds;
+    bool primaryChanged = index != m_selectedEntityIndex;
+    m_selectedIds = ids;
+    m_selectedEntityIndex = index;
     
-    QTextStream stream(&file);
-    stream << doc.toJson(QJsonDocument::Indented);
-    file.close();
-    
-    return true;
+    if (primaryChanged || setChanged) {
+        update();  // Repaint to show new selection
+    }
+    if (primaryChanged) {
+        emit entitySelectionChanged(m_selectedEntityIndex);
+    }
+    if (setChanged) {
+        emit selectionSetChanged();
+    }
 }
 
-bool Canvas::loadFromFile(const QString &filePath)
+void Canvas::toggleSelected(int index)
 {
-    // Read file
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        return false;
-    }
-    
-    QByteArray data = file.readAll();
-    file.close();
-    
-    // Parse JSON
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(data, &error);
-    if (error.error != QJsonParseError::NoError) {
-        return false;
+    if (index < 0 || index >= entityCount()) {
+        return;
     }
     
-    QJsonObject root = doc.object();
-    
-    // Clear existing entities
-    m_entities.clear();
-    m_selectedEntityIndex = -1;
-    
-    // Restore next entity ID if present
-    if (root.contains("next_entity_id")) {
-        m_nextEntityId = root["next_entity_id"].toInt();
+    int id = m_entities[index].id();
+    int previous = m_selectedEntityIndex;
+    if (m_selectedIds.contains(id)) {
+        m_selectedIds.remove(id);
+        if (index == m_selectedEntityIndex) {
+            m_selectedEntityIndex = topmostSelectedIndex();
+        }
     } else {
-        m_nextEntityId = 1;
+        m_selectedIds.insert(id);
+        m_selectedEntityIndex = index;  // The entity just added becomes the primary one
     }
     
-    // Load entities
-    if (root.contains("entities") && root["entities"].isArray()) {
-        QJsonArray entitiesArray = root["entities"].toArray();
-        for (const QJsonValue &value : entitiesArray) {
-            if (value.isObject()) {
-                Entity entity = Entity::fromJson(value.toObject());
-                m_entities.push_back(entity);
-            }
-        }
+    update();
+    if (m_selectedEntityIndex != previous) {
+        emit entitySelectionChanged(m_selectedEntityIndex);
     }
+    emit selectionSetChanged();
+}
+
+void Canvas::selectEntityIds(const QSet<int> &ids)
+{
+    int previous = m_selectedEntityIndex;
+    m_selectedIds = ids;
+    m_selectedEntityIndex = topmostSelectedIndex();
     
-    // Request repaint
     update();
-    
-    // Emit signals for each loaded entity (for list widget update)
-    for (int i = 0; i < static_cast<int>(m_entities.size()); ++i) {
-        emit entityAdded(i);
+    if (m_selectedEntityIndex != previous) {
+        emit entitySelectionChanged(m_selectedEntityIndex);
     }
+    emit selectionSetChanged();
+}
+
+void Canvas::selectEntitiesIn(const QRect &sceneRect)
+{
+    ensureGroupBvhCurrent();
+    std::vector<int> candidates;
+    m_groupBvh.query(sceneRect, &candidates);
     
-    return true;
+    QSet<int> ids;
+    for (int index : candidates) {
+        const Entity &entity = m_entities[index];
+        if (sceneRect.contains(entity.rect()) && m_layers.isEditable(entity.layerId())) {
+            ids.insert(entity.id());
+        }
+    }
+    selectEntityIds(ids);
 }
 
-void Canvas::setGridVisible(bool visible)
+int Canvas::topmostSelectedIndex() const
 {
-    if (m_gridVisible != visible) {
-        m_gridVisible = visible;
-        update();  // Repaint to show/hide grid
+    // Same order as picking: highest layer, then the entity drawn last
+    int found = -1;
+    int foundRank = -1;
+    if (m_selectedIds.isEmpty()) {
+        return found;
+    }
+    for (int i = entityCount() - 1; i >= 0; --i) {
+        if (!m_selectedIds.contains(m_entities[i].id())) {
+            continue;
+        }
+        int rank = m_layers.rankOf(m_entities[i].layerId());
+        if (rank > foundRank) {
+            found = i;
+            foundRank = rank;
+        }
     }
+    return found;
 }
 
-void Canvas::setGridSize(int size)
+std::vector<int> Canvas::selectedEntityIds() const
 {
-    if (size < 1) size = 1;  // Minimum grid size
-    if (m_gridSize != size) {
-        m_gridSize = size;
-        if (m_gridVisible) {
-            update();  // Repaint if grid is visible
+    std::vector<int> ids;
+    if (m_selectedIds.isEmpty()) {
+        return ids;
+    }
+    ids.reserve(m_selectedIds.size());
+    for (const Entity &entity : m_entities) {
+        if (m_selectedIds.contains(entity.id())) {
+            ids.push_back(entity.id());
         }
     }
+    return ids;
 }
 
-void Canvas::setSnapToGrid(bool snap)
+QSet<int> Canvas::editableSelection() const
 {
-    if (m_snapToGrid != snap) {
-        m_snapToGrid = snap;
-        // Optionally, snap all entities when enabling snap (for now, just set the flag)
-        update();
+    QSet<int> ids;
+    for (const Entity &entity : m_entities) {
+        if (m_selectedIds.contains(entity.id()) && m_layers.isEditable(entity.layerId())) {
+            ids.insert(entity.id());
+        }
     }
+    return ids;
 }
 
-int Canvas::addEntityAt(const QPoint &position)
+void Canvas::copySelection() const
 {
-    QString entityName = QString("Entity_%1").arg(m_nextEntityId);
-    Entity newEntity(m_nextEntityId, entityName, position);
-    
-    int newIndex = static_cast<int>(m_entities.size());
-    m_entities.push_back(newEntity);
-    
-    m_selectedEntityIndex = newIndex;
-    m_nextEntityId++;
-    
-    // Emit signal for UI updates
-    emit entityAdded(newIndex);
-    emit entitySelectionChanged(m_selectedEntityIndex);
-    
-    update();
+    // Flattened: prefab instances keep their resolved values, and groups
+    // and layers belong to this scene only. Components go along.
+    std::vector<Entity> clip;
+    ComponentStore components;
+    components.registry() = m_components.registry();
+    clip.reserve(m_selectedIds.size());
+    for (const Entity &entity : m_entities) {
+        if (m_selectedIds.contains(entity.id())) {
+            Entity copy = entity;
+            copy.setPrefab(-1);
+            copy.setGroupId(GroupTree::NO_GROUP);
+            copy.setLayerId(LayerStack::DEFAULT_LAYER);
+            clip.push_back(copy);
+            if (m_components.hasAny(entity.id())) {
+                components.setValues(entity.id(), m_components.valuesOf(entity.id()));
+            }
+        }
+    }
+    if (clip.empty()) {
+        return;
+    }
     
-    return newIndex;
+    // The system clipboard, so other editor instances can paste it too
+    QGuiApplication::clipboard()->setMimeData(EntityClipboard::toMimeData(clip, components));
 }
 
-void Canvas::removeEntityAt(int index)
+void Canvas::cutSelection()
 {
-    if (index < 0 || index >= static_cast<int>(m_entities.size())) {
+    if (m_streaming) {
+        return;  // No edits while a scene is streaming in
+    }
+    
+    QSet<int> ids = editableSelection();
+    if (ids.isEmpty()) {
         return;
     }
+    copySelection();
     
+    QString text = ids.size() == 1 ? QString("Cut Entity") : QString("Cut %1 Entities").arg(ids.size());
+    if (m_undoStack) {
+        m_undoStack->push(m_undoStack->create<RemoveEntitiesCommand>(this, ids, text));
+    } else {
+        takeEntities(ids);
+    }
+}
+
+void Canvas::paste()
+{
+    if (m_streaming || !m_layers.isEditable(m_activeLayer)) {
+        return;  // Nothing is added while streaming or to a hidden or locked layer
+    }
+    
+    std::vector<Entity> clip;
+    ComponentStore clipComponents;
+    if (!EntityClipboard::fromMimeData(QGuiApplication::clipboard()->mimeData(), &clip, &clipComponents) ||
+        clip.empty()) {
+        return;
+    }
+    
+    // Center the clip on the mouse when it is over the canvas, otherwise on the view
+    QRect bounds;
+    for (const Entity &entity : clip) {
+        bounds |= entity.rect();
+    }
+    QPoint cursor = mapFromGlobal(QCursor::pos());
+    QPoint target = rect().contains(cursor) ? mapToScene(cursor) : visibleSceneRect().center();
+    QPoint topLeft = target - QPoint(bounds.width() / 2, bounds.height() / 2);
+    if (m_snapToGrid) {
+        topLeft = snapToGrid(topLeft);
+    }
+    QPoint delta = topLeft - bounds.topLeft();
+    
+    // Components are matched by type and field name. Types this scene lacks
+    // are defined with the paste, their ids reserved now; worlds store none.
+    ComponentStore pastedComponents;
+    pastedComponents.registry() = m_components.registry();
+    std::vector<ComponentType> newTypes;
+    if (!isWorldOpen() && clipComponents.entityCount() > 0) {
+        for (const ComponentStore::Archetype *archetype : clipComponents.query({})) {
+            if (archetype->rowCount() == 0) {
+                continue;
+            }
+            for (int typeId : archetype->typeIds) {
+                const ComponentType *type = clipComponents.registry().find(typeId);
+                if (pastedComponents.registry().idOf(type->name) != 0) {
+                    continue;
+                }
+                int reservedId = m_components.registry().add(type->name, type->fields);
+                if (reservedId == 0) {
+                    continue;
+                }
+                newTypes.push_back(*m_components.registry().find(reservedId));
+                m_components.registry().remove(reservedId);
+                pastedComponents.registry().insert(newTypes.back());
+            }
+        }
+    }
+    
+    // Fresh consecutive ids, so undo can drop the block as one range
+    int firstId = m_nextEntityId;
+    QHash<int, ComponentStore::Values> components;
+    for (int i = 0; i < static_cast<int>(clip.size()); ++i) {
+        Entity &entity = clip[i];
+        Entity pasted(firstId + i, entity.nameRef(), entity.position() + delta);
+        pasted.setSize(entity.rect().width(), entity.rect().height());
+        pasted.setColor(entity.color());
+        pasted.setLayerId(m_activeLayer);
+        if (!isWorldOpen() && clipComponents.hasAny(entity.id())) {
+            pastedComponents.setValuesJson(pasted.id(), clipComponents.valuesToJson(entity.id()));
+            components.insert(pasted.id(), pastedComponents.valuesOf(pasted.id()));
+        }
+        entity = pasted;
+    }
+    
+    if (m_undoStack) {
+        m_undoStack->push(m_undoStack->create<PasteCommand>(this, std::move(clip), newTypes, std::move(components)));
+    } else {
+        for (const ComponentType &type : newTypes) {
+            setComponentTypeDefined(type, true);
+        }
+        appendEntityBlock(clip, components);
+    }
+}
+
+void Canvas::deleteSelection()
+{
+    if (m_streaming) {
+        return;  // No edits while a scene is streaming in
+    }
+    
+    QSet<int> ids = editableSelection();
+    if (ids.size() <= 1) {
+        // Single entity: same command as before multi-selection
+        if (m_selectedEntityIndex >= 0 && m_selectedEntityIndex < static_cast<int>(m_entities.size())) {
+            if (m_undoStack) {
+                m_undoStack->push(m_undoStack->create<DeleteEntityCommand>(this, m_selectedEntityIndex));
+            } else {
+                deleteSelectedEntity();
+            }
+        }
+        return;
+    }
+    
+    if (m_undoStack) {
+        m_undoStack->push(m_undoStack->create<RemoveEntitiesCommand>(
+            this, ids, QString("Delete %1 Entities").arg(ids.size())));
+    } else {
+        takeEntities(ids);
+    }
+}
+
+void Canvas::wheelEvent(QWheelEvent *event)
+{
+    // Wheel scrolls the view; Shift (or a horizontal wheel) scrolls sideways
+    QPoint steps = event->angleDelta() / 2;
+    if (event->modifiers() & Qt::ShiftModifier) {
+        steps = QPoint(steps.y(), steps.x());
+    }
+    setViewOffset(m_viewOffset - steps);
+    event->accept();
+}
+
+void Canvas::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    
+    // A larger widget shows more of the scene
+    emit viewChanged(visibleSceneRect());
+}
+
+void Canvas::keyPressEvent(QKeyEvent *event)
+{
+    if (m_streaming) {
+        QWidget::keyPressEvent(event);  // No edits while a scene is streaming in
+        return;
+    }
+    
+    if (event->key() == Qt::Key_Delete || event->key() == Qt::Key_Backspace) {
+        // Undoable delete of the whole selection
+        deleteSelection();
+        event->accept();
+    } else if (event->key() == Qt::Key_D && event->modifiers() & Qt::ControlModifier) {
+        // Ctrl+D: Duplicate selected entity
+        duplicateSelectedEntity();
+        event->accept();
+    } else {
+        QWidget::keyPressEvent(event);
+    }
+}
+
+SceneValidator::Report Canvas::validateScene() const
+{
+    return SceneValidator::validate(m_entities, m_nextEntityId, 0, SceneValidator::EDITOR_BUDGET_MS);
+}
+
+bool Canvas::saveToFile(const QString &filePath)
+{
+    // A plain save supersedes any journal that was next to the file. A
+    // compaction still writing the file would otherwise commit after us.
+    m_journal->waitForCompaction();
+    SceneParts scene(m_entities, m_nextEntityId);
+    scene.prefabs = &m_prefabs;
+    scene.tiles = &m_tiles;
+    scene.layers = &m_layers;
+    scene.groups = &m_groups;
+    scene.components = &m_components;
+    if (!SceneFile::save(filePath, scene, m_saveCompression)) {
+        return false;
+    }
+    m_journal->detach();
+    m_journal->clearPending();
+    SceneJournal::discard(filePath);
+    
+    return true;
+}
+
+bool Canvas::saveJournaled(const QString &filePath)
+{
+    if (m_journal->isAttachedTo(filePath)) {
+        return m_journal->appendChanges(m_entities, m_nextEntityId);
+    }
+    return m_journal->checkpoint(filePath, m_entities, m_nextEntityId, m_saveCompression);
+}
+
+bool Canvas::loadFromFile(const QString &filePath, SceneValidator::Report *report)
+{
+    SceneData scene;
+    if (!SceneFile::load(filePath, &scene)) {
+        return false;
+    }
+    
+    // Bring the scene up to date with any journaled (or crash-recovered) edits
+    if (!attachLoadedScene(filePath, &scene)) {
+        return false;
+    }
+    
+    // Report what the file got wrong; the scene still loads
+    if (report) {
+        *report = SceneValidator::validate(scene, 0, SceneValidator::EDITOR_BUDGET_MS);
+    }
+    
+    // Replace existing entities
+    m_entities = std::move(scene.entities);
+    m_prefabs = std::move(scene.prefabs);
+    m_tiles = std::move(scene.tiles);
+    installLayers(scene.layers);
+    installGroups(scene.groups);
+    installComponents(scene.components);
+    m_nextEntityId = scene.nextEntityId;
+    m_selectedEntityIndex = -1;
+    m_selectedIds.clear();
+    clearComparison();
+    
+    // Request repaint
+    update();
+    
+    // One batched notification instead of one signal per entity
+    emit sceneReset();
+    emit entitiesAppended(0, entityCount());
+    emit entitySelectionChanged(-1);
+    emit selectionSetChanged();
+    
+    return true;
+}
+
+bool Canvas::attachLoadedScene(const QString &filePath, SceneData *scene)
+{
+    // A plain scene replaces any open world
+    m_world->close();
+    return m_journal->replay(filePath, scene);
+}
+
+bool Canvas::exportWorld(const QString &manifestPath) const
+{
+    // An open world or a half-streamed scene holds only part of the level
+    if (m_streaming || isWorldOpen()) {
+        return false;
+    }
+    return WorldStreamer::exportWorld(manifestPath, m_entities, m_nextEntityId,
+                                      WorldStreamer::DEFAULT_CHUNK_SIZE, &m_prefabs, &m_layers, &m_groups);
+}
+
+bool Canvas::exportRuntime(const QString &filePath, QString *error) const
+{
+    return RuntimeExport::save(filePath, m_entities, error);
+}
+
+bool Canvas::openWorld(const QString &manifestPath)
+{
+    if (m_streaming) {
+        return false;
+    }
+    return m_world->open(manifestPath);
+}
+
+bool Canvas::saveWorld()
+{
+    return m_world->save();
+}
+
+bool Canvas::isWorldOpen() const
+{
+    return m_world->isOpen();
+}
+
+void Canvas::resetScene(int nextEntityId, const PrefabLibrary &prefabs, const LayerStack &layers,
+                        const GroupTree &groups)
+{
+    m_entities.clear();
+    m_prefabs = prefabs;
+    m_tiles.clear();
+    installLayers(layers);
+    installGroups(groups);
+    installComponents(ComponentStore());  // Worlds don't carry components
+    m_nextEntityId = nextEntityId;
+    m_selectedEntityIndex = -1;
+    m_selectedIds.clear();
+    clearComparison();
+    m_isDragging = false;
+    m_isPaintingTiles = false;
+    m_strokeChanges.clear();
+    m_isBrushing = false;
+    
+    // Edits to the previous scene can no longer be saved anywhere
+    m_journal->detach();
+    m_journal->clearPending();
+    
+    update();
+    emit sceneReset();
+    emit entitySelectionChanged(-1);
+    emit selectionSetChanged();
+}
+
+void Canvas::unloadEntities(const QSet<int> &ids)
+{
+    if (ids.isEmpty()) {
+        return;
+    }
+    
+    // Keep the selection by id across the compaction
+    int selectedId = -1;
+    if (const Entity *selected = getEntity(m_selectedEntityIndex)) {
+        selectedId = selected->id();
+    }
+    
+    m_entities.erase(std::remove_if(m_entities.begin(), m_entities.end(),
+                                    [&ids](const Entity &entity) { return ids.contains(entity.id()); }),
+                     m_entities.end());
+    
+    m_selectedEntityIndex = selectedId >= 0 ? indexOfEntityId(selectedId) : -1;
+    if (m_selectedEntityIndex < 0) {
+        m_isDragging = false;
+    }
+    
+    // Same entities in file order: the overlap index is keyed by id and stays valid
+    bool overlapsCurrent = !m_overlapsDirty;
+    update();
+    emit sceneReset();
+    emit entitiesAppended(0, entityCount());
+    m_overlapsDirty = !overlapsCurrent;
+    emit entitySelectionChanged(m_selectedEntityIndex);
+}
+
+SceneDiff::Result Canvas::reloadChanges(const SceneData &scene, int *keptEdits)
+{
+    SceneDiff::Result diff = SceneDiff::diff(m_entities, scene.entities, &m_components, &scene.components);
+    
+    // Unsaved edits here win over the file for the entities they touch
+    SceneDiff::Result applied;
+    int kept = 0;
+    auto isLocal = [this, &kept](int id) {
+        bool local = m_journal->isPending(id);
+        kept += local ? 1 : 0;
+        return local;
+    };
+    for (int id : diff.added) {
+        if (!isLocal(id)) {
+            applied.added.push_back(id);
+        }
+    }
+    for (int id : diff.removed) {
+        if (!isLocal(id)) {
+            applied.removed.push_back(id);
+        }
+    }
+    for (const SceneDiff::Change &change : diff.changed) {
+        if (!isLocal(change.entityId)) {
+            applied.changed.push_back(change);
+        }
+    }
+    if (keptEdits) {
+        *keptEdits = kept;
+    }
+    if (applied.isEmpty()) {
+        return applied;
+    }
+    
+    QHash<int, int> fileIndex;
+    fileIndex.reserve(static_cast<int>(scene.entities.size()));
+    for (int i = 0; i < static_cast<int>(scene.entities.size()); ++i) {
+        fileIndex.insert(scene.entities[i].id(), i);
+    }
+    int selectedId = -1;
+    if (const Entity *selected = getEntity(m_selectedEntityIndex)) {
+        selectedId = selected->id();
+    }
+    
+    // Small reloads notify per entity (the object list updates in place);
+    // large ones reset the list once
+    bool bulk = applied.added.size() + applied.removed.size() + applied.changed.size() >
+                static_cast<size_t>(RELOAD_SIGNAL_LIMIT);
+    
+    // The file already holds these changes, so they aren't journaled
+    m_reloading = true;
+    
+    // Components of reloaded entities come from the file, matched by type
+    // name; types the file added are defined here too
+    bool typesAdded = false;
+    for (const ComponentType &type : scene.components.registry().types()) {
+        if (m_components.registry().idOf(type.name) == 0) {
+            typesAdded = m_components.registry().add(type.name, type.fields) != 0 || typesAdded;
+        }
+    }
+    auto reloadComponents = [this, &scene](int entityId) {
+        m_components.setValuesJson(entityId, scene.components.valuesToJson(entityId));
+    };
+    
+    if (!applied.changed.empty()) {
+        QHash<int, int> index;
+        index.reserve(entityCount());
+        for (int i = 0; i < entityCount(); ++i) {
+            index.insert(m_entities[i].id(), i);
+        }
+        for (const SceneDiff::Change &change : applied.changed) {
+            int i = index.value(change.entityId);
+            invalidateLayerCache(m_entities[i].layerId());  // In case it moved to another layer
+            m_entities[i] = scene.entities[fileIndex.value(change.entityId)];
+            reloadComponents(change.entityId);
+            trackChanged(m_entities[i]);
+            if (change.fields & SceneDiff::Group) {
+                m_groupBvhDirty = true;  // Membership, not just bounds
+            }
+            if (!bulk) {
+                emit entityChanged(i);
+            }
+        }
+    }
+    
+    if (!applied.removed.empty()) {
+        QSet<int> removed(applied.removed.begin(), applied.removed.end());
+        if (bulk) {
+            for (const Entity &entity : m_entities) {
+                if (removed.contains(entity.id())) {
+                    trackRemoved(entity);
+                }
+            }
+            m_entities.erase(std::remove_if(m_entities.begin(), m_entities.end(),
+                                            [&removed](const Entity &entity) { return removed.contains(entity.id()); }),
+                             m_entities.end());
+        } else {
+            for (int i = entityCount() - 1; i >= 0; --i) {
+                int id = m_entities[i].id();
+                if (!removed.contains(id)) {
+                    continue;
+                }
+                trackRemoved(m_entities[i], i);
+                m_entities.erase(m_entities.begin() + i);
+                if (m_selectedEntityIndex == i) {
+                    m_selectedEntityIndex = -1;
+                } else if (m_selectedEntityIndex > i) {
+                    m_selectedEntityIndex--;
+                }
+                emit entityRemoved(i, id);
+            }
+        }
+    }
+    
+    int first = entityCount();
+    for (int id : applied.added) {
+        m_entities.push_back(scene.entities[fileIndex.value(id)]);
+        reloadComponents(id);
+        trackAdded(entityCount() - 1);
+        m_nextEntityId = qMax(m_nextEntityId, id + 1);
+    }
+    m_nextEntityId = qMax(m_nextEntityId, scene.nextEntityId);
+    m_prefabs.merge(scene.prefabs);  // Instances the file added may use new prefabs
+    
+    m_reloading = false;
+    
+    // The journal's base file was replaced: the next journaled save starts
+    // over with a full checkpoint
+    m_journal->detach();
+    
+    m_selectedEntityIndex = selectedId >= 0 ? indexOfEntityId(selectedId) : -1;
+    if (m_selectedEntityIndex < 0) {
+        m_isDragging = false;
+    }
+    
+    update();
+    if (bulk) {
+        emit sceneReset();
+        emit entitiesAppended(0, entityCount());
+    } else if (!applied.added.empty()) {
+        emit entitiesAppended(first, static_cast<int>(applied.added.size()));
+    }
+    if (typesAdded) {
+        emit componentTypesChanged();
+    }
+    emit entitySelectionChanged(m_selectedEntityIndex);
+    return applied;
+}
+
+void Canvas::beginStreaming(const SceneData &scene)
+{
+    // Keep the previous scene so a cancelled load can put it back
+    m_streamBackup = std::move(m_entities);
+    m_streamBackupNextId = m_nextEntityId;
+    m_streamBackupPrefabs = std::move(m_prefabs);
+    m_streamBackupTiles = std::move(m_tiles);
+    m_streamBackupLayers = m_layers;
+    m_streamBackupGroups = m_groups;
+    m_streamBackupComponents = std::move(m_components);
+    m_entities.clear();
+    m_prefabs = scene.prefabs;
+    m_tiles = scene.tiles;
+    installLayers(scene.layers);
+    installGroups(scene.groups);
+    installComponents(scene.components);
+    m_nextEntityId = scene.nextEntityId;
+    m_selectedEntityIndex = -1;
+    m_selectedIds.clear();
+    clearComparison();
+    m_isDragging = false;
+    m_isPaintingTiles = false;
+    m_strokeChanges.clear();
+    m_isBrushing = false;
+    m_streaming = true;
+    
+    update();
+    emit sceneReset();
+    emit entitySelectionChanged(-1);
+    emit selectionSetChanged();
+}
+
+void Canvas::appendEntities(const std::vector<Entity> &batch)
+{
+    if (batch.empty()) {
+        return;
+    }
+    
+    int first = entityCount();
+    m_entities.insert(m_entities.end(), batch.begin(), batch.end());
+    
+    update();
+    emit entitiesAppended(first, static_cast<int>(batch.size()));
+}
+
+void Canvas::endStreaming(std::vector<Entity> &&entities)
+{
+    // Batches arrived viewport-first; install the file's draw order,
+    // keeping the current selection by id
+    int selectedId = -1;
+    if (const Entity *selected = getEntity(m_selectedEntityIndex)) {
+        selectedId = selected->id();
+    }
+    
+    m_entities = std::move(entities);
+    m_streamBackup.clear();
+    m_streamBackup.shrink_to_fit();
+    m_streamBackupPrefabs.clear();
+    m_streamBackupTiles.clear();
+    m_streamBackupLayers = LayerStack();
+    m_streamBackupGroups.clear();
+    m_streamBackupComponents.clear();
+    m_streaming = false;
+    
+    m_selectedEntityIndex = -1;
+    if (selectedId >= 0) {
+        for (int i = 0; i < entityCount(); ++i) {
+            if (m_entities[i].id() == selectedId) {
+                m_selectedEntityIndex = i;
+                break;
+            }
+        }
+    }
+    
+    update();
+    emit sceneReset();
+    emit entitiesAppended(0, entityCount());
+    emit entitySelectionChanged(m_selectedEntityIndex);
+}
+
+void Canvas::cancelStreaming()
+{
+    if (!m_streaming) {
+        return;
+    }
+    
+    m_entities = std::move(m_streamBackup);
+    m_streamBackup.clear();
+    m_nextEntityId = m_streamBackupNextId;
+    m_prefabs = std::move(m_streamBackupPrefabs);
+    m_streamBackupPrefabs.clear();
+    m_tiles = std::move(m_streamBackupTiles);
+    m_streamBackupTiles.clear();
+    installLayers(m_streamBackupLayers);
+    m_streamBackupLayers = LayerStack();
+    installGroups(m_streamBackupGroups);
+    m_streamBackupGroups.clear();
+    installComponents(m_streamBackupComponents);
+    m_streamBackupComponents.clear();
+    m_selectedEntityIndex = -1;
+    m_selectedIds.clear();
+    m_streaming = false;
+    
+    // The journal was attached to the file we were loading; edits to the
+    // restored scene have nowhere to be appended, so saves start fresh
+    m_journal->detach();
+    
+    update();
+    emit sceneReset();
+    emit entitiesAppended(0, entityCount());
+    emit entitySelectionChanged(-1);
+    emit selectionSetChanged();
+}
+
+void Canvas::setGridVisible(bool visible)
+{
+    if (m_gridVisible != visible) {
+        m_gridVisible = visible;
+        update();  // Repaint to show/hide grid
+    }
+}
+
+void Canvas::setGridSize(int size)
+{
+    if (size < 1) size = 1;  // Minimum grid size
+    if (m_gridSize != size) {
+        m_gridSize = size;
+        update();
+    }
+}
+
+void Canvas::setSnapToEntities(bool snap)
+{
+    m_snapToEntities = snap;
+}
+
+void Canvas::setShowOverlaps(bool show)
+{
+    if (m_showOverlaps != show) {
+        m_showOverlaps = show;
+        m_overlapsDirty = true;
+        if (!show) {
+            m_overlaps.clear();  // Not maintained while hidden
+        }
+        update();
+    }
+}
+
+std::vector<std::pair<int, int>> Canvas::overlappingPairs()
+{
+    ensureOverlapsCurrent();
+    return m_overlaps.pairs();
+}
+
+SceneDiff::Result Canvas::compareWith(SceneData &&base)
+{
+    SceneDiff::Result diff = SceneDiff::diff(base.entities, m_entities, &base.components, &m_components);
+    
+    m_diffBase = std::move(base.entities);
+    m_diffBaseComponents = std::move(base.components);
+    m_diffBaseIndex.clear();
+    m_diffBaseIndex.reserve(static_cast<int>(m_diffBase.size()));
+    for (int i = 0; i < static_cast<int>(m_diffBase.size()); ++i) {
+        m_diffBaseIndex.insert(m_diffBase[i].id(), i);
+    }
+    m_diffAdded = QSet<int>(diff.added.begin(), diff.added.end());
+    m_diffRemoved = QSet<int>(diff.removed.begin(), diff.removed.end());
+    m_diffChanged.clear();
+    for (const SceneDiff::Change &change : diff.changed) {
+        m_diffChanged.insert(change.entityId);
+    }
+    m_diffActive = true;
+    
+    update();
+    return diff;
+}
+
+void Canvas::clearComparison()
+{
+    if (!m_diffActive) {
+        return;
+    }
+    m_diffActive = false;
+    m_diffBase.clear();
+    m_diffBase.shrink_to_fit();
+    m_diffBaseComponents.clear();
+    m_diffBaseIndex.clear();
+    m_diffAdded.clear();
+    m_diffChanged.clear();
+    m_diffRemoved.clear();
+    update();
+}
+
+void Canvas::updateComparison(const Entity &entity)
+{
+    // One entity against its base version: a hash lookup and a field compare
+    int id = entity.id();
+    m_diffRemoved.remove(id);
+    auto it = m_diffBaseIndex.constFind(id);
+    if (it == m_diffBaseIndex.constEnd()) {
+        m_diffAdded.insert(id);
+    } else if (SceneDiff::changedFields(m_diffBase[it.value()], entity, &m_diffBaseComponents, &m_components)) {
+        m_diffChanged.insert(id);
+    } else {
+        m_diffChanged.remove(id);
+    }
+}
+
+void Canvas::ensureOverlapsCurrent()
+{
+    if (m_overlapsDirty) {
+        m_overlaps.rebuild(m_entities);
+        m_overlapsDirty = false;
+    }
+}
+
+void Canvas::setSnapToGrid(bool snap)
+{
+    if (m_snapToGrid != snap) {
+        m_snapToGrid = snap;
+        // Optionally, snap all entities when enabling snap (for now, just set the flag)
+        update();
+    }
+}
+
+int Canvas::addEntityAt(const QPoint &position)
+{
+    // Default names are stored as the shared "Entity_%1" pattern, not a new string
+    Entity newEntity(m_nextEntityId, NamePool::instance().defaultPattern(), position);
+    newEntity.setLayerId(m_activeLayer);
+    
+    int newIndex = static_cast<int>(m_entities.size());
+    m_entities.push_back(newEntity);
+    trackAdded(newIndex);
+    m_nextEntityId++;
+    
+    // Emit signal for UI updates
+    emit entityAdded(newIndex);
+    selectOnly(newIndex);
+    
+    update();
+    
+    return newIndex;
+}
+
+void Canvas::removeEntityAt(int index)
+{
+    if (index < 0 || index >= static_cast<int>(m_entities.size())) {
+        return;
+    }
+    
+    int removedId = m_entities[index].id();
+    trackRemoved(m_entities[index], index);
     m_entities.erase(m_entities.begin() + index);
     
-    // Clear selection if removed entity was selected
-    if (m_selectedEntityIndex == index) {
-        m_selectedEntityIndex = -1;
-    } else if (m_selectedEntityIndex > index) {
-        // Adjust selection index if entity before it was removed
-        m_selectedEntityIndex--;
+    // Clear selection if removed entity was selected
+    if (m_selectedEntityIndex == index) {
+        m_selectedEntityIndex = -1;
+    } else if (m_selectedEntityIndex > index) {
+        // Adjust selection index if entity before it was removed
+        m_selectedEntityIndex--;
+    }
+    
+    // Emit signal
+    emit entityRemoved(index, removedId);
+    emit entitySelectionChanged(m_selectedEntityIndex);
+    
+    update();
+}
+
+int Canvas::insertEntity(const Entity &entity, int index, const ComponentStore::Values &components)
+{
+    if (index < 0) {
+        index = static_cast<int>(m_entities.size());
+    } else if (index > static_cast<int>(m_entities.size())) {
+        index = static_cast<int>(m_entities.size());
+    }
+    
+    m_entities.insert(m_entities.begin() + index, entity);
+    refreshFromPrefab(&m_entities[index]);  // The prefab may have changed since it was removed
+    if (!components.isEmpty()) {
+        m_components.setValues(entity.id(), components);
+    }
+    trackAdded(index);
+    
+    // Adjust selection if needed
+    if (m_selectedEntityIndex >= index) {
+        m_selectedEntityIndex++;
+    }
+    
+    // Emit signal
+    emit entityAdded(index);
+    emit entitySelectionChanged(m_selectedEntityIndex);
+    
+    update();
+    
+    return index;
+}
+
+void Canvas::setUndoStack(UndoHistory *undoStack)
+{
+    m_undoStack = undoStack;
+}
+
+void Canvas::notifyEntityChanged(int index)
+{
+    if (index < 0 || index >= static_cast<int>(m_entities.size())) {
+        return;
+    }
+    
+    trackChanged(m_entities[index]);
+    emit entityChanged(index);
+    update();
+}
+
+void Canvas::trackChanged(const Entity &entity, bool journal)
+{
+    invalidateLayerCache(entity.layerId());
+    if (!m_groupBvhDirty && !m_groupBvh.update(entity.id(), entity.rect())) {
+        m_groupBvhDirty = true;  // A new entity
+    }
+    if (journal && !m_reloading) {
+        m_journal->markChanged(entity.id());
+    }
+    m_world->entityChanged(entity);
+    emit entityEdited(entity.id());
+    if (m_diffActive) {
+        updateComparison(entity);
+    }
+    if (m_showOverlaps && !m_overlapsDirty) {
+        m_overlaps.update(entity.id(), entity.rect());
+    }
+    updateMinimapEntry(entity);
+}
+
+void Canvas::updateMinimapEntry(const Entity &entity)
+{
+    if (m_minimapEnabled && !m_minimapDirty) {
+        if (m_layers.isVisible(entity.layerId())) {
+            m_minimap.update(entity.id(), entity.rect(), entity.color());
+        } else {
+            m_minimap.remove(entity.id());
+        }
+    }
+}
+
+void Canvas::trackAdded(int index)
+{
+    if (!m_groupBvhDirty) {
+        m_groupBvh.insert(index, m_entities[index]);
+    }
+    trackChanged(m_entities[index]);
+}
+
+void Canvas::trackRemoved(const Entity &entity, int index)
+{
+    invalidateLayerCache(entity.layerId());
+    if (index < 0) {
+        m_groupBvhDirty = true;  // A batch: indices shift all over
+    } else if (!m_groupBvhDirty) {
+        m_groupBvh.remove(entity.id(), index);
+    }
+    m_selectedIds.remove(entity.id());
+    if (!m_reloading) {
+        m_journal->markRemoved(entity.id());
+    }
+    m_world->entityRemoved(entity);
+    emit entityErased(entity.id());
+    m_components.removeEntity(entity.id());
+    if (m_diffActive) {
+        m_diffAdded.remove(entity.id());
+        m_diffChanged.remove(entity.id());
+        if (m_diffBaseIndex.contains(entity.id())) {
+            m_diffRemoved.insert(entity.id());
+        }
+    }
+    if (m_showOverlaps && !m_overlapsDirty) {
+        m_overlaps.remove(entity.id());
+    }
+    if (m_minimapEnabled && !m_minimapDirty) {
+        m_minimap.remove(entity.id());
+    }
+}
+
+void Canvas::duplicateSelectedEntity()
+{
+    if (m_streaming) {
+        return;  // No edits while a scene is streaming in
+    }
+    
+    if (m_selectedEntityIndex < 0 || m_selectedEntityIndex >= static_cast<int>(m_entities.size())) {
+        return;  // No entity selected
+    }
+    
+    // Copy the source: adding the duplicate may reallocate m_entities
+    const Entity source = m_entities[m_selectedEntityIndex];
+    
+    // Calculate offset position (offset by entity width + 10 pixels)
+    QPoint offsetPos = source.position() + QPoint(source.rect().width() + 10, 0);
+    
+    // Snap to grid if enabled
+    if (m_snapToGrid) {
+        offsetPos = snapToGrid(offsetPos);
+    }
+    
+    // Use AddEntityCommand to create new entity at offset position
+    if (m_undoStack) {
+        m_undoStack->push(m_undoStack->create<AddEntityCommand>(this, offsetPos));
+        
+        // After command executes, update the new entity's properties
+        // Get the newly created entity (it will be the last one)
+        int newIndex = entityCount() - 1;
+        Entity *newEntity = getEntity(newIndex);
+        if (newEntity) {
+            copyAppearance(source, newEntity);
+            notifyEntityChanged(newIndex);
+            
+            // Select the new entity
+            setSelectedEntityIndex(newIndex);
+        }
+    } else {
+        // Fallback: create directly
+        Entity newEntity(m_nextEntityId, NamePool::instance().defaultPattern(), offsetPos);
+        
+        // Copy properties
+        copyAppearance(source, &newEntity);
+        
+        int newIndex = static_cast<int>(m_entities.size());
+        m_entities.push_back(newEntity);
+        trackAdded(newIndex);
+        
+        emit entityAdded(newIndex);
+        selectOnly(newIndex);
+        
+        m_nextEntityId++;
+        update();
+    }
+}
+
+void Canvas::copyAppearance(const Entity &source, Entity *target) const
+{
+    target->setLayerId(source.layerId());
+    
+    if (source.isPrefabInstance()) {
+        // Another instance of the same prefab: share it and copy only the overrides
+        target->setPrefab(source.prefabId(), source.overrides());
+        if (source.overrides() & Entity::OverrideName) {
+            target->setName(QString("%1 (Copy)").arg(source.name()));
+        }
+        if (source.overrides() & Entity::OverrideColor) {
+            target->setColor(source.color());
+        }
+        if (source.overrides() & Entity::OverrideSize) {
+            target->setSize(source.rect().width(), source.rect().height());
+        }
+        if (const Prefab *prefab = m_prefabs.find(source.prefabId())) {
+            target->applyPrefab(*prefab);
+        }
+        return;
+    }
+    
+    target->setName(QString("%1 (Copy)").arg(source.name()));
+    target->setColor(source.color());
+    target->setSize(source.rect().width(), source.rect().height());
+}
+
+void Canvas::mergePrefabs(const PrefabLibrary &prefabs)
+{
+    m_prefabs.merge(prefabs);
+}
+
+int Canvas::makePrefab(int index)
+{
+    Entity *entity = getEntity(index);
+    if (!entity || m_streaming) {
+        return -1;
+    }
+    if (entity->isPrefabInstance()) {
+        return entity->prefabId();
+    }
+    
+    Prefab prefab;
+    prefab.nameRef = entity->nameRef();
+    prefab.color = entity->color();
+    prefab.size = entity->rect().size();
+    // Reserve the id now; the command installs the prefab under it
+    prefab.id = m_prefabs.add(prefab);
+    m_prefabs.remove(prefab.id);
+    
+    Entity instance = *entity;
+    instance.setPrefab(prefab.id);
+    pushPrefabState(prefab.id, Prefab(), prefab, {*entity}, {instance}, "Make Prefab");
+    return prefab.id;
+}
+
+void Canvas::revertToPrefab(int index)
+{
+    Entity *entity = getEntity(index);
+    if (!entity || !entity->isPrefabInstance() || m_streaming) {
+        return;
+    }
+    const Prefab *prefab = m_prefabs.find(entity->prefabId());
+    if (!prefab || entity->overrides() == 0) {
+        return;
+    }
+    
+    Entity reverted = *entity;
+    reverted.clearOverrides();
+    reverted.applyPrefab(*prefab);
+    pushPrefabState(prefab->id, *prefab, *prefab, {*entity}, {reverted}, "Revert to Prefab");
+}
+
+void Canvas::applyToPrefab(int index)
+{
+    const Entity *entity = getEntity(index);
+    if (!entity || !entity->isPrefabInstance() || m_streaming) {
+        return;
+    }
+    
+    const Prefab *before = m_prefabs.find(entity->prefabId());
+    if (!before) {
+        return;
+    }
+    
+    Prefab prefab;
+    prefab.id = entity->prefabId();
+    prefab.nameRef = entity->nameRef();
+    prefab.color = entity->color();
+    prefab.size = entity->rect().size();
+    
+    // The instance now matches its prefab exactly
+    Entity instance = *entity;
+    instance.clearOverrides();
+    pushPrefabState(prefab.id, *before, prefab, {*entity}, {instance}, "Apply to Prefab");
+}
+
+void Canvas::updatePrefab(const Prefab &prefab)
+{
+    const Prefab *before = m_prefabs.find(prefab.id);
+    if (m_streaming || !before) {
+        return;
+    }
+    pushPrefabState(prefab.id, *before, prefab, {}, {}, "Update Prefab");
+}
+
+void Canvas::pushPrefabState(int prefabId, const Prefab &before, const Prefab &after,
+                             std::vector<Entity> &&entitiesBefore, std::vector<Entity> &&entitiesAfter,
+                             const QString &text)
+{
+    if (!m_undoStack) {
+        setPrefabState(prefabId, after, entitiesAfter);
+        return;
+    }
+    m_undoStack->push(m_undoStack->create<PrefabCommand>(this, prefabId, before, after, std::move(entitiesBefore),
+                                                         std::move(entitiesAfter), text));
+}
+
+void Canvas::setPrefabState(int prefabId, const Prefab &prefab, const std::vector<Entity> &entities)
+{
+    if (m_streaming) {
+        return;
+    }
+    if (prefab.id >= 0) {
+        m_prefabs.insert(prefab);
+    } else {
+        m_prefabs.remove(prefabId);
+    }
+    m_journal->markPrefabsChanged();
+    
+    QHash<int, int> slotById;
+    slotById.reserve(static_cast<int>(entities.size()));
+    for (int i = 0; i < static_cast<int>(entities.size()); ++i) {
+        slotById.insert(entities[i].id(), i);
+    }
+    
+    // One pass: restore the edited entities, refresh the other instances.
+    // Only instances whose inherited fields change are reported.
+    for (int i = 0; i < entityCount(); ++i) {
+        Entity &entity = m_entities[i];
+        auto it = slotById.constFind(entity.id());
+        if (it != slotById.constEnd()) {
+            entity = entities[it.value()];
+            refreshFromPrefab(&entity);
+            trackChanged(entity);
+        } else if (prefab.id >= 0 && entity.prefabId() == prefabId) {
+            QRect rect = entity.rect();
+            QColor color = entity.color();
+            NameRef nameRef = entity.nameRef();
+            entity.applyPrefab(prefab);
+            if (entity.rect() == rect && entity.color() == color && entity.nameRef() == nameRef) {
+                continue;
+            }
+            trackChanged(entity, false);
+        } else {
+            continue;
+        }
+        emit entityChanged(i);
+    }
+    update();
+}
+
+void Canvas::refreshFromPrefab(Entity *entity) const
+{
+    if (const Prefab *prefab = entity->isPrefabInstance() ? m_prefabs.find(entity->prefabId()) : nullptr) {
+        entity->applyPrefab(*prefab);
+    }
+}
+
+bool Canvas::isTileTool(Tool tool)
+{
+    return tool == Tool::PaintTiles || tool == Tool::RectTiles || tool == Tool::FillTiles;
+}
+
+void Canvas::setTool(Tool tool)
+{
+    if (m_isPaintingTiles) {
+        finishTileEdit();
+    }
+    if (m_isBrushing) {
+        finishBrush();
+    }
+    m_tool = tool;
+    m_isDragging = false;
+    m_isMarquee = false;
+    setCursor(tool == Tool::Select ? Qt::ArrowCursor : Qt::CrossCursor);
+}
+
+void Canvas::beginTileEdit(const QPoint &scenePos, Qt::MouseButton button)
+{
+    // Chunked worlds don't carry a tile layer (yet)
+    if (isWorldOpen()) {
+        return;
+    }
+    
+    m_strokeTile = (button == Qt::RightButton) ? 0 : m_activeTile;
+    m_strokeStartCell = m_tiles.cellAt(scenePos);
+    m_strokeLastCell = m_strokeStartCell;
+    m_strokeChanges.clear();
+    
+    switch (m_tool) {
+    case Tool::PaintTiles:
+        m_isPaintingTiles = true;
+        if (m_tiles.setTile(m_strokeStartCell, m_strokeTile, &m_strokeChanges)) {
+            update(m_tiles.cellRect(m_strokeStartCell).translated(-m_viewOffset));
+        }
+        break;
+    case Tool::RectTiles:
+        m_isPaintingTiles = true;
+        update();
+        break;
+    case Tool::FillTiles:
+        // Clipped to the view so filling open space stays bounded
+        m_tiles.floodFill(m_strokeStartCell, m_strokeTile, m_tiles.cellsIn(visibleSceneRect()),
+                          &m_strokeChanges);
+        m_isPaintingTiles = true;
+        finishTileEdit();
+        break;
+    case Tool::Select:
+        break;
+    }
+}
+
+void Canvas::continueTileEdit(const QPoint &scenePos)
+{
+    QPoint cell = m_tiles.cellAt(scenePos);
+    if (cell == m_strokeLastCell) {
+        return;
+    }
+    
+    if (m_tool == Tool::PaintTiles) {
+        // Repaint just the segment; the chunk images are rebuilt lazily
+        if (m_tiles.paintLine(m_strokeLastCell, cell, m_strokeTile, &m_strokeChanges)) {
+            QRect cells = QRect(m_strokeLastCell, cell).normalized();
+            QRect area = m_tiles.cellRect(cells.topLeft()).united(m_tiles.cellRect(cells.bottomRight()));
+            update(area.translated(-m_viewOffset));
+        }
+    } else {
+        update();  // Rectangle preview
+    }
+    m_strokeLastCell = cell;
+}
+
+void Canvas::finishTileEdit()
+{
+    if (m_tool == Tool::RectTiles) {
+        m_tiles.fillRect(QRect(m_strokeStartCell, m_strokeLastCell).normalized(), m_strokeTile, &m_strokeChanges);
+    }
+    m_isPaintingTiles = false;
+    update();
+    
+    if (m_strokeChanges.empty()) {
+        return;
+    }
+    
+    if (m_undoStack) {
+        // The edit is already on the layer; the command only records it
+        QString text = m_strokeTile ? "Paint Tiles" : "Erase Tiles";
+        if (m_tool == Tool::FillTiles) {
+            text = "Fill Tiles";
+        }
+        m_undoStack->push(m_undoStack->create<TileEditCommand>(this, std::move(m_strokeChanges), text));
+    } else {
+        trackTileChanges(m_strokeChanges);
+    }
+    m_strokeChanges.clear();
+}
+
+void Canvas::applyTileChanges(const std::vector<TileLayer::Change> &changes, bool undo)
+{
+    m_tiles.apply(changes, undo);
+    trackTileChanges(changes);
+    update();
+}
+
+void Canvas::trackTileChanges(const std::vector<TileLayer::Change> &changes)
+{
+    QSet<QPoint> chunks;
+    for (const TileLayer::Change &change : changes) {
+        chunks.insert(TileLayer::chunkOf(change.cell));
+    }
+    m_journal->markTileChunksChanged(chunks);
+}
+
+void Canvas::beginBrush(const QPoint &scenePos)
+{
+    if (!m_layers.isEditable(m_activeLayer)) {
+        return;
+    }
+    
+    EntityBrush brush(m_entities, m_gridSize, &m_layers);
+    m_brushStartCell = brush.cellAt(scenePos);
+    m_brushLastCell = m_brushStartCell;
+    
+    if (m_tool == Tool::FillBrush) {
+        // Empty space is filled only as far as the view, so the fill stays bounded
+        applyBrushPlan(brush.fill(m_brushStartCell, m_brushColor, brush.cellsIn(visibleSceneRect())), "Fill");
+        return;
+    }
+    
+    m_isBrushing = true;
+    update();
+}
+
+void Canvas::finishBrush()
+{
+    m_isBrushing = false;
+    update();
+    
+    EntityBrush brush(m_entities, m_gridSize, &m_layers);
+    if (m_tool == Tool::LineBrush) {
+        applyBrushPlan(brush.paint(EntityBrush::lineCells(m_brushStartCell, m_brushLastCell), m_brushColor),
+                       "Line Brush");
+    } else {
+        applyBrushPlan(brush.paint(EntityBrush::rectCells(QRect(m_brushStartCell, m_brushLastCell)), m_brushColor),
+                       "Rectangle Brush");
+    }
+}
+
+void Canvas::applyBrushPlan(EntityBrush::Plan plan, const QString &text)
+{
+    if (plan.isEmpty()) {
+        return;
+    }
+    
+    // Recolored entities are remembered by id with their previous color and
+    // prefab override bits
+    std::vector<int> ids;
+    std::vector<QRgb> oldColors;
+    std::vector<quint8> oldOverrides;
+    ids.reserve(plan.recolorIndices.size());
+    oldColors.reserve(plan.recolorIndices.size());
+    oldOverrides.reserve(plan.recolorIndices.size());
+    for (int index : plan.recolorIndices) {
+        ids.push_back(m_entities[index].id());
+        oldColors.push_back(m_entities[index].color().rgb());
+        oldOverrides.push_back(m_entities[index].overrides());
+    }
+    
+    // New entities take a block of consecutive ids
+    int firstId = m_nextEntityId;
+    m_nextEntityId += static_cast<int>(plan.newPositions.size());
+    QSize size(m_gridSize, m_gridSize);
+    
+    if (m_undoStack) {
+        m_undoStack->push(m_undoStack->create<BrushCommand>(this, firstId, std::move(plan.newPositions), size,
+                                                            m_brushColor, m_activeLayer, std::move(ids),
+                                                            std::move(oldColors), std::move(oldOverrides), text));
+    } else {
+        addEntityBlock(firstId, plan.newPositions, size, m_brushColor, m_activeLayer);
+        setEntityColors(ids, {m_brushColor.rgb()});
+    }
+}
+
+void Canvas::addEntityBlock(int firstId, const std::vector<QPoint> &positions, const QSize &size,
+                            const QColor &color, int layerId)
+{
+    if (positions.empty()) {
+        return;
+    }
+    
+    int first = entityCount();
+    int count = static_cast<int>(positions.size());
+    NameRef nameRef = NamePool::instance().defaultPattern();
+    m_entities.reserve(m_entities.size() + positions.size());
+    for (int i = 0; i < count; ++i) {
+        Entity entity(firstId + i, nameRef, positions[i]);
+        entity.setSize(size.width(), size.height());
+        entity.setColor(color);
+        entity.setLayerId(layerId);
+        m_entities.push_back(entity);
+        trackAdded(entityCount() - 1);
+    }
+    m_nextEntityId = qMax(m_nextEntityId, firstId + count);
+    
+    update();
+    emit entitiesAppended(first, count);
+}
+
+void Canvas::removeEntityBlock(int firstId, int count)
+{
+    if (count <= 0) {
+        return;
+    }
+    
+    int lastId = firstId + count - 1;
+    auto inBlock = [firstId, lastId](const Entity &entity) {
+        return entity.id() >= firstId && entity.id() <= lastId;
+    };
+    
+    int selectedId = -1;
+    if (const Entity *selected = getEntity(m_selectedEntityIndex)) {
+        selectedId = selected->id();
+    }
+    
+    for (const Entity &entity : m_entities) {
+        if (inBlock(entity)) {
+            trackRemoved(entity);
+        }
+    }
+    m_entities.erase(std::remove_if(m_entities.begin(), m_entities.end(), inBlock), m_entities.end());
+    
+    m_selectedEntityIndex = selectedId >= 0 ? indexOfEntityId(selectedId) : -1;
+    if (m_selectedEntityIndex < 0) {
+        m_isDragging = false;
+    }
+    
+    update();
+    emit sceneReset();
+    emit entitiesAppended(0, entityCount());
+    emit entitySelectionChanged(m_selectedEntityIndex);
+}
+
+void Canvas::setEntityColors(const std::vector<int> &ids, const std::vector<QRgb> &colors,
+                             const std::vector<quint8> *overrides)
+{
+    if (ids.empty() || colors.empty()) {
+        return;
+    }
+    
+    // One pass over the scene instead of one id lookup per entity
+    QHash<int, int> slotById;
+    slotById.reserve(static_cast<int>(ids.size()));
+    for (int i = 0; i < static_cast<int>(ids.size()); ++i) {
+        slotById.insert(ids[i], i);
+    }
+    
+    bool selectedChanged = false;
+    for (int i = 0; i < entityCount(); ++i) {
+        auto it = slotById.constFind(m_entities[i].id());
+        if (it == slotById.constEnd()) {
+            continue;
+        }
+        QRgb rgb = colors.size() == 1 ? colors.front() : colors[it.value()];
+        m_entities[i].setColor(QColor(rgb));
+        if (overrides && m_entities[i].isPrefabInstance()) {
+            // setColor() marked the color overridden; put back what it was
+            m_entities[i].setPrefab(m_entities[i].prefabId(), (*overrides)[it.value()]);
+            refreshFromPrefab(&m_entities[i]);
+        }
+        trackChanged(m_entities[i]);
+        selectedChanged = selectedChanged || i == m_selectedEntityIndex;
+    }
+    
+    update();
+    if (selectedChanged) {
+        emit entitySelectionChanged(m_selectedEntityIndex);  // Refresh the inspector
+    }
+}
+
+int Canvas::setEntityProperty(const QSet<int> &ids, EntityProperty property, const QVariant &value)
+{
+    if (m_streaming || ids.isEmpty()) {
+        return 0;
+    }
+    
+    // One pass over the scene; only the entities the edit changes are kept,
+    // each with the property's value and override bit before and after
+    std::vector<EntityPropertyState> before;
+    std::vector<EntityPropertyState> after;
+    QString name = value.toString();
+    QColor color = value.value<QColor>();
+    int size = value.toInt();
+    PooledName nameRef = property == EntityProperty::Name ? NamePool::instance().intern(name) : PooledName();
+    quint8 overrideBit = overrideBitOf(static_cast<int>(property));
+    for (const Entity &entity : m_entities) {
+        if (!ids.contains(entity.id())) {
+            continue;
+        }
+        EntityPropertyState old{entity.id(), entity.nameRef(), entity.color().rgba(), 0,
+                                (entity.overrides() & overrideBit) != 0};
+        EntityPropertyState edited = old;
+        edited.overridden = entity.isPrefabInstance();  // Setting a value overrides the prefab
+        bool changed = false;
+        switch (property) {
+        case EntityProperty::Name:
+            changed = entity.name() != name;
+            edited.name = nameRef;
+            break;
+        case EntityProperty::Color:
+            changed = color.isValid() && entity.color() != color;
+            edited.color = color.rgba();
+            break;
+        case EntityProperty::Width:
+            old.size = entity.rect().width();
+            changed = old.size != size;
+            edited.size = size;
+            break;
+        case EntityProperty::Height:
+            old.size = entity.rect().height();
+            changed = old.size != size;
+            edited.size = size;
+            break;
+        }
+        if (changed) {
+            before.push_back(std::move(old));
+            after.push_back(std::move(edited));
+        }
+    }
+    
+    int count = static_cast<int>(after.size());
+    if (count == 0) {
+        return 0;
+    }
+    if (!m_undoStack) {
+        setEntityStates(static_cast<int>(property), after);
+        return count;
+    }
+    
+    QString verb = property == EntityProperty::Name    ? "Rename"
+                   : property == EntityProperty::Color ? "Recolor"
+                                                       : "Resize";
+    QString text = count == 1 ? QString("%1 Entity").arg(verb) : QString("%1 %2 Entities").arg(verb).arg(count);
+    m_undoStack->push(m_undoStack->create<EditEntitiesCommand>(this, static_cast<int>(property), std::move(before),
+                                                               std::move(after), text));
+    return count;
+}
+
+quint8 Canvas::overrideBitOf(int property)
+{
+    switch (static_cast<EntityProperty>(property)) {
+    case EntityProperty::Name:
+        return Entity::OverrideName;
+    case EntityProperty::Color:
+        return Entity::OverrideColor;
+    case EntityProperty::Width:
+    case EntityProperty::Height:
+        return Entity::OverrideSize;
+    }
+    return 0;
+}
+
+void Canvas::setEntityStates(int property, const std::vector<EntityPropertyState> &states)
+{
+    if (states.empty()) {
+        return;
+    }
+    
+    QHash<int, int> slotById;
+    slotById.reserve(static_cast<int>(states.size()));
+    for (int i = 0; i < static_cast<int>(states.size()); ++i) {
+        slotById.insert(states[i].entityId, i);
     }
     
-    // Emit signal
-    emit entityRemoved(index);
-    emit entitySelectionChanged(m_selectedEntityIndex);
+    // Only the edited property: grouping, layers and prefab links may have
+    // changed since and stay as they are
+    quint8 overrideBit = overrideBitOf(property);
+    for (int i = 0; i < entityCount(); ++i) {
+        auto it = slotById.constFind(m_entities[i].id());
+        if (it == slotById.constEnd()) {
+            continue;
+        }
+        const EntityPropertyState &state = states[it.value()];
+        Entity &entity = m_entities[i];
+        switch (static_cast<EntityProperty>(property)) {
+        case EntityProperty::Name:
+            entity.setNameRef(state.name);
+            break;
+        case EntityProperty::Color:
+            entity.setColor(QColor::fromRgba(state.color));
+            break;
+        case EntityProperty::Width:
+            entity.setSize(state.size, entity.rect().height());
+            break;
+        case EntityProperty::Height:
+            entity.setSize(entity.rect().width(), state.size);
+            break;
+        }
+        if (entity.isPrefabInstance()) {
+            // The setters mark the override; put back the bit the state had
+            quint8 overrides = entity.overrides() & ~overrideBit;
+            entity.setPrefab(entity.prefabId(), state.overridden ? overrides | overrideBit : overrides);
+            refreshFromPrefab(&entity);
+        }
+        trackChanged(entity);
+        emit entityChanged(i);
+    }
+    update();
+}
+
+void Canvas::appendEntityBlock(const std::vector<Entity> &entities,
+                               const QHash<int, ComponentStore::Values> &components)
+{
+    if (entities.empty()) {
+        return;
+    }
+    
+    int first = entityCount();
+    m_entities.reserve(m_entities.size() + entities.size());
+    for (const Entity &entity : entities) {
+        m_entities.push_back(entity);
+        refreshFromPrefab(&m_entities.back());
+        auto values = components.constFind(entity.id());
+        if (values != components.constEnd()) {
+            m_components.setValues(entity.id(), values.value());
+        }
+        trackAdded(entityCount() - 1);
+        m_nextEntityId = qMax(m_nextEntityId, entity.id() + 1);
+    }
     
     update();
+    emit entitiesAppended(first, static_cast<int>(entities.size()));
 }
 
-int Canvas::insertEntity(const Entity &entity, int index)
+std::vector<std::pair<int, Entity>> Canvas::takeEntities(const QSet<int> &ids)
 {
-    if (index < 0) {
-        index = static_cast<int>(m_entities.size());
-    } else if (index > static_cast<int>(m_entities.size())) {
-        index = static_cast<int>(m_entities.size());
+    std::vector<std::pair<int, Entity>> removed;
+    if (ids.isEmpty()) {
+        return removed;
     }
     
-    m_entities.insert(m_entities.begin() + index, entity);
+    int selectedId = -1;
+    if (const Entity *selected = getEntity(m_selectedEntityIndex)) {
+        selectedId = selected->id();
+    }
     
-    // Adjust selection if needed
-    if (m_selectedEntityIndex >= index) {
-        m_selectedEntityIndex++;
+    // One compaction pass, keeping each removed entity's index for undo
+    size_t kept = 0;
+    for (size_t i = 0; i < m_entities.size(); ++i) {
+        if (ids.contains(m_entities[i].id())) {
+            trackRemoved(m_entities[i]);
+            removed.emplace_back(static_cast<int>(i), std::move(m_entities[i]));
+        } else {
+            if (kept != i) {
+                m_entities[kept] = std::move(m_entities[i]);
+            }
+            ++kept;
+        }
     }
+    if (removed.empty()) {
+        return removed;
+    }
+    m_entities.erase(m_entities.begin() + kept, m_entities.end());
     
-    // Emit signal
-    emit entityAdded(index);
+    m_selectedEntityIndex = selectedId >= 0 ? indexOfEntityId(selectedId) : -1;
+    if (m_selectedEntityIndex < 0) {
+        m_isDragging = false;
+    }
+    
+    update();
+    emit sceneReset();
+    emit entitiesAppended(0, entityCount());
     emit entitySelectionChanged(m_selectedEntityIndex);
+    emit selectionSetChanged();
+    return removed;
+}
+
+void Canvas::restoreEntities(const std::vector<std::pair<int, Entity>> &removed,
+                             const QHash<int, ComponentStore::Values> &components)
+{
+    if (removed.empty()) {
+        return;
+    }
     
+    int selectedId = -1;
+    if (const Entity *selected = getEntity(m_selectedEntityIndex)) {
+        selectedId = selected->id();
+    }
+    
+    // Entities that came back some other way (world chunk reload) are skipped
+    QSet<int> resident;
+    for (const Entity &entity : m_entities) {
+        resident.insert(entity.id());
+    }
+    
+    // Merge by original index: removed[k] goes back to index removed[k].first
+    std::vector<Entity> merged;
+    merged.reserve(m_entities.size() + removed.size());
+    auto next = m_entities.begin();
+    for (const auto &entry : removed) {
+        while (static_cast<int>(merged.size()) < entry.first && next != m_entities.end()) {
+            merged.push_back(std::move(*next++));
+        }
+        if (!resident.contains(entry.second.id())) {
+            merged.push_back(entry.second);
+            refreshFromPrefab(&merged.back());
+            auto values = components.constFind(entry.second.id());
+            if (values != components.constEnd()) {
+                m_components.setValues(entry.second.id(), values.value());
+            }
+            trackChanged(merged.back());
+        }
+    }
+    merged.insert(merged.end(), std::make_move_iterator(next), std::make_move_iterator(m_entities.end()));
+    m_entities = std::move(merged);
+    
+    m_selectedEntityIndex = selectedId >= 0 ? indexOfEntityId(selectedId) : -1;
+    
+    update();
+    emit sceneReset();
+    emit entitiesAppended(0, entityCount());
+    emit entitySelectionChanged(m_selectedEntityIndex);
+}
+
+void Canvas::installLayers(const LayerStack &layers)
+{
+    m_layers = layers;
+    m_activeLayer = LayerStack::DEFAULT_LAYER;
+    invalidateLayerCaches();
+    m_minimapDirty = true;
+    emit layersChanged();
+}
+
+void Canvas::layersEdited()
+{
+    m_journal->markLayersChanged();
     update();
+    emit layersChanged();
+}
+
+void Canvas::setActiveLayer(int layerId)
+{
+    layerId = m_layers.resolve(layerId);
+    if (m_activeLayer != layerId) {
+        // The old active layer goes back to being drawn from its cache
+        invalidateLayerCache(m_activeLayer);
+        m_activeLayer = layerId;
+        update();
+        emit layersChanged();
+    }
+}
+
+int Canvas::addLayer(const QString &name)
+{
+    int layerId = m_layers.add(name);
+    m_activeLayer = layerId;
+    layersEdited();
+    return layerId;
+}
+
+void Canvas::removeLayer(int layerId)
+{
+    if (m_streaming || !m_layers.remove(layerId)) {
+        return;
+    }
     
-    return index;
+    // Its entities fall back to the default layer
+    for (Entity &entity : m_entities) {
+        if (entity.layerId() == layerId) {
+            entity.setLayerId(LayerStack::DEFAULT_LAYER);
+            trackChanged(entity);
+        }
+    }
+    m_layerCaches.remove(layerId);
+    if (m_activeLayer == layerId) {
+        m_activeLayer = LayerStack::DEFAULT_LAYER;
+    }
+    layersEdited();
 }
 
-void Canvas::setUndoStack(QUndoStack *undoStack)
+void Canvas::renameLayer(int layerId, const QString &name)
 {
-    m_undoStack = undoStack;
+    if (m_layers.rename(layerId, name)) {
+        layersEdited();
+    }
 }
 
-void Canvas::duplicateSelectedEntity()
+void Canvas::setLayerVisible(int layerId, bool visible)
 {
-    if (m_selectedEntityIndex < 0 || m_selectedEntityIndex >= static_cast<int>(m_entities.size())) {
-        return;  // No entity selected
+    if (!m_layers.setVisible(layerId, visible)) {
+        return;
+    }
+    
+    // A hidden selection can't be edited
+    const Entity *selected = getEntity(m_selectedEntityIndex);
+    if (!visible && selected && m_layers.resolve(selected->layerId()) == layerId) {
+        setSelectedEntityIndex(-1);
     }
     
-    const Entity *sourceEntity = getEntity(m_selectedEntityIndex);
-    if (!sourceEntity) {
+    // Only the layer's own entities enter or leave the minimap
+    for (const Entity &entity : m_entities) {
+        if (m_layers.resolve(entity.layerId()) == layerId) {
+            updateMinimapEntry(entity);
+        }
+    }
+    layersEdited();
+}
+
+void Canvas::setLayerLocked(int layerId, bool locked)
+{
+    if (m_layers.setLocked(layerId, locked)) {
+        layersEdited();
+    }
+}
+
+void Canvas::moveLayer(int layerId, int position)
+{
+    if (m_layers.moveTo(layerId, position)) {
+        layersEdited();
+    }
+}
+
+void Canvas::moveSelectedEntityToLayer(int layerId)
+{
+    Entity *entity = getEntity(m_selectedEntityIndex);
+    if (!entity || m_streaming || !m_layers.contains(layerId) || entity->layerId() == layerId) {
         return;
     }
     
-    // Calculate offset position (offset by entity width + 10 pixels)
-    QPoint offsetPos = sourceEntity->position() + QPoint(sourceEntity->rect().width() + 10, 0);
+    invalidateLayerCache(entity->layerId());
+    entity->setLayerId(layerId);
+    notifyEntityChanged(m_selectedEntityIndex);
     
-    // Snap to grid if enabled
-    if (m_snapToGrid) {
-        offsetPos = snapToGrid(offsetPos);
+    // Follow it if the target layer hides it
+    if (!m_layers.isVisible(layerId)) {
+        setSelectedEntityIndex(-1);
+    }
+}
+
+void Canvas::installGroups(const GroupTree &groups)
+{
+    m_groups = groups;
+    m_groupBvhDirty = true;
+    m_dragGroupId = GroupTree::NO_GROUP;
+}
+
+void Canvas::installComponents(const ComponentStore &components)
+{
+    m_components = components;
+    emit componentTypesChanged();
+}
+
+int Canvas::defineComponentType(const QString &name, const std::vector<ComponentField> &fields)
+{
+    if (m_streaming || isWorldOpen()) {
+        return 0;
     }
     
-    // Use AddEntityCommand to create new entity at offset position
+    // Validate and reserve the id now; the command installs the type under it
+    int typeId = m_components.registry().add(name, fields);
+    if (typeId == 0) {
+        return 0;
+    }
+    ComponentType type = *m_components.registry().find(typeId);
+    m_components.registry().remove(typeId);
+    
     if (m_undoStack) {
-        AddEntityCommand *command = new AddEntityCommand(this, offsetPos);
-        m_undoStack->push(command);
-        
-        // After command executes, update the new entity's properties
-        // Get the newly created entity (it will be the last one)
-        int newIndex = entityCount() - 1;
-        Entity *newEntity = getEntity(newIndex);
-        if (newEntity) {
-            QString entityName = QString("%1 (Copy)").arg(sourceEntity->name());
-            newEntity->setName(entityName);
-            newEntity->setColor(sourceEntity->color());
-            newEntity->setSize(sourceEntity->rect().width(), sourceEntity->rect().height());
-            
-            // Select the new entity
-            setSelectedEntityIndex(newIndex);
-            update();
+        m_undoStack->push(m_undoStack->create<DefineComponentCommand>(this, type));
+    } else {
+        setComponentTypeDefined(type, true);
+    }
+    return typeId;
+}
+
+bool Canvas::setComponentTypeDefined(const ComponentType &type, bool defined)
+{
+    if (defined) {
+        if (!m_components.registry().insert(type)) {
+            return false;
         }
     } else {
-        // Fallback: create directly
-        QString entityName = QString("%1 (Copy)").arg(sourceEntity->name());
-        Entity newEntity(m_nextEntityId, entityName, offsetPos);
-        
-        // Copy properties
-        newEntity.setColor(sourceEntity->color());
-        newEntity.setSize(sourceEntity->rect().width(), sourceEntity->rect().height());
-        
-        int newIndex = static_cast<int>(m_entities.size());
-        m_entities.push_back(newEntity);
-        
-        m_selectedEntityIndex = newIndex;
-        
-        emit entityAdded(newIndex);
-        emit entitySelectionChanged(m_selectedEntityIndex);
-        
-        m_nextEntityId++;
-        update();
+        // Entities that got the type some other way (hot reload) lose it
+        QSet<int> affected;
+        for (const ComponentStore::Archetype *archetype : m_components.query({type.id})) {
+            affected.unite(QSet<int>(archetype->entityIds.begin(), archetype->entityIds.end()));
+        }
+        m_components.removeType(type.id);
+        if (!affected.isEmpty()) {
+            for (const Entity &entity : m_entities) {
+                if (affected.contains(entity.id())) {
+                    trackChanged(entity);
+                }
+            }
+        }
+    }
+    m_journal->markComponentTypesChanged();
+    emit componentTypesChanged();
+    return true;
+}
+
+bool Canvas::addComponent(int index, int typeId)
+{
+    const Entity *entity = getEntity(index);
+    const ComponentType *type = m_components.registry().find(typeId);
+    if (m_streaming || isWorldOpen() || !entity || !type || m_components.has(entity->id(), typeId)) {
+        return false;
+    }
+    ComponentStore::Values after = m_components.valuesOf(entity->id());
+    QVariantList defaults;
+    for (const ComponentField &field : type->fields) {
+        defaults.append(field.defaultValue);
+    }
+    after.insert(typeId, defaults);
+    pushComponentState(entity->id(), typeId, -1, std::move(after), QString("Add %1").arg(type->name));
+    return true;
+}
+
+bool Canvas::removeComponent(int index, int typeId)
+{
+    const Entity *entity = getEntity(index);
+    const ComponentType *type = m_components.registry().find(typeId);
+    if (m_streaming || isWorldOpen() || !entity || !type || !m_components.has(entity->id(), typeId)) {
+        return false;
+    }
+    ComponentStore::Values after = m_components.valuesOf(entity->id());
+    after.remove(typeId);
+    pushComponentState(entity->id(), typeId, -1, std::move(after), QString("Remove %1").arg(type->name));
+    return true;
+}
+
+bool Canvas::setComponentValue(int index, int typeId, int field, const QVariant &value)
+{
+    const Entity *entity = getEntity(index);
+    const ComponentType *type = m_components.registry().find(typeId);
+    if (m_streaming || isWorldOpen() || !entity || !type || field < 0 ||
+        field >= static_cast<int>(type->fields.size()) || !m_components.has(entity->id(), typeId)) {
+        return false;
+    }
+    const ComponentField &definition = type->fields[field];
+    QVariant converted = ComponentRegistry::convert(value, definition.type);
+    if (m_components.value(entity->id(), typeId, field) == converted) {
+        return false;
+    }
+    ComponentStore::Values after = m_components.valuesOf(entity->id());
+    after[typeId][field] = converted;
+    pushComponentState(entity->id(), typeId, field, std::move(after),
+                       QString("Edit %1.%2").arg(type->name, definition.name));
+    return true;
+}
+
+void Canvas::pushComponentState(int entityId, int typeId, int field, ComponentStore::Values &&after,
+                                const QString &text)
+{
+    if (!m_undoStack) {
+        setEntityComponents(entityId, after);
+        return;
+    }
+    m_undoStack->push(m_undoStack->create<ComponentCommand>(this, entityId, typeId, field,
+                                                            m_components.valuesOf(entityId), after, text));
+}
+
+bool Canvas::setEntityComponents(int entityId, const ComponentStore::Values &values)
+{
+    int index = indexOfEntityId(entityId, m_selectedEntityIndex);
+    if (index < 0) {
+        return false;
+    }
+    m_components.setValues(entityId, values);
+    notifyEntityChanged(index);
+    return true;
+}
+
+void Canvas::ensureGroupBvhCurrent()
+{
+    if (m_groupBvhDirty) {
+        m_groupBvh.build(m_entities, m_groups);
+        m_groupBvhDirty = false;
+    }
+}
+
+MinimapRaster &Canvas::minimap()
+{
+    m_minimapEnabled = true;
+    if (m_minimapDirty) {
+        m_minimap.rebuild(m_entities, m_layers);
+        m_minimapDirty = false;
+    }
+    return m_minimap;
+}
+
+bool Canvas::isInDraggedGroup(int index) const
+{
+    return m_isDragging && m_dragGroupId != GroupTree::NO_GROUP &&
+           std::binary_search(m_dragGroupMembers.begin(), m_dragGroupMembers.end(), index);
+}
+
+int Canvas::groupEntitiesIn(const QRect &sceneRect)
+{
+    if (m_streaming || isWorldOpen()) {
+        return GroupTree::NO_GROUP;
+    }
+    ensureGroupBvhCurrent();
+    
+    // Ungrouped entities inside the rect join the new group; groups join it
+    // whole, and only when they lie entirely inside
+    std::vector<int> candidates;
+    m_groupBvh.query(sceneRect, &candidates);
+    std::vector<int> loose;
+    QSet<int> nested;
+    for (int index : candidates) {
+        const Entity &entity = m_entities[index];
+        if (!sceneRect.contains(entity.rect()) || !m_layers.isEditable(entity.layerId())) {
+            continue;
+        }
+        int root = m_groups.rootOf(entity.groupId());
+        if (root == GroupTree::NO_GROUP) {
+            loose.push_back(index);
+        } else if (sceneRect.contains(m_groupBvh.groupBounds(root))) {
+            nested.insert(root);
+        }
+    }
+    if (loose.size() + nested.size() < 2) {
+        return GroupTree::NO_GROUP;
+    }
+    
+    // Reserve the id now; the command creates the group under it
+    EntityGroup group;
+    group.name = QString("Group %1").arg(m_groups.size() + 1);
+    group.id = m_groups.add(group.name);
+    m_groups.remove(group.id);
+    
+    std::vector<int> childGroupIds(nested.begin(), nested.end());
+    std::vector<int> memberIds;
+    memberIds.reserve(loose.size());
+    for (int index : loose) {
+        memberIds.push_back(m_entities[index].id());
+    }
+    if (m_undoStack) {
+        m_undoStack->push(m_undoStack->create<GroupCommand>(this, group, std::move(childGroupIds),
+                                                            std::move(memberIds), false));
+    } else {
+        formGroup(group, childGroupIds, memberIds);
+    }
+    return group.id;
+}
+
+void Canvas::ungroupSelected()
+{
+    const Entity *selected = getEntity(m_selectedEntityIndex);
+    int groupId = selected ? m_groups.rootOf(selected->groupId()) : GroupTree::NO_GROUP;
+    if (groupId == GroupTree::NO_GROUP || m_streaming || isWorldOpen()) {
+        return;
+    }
+    
+    // Remember the direct members and nested groups so undo can regroup them
+    ensureGroupBvhCurrent();
+    std::vector<int> memberIds;
+    for (int index : m_groupBvh.membersOf(groupId)) {
+        if (m_entities[index].groupId() == groupId) {
+            memberIds.push_back(m_entities[index].id());
+        }
+    }
+    EntityGroup group = *m_groups.find(groupId);
+    std::vector<int> childGroupIds = m_groups.childrenOf(groupId);
+    if (m_undoStack) {
+        m_undoStack->push(m_undoStack->create<GroupCommand>(this, group, std::move(childGroupIds),
+                                                            std::move(memberIds), true));
+    } else {
+        dissolveGroup(groupId);
+    }
+}
+
+void Canvas::formGroup(const EntityGroup &group, const std::vector<int> &childGroupIds,
+                       const std::vector<int> &memberIds)
+{
+    ensureGroupBvhCurrent();
+    m_groups.insert(group);
+    m_groupBvh.addGroup(group.id, group.parentId);
+    for (int child : childGroupIds) {
+        if (m_groups.setParent(child, group.id)) {
+            m_groupBvh.setGroupParent(child, group.id);
+        }
+    }
+    
+    QSet<int> members(memberIds.begin(), memberIds.end());
+    for (int i = 0; i < entityCount() && !members.isEmpty(); ++i) {
+        Entity &entity = m_entities[i];
+        if (!members.remove(entity.id())) {
+            continue;
+        }
+        entity.setGroupId(group.id);
+        if (!m_groupBvh.setEntityGroup(entity.id(), group.id)) {
+            m_groupBvhDirty = true;
+        }
+        trackChanged(entity);
+        emit entityChanged(i);
+    }
+    m_journal->markGroupsChanged();
+    update();
+}
+
+void Canvas::dissolveGroup(int groupId)
+{
+    const EntityGroup *group = m_groups.find(groupId);
+    if (!group) {
+        return;
+    }
+    
+    // Direct members and nested groups move up to the group's parent
+    int parentId = group->parentId;
+    ensureGroupBvhCurrent();
+    std::vector<int> members = m_groupBvh.membersOf(groupId);
+    m_groupBvh.removeGroup(groupId, parentId);
+    m_groups.remove(groupId);
+    for (int index : members) {
+        Entity &entity = m_entities[index];
+        if (entity.groupId() == groupId) {
+            entity.setGroupId(parentId);
+            trackChanged(entity);
+            emit entityChanged(index);
+        }
+    }
+    m_journal->markGroupsChanged();
+    update();
+}
+
+bool Canvas::translateGroup(int groupId, const QPoint &delta)
+{
+    if (!m_groups.contains(groupId)) {
+        return false;
+    }
+    if (delta.isNull()) {
+        return true;
+    }
+    ensureGroupBvhCurrent();
+    
+    // The hierarchy shifts the group's subtree as one node. Member positions
+    // are still what files, exports and diffs read, so they follow in one
+    // pass; the per-entity bookkeeping finds their rects already current.
+    m_groupBvh.translateGroup(groupId, delta);
+    for (int index : m_groupBvh.membersOf(groupId)) {
+        Entity &entity = m_entities[index];
+        entity.setPosition(entity.position() + delta);
+        trackChanged(entity);
     }
-}
\ No newline at end of file
+    update();
+    emit groupMoved(groupId);
+    return true;
+}
@@ -0,0 +1,76 @@
+#include "CommandArena.h"
+#include <new>
+
+CommandArena::CommandArena(std::size_t slabSize)
+    : m_slabSize(slabSize)
+    , m_cursor(nullptr)
+    , m_end(nullptr)
+{
+    for (FreeNode *&list : m_freeLists) {
+        list = nullptr;
+    }
+}
+
+CommandArena::~CommandArena()
+{
+    for (char *slab : m_slabs) {
+        ::operator delete(slab);
+    }
+}
+
+char *CommandArena::carve(std::size_t bytes)
+{
+    if (m_cursor == nullptr || static_cast<std::size_t>(m_end - m_cursor) < bytes) {
+        // Start a new slab; the unused tail of the old one is simply abandoned
+        char *slab = static_cast<char *>(::operator new(m_slabSize));
+        m_slabs.push_back(slab);
+        m_cursor = slab;
+        m_end = slab + m_slabSize;
+        m_stats.slabAllocations++;
+        m_stats.reservedBytes += m_slabSize;
+    }
+    char *block = m_cursor;
+    m_cursor += bytes;
+    return block;
+}
+
+void *CommandArena::allocate(std::size_t size)
+{
+    std::size_t cls = sizeClass(size);
+    if (cls == 0 || cls > NUM_CLASSES) {
+        // Oversized (or empty) requests bypass the pool
+        m_stats.allocations++;
+        m_stats.liveBlocks++;
+        return ::operator new(size);
+    }
+
+    m_stats.allocations++;
+    m_stats.liveBlocks++;
+
+    // Reuse a block released by a trimmed/undone command if one is available
+    FreeNode *node = m_freeLists[cls];
+    if (node) {
+        m_freeLists[cls] = node->next;
+        m_stats.recycled++;
+        return node;
+    }
+    return carve(cls * GRANULE);
+}
+
+void CommandArena::release(void *ptr, std::size_t size)
+{
+    if (!ptr) {
+        return;
+    }
+    m_stats.liveBlocks--;
+
+    std::size_t cls = sizeClass(size);
+    if (cls == 0 || cls > NUM_CLASSES) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    FreeNode *node = static_cast<FreeNode *>(ptr);
+    node->next = m_freeLists[cls];
+    m_freeLists[cls] = node;
+}
@@ -0,0 +1,49 @@
+#include "ComponentCommand.h"
+#include "Canvas.h"
+
+ComponentCommand::ComponentCommand(Canvas *canvas, int entityId, int typeId, int field,
+                                   const ComponentStore::Values &before, const ComponentStore::Values &after,
+                                   const QString &text, QUndoCommand *parent)
+    : EditorCommand(parent)
+    , m_canvas(canvas)
+    , m_entityId(entityId)
+    , m_typeId(typeId)
+    , m_field(field)
+    , m_before(before)
+    , m_after(after)
+{
+    setText(text);
+}
+
+void ComponentCommand::redo()
+{
+    if (!m_canvas) return;
+    
+    apply(m_after);
+}
+
+void ComponentCommand::undo()
+{
+    if (!m_canvas) return;
+    
+    apply(m_before);
+}
+
+void ComponentCommand::apply(const ComponentStore::Values &values)
+{
+    if (!m_canvas->setEntityComponents(m_entityId, values)) {
+        setObsolete(true);
+        m_canvas->reportCommandFailure(text());
+    }
+}
+
+bool ComponentCommand::mergeWith(const QUndoCommand *other)
+{
+    const ComponentCommand *next = static_cast<const ComponentCommand *>(other);
+    if (m_field < 0 || next->m_canvas != m_canvas || next->m_entityId != m_entityId ||
+        next->m_typeId != m_typeId || next->m_field != m_field) {
+        return false;
+    }
+    m_after = next->m_after;  // Keep the original "before"
+    return true;
+}
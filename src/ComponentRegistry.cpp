@@ -0,0 +1,269 @@
+#include "ComponentRegistry.h"
+#include <QColor>
+#include <QJsonObject>
+#include <QSet>
+#include <QStringList>
+
+int ComponentType::fieldIndex(const QString &fieldName) const
+{
+    for (int i = 0; i < static_cast<int>(fields.size()); ++i) {
+        if (fields[i].name == fieldName) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+ComponentRegistry::ComponentRegistry()
+    : m_nextId(1)
+{
+}
+
+int ComponentRegistry::add(const QString &name, const std::vector<ComponentField> &fields)
+{
+    if (!isValidName(name) || m_idByName.contains(name)) {
+        return 0;
+    }
+    QSet<QString> fieldNames;
+    for (const ComponentField &field : fields) {
+        if (!isValidName(field.name) || fieldNames.contains(field.name)) {
+            return 0;
+        }
+        fieldNames.insert(field.name);
+    }
+    
+    ComponentType type;
+    type.id = m_nextId++;
+    type.name = name;
+    type.fields = fields;
+    for (ComponentField &field : type.fields) {
+        field.defaultValue = convert(field.defaultValue, field.type);
+    }
+    m_indexById.insert(type.id, size());
+    m_idByName.insert(name, type.id);
+    m_types.push_back(type);
+    return type.id;
+}
+
+bool ComponentRegistry::isValidName(const QString &name)
+{
+    if (name.isEmpty()) {
+        return false;
+    }
+    for (QChar c : name) {
+        if (!c.isLetterOrNumber() && c != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ComponentRegistry::insert(const ComponentType &type)
+{
+    if (type.id <= 0 || m_indexById.contains(type.id) || m_idByName.contains(type.name)) {
+        return false;
+    }
+    m_indexById.insert(type.id, size());
+    m_idByName.insert(type.name, type.id);
+    m_types.push_back(type);
+    m_nextId = qMax(m_nextId, type.id + 1);
+    return true;
+}
+
+bool ComponentRegistry::remove(int id)
+{
+    auto it = m_indexById.find(id);
+    if (it == m_indexById.end()) {
+        return false;
+    }
+    int index = it.value();
+    m_idByName.remove(m_types[index].name);
+    m_indexById.erase(it);
+    m_types.erase(m_types.begin() + index);
+    for (auto &position : m_indexById) {
+        if (position > index) {
+            --position;
+        }
+    }
+    return true;  // m_nextId stays: ids are never reused
+}
+
+const ComponentType *ComponentRegistry::find(int id) const
+{
+    auto it = m_indexById.constFind(id);
+    return it != m_indexById.constEnd() ? &m_types[it.value()] : nullptr;
+}
+
+void ComponentRegistry::clear()
+{
+    m_types.clear();
+    m_indexById.clear();
+    m_idByName.clear();
+    m_nextId = 1;
+}
+
+bool ComponentRegistry::parseFields(const QString &spec, std::vector<ComponentField> *fields, QString *error)
+{
+    fields->clear();
+    const QStringList parts = spec.split(',', Qt::SkipEmptyParts);
+    for (const QString &part : parts) {
+        // name[:type][=default]
+        QString text = part.trimmed();
+        QString defaultText;
+        int equals = text.indexOf('=');
+        if (equals >= 0) {
+            defaultText = text.mid(equals + 1).trimmed();
+            text = text.left(equals).trimmed();
+        }
+        ComponentField field;
+        int colon = text.indexOf(':');
+        field.name = (colon >= 0 ? text.left(colon) : text).trimmed();
+        if (colon >= 0 && !typeFromName(text.mid(colon + 1).trimmed(), &field.type)) {
+            *error = QString("Unknown field type in '%1' (int, float, bool, string or color)").arg(part.trimmed());
+            return false;
+        }
+        if (field.name.isEmpty()) {
+            *error = QString("Missing field name in '%1'").arg(part.trimmed());
+            return false;
+        }
+        if (!isValidName(field.name)) {
+            *error = QString("Field names use letters, digits and '_' only ('%1')").arg(field.name);
+            return false;
+        }
+        field.defaultValue = convert(defaultText.isEmpty() ? QVariant() : QVariant(defaultText), field.type);
+        fields->push_back(field);
+    }
+    return true;
+}
+
+QVariant ComponentRegistry::convert(const QVariant &value, ComponentField::Type type)
+{
+    switch (type) {
+    case ComponentField::Type::Int:
+        return QVariant::fromValue<qint64>(value.isValid() ? value.toLongLong() : 0);
+    case ComponentField::Type::Float:
+        return QVariant(value.isValid() ? value.toDouble() : 0.0);
+    case ComponentField::Type::Bool:
+        if (value.typeId() == QMetaType::QString) {
+            QString text = value.toString().toLower();
+            return QVariant(text == "true" || text == "1" || text == "yes");
+        }
+        return QVariant(value.toBool());
+    case ComponentField::Type::String:
+        return QVariant(value.toString());
+    case ComponentField::Type::Color: {
+        QColor color = value.typeId() == QMetaType::QColor ? value.value<QColor>() : QColor(value.toString());
+        return QVariant::fromValue(color.isValid() ? color : QColor(Qt::white));
+    }
+    }
+    return QVariant();
+}
+
+QJsonValue ComponentRegistry::toJsonValue(const QVariant &value, ComponentField::Type type)
+{
+    switch (type) {
+    case ComponentField::Type::Int:
+        return QJsonValue(value.toLongLong());
+    case ComponentField::Type::Float:
+        return QJsonValue(value.toDouble());
+    case ComponentField::Type::Bool:
+        return QJsonValue(value.toBool());
+    case ComponentField::Type::String:
+        return QJsonValue(value.toString());
+    case ComponentField::Type::Color:
+        return QJsonValue(value.value<QColor>().name(QColor::HexArgb));
+    }
+    return QJsonValue();
+}
+
+QVariant ComponentRegistry::fromJsonValue(const QJsonValue &value, ComponentField::Type type)
+{
+    if (type == ComponentField::Type::Int) {
+        return QVariant::fromValue<qint64>(value.toInteger());
+    }
+    return convert(value.toVariant(), type);
+}
+
+QString ComponentRegistry::typeName(ComponentField::Type type)
+{
+    switch (type) {
+    case ComponentField::Type::Int:
+        return "int";
+    case ComponentField::Type::Float:
+        return "float";
+    case ComponentField::Type::Bool:
+        return "bool";
+    case ComponentField::Type::String:
+        return "string";
+    case ComponentField::Type::Color:
+        return "color";
+    }
+    return QString();
+}
+
+bool ComponentRegistry::typeFromName(const QString &name, ComponentField::Type *type)
+{
+    static const ComponentField::Type all[] = {ComponentField::Type::Int, ComponentField::Type::Float,
+                                               ComponentField::Type::Bool, ComponentField::Type::String,
+                                               ComponentField::Type::Color};
+    for (ComponentField::Type candidate : all) {
+        if (typeName(candidate) == name) {
+            *type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+QJsonArray ComponentRegistry::toJson() const
+{
+    QJsonArray array;
+    for (const ComponentType &type : m_types) {
+        QJsonArray fields;
+        for (const ComponentField &field : type.fields) {
+            QJsonObject json;
+            json["name"] = field.name;
+            json["type"] = typeName(field.type);
+            json["default"] = toJsonValue(field.defaultValue, field.type);
+            fields.append(json);
+        }
+        QJsonObject json;
+        json["id"] = type.id;
+        json["name"] = type.name;
+        json["fields"] = fields;
+        array.append(json);
+    }
+    return array;
+}
+
+ComponentRegistry ComponentRegistry::fromJson(const QJsonArray &array)
+{
+    ComponentRegistry registry;
+    for (const QJsonValue &value : array) {
+        QJsonObject json = value.toObject();
+        QString name = json["name"].toString();
+        int id = json["id"].toInt();
+        if (!isValidName(name) || id <= 0 || registry.m_indexById.contains(id) || registry.m_idByName.contains(name)) {
+            continue;  // Keep the rest of the scene loadable
+        }
+        
+        ComponentType type;
+        type.id = id;
+        type.name = name;
+        for (const QJsonValue &fieldValue : json["fields"].toArray()) {
+            QJsonObject fieldJson = fieldValue.toObject();
+            ComponentField field;
+            field.name = fieldJson["name"].toString();
+            typeFromName(fieldJson["type"].toString(), &field.type);
+            field.defaultValue = fromJsonValue(fieldJson["default"], field.type);
+            if (isValidName(field.name) && type.fieldIndex(field.name) < 0) {
+                type.fields.push_back(field);
+            }
+        }
+        registry.m_indexById.insert(id, registry.size());
+        registry.m_idByName.insert(name, id);
+        registry.m_types.push_back(type);
+        registry.m_nextId = qMax(registry.m_nextId, id + 1);
+    }
+    return registry;
+}
@@ -0,0 +1,420 @@
+#include "ComponentStore.h"
+#include <QColor>
+#include <QJsonArray>
+#include <algorithm>
+
+QVariant ComponentStore::Column::at(int row) const
+{
+    switch (type) {
+    case ComponentField::Type::Int:
+        return QVariant::fromValue<qint64>(ints[row]);
+    case ComponentField::Type::Bool:
+        return QVariant(ints[row] != 0);
+    case ComponentField::Type::Color:
+        return QVariant::fromValue(QColor::fromRgba(static_cast<QRgb>(ints[row])));
+    case ComponentField::Type::Float:
+        return QVariant(floats[row]);
+    case ComponentField::Type::String:
+        return QVariant(strings[row]);
+    }
+    return QVariant();
+}
+
+void ComponentStore::Column::set(int row, const QVariant &value)
+{
+    switch (type) {
+    case ComponentField::Type::Int:
+        ints[row] = value.toLongLong();
+        break;
+    case ComponentField::Type::Bool:
+        ints[row] = value.toBool() ? 1 : 0;
+        break;
+    case ComponentField::Type::Color:
+        ints[row] = value.value<QColor>().rgba();
+        break;
+    case ComponentField::Type::Float:
+        floats[row] = value.toDouble();
+        break;
+    case ComponentField::Type::String:
+        strings[row] = value.toString();
+        break;
+    }
+}
+
+void ComponentStore::Column::append(const QVariant &value)
+{
+    switch (type) {
+    case ComponentField::Type::Int:
+    case ComponentField::Type::Bool:
+    case ComponentField::Type::Color:
+        ints.push_back(0);
+        break;
+    case ComponentField::Type::Float:
+        floats.push_back(0.0);
+        break;
+    case ComponentField::Type::String:
+        strings.emplace_back();
+        break;
+    }
+    set(size() - 1, value);
+}
+
+void ComponentStore::Column::swapRemove(int row)
+{
+    auto removeFrom = [row](auto &values) {
+        values[row] = std::move(values.back());
+        values.pop_back();
+    };
+    switch (type) {
+    case ComponentField::Type::Int:
+    case ComponentField::Type::Bool:
+    case ComponentField::Type::Color:
+        removeFrom(ints);
+        break;
+    case ComponentField::Type::Float:
+        removeFrom(floats);
+        break;
+    case ComponentField::Type::String:
+        removeFrom(strings);
+        break;
+    }
+}
+
+int ComponentStore::Archetype::typeIndex(int typeId) const
+{
+    auto it = std::lower_bound(typeIds.begin(), typeIds.end(), typeId);
+    return (it != typeIds.end() && *it == typeId) ? static_cast<int>(it - typeIds.begin()) : -1;
+}
+
+const ComponentStore::Column *ComponentStore::Archetype::column(int typeId, int field) const
+{
+    int index = typeIndex(typeId);
+    if (index < 0) {
+        return nullptr;
+    }
+    int column = firstColumn[index] + field;
+    int end = index + 1 < static_cast<int>(typeIds.size()) ? firstColumn[index + 1] : static_cast<int>(columns.size());
+    return (field >= 0 && column < end) ? &columns[column] : nullptr;
+}
+
+bool ComponentStore::has(int entityId, int typeId) const
+{
+    auto it = m_locations.constFind(entityId);
+    return it != m_locations.constEnd() && m_archetypes[it->archetype].typeIndex(typeId) >= 0;
+}
+
+std::vector<int> ComponentStore::componentsOf(int entityId) const
+{
+    auto it = m_locations.constFind(entityId);
+    return it != m_locations.constEnd() ? m_archetypes[it->archetype].typeIds : std::vector<int>();
+}
+
+bool ComponentStore::add(int entityId, int typeId)
+{
+    const ComponentType *type = m_registry.find(typeId);
+    if (!type || has(entityId, typeId)) {
+        return false;
+    }
+    
+    Values values = take(entityId);
+    QVariantList defaults;
+    for (const ComponentField &field : type->fields) {
+        defaults.append(field.defaultValue);
+    }
+    values.insert(typeId, defaults);
+    setValues(entityId, values);
+    return true;
+}
+
+bool ComponentStore::remove(int entityId, int typeId)
+{
+    if (!has(entityId, typeId)) {
+        return false;
+    }
+    Values values = take(entityId);
+    values.remove(typeId);
+    setValues(entityId, values);
+    return true;
+}
+
+QVariant ComponentStore::value(int entityId, int typeId, int field) const
+{
+    auto it = m_locations.constFind(entityId);
+    if (it == m_locations.constEnd()) {
+        return QVariant();
+    }
+    const Column *column = m_archetypes[it->archetype].column(typeId, field);
+    return column ? column->at(it->row) : QVariant();
+}
+
+bool ComponentStore::setValue(int entityId, int typeId, int field, const QVariant &value)
+{
+    auto it = m_locations.constFind(entityId);
+    if (it == m_locations.constEnd()) {
+        return false;
+    }
+    Column *column = m_archetypes[it->archetype].column(typeId, field);
+    if (!column) {
+        return false;
+    }
+    column->set(it->row, ComponentRegistry::convert(value, column->type));
+    return true;
+}
+
+ComponentStore::Values ComponentStore::valuesOf(int entityId) const
+{
+    auto it = m_locations.constFind(entityId);
+    return it != m_locations.constEnd() ? rowValues(m_archetypes[it->archetype], it->row) : Values();
+}
+
+ComponentStore::Values ComponentStore::rowValues(const Archetype &archetype, int row) const
+{
+    Values values;
+    for (int i = 0; i < static_cast<int>(archetype.typeIds.size()); ++i) {
+        int end = i + 1 < static_cast<int>(archetype.typeIds.size()) ? archetype.firstColumn[i + 1]
+                                                                     : static_cast<int>(archetype.columns.size());
+        QVariantList fields;
+        for (int column = archetype.firstColumn[i]; column < end; ++column) {
+            fields.append(archetype.columns[column].at(row));
+        }
+        values.insert(archetype.typeIds[i], fields);
+    }
+    return values;
+}
+
+void ComponentStore::setValues(int entityId, const Values &values)
+{
+    take(entityId);
+    std::vector<int> typeIds;
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        if (m_registry.find(it.key())) {
+            typeIds.push_back(it.key());
+        }
+    }
+    if (typeIds.empty()) {
+        return;
+    }
+    std::sort(typeIds.begin(), typeIds.end());
+    insertRow(entityId, archetypeFor(typeIds), values);
+}
+
+ComponentStore::Values ComponentStore::take(int entityId)
+{
+    auto it = m_locations.find(entityId);
+    if (it == m_locations.end()) {
+        return Values();
+    }
+    Location location = it.value();
+    m_locations.erase(it);
+    return removeRow(location);
+}
+
+std::vector<const ComponentStore::Archetype *> ComponentStore::query(std::vector<int> typeIds) const
+{
+    std::sort(typeIds.begin(), typeIds.end());
+    std::vector<const Archetype *> result;
+    for (const Archetype &archetype : m_archetypes) {
+        if (archetype.rowCount() > 0 && std::includes(archetype.typeIds.begin(), archetype.typeIds.end(),
+                                                      typeIds.begin(), typeIds.end())) {
+            result.push_back(&archetype);
+        }
+    }
+    return result;
+}
+
+void ComponentStore::removeType(int typeId)
+{
+    // Rows move to the archetype without the type; those left behind are
+    // empty and skipped by queries and files
+    std::vector<int> entityIds;
+    for (const Archetype &archetype : m_archetypes) {
+        if (archetype.typeIndex(typeId) >= 0) {
+            entityIds.insert(entityIds.end(), archetype.entityIds.begin(), archetype.entityIds.end());
+        }
+    }
+    for (int entityId : entityIds) {
+        remove(entityId, typeId);
+    }
+    m_registry.remove(typeId);
+}
+
+void ComponentStore::clear()
+{
+    m_registry.clear();
+    m_archetypes.clear();
+    m_archetypeByTypes.clear();
+    m_locations.clear();
+}
+
+int ComponentStore::archetypeFor(const std::vector<int> &typeIds)
+{
+    auto it = m_archetypeByTypes.find(typeIds);
+    if (it != m_archetypeByTypes.end()) {
+        return it->second;
+    }
+    
+    Archetype archetype;
+    archetype.typeIds = typeIds;
+    for (int typeId : typeIds) {
+        archetype.firstColumn.push_back(static_cast<int>(archetype.columns.size()));
+        for (const ComponentField &field : m_registry.find(typeId)->fields) {
+            Column column;
+            column.type = field.type;
+            archetype.columns.push_back(column);
+        }
+    }
+    m_archetypes.push_back(std::move(archetype));
+    int index = archetypeCount() - 1;
+    m_archetypeByTypes.emplace(typeIds, index);
+    return index;
+}
+
+void ComponentStore::insertRow(int entityId, int archetypeIndex, const Values &values)
+{
+    Archetype &archetype = m_archetypes[archetypeIndex];
+    for (int i = 0; i < static_cast<int>(archetype.typeIds.size()); ++i) {
+        const ComponentType *type = m_registry.find(archetype.typeIds[i]);
+        QVariantList fields = values.value(type->id);
+        for (int field = 0; field < static_cast<int>(type->fields.size()); ++field) {
+            // Missing values (older rows, shorter lists) take the default
+            const ComponentField &definition = type->fields[field];
+            QVariant value = field < fields.size() ? ComponentRegistry::convert(fields[field], definition.type)
+                                                   : definition.defaultValue;
+            archetype.columns[archetype.firstColumn[i] + field].append(value);
+        }
+    }
+    archetype.entityIds.push_back(entityId);
+    m_locations.insert(entityId, {archetypeIndex, archetype.rowCount() - 1});
+}
+
+ComponentStore::Values ComponentStore::removeRow(const Location &location)
+{
+    Archetype &archetype = m_archetypes[location.archetype];
+    int entityId = archetype.entityIds[location.row];
+    Values values = rowValues(archetype, location.row);
+    
+    // The last row fills the gap
+    for (Column &column : archetype.columns) {
+        column.swapRemove(location.row);
+    }
+    int moved = archetype.entityIds.back();
+    archetype.entityIds[location.row] = moved;
+    archetype.entityIds.pop_back();
+    if (moved != entityId) {
+        m_locations[moved].row = location.row;
+    }
+    return values;
+}
+
+QJsonObject ComponentStore::toJson() const
+{
+    QJsonArray archetypes;
+    for (const Archetype &archetype : m_archetypes) {
+        if (archetype.rowCount() == 0) {
+            continue;
+        }
+        QJsonArray typeNames;
+        QJsonObject columns;
+        for (int i = 0; i < static_cast<int>(archetype.typeIds.size()); ++i) {
+            const ComponentType *type = m_registry.find(archetype.typeIds[i]);
+            typeNames.append(type->name);
+            for (int field = 0; field < static_cast<int>(type->fields.size()); ++field) {
+                const Column &column = archetype.columns[archetype.firstColumn[i] + field];
+                QJsonArray values;
+                for (int row = 0; row < archetype.rowCount(); ++row) {
+                    values.append(ComponentRegistry::toJsonValue(column.at(row), column.type));
+                }
+                columns[type->name + "." + type->fields[field].name] = values;
+            }
+        }
+        QJsonArray entities;
+        for (int entityId : archetype.entityIds) {
+            entities.append(entityId);
+        }
+        QJsonObject json;
+        json["types"] = typeNames;
+        json["entities"] = entities;
+        json["columns"] = columns;
+        archetypes.append(json);
+    }
+    
+    QJsonObject json;
+    json["types"] = m_registry.toJson();
+    json["archetypes"] = archetypes;
+    return json;
+}
+
+ComponentStore ComponentStore::fromJson(const QJsonObject &json)
+{
+    ComponentStore store;
+    store.m_registry = ComponentRegistry::fromJson(json["types"].toArray());
+    for (const QJsonValue &value : json["archetypes"].toArray()) {
+        QJsonObject archetype = value.toObject();
+        QJsonObject columns = archetype["columns"].toObject();
+        QJsonArray entities = archetype["entities"].toArray();
+        
+        // Columns of the known types; unknown types are dropped
+        std::vector<const ComponentType *> types;
+        for (const QJsonValue &name : archetype["types"].toArray()) {
+            if (const ComponentType *type = store.m_registry.find(store.m_registry.idOf(name.toString()))) {
+                types.push_back(type);
+            }
+        }
+        std::vector<std::vector<QJsonArray>> fieldColumns(types.size());
+        for (size_t i = 0; i < types.size(); ++i) {
+            for (const ComponentField &field : types[i]->fields) {
+                fieldColumns[i].push_back(columns[types[i]->name + "." + field.name].toArray());
+            }
+        }
+        
+        for (int row = 0; row < entities.size(); ++row) {
+            Values values;
+            for (size_t i = 0; i < types.size(); ++i) {
+                QVariantList fields;
+                for (size_t field = 0; field < types[i]->fields.size(); ++field) {
+                    const QJsonArray &column = fieldColumns[i][field];
+                    fields.append(row < column.size()
+                                      ? ComponentRegistry::fromJsonValue(column[row], types[i]->fields[field].type)
+                                      : types[i]->fields[field].defaultValue);
+                }
+                values.insert(types[i]->id, fields);
+            }
+            store.setValues(entities[row].toInt(), values);
+        }
+    }
+    return store;
+}
+
+QJsonObject ComponentStore::valuesToJson(int entityId) const
+{
+    QJsonObject json;
+    Values values = valuesOf(entityId);
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        const ComponentType *type = m_registry.find(it.key());
+        QJsonObject fields;
+        for (int field = 0; field < static_cast<int>(type->fields.size()); ++field) {
+            fields[type->fields[field].name] = ComponentRegistry::toJsonValue(it.value()[field], type->fields[field].type);
+        }
+        json[type->name] = fields;
+    }
+    return json;
+}
+
+void ComponentStore::setValuesJson(int entityId, const QJsonObject &json)
+{
+    Values values;
+    for (auto it = json.constBegin(); it != json.constEnd(); ++it) {
+        const ComponentType *type = m_registry.find(m_registry.idOf(it.key()));
+        if (!type) {
+            continue;
+        }
+        QJsonObject fieldsJson = it.value().toObject();
+        QVariantList fields;
+        for (const ComponentField &field : type->fields) {
+            fields.append(fieldsJson.contains(field.name) ? ComponentRegistry::fromJsonValue(fieldsJson[field.name], field.type)
+                                                          : field.defaultValue);
+        }
+        values.insert(type->id, fields);
+    }
+    setValues(entityId, values);
+}
@@ -0,0 +1,27 @@
+#include "DefineComponentCommand.h"
+#include "Canvas.h"
+
+DefineComponentCommand::DefineComponentCommand(Canvas *canvas, const ComponentType &type, QUndoCommand *parent)
+    : EditorCommand(parent)
+    , m_canvas(canvas)
+    , m_type(type)
+{
+    setText(QString("Define Component %1").arg(type.name));
+}
+
+void DefineComponentCommand::redo()
+{
+    if (!m_canvas) return;
+    
+    if (!m_canvas->setComponentTypeDefined(m_type, true)) {
+        setObsolete(true);  // The name was taken meanwhile (hot reload)
+        m_canvas->reportCommandFailure(text());
+    }
+}
+
+void DefineComponentCommand::undo()
+{
+    if (!m_canvas) return;
+    
+    m_canvas->setComponentTypeDefined(m_type, false);
+}
@@ -2,37 +2,44 @@
 #include "Canvas.h"
 
 DeleteEntityCommand::DeleteEntityCommand(Canvas *canvas, int entityIndex, QUndoCommand *parent)
-    : QUndoCommand(parent)
+    : EditorCommand(parent)
     , m_canvas(canvas)
     , m_entity(-1, "Placeholder", QPoint(0, 0))
+    , m_entityId(-1)
     , m_entityIndex(entityIndex)
-    , m_firstRedo(true)
 {
     setText("Delete Entity");
+    
+    if (const Entity *entity = canvas ? canvas->getEntity(entityIndex) : nullptr) {
+        m_entity = *entity;
+        m_entityId = entity->id();
+    }
 }
 
 void DeleteEntityCommand::redo()
 {
-    if (!m_canvas || m_entityIndex < 0) return;
+    if (!m_canvas || m_entityId < 0) return;
     
-    if (m_firstRedo) {
-        // First time: store entity and remove it
-        const Entity *entity = m_canvas->getEntity(m_entityIndex);
-        if (entity) {
-            m_entity = *entity;
-        }
-        m_canvas->removeEntityAt(m_entityIndex);
-        m_firstRedo = false;
-    } else {
-        // Subsequent redos: remove entity again
-        m_canvas->removeEntityAt(m_entityIndex);
+    // Look the entity up by id: indices shift as other entities are
+    // added, removed or streamed in and out of a world
+    int index = m_canvas->residentIndexOf(m_entityId, m_entity.position(), m_entityIndex);
+    if (index < 0) {
+        setObsolete(true);
+        m_canvas->reportCommandFailure(text());
+        return;
     }
+    
+    // Store the current state so undo restores exactly what was removed
+    m_entity = *m_canvas->getEntity(index);
+    m_components = m_canvas->components().valuesOf(m_entityId);
+    m_entityIndex = index;
+    m_canvas->removeEntityAt(m_entityIndex);
 }
 
 void DeleteEntityCommand::undo()
 {
-    if (!m_canvas || m_entityIndex < 0) return;
+    if (!m_canvas || m_entityId < 0) return;
     
     // Re-insert the entity at its original position
-    m_entityIndex = m_canvas->insertEntity(m_entity, m_entityIndex);
+    m_entityIndex = m_canvas->insertEntity(m_entity, m_entityIndex, m_components);
 }
\ No newline at end of file
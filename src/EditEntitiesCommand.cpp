@@ -0,0 +1,47 @@
+#include "EditEntitiesCommand.h"
+#include "Canvas.h"
+
+EditEntitiesCommand::EditEntitiesCommand(Canvas *canvas, int property, std::vector<EntityPropertyState> &&before,
+                                         std::vector<EntityPropertyState> &&after, const QString &text,
+                                         QUndoCommand *parent)
+    : EditorCommand(parent)
+    , m_canvas(canvas)
+    , m_property(property)
+    , m_before(std::move(before))
+    , m_after(std::move(after))
+{
+    setText(text);
+}
+
+void EditEntitiesCommand::redo()
+{
+    if (!m_canvas) return;
+    
+    m_canvas->setEntityStates(m_property, m_after);
+}
+
+void EditEntitiesCommand::undo()
+{
+    if (!m_canvas) return;
+    
+    m_canvas->setEntityStates(m_property, m_before);
+}
+
+bool EditEntitiesCommand::mergeWith(const QUndoCommand *other)
+{
+    // Only size steps merge; separate renames and recolors stay separate
+    const EditEntitiesCommand *next = static_cast<const EditEntitiesCommand *>(other);
+    bool sizeStep = m_property == static_cast<int>(Canvas::EntityProperty::Width) ||
+                    m_property == static_cast<int>(Canvas::EntityProperty::Height);
+    if (!sizeStep || next->m_canvas != m_canvas || next->m_property != m_property ||
+        next->m_after.size() != m_after.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < m_after.size(); ++i) {
+        if (next->m_after[i].entityId != m_after[i].entityId) {
+            return false;
+        }
+    }
+    m_after = next->m_after;  // Keep the original "before"
+    return true;
+}
@@ -0,0 +1,39 @@
+#include "EditorCommand.h"
+#include "CommandArena.h"
+#include <new>
+
+void *EditorCommand::operator new(std::size_t size)
+{
+    return operator new(size, nullptr);
+}
+
+void *EditorCommand::operator new(std::size_t size, CommandArena *arena)
+{
+    std::size_t total = size + sizeof(BlockHeader);
+    void *block = arena ? arena->allocate(total) : ::operator new(total);
+    
+    BlockHeader *header = static_cast<BlockHeader *>(block);
+    header->arena = arena;
+    header->size = total;
+    return header + 1;
+}
+
+void EditorCommand::operator delete(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    
+    BlockHeader *header = static_cast<BlockHeader *>(ptr) - 1;
+    if (header->arena) {
+        header->arena->release(header, header->size);
+    } else {
+        ::operator delete(header);
+    }
+}
+
+void EditorCommand::operator delete(void *ptr, CommandArena *arena)
+{
+    Q_UNUSED(arena)
+    operator delete(ptr);
+}
@@ -1,11 +1,29 @@
 #include "Entity.h"
+#include "PrefabLibrary.h"
 
 Entity::Entity(int id, const QString &name, const QPoint &position)
     : m_id(id)
-    , m_name(name)
+    , m_nameRef(NamePool::instance().intern(name))
     , m_position(position)
     , m_rect(position.x(), position.y(), DEFAULT_WIDTH, DEFAULT_HEIGHT)
     , m_color(QColor(100, 150, 255))  // Default blue color
+    , m_prefabId(-1)
+    , m_overrides(0)
+    , m_layerId(0)
+    , m_groupId(0)
+{
+}
+
+Entity::Entity(int id, NameRef nameRef, const QPoint &position)
+    : m_id(id)
+    , m_nameRef(nameRef)
+    , m_position(position)
+    , m_rect(position.x(), position.y(), DEFAULT_WIDTH, DEFAULT_HEIGHT)
+    , m_color(QColor(100, 150, 255))  // Default blue color
+    , m_prefabId(-1)
+    , m_overrides(0)
+    , m_layerId(0)
+    , m_groupId(0)
 {
 }
 
@@ -18,46 +36,149 @@ void Entity::setPosition(const QPoint &pos)
 
 void Entity::setName(const QString &name)
 {
-    m_name = name;
+    // Always literal: a name that happens to end in the id is not a pattern,
+    // so copies of the entity keep the same text
+    m_nameRef = NamePool::instance().intern(name);
+    if (isPrefabInstance()) {
+        m_overrides |= OverrideName;
+    }
+}
+
+void Entity::setNameRef(NameRef nameRef)
+{
+    m_nameRef = nameRef;
+    if (isPrefabInstance()) {
+        m_overrides |= OverrideName;
+    }
 }
 
 void Entity::setColor(const QColor &color)
 {
     m_color = color;
+    if (isPrefabInstance()) {
+        m_overrides |= OverrideColor;
+    }
 }
 
 void Entity::setSize(int width, int height)
 {
     m_rect.setSize(QSize(width, height));
+    if (isPrefabInstance()) {
+        m_overrides |= OverrideSize;
+    }
+}
+
+void Entity::setPrefab(int prefabId, quint8 overrides)
+{
+    m_prefabId = prefabId;
+    m_overrides = prefabId >= 0 ? overrides : 0;
 }
 
-QJsonObject Entity::toJson() const
+void Entity::applyPrefab(const Prefab &prefab)
+{
+    if (!(m_overrides & OverrideName)) {
+        m_nameRef = prefab.nameRef;
+    }
+    if (!(m_overrides & OverrideColor)) {
+        m_color = prefab.color;
+    }
+    if (!(m_overrides & OverrideSize)) {
+        m_rect.setSize(prefab.size);
+    }
+}
+
+QJsonObject Entity::toJson(NameTable *names) const
 {
     QJsonObject json;
     json["id"] = m_id;
-    json["name"] = m_name;
+    
+    // Prefab instances only carry what they override
+    bool instance = isPrefabInstance();
+    if (instance) {
+        json["prefab"] = m_prefabId;
+    }
+    
+    if (instance && !(m_overrides & OverrideName)) {
+        // Name comes from the prefab
+    } else if (!names) {
+        json["name"] = name();
+    } else if (!NamePool::isPattern(m_nameRef)) {
+        json["name"] = names->indexOf(m_nameRef);
+    } else if (instance || m_nameRef != NamePool::instance().defaultPattern()) {
+        json["name_pattern"] = names->indexOf(m_nameRef);
+    }
+    // Default "Entity_%1" names are implied by a missing name and not written at all
     json["x"] = m_position.x();
     json["y"] = m_position.y();
-    json["width"] = m_rect.width();
-    json["height"] = m_rect.height();
+    if (m_layerId != 0) {
+        json["layer"] = m_layerId;
+    }
+    if (m_groupId != 0) {
+        json["group"] = m_groupId;
+    }
+    
+    if (!instance || (m_overrides & OverrideSize)) {
+        json["width"] = m_rect.width();
+        json["height"] = m_rect.height();
+    }
     
     // Save color as RGB values
-    json["color_r"] = m_color.red();
-    json["color_g"] = m_color.green();
-    json["color_b"] = m_color.blue();
+    if (!instance || (m_overrides & OverrideColor)) {
+        json["color_r"] = m_color.red();
+        json["color_g"] = m_color.green();
+        json["color_b"] = m_color.blue();
+    }
     
     return json;
 }
 
-Entity Entity::fromJson(const QJsonObject &json)
+void Entity::registerName(NameTable *names) const
+{
+    // Inherited and default names are not written (see toJson())
+    bool instance = isPrefabInstance();
+    if ((instance && !(m_overrides & OverrideName)) ||
+        (!instance && m_nameRef == NamePool::instance().defaultPattern())) {
+        return;
+    }
+    names->indexOf(m_nameRef);
+}
+
+Entity Entity::fromJson(const QJsonObject &json, const NameTable *names)
 {
     int id = json["id"].toInt();
-    QString name = json["name"].toString();
     int x = json["x"].toInt();
     int y = json["y"].toInt();
     
+    // Resolve the name: inline string (legacy files), index into the file's
+    // name table, shared pattern, or the implied default pattern
+    NamePool &pool = NamePool::instance();
+    PooledName nameRef;
+    bool hasName = true;
+    QJsonValue nameValue = json["name"];
+    if (nameValue.isString()) {
+        // Legacy files spell out default names; those still follow the id
+        QString text = nameValue.toString();
+        nameRef = text == pool.resolve(pool.defaultPattern(), id) ? PooledName(pool.defaultPattern()) : pool.intern(text);
+    } else if (names && nameValue.isDouble() && names->isValidIndex(nameValue.toInt())) {
+        nameRef = names->literalRef(nameValue.toInt());
+    } else if (names && json.contains("name_pattern") && names->isValidIndex(json["name_pattern"].toInt())) {
+        nameRef = names->patternRef(json["name_pattern"].toInt());
+    } else {
+        nameRef = pool.defaultPattern();
+        hasName = false;
+    }
+    
     QPoint position(x, y);
-    Entity entity(id, name, position);
+    Entity entity(id, nameRef, position);
+    
+    // Prefab instance: fields present in the file are overrides; the rest are
+    // filled in from the scene's PrefabLibrary once it has been read
+    if (json.contains("prefab")) {
+        entity.setPrefab(json["prefab"].toInt(), hasName ? OverrideName : 0);
+    }
+    
+    entity.setLayerId(json["layer"].toInt(0));
+    entity.setGroupId(json["group"].toInt(0));
     
     // Restore size if present
     if (json.contains("width") && json.contains("height")) {
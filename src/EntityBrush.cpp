@@ -0,0 +1,237 @@
+#include "EntityBrush.h"
+#include <QSet>
+#include <cstdlib>
+
+namespace {
+
+int floorDiv(int value, int divisor)
+{
+    int result = value / divisor;
+    if (value < 0 && result * divisor != value) {
+        --result;
+    }
+    return result;
+}
+
+int ceilDiv(int value, int divisor)
+{
+    return -floorDiv(-value, divisor);
+}
+
+constexpr int BUCKET_SIZE = 128;  // Spatial hash cell for the connectivity search
+
+} // namespace
+
+EntityBrush::EntityBrush(const std::vector<Entity> &entities, int cellSize, const LayerStack *layers)
+    : m_entities(entities)
+    , m_cellSize(qMax(1, cellSize))
+    , m_layers(layers)
+{
+}
+
+QPoint EntityBrush::cellAt(const QPoint &scenePos) const
+{
+    return QPoint(floorDiv(scenePos.x(), m_cellSize), floorDiv(scenePos.y(), m_cellSize));
+}
+
+QRect EntityBrush::cellRect(const QPoint &cell) const
+{
+    return QRect(cell.x() * m_cellSize, cell.y() * m_cellSize, m_cellSize, m_cellSize);
+}
+
+QRect EntityBrush::cellsIn(const QRect &sceneRect) const
+{
+    return QRect(cellAt(sceneRect.topLeft()), cellAt(sceneRect.bottomRight()));
+}
+
+std::vector<QPoint> EntityBrush::lineCells(const QPoint &from, const QPoint &to)
+{
+    // Bresenham: every cell the line passes through, each once
+    std::vector<QPoint> cells;
+    int dx = std::abs(to.x() - from.x());
+    int dy = -std::abs(to.y() - from.y());
+    int stepX = from.x() < to.x() ? 1 : -1;
+    int stepY = from.y() < to.y() ? 1 : -1;
+    int error = dx + dy;
+
+    QPoint cell = from;
+    while (true) {
+        cells.push_back(cell);
+        if (cell == to) {
+            break;
+        }
+        int doubled = 2 * error;
+        if (doubled >= dy) {
+            error += dy;
+            cell.rx() += stepX;
+        }
+        if (doubled <= dx) {
+            error += dx;
+            cell.ry() += stepY;
+        }
+    }
+    return cells;
+}
+
+std::vector<QPoint> EntityBrush::rectCells(const QRect &cells)
+{
+    QRect area = cells.normalized();
+    std::vector<QPoint> result;
+    if (qint64(area.width()) * area.height() > MAX_CELLS) {
+        return result;
+    }
+    result.reserve(static_cast<size_t>(area.width()) * area.height());
+    for (int y = area.top(); y <= area.bottom(); ++y) {
+        for (int x = area.left(); x <= area.right(); ++x) {
+            result.push_back(QPoint(x, y));
+        }
+    }
+    return result;
+}
+
+QHash<QPoint, int> EntityBrush::coverage(const QRect &cells) const
+{
+    // One pass over the entities; each marks the cells whose center it
+    // contains. Later entities are drawn on top, so they overwrite.
+    QHash<QPoint, int> covered;
+    int half = m_cellSize / 2;
+    for (int i = 0; i < static_cast<int>(m_entities.size()); ++i) {
+        const QRect &rect = m_entities[i].rect();
+        if (rect.isEmpty() || !isEditable(m_entities[i])) {
+            continue;
+        }
+        // Cells c with c * size + half inside [left, right]
+        int firstX = qMax(cells.left(), ceilDiv(rect.left() - half, m_cellSize));
+        int lastX = qMin(cells.right(), floorDiv(rect.right() - half, m_cellSize));
+        int firstY = qMax(cells.top(), ceilDiv(rect.top() - half, m_cellSize));
+        int lastY = qMin(cells.bottom(), floorDiv(rect.bottom() - half, m_cellSize));
+        for (int y = firstY; y <= lastY; ++y) {
+            for (int x = firstX; x <= lastX; ++x) {
+                covered.insert(QPoint(x, y), i);
+            }
+        }
+    }
+    return covered;
+}
+
+EntityBrush::Plan EntityBrush::paint(const std::vector<QPoint> &cells, const QColor &color) const
+{
+    Plan plan;
+    if (cells.empty() || static_cast<int>(cells.size()) > MAX_CELLS) {
+        return plan;
+    }
+
+    QRect bounds(cells.front(), cells.front());
+    for (const QPoint &cell : cells) {
+        bounds |= QRect(cell, cell);
+    }
+    QHash<QPoint, int> covered = coverage(bounds);
+
+    QSet<int> recolored;
+    QSet<QPoint> created;
+    for (const QPoint &cell : cells) {
+        auto it = covered.constFind(cell);
+        if (it != covered.constEnd()) {
+            int index = it.value();
+            if (m_entities[index].color() != color && !recolored.contains(index)) {
+                recolored.insert(index);
+                plan.recolorIndices.push_back(index);
+            }
+        } else if (!created.contains(cell)) {
+            created.insert(cell);
+            plan.newPositions.push_back(cellRect(cell).topLeft());
+        }
+    }
+    return plan;
+}
+
+EntityBrush::Plan EntityBrush::fill(const QPoint &cell, const QColor &color, const QRect &bounds) const
+{
+    // On an entity: recolor its connected group
+    QPoint center = cellRect(cell).center();
+    for (int i = static_cast<int>(m_entities.size()) - 1; i >= 0; --i) {
+        if (m_entities[i].rect().contains(center) && isEditable(m_entities[i])) {
+            return recolorConnected(i, color);
+        }
+    }
+
+    // On empty space: paint the connected empty cells inside the bounds
+    Plan plan;
+    QRect area = bounds.normalized();
+    if (!area.contains(cell) || qint64(area.width()) * area.height() > MAX_CELLS) {
+        return plan;
+    }
+    QHash<QPoint, int> covered = coverage(area);
+
+    QSet<QPoint> visited{cell};
+    std::vector<QPoint> pending{cell};
+    while (!pending.empty()) {
+        QPoint current = pending.back();
+        pending.pop_back();
+        plan.newPositions.push_back(cellRect(current).topLeft());
+
+        const QPoint neighbours[] = {current + QPoint(1, 0), current - QPoint(1, 0),
+                                     current + QPoint(0, 1), current - QPoint(0, 1)};
+        for (const QPoint &next : neighbours) {
+            if (area.contains(next) && !covered.contains(next) && !visited.contains(next)) {
+                visited.insert(next);
+                pending.push_back(next);
+            }
+        }
+    }
+    return plan;
+}
+
+EntityBrush::Plan EntityBrush::recolorConnected(int seedIndex, const QColor &color) const
+{
+    Plan plan;
+    QColor target = m_entities[seedIndex].color();
+    if (target == color) {
+        return plan;
+    }
+
+    // Bucket same-colored entities so each step only tests nearby ones
+    QHash<QPoint, std::vector<int>> buckets;
+    auto bucketRange = [](const QRect &rect) {
+        return QRect(QPoint(floorDiv(rect.left(), BUCKET_SIZE), floorDiv(rect.top(), BUCKET_SIZE)),
+                     QPoint(floorDiv(rect.right(), BUCKET_SIZE), floorDiv(rect.bottom(), BUCKET_SIZE)));
+    };
+    for (int i = 0; i < static_cast<int>(m_entities.size()); ++i) {
+        if (m_entities[i].color() != target || !isEditable(m_entities[i])) {
+            continue;
+        }
+        QRect range = bucketRange(m_entities[i].rect());
+        for (int by = range.top(); by <= range.bottom(); ++by) {
+            for (int bx = range.left(); bx <= range.right(); ++bx) {
+                buckets[QPoint(bx, by)].push_back(i);
+            }
+        }
+    }
+
+    // Entities are connected when they overlap or share an edge
+    QSet<int> visited{seedIndex};
+    std::vector<int> pending{seedIndex};
+    while (!pending.empty()) {
+        int index = pending.back();
+        pending.pop_back();
+        plan.recolorIndices.push_back(index);
+
+        QRect reach = m_entities[index].rect().adjusted(-1, -1, 1, 1);
+        QRect range = bucketRange(reach);
+        for (int by = range.top(); by <= range.bottom(); ++by) {
+            for (int bx = range.left(); bx <= range.right(); ++bx) {
+                auto it = buckets.constFind(QPoint(bx, by));
+                if (it == buckets.constEnd()) {
+                    continue;
+                }
+                for (int other : it.value()) {
+                    if (!visited.contains(other) && m_entities[other].rect().intersects(reach)) {
+                        visited.insert(other);
+                        pending.push_back(other);
+                    }
+                }
+            }
+        }
+    }
+    return plan;
+}
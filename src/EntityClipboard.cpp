@@ -0,0 +1,221 @@
+#include "EntityClipboard.h"
+#include "SceneCodec.h"
+#include "SceneFile.h"
+#include <QDataStream>
+#include <QHash>
+#include <QMimeData>
+
+QByteArray EntityClipboard::encode(const std::vector<Entity> &entities, const ComponentStore &components)
+{
+    // Distinct names once; entities refer to them by index
+    QHash<NameRef, quint32> nameIndex;
+    std::vector<NameRef> names;
+    for (const Entity &entity : entities) {
+        if (!nameIndex.contains(entity.nameRef())) {
+            nameIndex.insert(entity.nameRef(), static_cast<quint32>(names.size()));
+            names.push_back(entity.nameRef());
+        }
+    }
+    
+    QByteArray raw;
+    QDataStream out(&raw, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << MAGIC << FORMAT_VERSION;
+    out << static_cast<quint32>(names.size());
+    for (NameRef ref : names) {
+        // Patterns ("Entity_%1") take the pasted entity's new id
+        out << static_cast<quint8>(NamePool::isPattern(ref)) << NamePool::instance().text(ref);
+    }
+    out << static_cast<quint32>(entities.size());
+    for (const Entity &entity : entities) {
+        const QRect &rect = entity.rect();
+        out << nameIndex.value(entity.nameRef()) << qint32(rect.x()) << qint32(rect.y()) << qint32(rect.width())
+            << qint32(rect.height()) << quint32(entity.color().rgba());
+    }
+    
+    // Component types in use, by name, then (entity index, type index, field values) entries
+    QHash<int, quint32> typeIndex;
+    std::vector<const ComponentType *> types;
+    std::vector<std::pair<quint32, ComponentStore::Values>> rows;
+    for (int i = 0; i < static_cast<int>(entities.size()); ++i) {
+        if (!components.hasAny(entities[i].id())) {
+            continue;
+        }
+        ComponentStore::Values values = components.valuesOf(entities[i].id());
+        for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+            if (!typeIndex.contains(it.key())) {
+                typeIndex.insert(it.key(), static_cast<quint32>(types.size()));
+                types.push_back(components.registry().find(it.key()));
+            }
+        }
+        rows.emplace_back(static_cast<quint32>(i), std::move(values));
+    }
+    out << static_cast<quint32>(types.size());
+    for (const ComponentType *type : types) {
+        out << type->name << static_cast<quint32>(type->fields.size());
+        for (const ComponentField &field : type->fields) {
+            out << field.name << static_cast<quint8>(field.type) << field.defaultValue;
+        }
+    }
+    quint32 entryCount = 0;
+    for (const auto &row : rows) {
+        entryCount += static_cast<quint32>(row.second.size());
+    }
+    out << entryCount;
+    for (const auto &row : rows) {
+        for (auto it = row.second.constBegin(); it != row.second.constEnd(); ++it) {
+            out << row.first << typeIndex.value(it.key());
+            for (const QVariant &value : it.value()) {
+                out << value;
+            }
+        }
+    }
+    
+    return raw.size() > COMPRESS_THRESHOLD ? SceneCodec::compress(raw) : raw;
+}
+
+bool EntityClipboard::decode(const QByteArray &data, std::vector<Entity> *entities, ComponentStore *components)
+{
+    QByteArray raw;
+    if (SceneCodec::isCompressed(data)) {
+        if (!SceneCodec::decompress(data, &raw)) {
+            return false;
+        }
+    } else {
+        raw = data;
+    }
+    
+    QDataStream in(raw);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint8 version = 0;
+    in >> magic >> version;
+    if (magic != MAGIC || version < 1 || version > FORMAT_VERSION) {
+        return false;
+    }
+    
+    quint32 nameCount = 0;
+    in >> nameCount;
+    std::vector<PooledName> names;  // Holds the literal names until the entities do
+    for (quint32 i = 0; i < nameCount && in.status() == QDataStream::Ok; ++i) {
+        quint8 pattern = 0;
+        QString text;
+        in >> pattern >> text;
+        if (pattern) {
+            names.push_back(NamePool::instance().internPattern(text));
+        } else {
+            names.push_back(NamePool::instance().intern(text));
+        }
+    }
+    
+    quint32 count = 0;
+    in >> count;
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+    entities->clear();
+    entities->reserve(qMin<quint32>(count, static_cast<quint32>(raw.size() / 24)));
+    for (quint32 i = 0; i < count; ++i) {
+        quint32 name = 0;
+        qint32 x = 0, y = 0, width = 0, height = 0;
+        quint32 rgba = 0;
+        in >> name >> x >> y >> width >> height >> rgba;
+        if (in.status() != QDataStream::Ok || name >= names.size()) {
+            return false;
+        }
+        // Ids are assigned when pasting; these only key the components
+        Entity entity(static_cast<int>(i) + 1, names[name], QPoint(x, y));
+        entity.setSize(width, height);
+        entity.setColor(QColor::fromRgba(rgba));
+        entities->push_back(entity);
+    }
+    
+    ComponentStore store;
+    if (version >= 2) {
+        quint32 typeCount = 0;
+        in >> typeCount;
+        std::vector<int> typeIds;  // Per type index; 0 if the definition was rejected
+        std::vector<std::vector<ComponentField>> typeFields;
+        for (quint32 i = 0; i < typeCount && in.status() == QDataStream::Ok; ++i) {
+            QString typeName;
+            quint32 fieldCount = 0;
+            in >> typeName >> fieldCount;
+            std::vector<ComponentField> fields;
+            for (quint32 field = 0; field < fieldCount && in.status() == QDataStream::Ok; ++field) {
+                ComponentField definition;
+                quint8 type = 0;
+                in >> definition.name >> type >> definition.defaultValue;
+                if (type > static_cast<quint8>(ComponentField::Type::Color)) {
+                    return false;
+                }
+                definition.type = static_cast<ComponentField::Type>(type);
+                definition.defaultValue = ComponentRegistry::convert(definition.defaultValue, definition.type);
+                fields.push_back(definition);
+            }
+            typeIds.push_back(store.registry().add(typeName, fields));
+            typeFields.push_back(std::move(fields));
+        }
+        
+        quint32 entryCount = 0;
+        in >> entryCount;
+        for (quint32 i = 0; i < entryCount && in.status() == QDataStream::Ok; ++i) {
+            quint32 entity = 0, type = 0;
+            in >> entity >> type;
+            if (in.status() != QDataStream::Ok || entity >= count || type >= typeIds.size()) {
+                return false;
+            }
+            QVariantList fields;
+            for (const ComponentField &field : typeFields[type]) {
+                QVariant value;
+                in >> value;
+                fields.append(ComponentRegistry::convert(value, field.type));
+            }
+            if (typeIds[type] != 0) {
+                int entityId = static_cast<int>(entity) + 1;
+                ComponentStore::Values values = store.valuesOf(entityId);
+                values.insert(typeIds[type], fields);
+                store.setValues(entityId, values);
+            }
+        }
+        if (in.status() != QDataStream::Ok) {
+            return false;
+        }
+    }
+    if (components) {
+        *components = std::move(store);
+    }
+    return true;
+}
+
+QMimeData *EntityClipboard::toMimeData(const std::vector<Entity> &entities, const ComponentStore &components)
+{
+    QMimeData *mime = new QMimeData();
+    mime->setData(MIME_TYPE, encode(entities, components));
+    SceneParts parts(entities, 1);
+    parts.components = &components;
+    mime->setText(QString::fromUtf8(SceneFile::toJson(parts)));
+    return mime;
+}
+
+bool EntityClipboard::fromMimeData(const QMimeData *mime, std::vector<Entity> *entities, ComponentStore *components)
+{
+    if (!mime) {
+        return false;
+    }
+    if (mime->hasFormat(MIME_TYPE)) {
+        return decode(mime->data(MIME_TYPE), entities, components);
+    }
+    
+    // Scene JSON from another tool (or an older copy)
+    if (mime->hasText()) {
+        SceneData scene;
+        if (SceneFile::fromJson(mime->text().toUtf8(), &scene, 1) && !scene.entities.empty()) {
+            *entities = std::move(scene.entities);
+            if (components) {
+                *components = std::move(scene.components);
+            }
+            return true;
+        }
+    }
+    return false;
+}
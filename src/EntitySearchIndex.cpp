@@ -0,0 +1,142 @@
+#include "EntitySearchIndex.h"
+#include <algorithm>
+#include <iterator>
+
+QString EntitySearchIndex::labelFor(int entityId, const QString &name)
+{
+    return QString("%1: %2").arg(entityId).arg(name);
+}
+
+std::vector<EntitySearchIndex::Trigram> EntitySearchIndex::trigramsOf(const QString &folded)
+{
+    std::vector<Trigram> trigrams;
+    for (int i = 0; i + 3 <= folded.size(); ++i) {
+        trigrams.push_back(Trigram(folded[i].unicode()) << 32 | Trigram(folded[i + 1].unicode()) << 16 |
+                           Trigram(folded[i + 2].unicode()));
+    }
+    // A label repeating a trigram is listed once
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+void EntitySearchIndex::addPostings(int entityId, const QString &folded)
+{
+    for (Trigram trigram : trigramsOf(folded)) {
+        std::vector<int> &ids = m_postings[trigram];
+        // Ids mostly arrive in increasing order, so this is usually an append
+        auto it = std::lower_bound(ids.begin(), ids.end(), entityId);
+        if (it == ids.end() || *it != entityId) {
+            ids.insert(it, entityId);
+        }
+    }
+}
+
+void EntitySearchIndex::removePostings(int entityId, const QString &folded)
+{
+    for (Trigram trigram : trigramsOf(folded)) {
+        auto posting = m_postings.find(trigram);
+        if (posting == m_postings.end()) {
+            continue;
+        }
+        std::vector<int> &ids = posting.value();
+        auto it = std::lower_bound(ids.begin(), ids.end(), entityId);
+        if (it != ids.end() && *it == entityId) {
+            ids.erase(it);
+        }
+        if (ids.empty()) {
+            m_postings.erase(posting);
+        }
+    }
+}
+
+bool EntitySearchIndex::update(int entityId, const QString &label)
+{
+    QString folded = label.toCaseFolded();
+    auto it = m_labels.find(entityId);
+    if (it != m_labels.end()) {
+        if (it->text == label) {
+            return false;
+        }
+        removePostings(entityId, it->folded);
+        *it = {label, folded};
+    } else {
+        m_labels.insert(entityId, {label, folded});
+    }
+    addPostings(entityId, folded);
+    return true;
+}
+
+void EntitySearchIndex::remove(int entityId)
+{
+    auto it = m_labels.find(entityId);
+    if (it != m_labels.end()) {
+        removePostings(entityId, it->folded);
+        m_labels.erase(it);
+    }
+}
+
+void EntitySearchIndex::clear()
+{
+    m_labels.clear();
+    m_postings.clear();
+}
+
+std::vector<int> EntitySearchIndex::find(const QString &text, int limit, int *total) const
+{
+    std::vector<int> matches;
+    QString needle = text.trimmed().toCaseFolded();
+    if (needle.isEmpty()) {
+        if (total) {
+            *total = 0;
+        }
+        return matches;
+    }
+    
+    if (needle.size() < 3) {
+        // Too short for the trigrams: scan every label
+        for (auto it = m_labels.constBegin(); it != m_labels.constEnd(); ++it) {
+            if (it->folded.contains(needle)) {
+                matches.push_back(it.key());
+            }
+        }
+        std::sort(matches.begin(), matches.end());
+    } else {
+        // Intersect the posting lists, shortest first
+        std::vector<const std::vector<int> *> lists;
+        for (Trigram trigram : trigramsOf(needle)) {
+            auto posting = m_postings.constFind(trigram);
+            if (posting == m_postings.constEnd()) {
+                lists.clear();
+                break;  // A trigram no label has: nothing matches
+            }
+            lists.push_back(&posting.value());
+        }
+        std::sort(lists.begin(), lists.end(),
+                  [](const std::vector<int> *a, const std::vector<int> *b) { return a->size() < b->size(); });
+        
+        std::vector<int> candidates = lists.empty() ? std::vector<int>() : *lists.front();
+        std::vector<int> narrowed;
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+            narrowed.clear();
+            std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(),
+                                  std::back_inserter(narrowed));
+            candidates.swap(narrowed);
+        }
+        
+        // Every trigram present doesn't mean the substring is: confirm
+        for (int id : candidates) {
+            if (m_labels.value(id).folded.contains(needle)) {
+                matches.push_back(id);
+            }
+        }
+    }
+    
+    if (total) {
+        *total = static_cast<int>(matches.size());
+    }
+    if (limit >= 0 && static_cast<int>(matches.size()) > limit) {
+        matches.resize(limit);
+    }
+    return matches;
+}
@@ -0,0 +1,396 @@
+#include "GroupBvh.h"
+#include <algorithm>
+
+namespace {
+
+qint64 areaOf(const QRect &rect)
+{
+    return static_cast<qint64>(rect.width()) * rect.height();
+}
+
+} // namespace
+
+GroupBvh::GroupBvh()
+    : m_root(-1)
+{
+}
+
+void GroupBvh::clear()
+{
+    m_nodes.clear();
+    m_root = -1;
+    m_groupNodes.clear();
+    m_slots.clear();
+}
+
+void GroupBvh::build(const std::vector<Entity> &entities, const GroupTree &groups)
+{
+    clear();
+    
+    // One node per group, holding the entities directly in it
+    for (const EntityGroup &group : groups.groups()) {
+        Node node;
+        node.groupId = group.id;
+        m_groupNodes.insert(group.id, static_cast<int>(m_nodes.size()));
+        m_nodes.push_back(node);
+    }
+    std::vector<Entry> entries;
+    for (int i = 0; i < static_cast<int>(entities.size()); ++i) {
+        const Entity &entity = entities[i];
+        auto it = m_groupNodes.constFind(entity.groupId());
+        if (it != m_groupNodes.constEnd()) {
+            Node &node = m_nodes[it.value()];
+            m_slots.insert(entity.id(), {it.value(), static_cast<int>(node.items.size())});
+            node.items.push_back({i, entity.id(), entity.rect()});
+        } else {
+            entries.push_back({entity.rect(), -1, {i, entity.id(), entity.rect()}});
+        }
+    }
+    
+    // Nest the group nodes, then fit their boxes bottom-up
+    for (auto it = m_groupNodes.constBegin(); it != m_groupNodes.constEnd(); ++it) {
+        int parent = m_groupNodes.value(groups.parentOf(it.key()), -1);
+        if (parent >= 0) {
+            m_nodes[it.value()].parent = parent;
+            m_nodes[parent].children.push_back(it.value());
+        }
+    }
+    for (auto it = m_groupNodes.constBegin(); it != m_groupNodes.constEnd(); ++it) {
+        if (m_nodes[it.value()].parent < 0) {
+            entries.push_back({fitGroup(it.value()), it.value(), {-1, -1, QRect()}});
+        }
+    }
+    
+    if (!entries.empty()) {
+        m_root = buildSplit(entries, 0, static_cast<int>(entries.size()));
+    }
+}
+
+QRect GroupBvh::fitGroup(int node)
+{
+    // Group nesting is shallow, so plain recursion is fine here
+    for (int child : m_nodes[node].children) {
+        fitGroup(child);
+    }
+    m_nodes[node].bounds = computeBounds(m_nodes[node]);
+    return m_nodes[node].bounds;
+}
+
+int GroupBvh::buildSplit(std::vector<Entry> &entries, int begin, int end)
+{
+    int index = static_cast<int>(m_nodes.size());
+    m_nodes.push_back(Node());
+    
+    if (end - begin <= LEAF_SIZE) {
+        for (int i = begin; i < end; ++i) {
+            const Entry &entry = entries[i];
+            if (entry.node >= 0) {
+                m_nodes[entry.node].parent = index;
+                m_nodes[index].children.push_back(entry.node);
+            } else {
+                Node &leaf = m_nodes[index];
+                m_slots.insert(entry.item.entityId, {index, static_cast<int>(leaf.items.size())});
+                leaf.items.push_back(entry.item);
+            }
+        }
+        m_nodes[index].bounds = computeBounds(m_nodes[index]);
+        return index;
+    }
+    
+    // Split at the median center along the longer axis of the centers
+    QRect centers;
+    for (int i = begin; i < end; ++i) {
+        QPoint center = entries[i].rect.center();
+        centers |= QRect(center, center);
+    }
+    bool alongX = centers.width() >= centers.height();
+    int middle = begin + (end - begin) / 2;
+    std::nth_element(entries.begin() + begin, entries.begin() + middle, entries.begin() + end,
+                     [alongX](const Entry &a, const Entry &b) {
+                         return alongX ? a.rect.center().x() < b.rect.center().x()
+                                       : a.rect.center().y() < b.rect.center().y();
+                     });
+    
+    int left = buildSplit(entries, begin, middle);
+    int right = buildSplit(entries, middle, end);
+    m_nodes[left].parent = index;
+    m_nodes[right].parent = index;
+    m_nodes[index].children = {left, right};
+    m_nodes[index].bounds = m_nodes[left].bounds | m_nodes[right].bounds;
+    return index;
+}
+
+QRect GroupBvh::computeBounds(const Node &node) const
+{
+    QRect bounds;
+    for (const Item &item : node.items) {
+        bounds |= item.rect;
+    }
+    for (int child : node.children) {
+        bounds |= m_nodes[child].bounds;
+    }
+    return bounds;
+}
+
+void GroupBvh::refit(int node)
+{
+    // Stop as soon as a box comes out unchanged: nothing above it moves
+    while (node >= 0) {
+        QRect bounds = computeBounds(m_nodes[node]);
+        if (bounds == m_nodes[node].bounds) {
+            return;
+        }
+        m_nodes[node].bounds = bounds;
+        node = m_nodes[node].parent;
+    }
+}
+
+bool GroupBvh::update(int entityId, const QRect &rect)
+{
+    auto it = m_slots.constFind(entityId);
+    if (it == m_slots.constEnd()) {
+        return false;
+    }
+    Item &item = m_nodes[it->node].items[it->item];
+    if (item.rect != rect) {
+        item.rect = rect;
+        refit(it->node);
+    }
+    return true;
+}
+
+void GroupBvh::translateGroup(int groupId, const QPoint &delta)
+{
+    int top = m_groupNodes.value(groupId, -1);
+    if (top < 0 || delta.isNull()) {
+        return;
+    }
+    
+    std::vector<int> pending{top};
+    while (!pending.empty()) {
+        Node &node = m_nodes[pending.back()];
+        pending.pop_back();
+        node.bounds.translate(delta);
+        for (Item &item : node.items) {
+            item.rect.translate(delta);
+        }
+        pending.insert(pending.end(), node.children.begin(), node.children.end());
+    }
+    refit(m_nodes[top].parent);
+}
+
+void GroupBvh::insert(int index, const Entity &entity)
+{
+    if (index < entityCount()) {
+        shiftIndices(index, 1);
+    }
+    int node = m_groupNodes.value(entity.groupId(), -1);
+    if (node < 0) {
+        node = chooseLeaf(entity.rect());
+    }
+    addItem(node, {index, entity.id(), entity.rect()});
+}
+
+void GroupBvh::remove(int entityId, int index)
+{
+    if (takeItem(entityId).index >= 0 && index < entityCount()) {
+        shiftIndices(index + 1, -1);
+    }
+}
+
+bool GroupBvh::setEntityGroup(int entityId, int groupId)
+{
+    Item item = takeItem(entityId);
+    if (item.index < 0) {
+        return false;
+    }
+    int node = m_groupNodes.value(groupId, -1);
+    addItem(node >= 0 ? node : chooseLeaf(item.rect), item);
+    return true;
+}
+
+void GroupBvh::addGroup(int groupId, int parentId)
+{
+    Node node;
+    node.groupId = groupId;
+    int index = static_cast<int>(m_nodes.size());
+    m_nodes.push_back(node);
+    m_groupNodes.insert(groupId, index);
+    attach(index, m_groupNodes.value(parentId, -1));
+}
+
+void GroupBvh::setGroupParent(int groupId, int parentId)
+{
+    int node = m_groupNodes.value(groupId, -1);
+    if (node >= 0) {
+        detach(node);
+        attach(node, m_groupNodes.value(parentId, -1));
+    }
+}
+
+void GroupBvh::removeGroup(int groupId, int parentId)
+{
+    int node = m_groupNodes.value(groupId, -1);
+    if (node < 0) {
+        return;
+    }
+    
+    // Hand the contents over, then drop the node (its slot stays unused
+    // until the next build)
+    int parent = m_groupNodes.value(parentId, -1);
+    std::vector<int> children;
+    children.swap(m_nodes[node].children);
+    for (int child : children) {
+        m_nodes[child].parent = -1;
+        attach(child, parent);
+    }
+    std::vector<Item> items;
+    items.swap(m_nodes[node].items);
+    for (const Item &item : items) {
+        addItem(parent >= 0 ? parent : chooseLeaf(item.rect), item);
+    }
+    detach(node);
+    m_groupNodes.remove(groupId);
+}
+
+int GroupBvh::chooseLeaf(const QRect &rect)
+{
+    if (m_root < 0) {
+        m_root = static_cast<int>(m_nodes.size());
+        m_nodes.push_back(Node());
+        return m_root;
+    }
+    
+    // Descend through the split nodes (group nodes hang off the leaves)
+    int node = m_root;
+    while (true) {
+        int best = -1;
+        qint64 bestGrowth = 0;
+        for (int child : m_nodes[node].children) {
+            const Node &candidate = m_nodes[child];
+            if (candidate.groupId != GroupTree::NO_GROUP) {
+                continue;
+            }
+            qint64 growth = areaOf(candidate.bounds | rect) - areaOf(candidate.bounds);
+            if (best < 0 || growth < bestGrowth) {
+                best = child;
+                bestGrowth = growth;
+            }
+        }
+        if (best < 0) {
+            return node;
+        }
+        node = best;
+    }
+}
+
+void GroupBvh::attach(int node, int parent)
+{
+    if (parent < 0) {
+        parent = chooseLeaf(m_nodes[node].bounds);
+    }
+    m_nodes[node].parent = parent;
+    m_nodes[parent].children.push_back(node);
+    refit(parent);
+}
+
+void GroupBvh::detach(int node)
+{
+    int parent = m_nodes[node].parent;
+    if (parent < 0) {
+        return;
+    }
+    std::vector<int> &siblings = m_nodes[parent].children;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), node));
+    m_nodes[node].parent = -1;
+    refit(parent);
+}
+
+void GroupBvh::addItem(int node, const Item &item)
+{
+    m_slots.insert(item.entityId, {node, static_cast<int>(m_nodes[node].items.size())});
+    m_nodes[node].items.push_back(item);
+    refit(node);
+}
+
+GroupBvh::Item GroupBvh::takeItem(int entityId)
+{
+    auto it = m_slots.find(entityId);
+    if (it == m_slots.end()) {
+        return {-1, entityId, QRect()};
+    }
+    Slot slot = it.value();
+    m_slots.erase(it);
+    
+    // Swap-remove; the entity moved into the gap gets its slot fixed
+    std::vector<Item> &items = m_nodes[slot.node].items;
+    Item item = items[slot.item];
+    if (slot.item + 1 < static_cast<int>(items.size())) {
+        items[slot.item] = items.back();
+        m_slots[items[slot.item].entityId].item = slot.item;
+    }
+    items.pop_back();
+    refit(slot.node);
+    return item;
+}
+
+void GroupBvh::shiftIndices(int from, int delta)
+{
+    for (Node &node : m_nodes) {
+        for (Item &item : node.items) {
+            if (item.index >= from) {
+                item.index += delta;
+            }
+        }
+    }
+}
+
+void GroupBvh::query(const QRect &area, std::vector<int> *indices) const
+{
+    indices->clear();
+    if (m_root < 0) {
+        return;
+    }
+    
+    std::vector<int> pending{m_root};
+    while (!pending.empty()) {
+        const Node &node = m_nodes[pending.back()];
+        pending.pop_back();
+        if (!node.bounds.intersects(area)) {
+            continue;  // The whole subtree misses
+        }
+        for (const Item &item : node.items) {
+            if (item.rect.intersects(area)) {
+                indices->push_back(item.index);
+            }
+        }
+        pending.insert(pending.end(), node.children.begin(), node.children.end());
+    }
+    std::sort(indices->begin(), indices->end());
+}
+
+std::vector<int> GroupBvh::membersOf(int groupId) const
+{
+    std::vector<int> indices;
+    int top = m_groupNodes.value(groupId, -1);
+    std::vector<int> pending;
+    if (top >= 0) {
+        pending.push_back(top);
+    }
+    while (!pending.empty()) {
+        const Node &node = m_nodes[pending.back()];
+        pending.pop_back();
+        for (const Item &item : node.items) {
+            indices.push_back(item.index);
+        }
+        pending.insert(pending.end(), node.children.begin(), node.children.end());
+    }
+    std::sort(indices.begin(), indices.end());
+    return indices;
+}
+
+QRect GroupBvh::groupBounds(int groupId) const
+{
+    int node = m_groupNodes.value(groupId, -1);
+    return node >= 0 ? m_nodes[node].bounds : QRect();
+}
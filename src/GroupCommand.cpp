@@ -0,0 +1,36 @@
+#include "GroupCommand.h"
+#include "Canvas.h"
+
+GroupCommand::GroupCommand(Canvas *canvas, const EntityGroup &group, std::vector<int> &&childGroupIds,
+                           std::vector<int> &&memberIds, bool ungroup, QUndoCommand *parent)
+    : EditorCommand(parent)
+    , m_canvas(canvas)
+    , m_group(group)
+    , m_childGroupIds(std::move(childGroupIds))
+    , m_memberIds(std::move(memberIds))
+    , m_ungroup(ungroup)
+{
+    setText(ungroup ? "Ungroup" : "Group");
+}
+
+void GroupCommand::undo()
+{
+    if (!m_canvas) return;
+    
+    if (m_ungroup) {
+        m_canvas->formGroup(m_group, m_childGroupIds, m_memberIds);
+    } else {
+        m_canvas->dissolveGroup(m_group.id);
+    }
+}
+
+void GroupCommand::redo()
+{
+    if (!m_canvas) return;
+    
+    if (m_ungroup) {
+        m_canvas->dissolveGroup(m_group.id);
+    } else {
+        m_canvas->formGroup(m_group, m_childGroupIds, m_memberIds);
+    }
+}
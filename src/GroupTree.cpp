@@ -0,0 +1,179 @@
+#include "GroupTree.h"
+#include <QJsonObject>
+#include <algorithm>
+
+GroupTree::GroupTree()
+    : m_nextId(NO_GROUP + 1)
+{
+}
+
+int GroupTree::add(const QString &name, int parentId)
+{
+    EntityGroup group;
+    group.id = m_nextId++;
+    group.name = name;
+    group.parentId = contains(parentId) ? parentId : NO_GROUP;
+    m_groups.insert(group.id, group);
+    return group.id;
+}
+
+void GroupTree::insert(const EntityGroup &group)
+{
+    EntityGroup stored = group;
+    if (!contains(stored.parentId)) {
+        stored.parentId = NO_GROUP;
+    }
+    m_groups.insert(stored.id, stored);
+    m_nextId = std::max(m_nextId, stored.id + 1);
+}
+
+bool GroupTree::remove(int id)
+{
+    auto it = m_groups.find(id);
+    if (it == m_groups.end()) {
+        return false;
+    }
+    int parentId = it->parentId;
+    m_groups.erase(it);
+    for (EntityGroup &group : m_groups) {
+        if (group.parentId == id) {
+            group.parentId = parentId;
+        }
+    }
+    return true;
+}
+
+bool GroupTree::rename(int id, const QString &name)
+{
+    auto it = m_groups.find(id);
+    if (it == m_groups.end()) {
+        return false;
+    }
+    it->name = name;
+    return true;
+}
+
+bool GroupTree::setParent(int id, int parentId)
+{
+    if (!contains(id) || (parentId != NO_GROUP && (!contains(parentId) || isWithin(parentId, id)))) {
+        return false;
+    }
+    m_groups[id].parentId = parentId;
+    return true;
+}
+
+const EntityGroup *GroupTree::find(int id) const
+{
+    auto it = m_groups.constFind(id);
+    return it != m_groups.constEnd() ? &it.value() : nullptr;
+}
+
+int GroupTree::parentOf(int id) const
+{
+    const EntityGroup *group = find(id);
+    return group ? group->parentId : NO_GROUP;
+}
+
+int GroupTree::rootOf(int id) const
+{
+    if (!contains(id)) {
+        return NO_GROUP;
+    }
+    while (parentOf(id) != NO_GROUP) {
+        id = parentOf(id);
+    }
+    return id;
+}
+
+bool GroupTree::isWithin(int id, int ancestorId) const
+{
+    while (id != NO_GROUP) {
+        if (id == ancestorId) {
+            return true;
+        }
+        id = parentOf(id);
+    }
+    return false;
+}
+
+std::vector<int> GroupTree::childrenOf(int id) const
+{
+    std::vector<int> children;
+    for (const EntityGroup &group : m_groups) {
+        if (group.parentId == id) {
+            children.push_back(group.id);
+        }
+    }
+    std::sort(children.begin(), children.end());
+    return children;
+}
+
+int GroupTree::depthOf(int id) const
+{
+    int depth = 0;
+    for (id = parentOf(id); id != NO_GROUP; id = parentOf(id)) {
+        ++depth;
+    }
+    return depth;
+}
+
+void GroupTree::clear()
+{
+    m_groups.clear();
+    m_nextId = NO_GROUP + 1;
+}
+
+QJsonArray GroupTree::toJson() const
+{
+    // Sorted by id so saves are stable
+    QList<int> keys = m_groups.keys();
+    std::vector<int> ids(keys.begin(), keys.end());
+    std::sort(ids.begin(), ids.end());
+    
+    QJsonArray array;
+    for (int id : ids) {
+        const EntityGroup &group = m_groups[id];
+        QJsonObject json;
+        json["id"] = group.id;
+        json["name"] = group.name;
+        if (group.parentId != NO_GROUP) {
+            json["parent"] = group.parentId;
+        }
+        array.append(json);
+    }
+    return array;
+}
+
+GroupTree GroupTree::fromJson(const QJsonArray &array)
+{
+    GroupTree tree;
+    for (const QJsonValue &value : array) {
+        QJsonObject json = value.toObject();
+        EntityGroup group;
+        group.id = json["id"].toInt(NO_GROUP);
+        if (group.id <= NO_GROUP || tree.contains(group.id)) {
+            continue;
+        }
+        group.name = json["name"].toString();
+        group.parentId = json["parent"].toInt(NO_GROUP);
+        tree.m_groups.insert(group.id, group);
+        tree.m_nextId = std::max(tree.m_nextId, group.id + 1);
+    }
+    
+    // Unknown parents and cycles make a group top-level
+    for (EntityGroup &group : tree.m_groups) {
+        if (group.parentId != NO_GROUP && !tree.contains(group.parentId)) {
+            group.parentId = NO_GROUP;
+        }
+    }
+    for (auto it = tree.m_groups.begin(); it != tree.m_groups.end(); ++it) {
+        int steps = 0;
+        for (int id = it->parentId; id != NO_GROUP && steps <= tree.size(); id = tree.parentOf(id)) {
+            ++steps;
+        }
+        if (steps > tree.size()) {
+            it->parentId = NO_GROUP;
+        }
+    }
+    return tree;
+}
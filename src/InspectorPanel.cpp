@@ -9,18 +9,44 @@
 #include <QPushButton>
 #include <QSpinBox>
 #include <QColorDialog>
+#include <QStringList>
+#include <QCheckBox>
+#include <QDoubleSpinBox>
+#include <QHBoxLayout>
+#include <QInputDialog>
+#include <QMessageBox>
+#include <limits>
 
 InspectorPanel::InspectorPanel(QWidget *parent)
     : QWidget(parent)
+    , m_componentsEntityId(-1)
     , m_currentEntityIndex(-1)
+    , m_commitTimer(new QTimer(this))
+    , m_refreshTimer(new QTimer(this))
+    , m_pendingWidth(-1)
+    , m_pendingHeight(-1)
     , m_canvas(nullptr)  // Initialize to nullptr
 {
+    m_commitTimer->setSingleShot(true);
+    m_commitTimer->setInterval(COMMIT_DELAY_MS);
+    connect(m_commitTimer, &QTimer::timeout, this, &InspectorPanel::commitPendingEdits);
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setInterval(0);
+    connect(m_refreshTimer, &QTimer::timeout, this, &InspectorPanel::refreshFromSelection);
     setupUI();
 }
 
 void InspectorPanel::setCanvas(Canvas *canvas)
 {
     m_canvas = canvas;
+    if (m_canvas) {
+        // Edits mark prefab overrides, so keep the prefab row current
+        connect(m_canvas, &Canvas::entityChanged, this, &InspectorPanel::onEntityChanged);
+        connect(m_canvas, &Canvas::groupMoved, this, &InspectorPanel::scheduleRefresh);
+        connect(m_canvas, &Canvas::componentTypesChanged, this, &InspectorPanel::onComponentTypesChanged);
+        connect(m_canvas, &Canvas::selectionSetChanged, this, &InspectorPanel::scheduleRefresh);
+    }
+    onComponentTypesChanged();
 }
 
 void InspectorPanel::setupUI()
@@ -36,10 +62,9 @@ void InspectorPanel::setupUI()
     QGroupBox *propertiesGroup = new QGroupBox("Properties", this);
     QFormLayout *formLayout = new QFormLayout();
     
-    // Name field - NOW ENABLED
+    // Name field, committed when editing finishes
     m_nameEdit = new QLineEdit(this);
     m_nameEdit->setPlaceholderText("Entity name");
-    // REMOVED: setEnabled(false) - now editable!
     formLayout->addRow("Name:", m_nameEdit);
     
     // Color button - NOW ENABLED
@@ -49,22 +74,61 @@ void InspectorPanel::setupUI()
     // REMOVED: setEnabled(false) - now editable!
     formLayout->addRow("Color:", m_colorButton);
     
-    // Size fields - NOW ENABLED
+    // Size fields. Typed values apply on Enter or focus out; the value just
+    // below the range stands for "mixed"
     m_widthSpin = new QSpinBox(this);
-    m_widthSpin->setRange(10, 500);
+    m_widthSpin->setRange(MIN_SIZE, MAX_SIZE);
     m_widthSpin->setSuffix(" px");
-    // REMOVED: setEnabled(false) - now editable!
+    m_widthSpin->setKeyboardTracking(false);
     formLayout->addRow("Width:", m_widthSpin);
     
     m_heightSpin = new QSpinBox(this);
-    m_heightSpin->setRange(10, 500);
+    m_heightSpin->setRange(MIN_SIZE, MAX_SIZE);
     m_heightSpin->setSuffix(" px");
-    // REMOVED: setEnabled(false) - now editable!
+    m_heightSpin->setKeyboardTracking(false);
     formLayout->addRow("Height:", m_heightSpin);
     
     propertiesGroup->setLayout(formLayout);
     mainLayout->addWidget(propertiesGroup);
     
+    // Prefab group
+    QGroupBox *prefabGroup = new QGroupBox("Prefab", this);
+    QVBoxLayout *prefabLayout = new QVBoxLayout();
+    
+    m_prefabLabel = new QLabel("Not a prefab instance", this);
+    m_prefabLabel->setWordWrap(true);
+    prefabLayout->addWidget(m_prefabLabel);
+    
+    m_makePrefabButton = new QPushButton("Make Prefab", this);
+    m_revertPrefabButton = new QPushButton("Revert to Prefab", this);
+    m_applyPrefabButton = new QPushButton("Apply to Prefab", this);
+    prefabLayout->addWidget(m_makePrefabButton);
+    prefabLayout->addWidget(m_revertPrefabButton);
+    prefabLayout->addWidget(m_applyPrefabButton);
+    
+    prefabGroup->setLayout(prefabLayout);
+    mainLayout->addWidget(prefabGroup);
+    updatePrefabRow(-1);
+    
+    // Components group: one box per component, then the add/define row
+    QGroupBox *componentsGroup = new QGroupBox("Components", this);
+    QVBoxLayout *componentsGroupLayout = new QVBoxLayout();
+    m_componentsLayout = new QVBoxLayout();
+    componentsGroupLayout->addLayout(m_componentsLayout);
+    
+    QHBoxLayout *addLayout = new QHBoxLayout();
+    m_componentTypeCombo = new QComboBox(this);
+    m_addComponentButton = new QPushButton("Add", this);
+    m_defineComponentButton = new QPushButton("Define...", this);
+    m_defineComponentButton->setToolTip("Define a new component type for this scene");
+    addLayout->addWidget(m_componentTypeCombo, 1);
+    addLayout->addWidget(m_addComponentButton);
+    addLayout->addWidget(m_defineComponentButton);
+    componentsGroupLayout->addLayout(addLayout);
+    
+    componentsGroup->setLayout(componentsGroupLayout);
+    mainLayout->addWidget(componentsGroup);
+    
     // Status label
     m_statusLabel = new QLabel("No selection", this);
     m_statusLabel->setWordWrap(true);
@@ -76,60 +140,117 @@ void InspectorPanel::setupUI()
     setLayout(mainLayout);
     
     // Connect slots
-    connect(m_nameEdit, &QLineEdit::textChanged, this, &InspectorPanel::onNameChanged);
+    connect(m_nameEdit, &QLineEdit::editingFinished, this, &InspectorPanel::onNameEdited);
     connect(m_colorButton, &QPushButton::clicked, this, &InspectorPanel::onColorChanged);
     connect(m_widthSpin, QOverload<int>::of(&QSpinBox::valueChanged), 
             this, &InspectorPanel::onWidthChanged);
     connect(m_heightSpin, QOverload<int>::of(&QSpinBox::valueChanged), 
             this, &InspectorPanel::onHeightChanged);
+    connect(m_makePrefabButton, &QPushButton::clicked, this, &InspectorPanel::onMakePrefab);
+    connect(m_revertPrefabButton, &QPushButton::clicked, this, &InspectorPanel::onRevertToPrefab);
+    connect(m_applyPrefabButton, &QPushButton::clicked, this, &InspectorPanel::onApplyToPrefab);
+    connect(m_addComponentButton, &QPushButton::clicked, this, &InspectorPanel::onAddComponent);
+    connect(m_defineComponentButton, &QPushButton::clicked, this, &InspectorPanel::onDefineComponentType);
+    updateComponents(-1);
 }
 
 void InspectorPanel::onSelectionChanged(int entityIndex)
 {
     m_currentEntityIndex = entityIndex;
-    
-    if (entityIndex < 0) {
-        clearDisplay();
-        m_statusLabel->setText("No selection");
-    } else {
-        m_statusLabel->setText(QString("Entity selected:\nIndex: %1").arg(entityIndex));
-        // For now, just show the index
-        // In next step, we'll fetch the entity and display its properties
-    }
+    refreshFromSelection();
 }
 
 void InspectorPanel::clearDisplay()
 {
+    blockSignals(true);
     m_nameEdit->clear();
+    m_nameEdit->setPlaceholderText("Entity name");
+    m_colorButton->setText("Color");
     m_colorButton->setStyleSheet("background-color: rgb(200, 200, 200);");
-    m_widthSpin->setValue(0);
-    m_heightSpin->setValue(0);
+    setSizeValue(m_widthSpin, 0, false);
+    setSizeValue(m_heightSpin, 0, false);
+    blockSignals(false);
+    updatePrefabRow(-1);
+    updateComponents(-1);
 }
 
+void InspectorPanel::scheduleRefresh()
+{
+    m_refreshTimer->start();
+}
 
-void InspectorPanel::updateFromEntity(int id, const QString &name, const QColor &color, int width, int height)
+void InspectorPanel::refreshFromSelection()
 {
+    // Edits still waiting apply to the entities they were made for
+    commitPendingEdits();
+    m_refreshTimer->stop();
+    
+    const Entity *primary = m_canvas ? m_canvas->getEntity(m_currentEntityIndex) : nullptr;
+    m_editIds.clear();
+    if (!primary) {
+        clearDisplay();
+        m_statusLabel->setText("No selection");
+        return;
+    }
+    
+    // One pass over the selection: which values all entities share. Default
+    // names are patterns expanded with the id, so they differ per entity.
+    m_editIds.insert(primary->id());
+    bool patternName = NamePool::isPattern(primary->nameRef());
+    bool mixedName = false;
+    bool mixedColor = false;
+    bool mixedWidth = false;
+    bool mixedHeight = false;
+    for (const Entity &entity : m_canvas->entities()) {
+        if (entity.id() == primary->id() || !m_canvas->isEntitySelected(entity.id())) {
+            continue;
+        }
+        m_editIds.insert(entity.id());
+        mixedName = mixedName || patternName || entity.nameRef() != primary->nameRef();
+        mixedColor = mixedColor || entity.color() != primary->color();
+        mixedWidth = mixedWidth || entity.rect().width() != primary->rect().width();
+        mixedHeight = mixedHeight || entity.rect().height() != primary->rect().height();
+    }
+    
     // Block signals to prevent triggering property change handlers
     blockSignals(true);
     
-    // Update all UI fields with entity data
-    m_nameEdit->setText(name);
-    
-    // Update color button appearance
-    QString colorStyle = QString("background-color: rgb(%1, %2, %3);")
-                            .arg(color.red())
-                            .arg(color.green())
-                            .arg(color.blue());
-    m_colorButton->setStyleSheet(colorStyle);
+    // A name being typed is left alone until it is committed
+    if (!m_nameEdit->isModified()) {
+        m_nameEdit->setText(mixedName ? QString() : primary->name());
+        m_nameEdit->setPlaceholderText(mixedName ? "Multiple names" : "Entity name");
+    }
     
-    // Update size fields
-    m_widthSpin->setValue(width);
-    m_heightSpin->setValue(height);
+    QColor color = primary->color();
+    m_colorButton->setText(mixedColor ? "Mixed" : "Color");
+    m_colorButton->setStyleSheet(mixedColor ? QString("background-color: rgb(200, 200, 200);")
+                                            : QString("background-color: rgb(%1, %2, %3);")
+                                                  .arg(color.red())
+                                                  .arg(color.green())
+                                                  .arg(color.blue()));
     
-    m_statusLabel->setText(QString("Entity ID: %1").arg(id));
+    setSizeValue(m_widthSpin, primary->rect().width(), mixedWidth);
+    setSizeValue(m_heightSpin, primary->rect().height(), mixedHeight);
     
-    // Restore signals
     blockSignals(false);
+    
+    if (m_editIds.size() > 1) {
+        m_statusLabel->setText(QString("%1 entities selected\nEdits apply to all of them").arg(m_editIds.size()));
+    } else {
+        m_statusLabel->setText(QString("Entity ID: %1").arg(primary->id()));
+    }
+    
+    // Prefab and components describe the primary entity only
+    updatePrefabRow(m_currentEntityIndex);
+    updateComponents(m_currentEntityIndex);
+}
+
+void InspectorPanel::setSizeValue(QSpinBox *spin, int value, bool mixed)
+{
+    // The special text shows at the minimum, one below the valid range
+    spin->setSpecialValueText(mixed ? "Mixed" : QString());
+    spin->setMinimum(mixed ? MIN_SIZE - 1 : MIN_SIZE);
+    spin->setValue(mixed ? MIN_SIZE - 1 : value);
 }
 
 void InspectorPanel::blockSignals(bool block)
@@ -141,76 +262,339 @@ void InspectorPanel::blockSignals(bool block)
     m_heightSpin->blockSignals(block);
 }
 
-void InspectorPanel::onNameChanged()
+void InspectorPanel::onNameEdited()
 {
-    if (!m_canvas || m_currentEntityIndex < 0) {
+    if (!m_nameEdit->isModified()) {
+        return;  // Focus left without typing
+    }
+    m_nameEdit->setModified(false);
+    if (!m_canvas || m_editIds.isEmpty() || m_canvas->isStreaming()) {
+        return;
+    }
+    m_canvas->setEntityProperty(m_editIds, Canvas::EntityProperty::Name, m_nameEdit->text());
+}
+
+void InspectorPanel::onColorChanged()
+{
+    const Entity *primary = m_canvas ? m_canvas->getEntity(m_currentEntityIndex) : nullptr;
+    if (!primary || m_editIds.isEmpty() || m_canvas->isStreaming()) {
+        return;
+    }
+    
+    // Open color dialog
+    QColor newColor = QColorDialog::getColor(primary->color(), this, "Choose Color");
+    if (newColor.isValid()) {
+        m_canvas->setEntityProperty(m_editIds, Canvas::EntityProperty::Color, newColor);
+    }
+}
+
+void InspectorPanel::onWidthChanged(int value)
+{
+    if (value < MIN_SIZE) {
+        return;  // Back on "mixed"
+    }
+    m_pendingWidth = value;
+    m_commitTimer->start();
+}
+
+void InspectorPanel::onHeightChanged(int value)
+{
+    if (value < MIN_SIZE) {
+        return;
+    }
+    m_pendingHeight = value;
+    m_commitTimer->start();
+}
+
+void InspectorPanel::commitPendingEdits()
+{
+    m_commitTimer->stop();
+    int width = m_pendingWidth;
+    int height = m_pendingHeight;
+    m_pendingWidth = -1;
+    m_pendingHeight = -1;
+    if (!m_canvas || m_editIds.isEmpty() || m_canvas->isStreaming()) {
         return;
     }
     
-    Entity *entity = m_canvas->getEntity(m_currentEntityIndex);
-    if (entity) {
-        QString newName = m_nameEdit->text();
-        if (newName != entity->name()) {
-            entity->setName(newName);
-            // Request canvas repaint
-            m_canvas->update();
+    if (width >= 0) {
+        m_canvas->setEntityProperty(m_editIds, Canvas::EntityProperty::Width, width);
+    }
+    if (height >= 0) {
+        m_canvas->setEntityProperty(m_editIds, Canvas::EntityProperty::Height, height);
+    }
+}
+
+void InspectorPanel::updatePrefabRow(int entityIndex)
+{
+    const Entity *entity = m_canvas ? m_canvas->getEntity(entityIndex) : nullptr;
+    bool editable = entity && !m_canvas->isStreaming();
+    bool instance = entity && entity->isPrefabInstance();
+    
+    if (!entity) {
+        m_prefabLabel->setText("No selection");
+    } else if (!instance) {
+        m_prefabLabel->setText("Not a prefab instance");
+    } else {
+        QStringList overridden;
+        if (entity->overrides() & Entity::OverrideName) {
+            overridden << "name";
         }
+        if (entity->overrides() & Entity::OverrideColor) {
+            overridden << "color";
+        }
+        if (entity->overrides() & Entity::OverrideSize) {
+            overridden << "size";
+        }
+        m_prefabLabel->setText(QString("Prefab #%1\nOverrides: %2")
+                                   .arg(entity->prefabId())
+                                   .arg(overridden.isEmpty() ? "none" : overridden.join(", ")));
     }
+    
+    m_makePrefabButton->setEnabled(editable && !instance);
+    m_revertPrefabButton->setEnabled(editable && instance && entity->overrides() != 0);
+    m_applyPrefabButton->setEnabled(editable && instance && entity->overrides() != 0);
 }
 
-void InspectorPanel::onColorChanged()
+void InspectorPanel::onEntityChanged(int entityIndex)
 {
-    if (!m_canvas || m_currentEntityIndex < 0) {
+    // A bulk edit emits one signal per entity; refresh once afterwards
+    const Entity *entity = m_canvas ? m_canvas->getEntity(entityIndex) : nullptr;
+    if (entityIndex == m_currentEntityIndex || (entity && m_editIds.contains(entity->id()))) {
+        scheduleRefresh();
+    }
+}
+
+void InspectorPanel::onComponentTypesChanged()
+{
+    m_componentTypeCombo->clear();
+    if (m_canvas) {
+        for (const ComponentType &type : m_canvas->components().registry().types()) {
+            m_componentTypeCombo->addItem(type.name, type.id);
+        }
+    }
+    
+    // A new store (scene load) may reuse type ids, so rebuild the editors
+    clearComponentEditors();
+    updateComponents(m_currentEntityIndex);
+}
+
+void InspectorPanel::updateComponents(int entityIndex)
+{
+    const Entity *entity = m_canvas ? m_canvas->getEntity(entityIndex) : nullptr;
+    // Worlds don't store components
+    bool editable = entity && !m_canvas->isStreaming() && !m_canvas->isWorldOpen();
+    m_componentTypeCombo->setEnabled(editable && m_componentTypeCombo->count() > 0);
+    m_addComponentButton->setEnabled(editable && m_componentTypeCombo->count() > 0);
+    m_defineComponentButton->setEnabled(m_canvas && !m_canvas->isStreaming() && !m_canvas->isWorldOpen());
+    
+    if (!entity) {
+        clearComponentEditors();
+        return;
+    }
+    
+    const ComponentStore &components = m_canvas->components();
+    std::vector<int> typeIds = components.componentsOf(entity->id());
+    if (entity->id() == m_componentsEntityId && typeIds == m_shownComponents) {
+        // Same components: only values can differ
+        for (const FieldEditor &editor : m_fieldEditors) {
+            setEditorValue(editor.editor, components.value(entity->id(), editor.typeId, editor.field));
+            editor.editor->setEnabled(editable);
+        }
         return;
     }
     
-    Entity *entity = m_canvas->getEntity(m_currentEntityIndex);
-    if (entity) {
-        // Open color dialog
-        QColor newColor = QColorDialog::getColor(entity->color(), this, "Choose Color");
-        
-        if (newColor.isValid() && newColor != entity->color()) {
-            entity->setColor(newColor);
-            
-            // Update button appearance
-            QString colorStyle = QString("background-color: rgb(%1, %2, %3);")
-                                    .arg(newColor.red())
-                                    .arg(newColor.green())
-                                    .arg(newColor.blue());
-            m_colorButton->setStyleSheet(colorStyle);
-            
-            // Request canvas repaint
-            m_canvas->update();
+    clearComponentEditors();
+    m_componentsEntityId = entity->id();
+    m_shownComponents = typeIds;
+    for (int typeId : typeIds) {
+        const ComponentType *type = components.registry().find(typeId);
+        if (!type) {
+            continue;
+        }
+        QGroupBox *box = new QGroupBox(type->name, this);
+        QFormLayout *form = new QFormLayout(box);
+        for (int field = 0; field < static_cast<int>(type->fields.size()); ++field) {
+            QWidget *editor = createFieldEditor(typeId, field, components.value(entity->id(), typeId, field));
+            editor->setEnabled(editable);
+            form->addRow(type->fields[field].name + ":", editor);
+            m_fieldEditors.push_back({typeId, field, editor});
         }
+        QPushButton *removeButton = new QPushButton("Remove", box);
+        removeButton->setEnabled(editable);
+        connect(removeButton, &QPushButton::clicked, this, [this, typeId]() {
+            if (m_canvas) {
+                m_canvas->removeComponent(m_currentEntityIndex, typeId);
+            }
+        });
+        form->addRow(removeButton);
+        m_componentsLayout->addWidget(box);
+        m_componentBoxes.push_back(box);
     }
 }
 
-void InspectorPanel::onWidthChanged(int value)
+void InspectorPanel::clearComponentEditors()
 {
-    if (!m_canvas || m_currentEntityIndex < 0) {
+    for (QWidget *box : m_componentBoxes) {
+        box->hide();
+        box->deleteLater();  // May be called from one of the box's own buttons
+    }
+    m_componentBoxes.clear();
+    m_fieldEditors.clear();
+    m_shownComponents.clear();
+    m_componentsEntityId = -1;
+}
+
+QWidget *InspectorPanel::createFieldEditor(int typeId, int field, const QVariant &value)
+{
+    const ComponentType *type = m_canvas->components().registry().find(typeId);
+    ComponentField::Type fieldType = type->fields[field].type;
+    auto apply = [this, typeId, field](const QVariant &newValue) {
+        if (m_canvas) {
+            m_canvas->setComponentValue(m_currentEntityIndex, typeId, field, newValue);
+        }
+    };
+    
+    QWidget *editor = nullptr;
+    switch (fieldType) {
+    case ComponentField::Type::Int: {
+        QSpinBox *spin = new QSpinBox(this);
+        spin->setRange(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+        connect(spin, QOverload<int>::of(&QSpinBox::valueChanged), this, apply);
+        editor = spin;
+        break;
+    }
+    case ComponentField::Type::Float: {
+        QDoubleSpinBox *spin = new QDoubleSpinBox(this);
+        spin->setRange(-1e9, 1e9);
+        spin->setDecimals(3);
+        connect(spin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, apply);
+        editor = spin;
+        break;
+    }
+    case ComponentField::Type::Bool: {
+        QCheckBox *check = new QCheckBox(this);
+        connect(check, &QCheckBox::toggled, this, apply);
+        editor = check;
+        break;
+    }
+    case ComponentField::Type::String: {
+        QLineEdit *edit = new QLineEdit(this);
+        connect(edit, &QLineEdit::editingFinished, this, [edit, apply]() { apply(edit->text()); });
+        editor = edit;
+        break;
+    }
+    case ComponentField::Type::Color: {
+        QPushButton *button = new QPushButton("Color", this);
+        connect(button, &QPushButton::clicked, this, [this, button, apply]() {
+            QColor current = button->property("componentColor").value<QColor>();
+            QColor chosen = QColorDialog::getColor(current, this, "Choose Color");
+            if (chosen.isValid() && chosen != current) {
+                apply(QVariant::fromValue(chosen));
+            }
+        });
+        editor = button;
+        break;
+    }
+    }
+    setEditorValue(editor, value);
+    return editor;
+}
+
+void InspectorPanel::setEditorValue(QWidget *editor, const QVariant &value)
+{
+    // Programmatic updates must not write back to the canvas
+    editor->blockSignals(true);
+    if (QSpinBox *spin = qobject_cast<QSpinBox *>(editor)) {
+        spin->setValue(value.toInt());
+    } else if (QDoubleSpinBox *spin = qobject_cast<QDoubleSpinBox *>(editor)) {
+        spin->setValue(value.toDouble());
+    } else if (QCheckBox *check = qobject_cast<QCheckBox *>(editor)) {
+        check->setChecked(value.toBool());
+    } else if (QLineEdit *edit = qobject_cast<QLineEdit *>(editor)) {
+        if (!edit->hasFocus()) {
+            edit->setText(value.toString());
+        }
+    } else if (QPushButton *button = qobject_cast<QPushButton *>(editor)) {
+        QColor color = value.value<QColor>();
+        button->setProperty("componentColor", QVariant::fromValue(color));
+        button->setStyleSheet(QString("background-color: rgb(%1, %2, %3);")
+                                  .arg(color.red())
+                                  .arg(color.green())
+                                  .arg(color.blue()));
+    }
+    editor->blockSignals(false);
+}
+
+void InspectorPanel::onAddComponent()
+{
+    if (!m_canvas || m_currentEntityIndex < 0 || m_componentTypeCombo->currentIndex() < 0) {
+        return;
+    }
+    m_canvas->addComponent(m_currentEntityIndex, m_componentTypeCombo->currentData().toInt());
+}
+
+void InspectorPanel::onDefineComponentType()
+{
+    if (!m_canvas) {
+        return;
+    }
+    
+    bool ok = false;
+    QString name = QInputDialog::getText(this, "Define Component", "Component name:", QLineEdit::Normal,
+                                         QString(), &ok).trimmed();
+    if (!ok || name.isEmpty()) {
+        return;
+    }
+    if (!ComponentRegistry::isValidName(name)) {
+        QMessageBox::warning(this, "Define Component", "Component names use letters, digits and '_' only.");
+        return;
+    }
+    QString spec = QInputDialog::getText(this, "Define Component",
+                                         "Fields (e.g. \"hp:int=100, speed:float, tag:string\"):",
+                                         QLineEdit::Normal, QString(), &ok);
+    if (!ok) {
         return;
     }
     
-    Entity *entity = m_canvas->getEntity(m_currentEntityIndex);
-    if (entity && value != entity->rect().width()) {
-        int currentHeight = entity->rect().height();
-        entity->setSize(value, currentHeight);
-        // Request canvas repaint
-        m_canvas->update();
+    std::vector<ComponentField> fields;
+    QString error;
+    if (!ComponentRegistry::parseFields(spec, &fields, &error)) {
+        QMessageBox::warning(this, "Define Component", error);
+        return;
     }
+    int typeId = m_canvas->defineComponentType(name, fields);
+    if (typeId == 0) {
+        QMessageBox::warning(this, "Define Component",
+                             QString("\"%1\" is already defined or has repeated field names.").arg(name));
+        return;
+    }
+    m_componentTypeCombo->setCurrentIndex(m_componentTypeCombo->findData(typeId));
 }
 
-void InspectorPanel::onHeightChanged(int value)
+void InspectorPanel::onMakePrefab()
 {
     if (!m_canvas || m_currentEntityIndex < 0) {
         return;
     }
-    
-    Entity *entity = m_canvas->getEntity(m_currentEntityIndex);
-    if (entity && value != entity->rect().height()) {
-        int currentWidth = entity->rect().width();
-        entity->setSize(currentWidth, value);
-        // Request canvas repaint
-        m_canvas->update();
+    m_canvas->makePrefab(m_currentEntityIndex);
+    refreshFromSelection();
+}
+
+void InspectorPanel::onRevertToPrefab()
+{
+    if (!m_canvas || m_currentEntityIndex < 0) {
+        return;
     }
-}
\ No newline at end of file
+    m_canvas->revertToPrefab(m_currentEntityIndex);
+    refreshFromSelection();
+}
+
+void InspectorPanel::onApplyToPrefab()
+{
+    if (!m_canvas || m_currentEntityIndex < 0) {
+        return;
+    }
+    m_canvas->applyToPrefab(m_currentEntityIndex);
+    refreshFromSelection();
+}
@@ -0,0 +1,194 @@
+#include "LayerPanel.h"
+#include "Canvas.h"
+#include "LayerStack.h"
+#include <QFont>
+#include <QGridLayout>
+#include <QListWidget>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+LayerPanel::LayerPanel(QWidget *parent)
+    : QWidget(parent)
+    , m_canvas(nullptr)
+    , m_refreshing(false)
+{
+    setupUI();
+}
+
+void LayerPanel::setCanvas(Canvas *canvas)
+{
+    m_canvas = canvas;
+    if (m_canvas) {
+        // Queued: the list may be rebuilt from one of its own signals
+        connect(m_canvas, &Canvas::layersChanged, this, &LayerPanel::refresh, Qt::QueuedConnection);
+    }
+    refresh();
+}
+
+void LayerPanel::setupUI()
+{
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+    
+    m_list = new QListWidget(this);
+    m_list->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_list->setEditTriggers(QAbstractItemView::DoubleClicked | QAbstractItemView::EditKeyPressed);
+    mainLayout->addWidget(m_list);
+    
+    QGridLayout *buttons = new QGridLayout();
+    m_addButton = new QPushButton("Add", this);
+    m_removeButton = new QPushButton("Remove", this);
+    m_upButton = new QPushButton("Up", this);
+    m_downButton = new QPushButton("Down", this);
+    m_lockButton = new QPushButton("Lock", this);
+    m_lockButton->setCheckable(true);
+    m_moveHereButton = new QPushButton("Move Selected Here", this);
+    m_moveHereButton->setToolTip("Move the selected entity to this layer");
+    buttons->addWidget(m_addButton, 0, 0);
+    buttons->addWidget(m_removeButton, 0, 1);
+    buttons->addWidget(m_upButton, 1, 0);
+    buttons->addWidget(m_downButton, 1, 1);
+    buttons->addWidget(m_lockButton, 2, 0);
+    buttons->addWidget(m_moveHereButton, 2, 1);
+    mainLayout->addLayout(buttons);
+    
+    connect(m_list, &QListWidget::currentRowChanged, this, &LayerPanel::onCurrentRowChanged);
+    connect(m_list, &QListWidget::itemChanged, this, &LayerPanel::onItemChanged);
+    connect(m_addButton, &QPushButton::clicked, this, &LayerPanel::onAddLayer);
+    connect(m_removeButton, &QPushButton::clicked, this, &LayerPanel::onRemoveLayer);
+    connect(m_upButton, &QPushButton::clicked, this, &LayerPanel::onMoveUp);
+    connect(m_downButton, &QPushButton::clicked, this, &LayerPanel::onMoveDown);
+    connect(m_lockButton, &QPushButton::clicked, this, &LayerPanel::onToggleLock);
+    connect(m_moveHereButton, &QPushButton::clicked, this, &LayerPanel::onMoveSelectedHere);
+}
+
+void LayerPanel::refresh()
+{
+    m_refreshing = true;
+    m_list->clear();
+    
+    int currentRow = -1;
+    if (m_canvas) {
+        const std::vector<Layer> &layers = m_canvas->layers().layers();
+        for (auto it = layers.rbegin(); it != layers.rend(); ++it) {
+            QListWidgetItem *item = new QListWidgetItem(it->name);
+            item->setData(Qt::UserRole, it->id);
+            if (it->locked) {
+                QFont font = item->font();
+                font.setItalic(true);
+                item->setFont(font);
+                item->setToolTip("Locked");
+            }
+            item->setFlags(item->flags() | Qt::ItemIsUserCheckable | Qt::ItemIsEditable);
+            item->setCheckState(it->visible ? Qt::Checked : Qt::Unchecked);
+            m_list->addItem(item);
+            if (it->id == m_canvas->activeLayer()) {
+                currentRow = m_list->count() - 1;
+            }
+        }
+    }
+    m_list->setCurrentRow(currentRow);
+    
+    const Layer *current = m_canvas ? m_canvas->layers().find(currentLayerId()) : nullptr;
+    bool isDefault = !current || current->id == LayerStack::DEFAULT_LAYER;
+    m_addButton->setEnabled(m_canvas != nullptr);
+    m_removeButton->setEnabled(!isDefault && !m_canvas->isStreaming());
+    m_upButton->setEnabled(current != nullptr && currentRow > 0);
+    m_downButton->setEnabled(current != nullptr && currentRow < m_list->count() - 1);
+    m_lockButton->setEnabled(current != nullptr);
+    m_lockButton->setChecked(current != nullptr && current->locked);
+    m_moveHereButton->setEnabled(current != nullptr);
+    m_refreshing = false;
+}
+
+int LayerPanel::layerIdAt(int row) const
+{
+    QListWidgetItem *item = m_list->item(row);
+    return item ? item->data(Qt::UserRole).toInt() : -1;
+}
+
+int LayerPanel::currentLayerId() const
+{
+    return layerIdAt(m_list->currentRow());
+}
+
+void LayerPanel::onCurrentRowChanged(int row)
+{
+    if (!m_refreshing && m_canvas && row >= 0) {
+        m_canvas->setActiveLayer(layerIdAt(row));
+    }
+}
+
+void LayerPanel::onItemChanged(QListWidgetItem *item)
+{
+    if (m_refreshing || !m_canvas) {
+        return;
+    }
+    int layerId = item->data(Qt::UserRole).toInt();
+    const Layer *layer = m_canvas->layers().find(layerId);
+    if (!layer) {
+        return;
+    }
+    
+    bool visible = item->checkState() == Qt::Checked;
+    if (visible != layer->visible) {
+        m_canvas->setLayerVisible(layerId, visible);
+        return;
+    }
+    QString name = item->text().trimmed();
+    if (!name.isEmpty() && name != layer->name) {
+        m_canvas->renameLayer(layerId, name);
+    } else {
+        refresh();  // Restore the shown label
+    }
+}
+
+void LayerPanel::onAddLayer()
+{
+    if (m_canvas) {
+        m_canvas->addLayer(QString("Layer %1").arg(m_canvas->layers().size()));
+    }
+}
+
+void LayerPanel::onRemoveLayer()
+{
+    if (m_canvas) {
+        m_canvas->removeLayer(currentLayerId());
+    }
+}
+
+void LayerPanel::moveCurrent(int step)
+{
+    if (!m_canvas) {
+        return;
+    }
+    // Rows run top to bottom; stack positions bottom to top
+    int position = m_canvas->layers().rankOf(currentLayerId()) + step;
+    if (position >= 0 && position < m_canvas->layers().size()) {
+        m_canvas->moveLayer(currentLayerId(), position);
+    }
+}
+
+void LayerPanel::onMoveUp()
+{
+    moveCurrent(1);
+}
+
+void LayerPanel::onMoveDown()
+{
+    moveCurrent(-1);
+}
+
+void LayerPanel::onToggleLock()
+{
+    const Layer *layer = m_canvas ? m_canvas->layers().find(currentLayerId()) : nullptr;
+    if (layer) {
+        m_canvas->setLayerLocked(layer->id, !layer->locked);
+    }
+}
+
+void LayerPanel::onMoveSelectedHere()
+{
+    if (m_canvas) {
+        m_canvas->moveSelectedEntityToLayer(currentLayerId());
+    }
+}
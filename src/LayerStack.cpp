@@ -0,0 +1,165 @@
+#include "LayerStack.h"
+#include <QJsonObject>
+#include <algorithm>
+
+LayerStack::LayerStack()
+    : m_nextId(DEFAULT_LAYER + 1)
+{
+    Layer base;
+    base.id = DEFAULT_LAYER;
+    base.name = "Default";
+    m_layers.push_back(base);
+    reindex();
+}
+
+void LayerStack::reindex()
+{
+    m_rank.clear();
+    for (int i = 0; i < size(); ++i) {
+        m_rank.insert(m_layers[i].id, i);
+    }
+}
+
+int LayerStack::add(const QString &name)
+{
+    Layer layer;
+    layer.id = m_nextId++;
+    layer.name = name;
+    m_layers.push_back(layer);
+    m_rank.insert(layer.id, size() - 1);
+    return layer.id;
+}
+
+bool LayerStack::remove(int id)
+{
+    if (id == DEFAULT_LAYER || !contains(id)) {
+        return false;
+    }
+    m_layers.erase(m_layers.begin() + m_rank.value(id));
+    reindex();
+    return true;
+}
+
+bool LayerStack::rename(int id, const QString &name)
+{
+    if (!contains(id)) {
+        return false;
+    }
+    m_layers[m_rank.value(id)].name = name;
+    return true;
+}
+
+bool LayerStack::setVisible(int id, bool visible)
+{
+    if (!contains(id)) {
+        return false;
+    }
+    m_layers[m_rank.value(id)].visible = visible;
+    return true;
+}
+
+bool LayerStack::setLocked(int id, bool locked)
+{
+    if (!contains(id)) {
+        return false;
+    }
+    m_layers[m_rank.value(id)].locked = locked;
+    return true;
+}
+
+bool LayerStack::moveTo(int id, int position)
+{
+    if (!contains(id)) {
+        return false;
+    }
+    int from = m_rank.value(id);
+    int to = qBound(0, position, size() - 1);
+    if (from == to) {
+        return false;
+    }
+    Layer layer = m_layers[from];
+    m_layers.erase(m_layers.begin() + from);
+    m_layers.insert(m_layers.begin() + to, layer);
+    reindex();
+    return true;
+}
+
+const Layer *LayerStack::find(int id) const
+{
+    auto it = m_rank.constFind(id);
+    return it != m_rank.constEnd() ? &m_layers[it.value()] : nullptr;
+}
+
+int LayerStack::rankOf(int id) const
+{
+    return m_rank.value(resolve(id));
+}
+
+bool LayerStack::isVisible(int id) const
+{
+    return m_layers[rankOf(id)].visible;
+}
+
+bool LayerStack::isEditable(int id) const
+{
+    const Layer &layer = m_layers[rankOf(id)];
+    return layer.visible && !layer.locked;
+}
+
+bool LayerStack::isDefault() const
+{
+    const Layer &base = m_layers.front();
+    return size() == 1 && base.name == "Default" && base.visible && !base.locked;
+}
+
+QJsonArray LayerStack::toJson() const
+{
+    // Written bottom to top, so array order is draw order
+    QJsonArray array;
+    for (const Layer &layer : m_layers) {
+        QJsonObject json;
+        json["id"] = layer.id;
+        json["name"] = layer.name;
+        if (!layer.visible) {
+            json["visible"] = false;
+        }
+        if (layer.locked) {
+            json["locked"] = true;
+        }
+        array.append(json);
+    }
+    return array;
+}
+
+LayerStack LayerStack::fromJson(const QJsonArray &array)
+{
+    LayerStack stack;
+    if (array.isEmpty()) {
+        return stack;
+    }
+
+    std::vector<Layer> layers;
+    bool hasDefault = false;
+    for (const QJsonValue &value : array) {
+        QJsonObject json = value.toObject();
+        Layer layer;
+        layer.id = json["id"].toInt(-1);
+        if (layer.id < 0 || std::any_of(layers.begin(), layers.end(),
+                                        [&layer](const Layer &other) { return other.id == layer.id; })) {
+            continue;
+        }
+        layer.name = json["name"].toString();
+        layer.visible = json["visible"].toBool(true);
+        layer.locked = json["locked"].toBool(false);
+        hasDefault = hasDefault || layer.id == DEFAULT_LAYER;
+        stack.m_nextId = std::max(stack.m_nextId, layer.id + 1);
+        layers.push_back(layer);
+    }
+    if (!hasDefault) {
+        layers.insert(layers.begin(), stack.m_layers.front());
+    }
+
+    stack.m_layers = std::move(layers);
+    stack.reindex();
+    return stack;
+}
@@ -0,0 +1,281 @@
+#include "LiveLinkServer.h"
+#include "Canvas.h"
+#include "LiveLinkProtocol.h"
+#include "RuntimeExport.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QtEndian>
+#include <chrono>
+
+namespace {
+
+void appendU32(QByteArray *bytes, quint32 value)
+{
+    uchar raw[4];
+    qToLittleEndian<quint32>(value, raw);
+    bytes->append(reinterpret_cast<const char *>(raw), 4);
+}
+
+} // namespace
+
+LiveLinkServer::LiveLinkServer(Canvas *canvas, QObject *parent)
+    : QObject(parent)
+    , m_canvas(canvas)
+    , m_server(new QLocalServer(this))
+    , m_resetPending(false)
+    , m_firstEditUs(0)
+{
+    m_frameTimer.setSingleShot(true);
+    m_frameTimer.setInterval(FRAME_MS);
+    connect(&m_frameTimer, &QTimer::timeout, this, &LiveLinkServer::flush);
+    connect(m_server, &QLocalServer::newConnection, this, &LiveLinkServer::onNewConnection);
+    
+    // Ids only; the entity state is read when the frame is sent. Streamed
+    // batches are appended without the per-entity bookkeeping.
+    connect(m_canvas, &Canvas::entityEdited, this, &LiveLinkServer::markChanged);
+    connect(m_canvas, &Canvas::entityErased, this, &LiveLinkServer::markRemoved);
+    connect(m_canvas, &Canvas::entitiesAppended, this, [this](int first, int count) {
+        for (int i = first; i < first + count && !m_resetPending && !m_clients.isEmpty(); ++i) {
+            markChanged(m_canvas->getEntity(i)->id());
+        }
+    });
+    connect(m_canvas, &Canvas::sceneReset, this, &LiveLinkServer::markReset);
+}
+
+LiveLinkServer::~LiveLinkServer()
+{
+    stop();
+}
+
+bool LiveLinkServer::start(const QString &name)
+{
+    stop();
+    QString serverName = name.isEmpty() ? QString(LiveLinkProtocol::DEFAULT_SERVER_NAME) : name;
+    
+    // A socket file left behind by a crashed editor would block listening
+    QLocalServer::removeServer(serverName);
+    return m_server->listen(serverName);
+}
+
+void LiveLinkServer::stop()
+{
+    m_frameTimer.stop();
+    while (!m_clients.isEmpty()) {
+        QLocalSocket *socket = m_clients.first().socket;
+        removeClient(socket);
+        socket->abort();
+    }
+    m_server->close();
+    m_changedIds.clear();
+    m_removedIds.clear();
+    m_resetPending = false;
+    m_firstEditUs = 0;
+}
+
+bool LiveLinkServer::isListening() const
+{
+    return m_server->isListening();
+}
+
+QString LiveLinkServer::serverName() const
+{
+    return m_server->serverName();
+}
+
+QString LiveLinkServer::errorString() const
+{
+    return m_server->errorString();
+}
+
+void LiveLinkServer::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() { removeClient(socket); });
+        connect(socket, &QLocalSocket::bytesWritten, this,
+                [this, socket](qint64 bytes) { onBytesWritten(socket, bytes); });
+        m_clients.append(Client{socket});
+        sendSnapshot(m_clients.last());
+    }
+    emit clientCountChanged(m_clients.size());
+}
+
+void LiveLinkServer::removeClient(QLocalSocket *socket)
+{
+    for (int i = 0; i < m_clients.size(); ++i) {
+        if (m_clients[i].socket == socket) {
+            m_clients.removeAt(i);
+            socket->disconnect(this);
+            socket->deleteLater();
+            emit clientCountChanged(m_clients.size());
+            return;
+        }
+    }
+}
+
+void LiveLinkServer::markChanged(int entityId)
+{
+    if (m_clients.isEmpty()) {
+        return;  // New clients start from a snapshot anyway
+    }
+    m_removedIds.remove(entityId);
+    m_changedIds.insert(entityId);
+    scheduleFlush();
+}
+
+void LiveLinkServer::markRemoved(int entityId)
+{
+    if (m_clients.isEmpty()) {
+        return;
+    }
+    m_changedIds.remove(entityId);
+    m_removedIds.insert(entityId);
+    scheduleFlush();
+}
+
+void LiveLinkServer::markReset()
+{
+    if (m_clients.isEmpty()) {
+        return;
+    }
+    m_resetPending = true;
+    m_changedIds.clear();
+    m_removedIds.clear();
+    scheduleFlush();
+}
+
+void LiveLinkServer::scheduleFlush()
+{
+    if (m_firstEditUs == 0) {
+        m_firstEditUs = nowUs();
+    }
+    if (!m_frameTimer.isActive()) {
+        m_frameTimer.start();
+    }
+}
+
+void LiveLinkServer::flush()
+{
+    quint64 editTimeUs = m_firstEditUs;
+    if (m_resetPending) {
+        QByteArray snapshot = encodeSnapshot();
+        for (Client &client : m_clients) {
+            if (backlog(client) > MAX_BUFFERED_BYTES) {
+                client.needsSnapshot = true;  // Sent once it has drained
+            } else if (send(client, LiveLinkProtocol::SNAPSHOT, snapshot, editTimeUs)) {
+                client.needsSnapshot = false;
+                client.snapshotEnd = client.queuedBytes;
+                client.snapshotSize = snapshot.size();
+            }
+        }
+    } else if (!m_changedIds.isEmpty() || !m_removedIds.isEmpty()) {
+        QByteArray delta = encodeDelta();
+        for (Client &client : m_clients) {
+            if (client.needsSnapshot) {
+                continue;  // Behind: this delta is covered by its next snapshot
+            }
+            if (backlog(client) + delta.size() > MAX_BUFFERED_BYTES) {
+                client.needsSnapshot = true;
+                continue;
+            }
+            send(client, LiveLinkProtocol::DELTA, delta, editTimeUs);
+        }
+    }
+    
+    m_changedIds.clear();
+    m_removedIds.clear();
+    m_resetPending = false;
+    m_firstEditUs = 0;
+}
+
+void LiveLinkServer::onBytesWritten(QLocalSocket *socket, qint64 bytes)
+{
+    for (Client &client : m_clients) {
+        if (client.socket == socket) {
+            client.sentBytes += bytes;
+            if (client.needsSnapshot && backlog(client) <= RESUME_BYTES) {
+                sendSnapshot(client);
+            }
+            return;
+        }
+    }
+}
+
+void LiveLinkServer::sendSnapshot(Client &client)
+{
+    QByteArray snapshot = encodeSnapshot();
+    if (send(client, LiveLinkProtocol::SNAPSHOT, snapshot, nowUs())) {
+        client.needsSnapshot = false;
+        client.snapshotEnd = client.queuedBytes;
+        client.snapshotSize = snapshot.size();
+    }
+}
+
+qint64 LiveLinkServer::backlog(const Client &client)
+{
+    qint64 snapshotLeft = qBound<qint64>(0, client.snapshotEnd - client.sentBytes, client.snapshotSize);
+    return client.socket->bytesToWrite() - snapshotLeft;
+}
+
+bool LiveLinkServer::send(Client &client, quint8 type, const QByteArray &body, quint64 editTimeUs)
+{
+    uchar header[LiveLinkProtocol::FRAME_HEADER_SIZE] = {};
+    qToLittleEndian<quint32>(LiveLinkProtocol::FRAME_HEADER_SIZE - 4 + body.size(), header + LiveLinkProtocol::F_SIZE);
+    header[LiveLinkProtocol::F_TYPE] = type;
+    qToLittleEndian<quint32>(++client.sequence, header + LiveLinkProtocol::F_SEQUENCE);
+    qToLittleEndian<quint64>(editTimeUs, header + LiveLinkProtocol::F_EDIT_TIME);
+    
+    QLocalSocket *socket = client.socket;
+    if (socket->write(reinterpret_cast<const char *>(header), sizeof(header)) != qint64(sizeof(header)) ||
+        socket->write(body) != body.size()) {
+        return false;
+    }
+    client.queuedBytes += qint64(sizeof(header)) + body.size();
+    return true;
+}
+
+QByteArray LiveLinkServer::encodeSnapshot() const
+{
+    return RuntimeExport::build(m_canvas->entities());
+}
+
+QByteArray LiveLinkServer::encodeDelta() const
+{
+    QByteArray body;
+    body.reserve(8 + m_removedIds.size() * 4 + m_changedIds.size() * (RuntimeScene::ENTITY_SIZE + 16));
+    appendU32(&body, static_cast<quint32>(m_removedIds.size()));
+    appendU32(&body, 0);  // Upsert count, filled in below
+    for (int entityId : m_removedIds) {
+        appendU32(&body, static_cast<quint32>(entityId));
+    }
+    
+    // One pass over the entities finds every changed one; ids no longer in
+    // the scene (gone without a removal) are skipped
+    quint32 upserts = 0;
+    int pending = m_changedIds.size();
+    for (const Entity &entity : m_canvas->entities()) {
+        if (pending == 0) {
+            break;
+        }
+        if (!m_changedIds.contains(entity.id())) {
+            continue;
+        }
+        --pending;
+        QByteArray name = entity.name().toUtf8();
+        quint32 length = name.isEmpty() ? RuntimeScene::NO_NAME : static_cast<quint32>(name.size());
+        
+        qsizetype at = body.size();
+        body.resize(at + RuntimeScene::ENTITY_SIZE);
+        RuntimeExport::writeEntity(entity, length, reinterpret_cast<uchar *>(body.data()) + at);
+        body.append(name);
+        body.append(LiveLinkProtocol::paddedNameSize(length) - name.size(), '\0');
+        ++upserts;
+    }
+    qToLittleEndian<quint32>(upserts, body.data() + 4);
+    return body;
+}
+
+quint64 LiveLinkServer::nowUs()
+{
+    using namespace std::chrono;
+    return static_cast<quint64>(duration_cast<microseconds>(system_clock::now().time_since_epoch()).count());
+}
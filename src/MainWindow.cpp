@@ -1,24 +1,54 @@
 #include "MainWindow.h"
 #include "Canvas.h"
 #include "InspectorPanel.h" 
+#include "LayerPanel.h"
+#include "MinimapWidget.h"
 #include "AddEntityCommand.h"
 #include <QDockWidget>
 #include <QListWidget>
+#include <QLineEdit>
 #include <QVBoxLayout>
 #include <QLabel>
 #include <QMenuBar>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QElapsedTimer>
 #include <QMessageBox>
-#include <QUndoStack> 
+#include "UndoHistory.h"
+#include "SceneLoader.h"
+#include "SceneWatcher.h"
+#include "LiveLinkServer.h"
+#include "SceneFile.h"
+#include "SceneJournal.h"
+#include <QStatusBar>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QActionGroup>
+#include <QPixmap>
+#include <QColorDialog>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_canvas(nullptr)
     , m_objectListDock(nullptr)
     , m_objectListWidget(nullptr)
+    , m_objectSearchEdit(nullptr)
+    , m_objectSearchStatus(nullptr)
     , m_inspectorPanel(nullptr)
     , m_inspectorDock(nullptr)
-    , m_undoStack(new QUndoStack(this))
+    , m_layerPanel(nullptr)
+    , m_layerDock(nullptr)
+    , m_minimap(nullptr)
+    , m_minimapDock(nullptr)
+    , m_undoStack(new UndoHistory(this))
+    , m_undoAction(nullptr)
+    , m_redoAction(nullptr)
+    , m_sceneLoader(nullptr)
+    , m_loadProgressBar(nullptr)
+    , m_cancelLoadButton(nullptr)
+    , m_sceneWatcher(nullptr)
+    , m_liveLink(nullptr)
+    , m_journaledSaves(false)
 {
     // Set window title and size
     setWindowTitle("Qt Level Editor Lite");
@@ -40,6 +70,22 @@ MainWindow::MainWindow(QWidget *parent)
     m_inspectorDock->setWidget(m_inspectorPanel);
     addDockWidget(Qt::LeftDockWidgetArea, m_inspectorDock);
     
+    // Set up the layer panel below the object list
+    m_layerPanel = new LayerPanel(this);
+    m_layerPanel->setCanvas(m_canvas);
+    m_layerDock = new QDockWidget("Layers", this);
+    m_layerDock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+    m_layerDock->setWidget(m_layerPanel);
+    addDockWidget(Qt::RightDockWidgetArea, m_layerDock);
+    
+    // Scene overview below the layers; click to move the view
+    m_minimap = new MinimapWidget(this);
+    m_minimap->setCanvas(m_canvas);
+    m_minimapDock = new QDockWidget("Minimap", this);
+    m_minimapDock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+    m_minimapDock->setWidget(m_minimap);
+    addDockWidget(Qt::RightDockWidgetArea, m_minimapDock);
+    
     // Set up the menu bar
     QMenuBar *menuBar = this->menuBar();
     QMenu *fileMenu = menuBar->addMenu("&File");
@@ -57,18 +103,38 @@ MainWindow::MainWindow(QWidget *parent)
      // Edit menu
      QMenu *editMenu = menuBar->addMenu("&Edit");
     
-     QAction *undoAction = m_undoStack->createUndoAction(this, "&Undo");
-     undoAction->setShortcut(QKeySequence::Undo);
-     editMenu->addAction(undoAction);
+     m_undoAction = m_undoStack->createUndoAction(this, "&Undo");
+     m_undoAction->setShortcut(QKeySequence::Undo);
+     editMenu->addAction(m_undoAction);
      
-     QAction *redoAction = m_undoStack->createRedoAction(this, "&Redo");
-     redoAction->setShortcut(QKeySequence::Redo);
-     editMenu->addAction(redoAction);
+     m_redoAction = m_undoStack->createRedoAction(this, "&Redo");
+     m_redoAction->setShortcut(QKeySequence::Redo);
+     editMenu->addAction(m_redoAction);
+
+    // Clipboard: entity sets, shared with other editor instances
+    editMenu->addSeparator();
+    QAction *cutAction = editMenu->addAction("Cu&t");
+    cutAction->setShortcut(QKeySequence::Cut);
+    connect(cutAction, &QAction::triggered, m_canvas, &Canvas::cutSelection);
+    
+    QAction *copyAction = editMenu->addAction("&Copy");
+    copyAction->setShortcut(QKeySequence::Copy);
+    connect(copyAction, &QAction::triggered, m_canvas, &Canvas::copySelection);
+    
+    QAction *pasteAction = editMenu->addAction("&Paste");
+    pasteAction->setShortcut(QKeySequence::Paste);
+    connect(pasteAction, &QAction::triggered, m_canvas, &Canvas::paste);
+    editMenu->addSeparator();
 
      // Duplicate action
     QAction *duplicateAction = editMenu->addAction("&Duplicate");
     duplicateAction->setShortcut(QKeySequence("Ctrl+D"));
     connect(duplicateAction, &QAction::triggered, m_canvas, &Canvas::duplicateSelectedEntity);
+    
+    // Groups are made with the group tool; this dissolves the selected one
+    QAction *ungroupAction = editMenu->addAction("&Ungroup");
+    ungroupAction->setShortcut(QKeySequence("Ctrl+Shift+U"));
+    connect(ungroupAction, &QAction::triggered, m_canvas, &Canvas::ungroupSelected);
 
     // Snap-to-grid toggle
     QAction *toggleSnapAction = viewMenu->addAction("Snap to &Grid");
@@ -77,11 +143,101 @@ MainWindow::MainWindow(QWidget *parent)
     toggleSnapAction->setShortcut(QKeySequence("Ctrl+Shift+G"));
     connect(toggleSnapAction, &QAction::triggered, this, &MainWindow::toggleSnapToGrid);
     
+    // Magnetic snapping to nearby entity edges and centers
+    QAction *snapEntitiesAction = viewMenu->addAction("Snap to &Entities");
+    snapEntitiesAction->setCheckable(true);
+    snapEntitiesAction->setChecked(false);
+    connect(snapEntitiesAction, &QAction::toggled, m_canvas, &Canvas::setSnapToEntities);
+    
+    viewMenu->addSeparator();
+    
+    // Overlap analysis
+    QAction *showOverlapsAction = viewMenu->addAction("Highlight &Overlaps");
+    showOverlapsAction->setCheckable(true);
+    showOverlapsAction->setChecked(false);
+    connect(showOverlapsAction, &QAction::toggled, m_canvas, &Canvas::setShowOverlaps);
+    
+    QAction *reportOverlapsAction = viewMenu->addAction("&Report Overlaps...");
+    connect(reportOverlapsAction, &QAction::triggered, this, &MainWindow::onReportOverlaps);
+    
+    // Tools menu: entity selection, tile painting (right button erases tiles),
+    // entity brushes that create or recolor many entities at once and grouping
+    QMenu *toolsMenu = menuBar->addMenu("&Tools");
+    QActionGroup *toolGroup = new QActionGroup(this);
+    const std::pair<const char *, Canvas::Tool> tools[] = {
+        {"&Select", Canvas::Tool::Select},
+        {"&Paint Tiles", Canvas::Tool::PaintTiles},
+        {"Tile &Rectangle", Canvas::Tool::RectTiles},
+        {"&Fill Tiles", Canvas::Tool::FillTiles},
+        {"&Line Brush", Canvas::Tool::LineBrush},
+        {"Rectangle &Brush", Canvas::Tool::RectBrush},
+        {"Fill B&rush", Canvas::Tool::FillBrush},
+        {"&Group", Canvas::Tool::Group},
+    };
+    int toolNumber = 0;
+    for (const auto &entry : tools) {
+        QAction *toolAction = toolsMenu->addAction(entry.first);
+        toolAction->setCheckable(true);
+        toolAction->setChecked(entry.second == Canvas::Tool::Select);
+        toolAction->setShortcut(QKeySequence(QString::number(++toolNumber)));
+        toolGroup->addAction(toolAction);
+        Canvas::Tool tool = entry.second;
+        connect(toolAction, &QAction::triggered, m_canvas, [this, tool]() { m_canvas->setTool(tool); });
+    }
+    
+    toolsMenu->addSeparator();
+    QAction *brushColorAction = toolsMenu->addAction("Brush &Color...");
+    connect(brushColorAction, &QAction::triggered, this, [this]() {
+        QColor color = QColorDialog::getColor(m_canvas->brushColor(), this, "Brush Color");
+        if (color.isValid()) {
+            m_canvas->setBrushColor(color);
+        }
+    });
+    
+    // Live link: games connected to the local socket see edits as they happen
+    toolsMenu->addSeparator();
+    QAction *liveLinkAction = toolsMenu->addAction("Li&ve Link");
+    liveLinkAction->setCheckable(true);
+    liveLinkAction->setChecked(false);
+    connect(liveLinkAction, &QAction::toggled, this, &MainWindow::toggleLiveLink);
+    
+    // Tile palette
+    QMenu *tileMenu = toolsMenu->addMenu("&Tile");
+    QActionGroup *tileGroup = new QActionGroup(this);
+    const QVector<QColor> &palette = m_canvas->tiles().palette();
+    for (int i = 0; i < palette.size(); ++i) {
+        QPixmap swatch(16, 16);
+        swatch.fill(palette[i]);
+        QAction *tileAction = tileMenu->addAction(QIcon(swatch), QString("Tile %1").arg(i + 1));
+        tileAction->setCheckable(true);
+        tileAction->setChecked(i + 1 == m_canvas->activeTile());
+        tileGroup->addAction(tileAction);
+        TileLayer::TileId id = static_cast<TileLayer::TileId>(i + 1);
+        connect(tileAction, &QAction::triggered, m_canvas, [this, id]() { m_canvas->setActiveTile(id); });
+    }
+    
     // Save action
-    QAction *saveAction = fileMenu->addAction("&Save Scene...");
+    QAction *saveAction = fileMenu->addAction("&Save Scene");
     saveAction->setShortcut(QKeySequence::Save);
     connect(saveAction, &QAction::triggered, this, &MainWindow::onSaveScene);
     
+    // Save As action
+    QAction *saveAsAction = fileMenu->addAction("Save Scene &As...");
+    saveAsAction->setShortcut(QKeySequence::SaveAs);
+    connect(saveAsAction, &QAction::triggered, this, &MainWindow::onSaveSceneAs);
+    
+    // Journaled saves toggle (append only the edits since the last save)
+    QAction *journalAction = fileMenu->addAction("&Journaled Saves");
+    journalAction->setCheckable(true);
+    journalAction->setChecked(false);
+    connect(journalAction, &QAction::triggered, this, &MainWindow::toggleJournaledSaves);
+    
+    // Compressed saves toggle (loading detects compressed files either way)
+    QAction *compressAction = fileMenu->addAction("&Compress Saved Scenes");
+    compressAction->setCheckable(true);
+    compressAction->setChecked(false);
+    connect(compressAction, &QAction::triggered, this, &MainWindow::toggleCompressedSaves);
+    
     // Load action
     QAction *loadAction = fileMenu->addAction("&Load Scene...");
     loadAction->setShortcut(QKeySequence::Open);
@@ -89,6 +245,28 @@ MainWindow::MainWindow(QWidget *parent)
     
     fileMenu->addSeparator();
     
+    // Chunked worlds (large levels streamed in around the view)
+    QAction *openWorldAction = fileMenu->addAction("Open &World...");
+    connect(openWorldAction, &QAction::triggered, this, &MainWindow::onOpenWorld);
+    
+    QAction *exportWorldAction = fileMenu->addAction("Export as Wo&rld...");
+    connect(exportWorldAction, &QAction::triggered, this, &MainWindow::onExportWorld);
+    
+    // Flat binary scene the game reads in place (no JSON parsing at startup)
+    QAction *exportRuntimeAction = fileMenu->addAction("Export for R&untime...");
+    connect(exportRuntimeAction, &QAction::triggered, this, &MainWindow::onExportRuntime);
+    
+    fileMenu->addSeparator();
+    
+    // Overlay of what changed relative to another version of the scene
+    QAction *compareAction = fileMenu->addAction("Co&mpare With Scene...");
+    connect(compareAction, &QAction::triggered, this, &MainWindow::onCompareWithScene);
+    
+    QAction *clearCompareAction = fileMenu->addAction("Clear Comparison");
+    connect(clearCompareAction, &QAction::triggered, this, &MainWindow::onClearComparison);
+    
+    fileMenu->addSeparator();
+    
     // Exit action
     QAction *exitAction = fileMenu->addAction("E&xit");
     exitAction->setShortcut(QKeySequence::Quit);
@@ -97,7 +275,39 @@ MainWindow::MainWindow(QWidget *parent)
     // Connect canvas signals to our slots
     connect(m_canvas, &Canvas::entityAdded, this, &MainWindow::onEntityAdded);
     connect(m_canvas, &Canvas::entityRemoved, this, &MainWindow::onEntityRemoved);
+    connect(m_canvas, &Canvas::entityChanged, this, &MainWindow::onEntityChanged);
     connect(m_canvas, &Canvas::entitySelectionChanged, this, &MainWindow::onEntitySelectionChanged);
+    connect(m_canvas, &Canvas::entitiesAppended, this, &MainWindow::onEntitiesAppended);
+    connect(m_canvas, &Canvas::commandFailed, this, [this](const QString &message) {
+        statusBar()->showMessage(message, 5000);
+    });
+    connect(m_canvas, &Canvas::sceneReset, this, &MainWindow::onSceneReset);
+    
+    // Progressive loading: progress bar and cancel button in the status bar
+    m_sceneLoader = new SceneLoader(m_canvas, this);
+    m_loadProgressBar = new QProgressBar(this);
+    m_loadProgressBar->setMaximumWidth(200);
+    m_loadProgressBar->setVisible(false);
+    m_cancelLoadButton = new QPushButton("Cancel", this);
+    m_cancelLoadButton->setVisible(false);
+    statusBar()->addPermanentWidget(m_loadProgressBar);
+    statusBar()->addPermanentWidget(m_cancelLoadButton);
+    connect(m_cancelLoadButton, &QPushButton::clicked, m_sceneLoader, &SceneLoader::cancel);
+    connect(m_sceneLoader, &SceneLoader::progressChanged, this, &MainWindow::onLoadProgress);
+    connect(m_sceneLoader, &SceneLoader::finished, this, &MainWindow::onLoadFinished);
+    connect(m_sceneLoader, &SceneLoader::canceled, this, &MainWindow::onLoadCanceled);
+    
+    // Rewrites of the open scene by other tools are applied as differences
+    m_sceneWatcher = new SceneWatcher(this);
+    connect(m_sceneWatcher, &SceneWatcher::sceneChanged, this, &MainWindow::onSceneFileChanged);
+    connect(m_sceneWatcher, &SceneWatcher::reloadFailed, this, &MainWindow::onSceneReloadFailed);
+    // Compaction rewrites the scene file in the background, after the save
+    // returned; that write is ours too
+    connect(m_canvas, &Canvas::journalCompacted, this, [this](bool success) {
+        if (success) {
+            m_sceneWatcher->noteOwnWrite();
+        }
+    });
 
     // Connect inspector to selection changes
     connect(m_canvas, &Canvas::entitySelectionChanged, m_inspectorPanel, &InspectorPanel::onSelectionChanged);
@@ -111,16 +321,32 @@ void MainWindow::setupObjectListPanel()
     m_objectListDock = new QDockWidget("Objects", this);
     m_objectListDock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
     
+    // Search box above the list: typing filters it to the matching entities
+    QWidget *objectPanel = new QWidget(m_objectListDock);
+    QVBoxLayout *objectLayout = new QVBoxLayout(objectPanel);
+    objectLayout->setContentsMargins(0, 0, 0, 0);
+    m_objectSearchEdit = new QLineEdit(objectPanel);
+    m_objectSearchEdit->setPlaceholderText("Search by name or id");
+    m_objectSearchEdit->setClearButtonEnabled(true);
+    objectLayout->addWidget(m_objectSearchEdit);
+    connect(m_objectSearchEdit, &QLineEdit::textChanged, this, &MainWindow::onObjectSearchChanged);
+    connect(m_objectSearchEdit, &QLineEdit::returnPressed, this, &MainWindow::onObjectSearchAccepted);
+    
     // Create the list widget
-    m_objectListWidget = new QListWidget(m_objectListDock);
+    m_objectListWidget = new QListWidget(objectPanel);
     m_objectListWidget->setSelectionMode(QAbstractItemView::SingleSelection);
+    objectLayout->addWidget(m_objectListWidget);
+    
+    m_objectSearchStatus = new QLabel(objectPanel);
+    m_objectSearchStatus->hide();
+    objectLayout->addWidget(m_objectSearchStatus);
     
     // Connect list widget selection to our slot
     connect(m_objectListWidget, &QListWidget::currentRowChanged, 
             this, &MainWindow::onEntityListItemSelected);
     
-    // Set the list widget as the dock's widget
-    m_objectListDock->setWidget(m_objectListWidget);
+    // Set the panel as the dock's widget
+    m_objectListDock->setWidget(objectPanel);
     
     // Add the dock to the main window
     addDockWidget(Qt::RightDockWidgetArea, m_objectListDock);
@@ -128,6 +354,11 @@ void MainWindow::setupObjectListPanel()
 
 void MainWindow::updateObjectList()
 {
+    if (isFilteringObjects()) {
+        applyObjectFilter();
+        return;
+    }
+    
     // Clear the list
     m_objectListWidget->clear();
     
@@ -156,6 +387,15 @@ void MainWindow::updateObjectList()
 
 void MainWindow::onEntityListItemSelected(int row)
 {
+    if (isFilteringObjects()) {
+        // Rows are search hits, not entity indices
+        QListWidgetItem *item = m_objectListWidget->item(row);
+        if (item) {
+            selectEntityId(item->data(Qt::UserRole).toInt());
+        }
+        return;
+    }
+    
     if (row >= 0 && row < m_canvas->entityCount()) {
         m_canvas->setSelectedEntityIndex(row);
     } else {
@@ -165,47 +405,171 @@ void MainWindow::onEntityListItemSelected(int row)
 
 void MainWindow::onEntityAdded(int index)
 {
-    Q_UNUSED(index)
+    indexEntity(index);
     updateObjectList();
 }
 
-void MainWindow::onEntityRemoved(int index)
+void MainWindow::onEntityRemoved(int index, int entityId)
 {
     Q_UNUSED(index)
+    m_searchIndex.remove(entityId);
     updateObjectList();
 }
 
+void MainWindow::onEntityChanged(int index)
+{
+    const Entity *entity = m_canvas->getEntity(index);
+    if (!entity) {
+        return;
+    }
+    
+    // Most changes (moves, colors) leave the label alone
+    QString label = EntitySearchIndex::labelFor(entity->id(), entity->name());
+    if (!m_searchIndex.update(entity->id(), label)) {
+        return;
+    }
+    if (isFilteringObjects()) {
+        applyObjectFilter();
+    } else if (QListWidgetItem *item = m_objectListWidget->item(index)) {
+        item->setText(label);
+    }
+}
+
+void MainWindow::indexEntity(int index)
+{
+    if (const Entity *entity = m_canvas->getEntity(index)) {
+        m_searchIndex.update(entity->id(), EntitySearchIndex::labelFor(entity->id(), entity->name()));
+    }
+}
+
+bool MainWindow::isFilteringObjects() const
+{
+    return !m_objectSearchEdit->text().trimmed().isEmpty();
+}
+
+void MainWindow::applyObjectFilter()
+{
+    int total = 0;
+    std::vector<int> hits = m_searchIndex.find(m_objectSearchEdit->text(), MAX_SEARCH_RESULTS, &total);
+    
+    const Entity *selected = m_canvas->getEntity(m_canvas->selectedEntityIndex());
+    int selectedRow = -1;
+    m_objectListWidget->blockSignals(true);
+    m_objectListWidget->clear();
+    for (int id : hits) {
+        QListWidgetItem *item = new QListWidgetItem(m_searchIndex.label(id), m_objectListWidget);
+        item->setData(Qt::UserRole, id);
+        if (selected && selected->id() == id) {
+            selectedRow = m_objectListWidget->count() - 1;
+        }
+    }
+    m_objectListWidget->setCurrentRow(selectedRow);
+    m_objectListWidget->blockSignals(false);
+    
+    m_objectSearchStatus->setText(total > static_cast<int>(hits.size())
+                                      ? QString("%1 matches (first %2 shown)").arg(total).arg(static_cast<int>(hits.size()))
+                                      : QString("%1 matches").arg(total));
+}
+
+void MainWindow::selectEntityId(int entityId)
+{
+    int index = m_canvas->indexOfEntityId(entityId);
+    m_canvas->setSelectedEntityIndex(index);
+    if (const Entity *entity = m_canvas->getEntity(index)) {
+        m_canvas->centerOn(entity->rect().center());
+    }
+}
+
+void MainWindow::onObjectSearchChanged()
+{
+    bool filtering = isFilteringObjects();
+    m_objectSearchStatus->setVisible(filtering);
+    updateObjectList();
+}
+
+void MainWindow::onObjectSearchAccepted()
+{
+    if (isFilteringObjects() && m_objectListWidget->count() > 0) {
+        selectEntityId(m_objectListWidget->item(0)->data(Qt::UserRole).toInt());
+    }
+}
+
+void MainWindow::onEntitiesAppended(int first, int count)
+{
+    for (int i = first; i < first + count; ++i) {
+        indexEntity(i);
+    }
+    if (isFilteringObjects()) {
+        applyObjectFilter();
+        return;
+    }
+    
+    // Append only the new rows instead of rebuilding the whole list
+    m_objectListWidget->blockSignals(true);
+    for (int i = first; i < first + count; ++i) {
+        const Entity *entity = m_canvas->getEntity(i);
+        if (entity) {
+            m_objectListWidget->addItem(QString("%1: %2").arg(entity->id()).arg(entity->name()));
+        }
+    }
+    m_objectListWidget->blockSignals(false);
+}
+
+void MainWindow::onSceneReset()
+{
+    m_searchIndex.clear();
+    m_objectListWidget->blockSignals(true);
+    m_objectListWidget->clear();
+    m_objectListWidget->blockSignals(false);
+}
+
 void MainWindow::onEntitySelectionChanged(int index)
 {
     // Block signals to prevent recursive updates
     m_objectListWidget->blockSignals(true);
     
-    if (index >= 0 && index < m_objectListWidget->count()) {
+    if (isFilteringObjects()) {
+        // Find the entity among the search hits
+        const Entity *entity = m_canvas->getEntity(index);
+        int row = -1;
+        for (int i = 0; entity && i < m_objectListWidget->count(); ++i) {
+            if (m_objectListWidget->item(i)->data(Qt::UserRole).toInt() == entity->id()) {
+                row = i;
+                break;
+            }
+        }
+        m_objectListWidget->setCurrentRow(row);
+    } else if (index >= 0 && index < m_objectListWidget->count()) {
         m_objectListWidget->setCurrentRow(index);
     } else {
         m_objectListWidget->clearSelection();
     }
 
-    // Update inspector with entity data
-    if (index >= 0 && index < m_canvas->entityCount()) {
-        const Entity *entity = m_canvas->getEntity(index);
-        if (entity) {
-            m_inspectorPanel->updateFromEntity(
-                entity->id(),
-                entity->name(),
-                entity->color(),
-                entity->rect().width(),
-                entity->rect().height()
-            );
+    // The inspector follows entitySelectionChanged itself
+    m_objectListWidget->blockSignals(false);
+}
+
+void MainWindow::onSaveScene()
+{
+    // An open world saves its dirty chunks in place
+    if (m_canvas->isWorldOpen()) {
+        if (m_canvas->saveWorld()) {
+            statusBar()->showMessage("World saved", 3000);
+        } else {
+            QMessageBox::warning(this, "Error", "Failed to save world.");
         }
-    } else {
-        m_inspectorPanel->onSelectionChanged(-1);
+        return;
     }
     
-    m_objectListWidget->blockSignals(false);
+    // Save to the current file if there is one, otherwise ask for a path
+    if (m_currentFilePath.isEmpty()) {
+        onSaveSceneAs();
+        return;
+    }
+    saveSceneTo(m_currentFilePath);
 }
 
-void MainWindow::onSaveScene()
+void MainWindow::onSaveSceneAs()
 {
     QString filePath = QFileDialog::getSaveFileName(
         this,
@@ -223,11 +587,31 @@ void MainWindow::onSaveScene()
         filePath += ".json";
     }
     
-    if (m_canvas->saveToFile(filePath)) {
+    saveSceneTo(filePath);
+}
+
+bool MainWindow::saveSceneTo(const QString &filePath)
+{
+    // Check before writing, so problems can be fixed before they reach the file
+    SceneValidator::Report report = m_canvas->validateScene();
+    if (!report.isValid() &&
+        QMessageBox::warning(this, "Scene Has Issues",
+                             "The scene has problems:\n\n" + report.summary() + "\n\nSave anyway?",
+                             QMessageBox::Save | QMessageBox::Cancel, QMessageBox::Cancel) != QMessageBox::Save) {
+        return false;
+    }
+    
+    bool saved = m_journaledSaves ? m_canvas->saveJournaled(filePath)
+                                  : m_canvas->saveToFile(filePath);
+    if (saved) {
+        m_currentFilePath = filePath;
+        m_sceneWatcher->watch(filePath);
+        m_sceneWatcher->noteOwnWrite();
         QMessageBox::information(this, "Success", "Scene saved successfully!");
     } else {
         QMessageBox::warning(this, "Error", "Failed to save scene to file.");
     }
+    return saved;
 }
 
 void MainWindow::onLoadScene()
@@ -243,12 +627,293 @@ void MainWindow::onLoadScene()
         return;  // User cancelled
     }
     
-    if (m_canvas->loadFromFile(filePath)) {
-        updateObjectList();
-        QMessageBox::information(this, "Success", "Scene loaded successfully!");
+    m_sceneWatcher->watch(QString());
+    
+    // Loads in the background; see onLoadFinished(). The history stays until
+    // the load succeeds (a cancelled or failed load keeps the old scene), but
+    // it can't be replayed against the scene streaming in.
+    m_undoAction->setEnabled(false);
+    m_redoAction->setEnabled(false);
+    m_sceneLoader->load(filePath);
+}
+
+void MainWindow::onOpenWorld()
+{
+    QString filePath = QFileDialog::getOpenFileName(
+        this,
+        "Open World",
+        "",
+        "World Files (*.world);;All Files (*)"
+    );
+    
+    if (filePath.isEmpty()) {
+        return;  // User cancelled
+    }
+    
+    m_sceneLoader->cancel();
+    
+    if (m_canvas->openWorld(filePath)) {
+        // Commands refer to the old scene's entities
+        m_undoStack->clear();
+        m_currentFilePath.clear();
+        m_sceneWatcher->watch(QString());
+        statusBar()->showMessage("World opened", 3000);
+    } else {
+        QMessageBox::warning(this, "Error", "Failed to open world.");
+    }
+}
+
+void MainWindow::onExportWorld()
+{
+    if (m_canvas->isWorldOpen() || m_canvas->isStreaming()) {
+        QMessageBox::warning(this, "Export", "Only a fully loaded scene can be exported as a world.");
+        return;
+    }
+    
+    QString filePath = QFileDialog::getSaveFileName(
+        this,
+        "Export as World",
+        "",
+        "World Files (*.world);;All Files (*)"
+    );
+    
+    if (filePath.isEmpty()) {
+        return;  // User cancelled
+    }
+    
+    // Ensure .world extension
+    if (!filePath.endsWith(".world", Qt::CaseInsensitive)) {
+        filePath += ".world";
+    }
+    
+    if (m_canvas->exportWorld(filePath)) {
+        // Worlds hold entities, prefabs, layers and groups only
+        QStringList dropped;
+        if (!m_canvas->tiles().isEmpty()) {
+            dropped << "The tile layer is not exported.";
+        }
+        if (m_canvas->components().entityCount() > 0) {
+            dropped << "Components are not exported.";
+        }
+        QString message = "World exported successfully!";
+        if (!dropped.isEmpty()) {
+            message += "\n\n" + dropped.join('\n');
+        }
+        QMessageBox::information(this, "Success", message);
+    } else {
+        QMessageBox::warning(this, "Error", "Failed to export world.");
+    }
+}
+
+void MainWindow::toggleLiveLink(bool enabled)
+{
+    if (!enabled) {
+        if (m_liveLink) {
+            m_liveLink->stop();
+        }
+        statusBar()->showMessage("Live link stopped", 3000);
+        return;
+    }
+    
+    if (!m_liveLink) {
+        m_liveLink = new LiveLinkServer(m_canvas, this);
+        connect(m_liveLink, &LiveLinkServer::clientCountChanged, this, &MainWindow::onLiveLinkClientsChanged);
+    }
+    if (m_liveLink->start()) {
+        statusBar()->showMessage(QString("Live link listening on '%1'").arg(m_liveLink->serverName()), 5000);
+    } else {
+        QMessageBox::warning(this, "Live Link", "Cannot start the live link: " + m_liveLink->errorString());
+    }
+}
+
+void MainWindow::onLiveLinkClientsChanged(int count)
+{
+    statusBar()->showMessage(QString("Live link: %1 game(s) connected").arg(count), 3000);
+}
+
+void MainWindow::onExportRuntime()
+{
+    if (m_canvas->isWorldOpen() || m_canvas->isStreaming()) {
+        QMessageBox::warning(this, "Export", "Only a fully loaded scene can be exported for the runtime.");
+        return;
+    }
+    
+    QString filePath = QFileDialog::getSaveFileName(
+        this,
+        "Export for Runtime",
+        "",
+        "Runtime Scenes (*.qlrt);;All Files (*)"
+    );
+    
+    if (filePath.isEmpty()) {
+        return;  // User cancelled
+    }
+    
+    // Ensure .qlrt extension
+    if (!filePath.endsWith(".qlrt", Qt::CaseInsensitive)) {
+        filePath += ".qlrt";
+    }
+    
+    QString error;
+    if (m_canvas->exportRuntime(filePath, &error)) {
+        // The runtime format carries entity fields only
+        QString note = m_canvas->components().entityCount() > 0 ? " (components are not exported)" : QString();
+        statusBar()->showMessage(QString("Exported %1 entities for the runtime%2").arg(m_canvas->entityCount()).arg(note),
+                                 5000);
+    } else {
+        QMessageBox::warning(this, "Error", "Failed to export for the runtime: " + error);
+    }
+}
+
+void MainWindow::onCompareWithScene()
+{
+    if (m_canvas->isWorldOpen() || m_canvas->isStreaming()) {
+        QMessageBox::warning(this, "Compare", "Only a fully loaded scene can be compared.");
+        return;
+    }
+    
+    QString filePath = QFileDialog::getOpenFileName(
+        this,
+        "Compare With Scene",
+        "",
+        "JSON Files (*.json);;All Files (*)"
+    );
+    
+    if (filePath.isEmpty()) {
+        return;  // User cancelled
+    }
+    
+    // The other version as it would load, journal included. Read-only:
+    // viewing a diff must not trim the other scene's journal.
+    SceneData base;
+    if (!SceneFile::load(filePath, &base) || !SceneJournal::replayReadOnly(filePath, &base)) {
+        QMessageBox::warning(this, "Error", "Failed to load scene from file.");
+        return;
+    }
+    
+    SceneDiff::Result diff = m_canvas->compareWith(std::move(base));
+    statusBar()->showMessage(QString("Compared with %1: %2").arg(QFileInfo(filePath).fileName(), diff.summary()));
+}
+
+void MainWindow::onClearComparison()
+{
+    m_canvas->clearComparison();
+    statusBar()->clearMessage();
+}
+
+void MainWindow::onLoadProgress(int loaded, int total)
+{
+    m_loadProgressBar->setVisible(true);
+    m_cancelLoadButton->setVisible(true);
+    
+    if (total <= 0) {
+        // Still parsing: busy indicator
+        m_loadProgressBar->setRange(0, 0);
+        statusBar()->showMessage("Reading scene...");
+    } else {
+        m_loadProgressBar->setRange(0, total);
+        m_loadProgressBar->setValue(loaded);
+        statusBar()->showMessage(QString("Loading entities: %1 / %2").arg(loaded).arg(total));
+    }
+}
+
+void MainWindow::onLoadFinished(bool success)
+{
+    m_loadProgressBar->setVisible(false);
+    m_cancelLoadButton->setVisible(false);
+    statusBar()->clearMessage();
+    
+    if (success) {
+        // Commands refer to the old scene's entities
+        m_undoStack->clear();
+        m_currentFilePath = m_sceneLoader->filePath();
+        m_sceneWatcher->watch(m_currentFilePath);
+        const SceneValidator::Report &report = m_sceneLoader->validationReport();
+        if (report.isValid()) {
+            QMessageBox::information(this, "Success", "Scene loaded successfully!");
+        } else {
+            QMessageBox::warning(this, "Loaded With Issues", "Scene loaded, but it has problems:\n\n" + report.summary());
+        }
     } else {
         QMessageBox::warning(this, "Error", "Failed to load scene from file.");
     }
+    restoreUndoActions();
+}
+
+void MainWindow::restoreUndoActions()
+{
+    m_undoAction->setEnabled(m_undoStack->canUndo());
+    m_redoAction->setEnabled(m_undoStack->canRedo());
+}
+
+void MainWindow::onLoadCanceled()
+{
+    m_loadProgressBar->setVisible(false);
+    m_cancelLoadButton->setVisible(false);
+    statusBar()->showMessage("Loading cancelled", 3000);
+    
+    // The previous scene is back
+    m_sceneWatcher->watch(m_currentFilePath);
+    restoreUndoActions();
+}
+
+void MainWindow::onSceneFileChanged()
+{
+    std::shared_ptr<SceneData> scene = m_sceneWatcher->takeScene();
+    if (!scene || m_sceneLoader->isLoading() || m_canvas->isWorldOpen()) {
+        return;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    int kept = 0;
+    SceneDiff::Result applied = m_canvas->reloadChanges(*scene, &kept);
+    
+    QString message = QString("Reloaded %1: %2 (%3 ms)")
+                          .arg(QFileInfo(m_currentFilePath).fileName(), applied.summary())
+                          .arg(timer.elapsed());
+    if (kept > 0) {
+        message += QString(", kept unsaved edits to %1 entities").arg(kept);
+    }
+    statusBar()->showMessage(message, 5000);
+}
+
+void MainWindow::onSceneReloadFailed()
+{
+    statusBar()->showMessage(QString("Could not reload %1").arg(QFileInfo(m_currentFilePath).fileName()), 5000);
+}
+
+void MainWindow::toggleJournaledSaves()
+{
+    m_journaledSaves = !m_journaledSaves;
+}
+
+void MainWindow::onReportOverlaps()
+{
+    std::vector<std::pair<int, int>> pairs = m_canvas->overlappingPairs();
+    if (pairs.empty()) {
+        QMessageBox::information(this, "Overlaps", "No entities overlap.");
+        return;
+    }
+    
+    // List the first few pairs by entity id
+    const size_t maxListed = 20;
+    QStringList lines;
+    for (size_t i = 0; i < pairs.size() && i < maxListed; ++i) {
+        lines << QString("Entity %1 overlaps entity %2").arg(pairs[i].first).arg(pairs[i].second);
+    }
+    if (pairs.size() > maxListed) {
+        lines << QString("... and %1 more").arg(pairs.size() - maxListed);
+    }
+    QMessageBox::information(this, "Overlaps",
+                             QString("%1 overlapping pairs:\n\n%2").arg(pairs.size()).arg(lines.join("\n")));
+}
+
+void MainWindow::toggleCompressedSaves()
+{
+    bool compressed = m_canvas->saveCompression() != SceneCodec::Compression::None;
+    m_canvas->setSaveCompression(compressed ? SceneCodec::Compression::None
+                                            : SceneCodec::Compression::Zlib);
 }
 
 void MainWindow::toggleGridVisibility()
@@ -0,0 +1,169 @@
+#include "MinimapRaster.h"
+
+namespace {
+
+int floorDiv(int value, int divisor)
+{
+    int result = value / divisor;
+    if (value < 0 && result * divisor != value) {
+        --result;
+    }
+    return result;
+}
+
+} // namespace
+
+MinimapRaster::MinimapRaster()
+    : m_cellSize(MIN_CELL_SIZE)
+{
+}
+
+void MinimapRaster::clear()
+{
+    m_footprints.clear();
+    m_cellSize = MIN_CELL_SIZE;
+    m_origin = QPoint();
+    m_gridSize = QSize();
+    m_cells.clear();
+    m_image = QImage();
+    m_dirty = QRect();
+}
+
+void MinimapRaster::rebuild(const std::vector<Entity> &entities, const LayerStack &layers)
+{
+    clear();
+    
+    // Footprints first, then one grid sized for all of them
+    QRect bounds;
+    m_footprints.reserve(static_cast<int>(entities.size()));
+    for (const Entity &entity : entities) {
+        if (entity.rect().isEmpty() || !layers.isVisible(entity.layerId())) {
+            continue;
+        }
+        m_footprints.insert(entity.id(), {entity.rect(), entity.color().rgb()});
+        bounds |= entity.rect();
+    }
+    if (!bounds.isEmpty()) {
+        resize(bounds);
+    }
+}
+
+void MinimapRaster::update(int entityId, const QRect &rect, const QColor &color)
+{
+    auto it = m_footprints.find(entityId);
+    if (it != m_footprints.end()) {
+        if (it->rect == rect && it->color == color.rgb()) {
+            return;
+        }
+        accumulate(*it, -1);
+        m_footprints.erase(it);
+    }
+    if (rect.isEmpty()) {
+        return;
+    }
+    
+    Footprint footprint{rect, color.rgb()};
+    m_footprints.insert(entityId, footprint);
+    if (!sceneRect().contains(rect)) {
+        fit(rect);  // Re-adds every footprint, this one included
+    } else {
+        accumulate(footprint, 1);
+    }
+}
+
+void MinimapRaster::remove(int entityId)
+{
+    auto it = m_footprints.find(entityId);
+    if (it != m_footprints.end()) {
+        accumulate(*it, -1);
+        m_footprints.erase(it);
+    }
+}
+
+QRect MinimapRaster::sceneRect() const
+{
+    return QRect(m_origin, m_gridSize * m_cellSize);
+}
+
+QRect MinimapRaster::cellsOf(const QRect &sceneRect) const
+{
+    QRect cells(QPoint(floorDiv(sceneRect.left() - m_origin.x(), m_cellSize),
+                       floorDiv(sceneRect.top() - m_origin.y(), m_cellSize)),
+                QPoint(floorDiv(sceneRect.right() - m_origin.x(), m_cellSize),
+                       floorDiv(sceneRect.bottom() - m_origin.y(), m_cellSize)));
+    return cells.intersected(QRect(QPoint(0, 0), m_gridSize));
+}
+
+void MinimapRaster::accumulate(const Footprint &footprint, int sign)
+{
+    QRect cells = cellsOf(footprint.rect);
+    if (cells.isEmpty()) {
+        return;
+    }
+    
+    quint32 red = static_cast<quint32>(qRed(footprint.color) * sign);
+    quint32 green = static_cast<quint32>(qGreen(footprint.color) * sign);
+    quint32 blue = static_cast<quint32>(qBlue(footprint.color) * sign);
+    quint32 count = static_cast<quint32>(sign);
+    for (int y = cells.top(); y <= cells.bottom(); ++y) {
+        Cell *row = &m_cells[static_cast<size_t>(y) * m_gridSize.width()];
+        for (int x = cells.left(); x <= cells.right(); ++x) {
+            // Unsigned wrap-around makes subtracting exact
+            row[x].red += red;
+            row[x].green += green;
+            row[x].blue += blue;
+            row[x].count += count;
+        }
+    }
+    m_dirty |= cells;
+}
+
+void MinimapRaster::fit(const QRect &sceneRect)
+{
+    // Grow by a margin so a scene that keeps expanding doesn't resize every time
+    QRect bounds = this->sceneRect().isEmpty() ? sceneRect : this->sceneRect().united(sceneRect);
+    int marginX = bounds.width() / 4;
+    int marginY = bounds.height() / 4;
+    resize(bounds.adjusted(-marginX, -marginY, marginX, marginY));
+}
+
+void MinimapRaster::resize(const QRect &sceneRect)
+{
+    m_cellSize = MIN_CELL_SIZE;
+    while (sceneRect.width() / m_cellSize >= MAX_CELLS || sceneRect.height() / m_cellSize >= MAX_CELLS) {
+        m_cellSize *= 2;
+    }
+    
+    // Cells stay aligned to multiples of the cell size
+    m_origin = QPoint(floorDiv(sceneRect.left(), m_cellSize) * m_cellSize,
+                      floorDiv(sceneRect.top(), m_cellSize) * m_cellSize);
+    m_gridSize = QSize((sceneRect.right() - m_origin.x()) / m_cellSize + 1,
+                       (sceneRect.bottom() - m_origin.y()) / m_cellSize + 1);
+    m_cells.assign(static_cast<size_t>(m_gridSize.width()) * m_gridSize.height(), Cell());
+    m_image = QImage(m_gridSize, QImage::Format_ARGB32);
+    m_dirty = QRect(QPoint(0, 0), m_gridSize);
+    
+    for (const Footprint &footprint : std::as_const(m_footprints)) {
+        accumulate(footprint, 1);
+    }
+}
+
+const QImage &MinimapRaster::image()
+{
+    if (m_dirty.isEmpty()) {
+        return m_image;
+    }
+    
+    // Average color of the entities in each touched cell
+    for (int y = m_dirty.top(); y <= m_dirty.bottom(); ++y) {
+        const Cell *cells = &m_cells[static_cast<size_t>(y) * m_gridSize.width()];
+        QRgb *pixels = reinterpret_cast<QRgb *>(m_image.scanLine(y));
+        for (int x = m_dirty.left(); x <= m_dirty.right(); ++x) {
+            const Cell &cell = cells[x];
+            pixels[x] = cell.count == 0 ? qRgba(0, 0, 0, 0)
+                                        : qRgb(cell.red / cell.count, cell.green / cell.count, cell.blue / cell.count);
+        }
+    }
+    m_dirty = QRect();
+    return m_image;
+}
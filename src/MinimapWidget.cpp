@@ -0,0 +1,107 @@
+#include "MinimapWidget.h"
+#include "Canvas.h"
+#include "MinimapRaster.h"
+#include <QMouseEvent>
+#include <QPainter>
+
+MinimapWidget::MinimapWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_canvas(nullptr)
+{
+    setMinimumSize(120, 90);
+    setCursor(Qt::PointingHandCursor);
+}
+
+void MinimapWidget::setCanvas(Canvas *canvas)
+{
+    m_canvas = canvas;
+    if (m_canvas) {
+        connect(m_canvas, &Canvas::minimapChanged, this, QOverload<>::of(&QWidget::update));
+        connect(m_canvas, &Canvas::viewChanged, this, QOverload<>::of(&QWidget::update));
+    }
+    update();
+}
+
+QSize MinimapWidget::sizeHint() const
+{
+    return QSize(200, 150);
+}
+
+QRect MinimapWidget::shownSceneRect()
+{
+    // The scene plus the view, so the view outline is always inside
+    QRect shown = m_canvas->visibleSceneRect();
+    const MinimapRaster &raster = m_canvas->minimap();
+    if (!raster.isEmpty()) {
+        shown |= raster.sceneRect();
+    }
+    return shown;
+}
+
+QRectF MinimapWidget::targetRect(const QRect &sceneRect) const
+{
+    QRectF area = QRectF(rect()).adjusted(4, 4, -4, -4);
+    qreal scale = qMin(area.width() / sceneRect.width(), area.height() / sceneRect.height());
+    QSizeF size(sceneRect.width() * scale, sceneRect.height() * scale);
+    return QRectF(area.center() - QPointF(size.width() / 2, size.height() / 2), size);
+}
+
+void MinimapWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+    
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().window());
+    if (!m_canvas) {
+        return;
+    }
+    
+    QRect shown = shownSceneRect();
+    QRectF target = targetRect(shown);
+    painter.fillRect(target, QColor(240, 240, 240));
+    
+    // Painter in scene coordinates from here on
+    painter.translate(target.topLeft());
+    painter.scale(target.width() / shown.width(), target.height() / shown.height());
+    painter.translate(-shown.topLeft());
+    
+    MinimapRaster &raster = m_canvas->minimap();
+    if (!raster.isEmpty()) {
+        painter.drawImage(QRectF(raster.sceneRect()), raster.image());
+    }
+    
+    // Visible area of the canvas
+    painter.setBrush(Qt::NoBrush);
+    QPen viewPen(QColor(255, 200, 0), 2);
+    viewPen.setCosmetic(true);  // Same width at any scale
+    painter.setPen(viewPen);
+    painter.drawRect(m_canvas->visibleSceneRect());
+}
+
+void MinimapWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        navigateTo(event->position().toPoint());
+    }
+}
+
+void MinimapWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons() & Qt::LeftButton) {
+        navigateTo(event->position().toPoint());
+    }
+}
+
+void MinimapWidget::navigateTo(const QPoint &widgetPos)
+{
+    if (!m_canvas) {
+        return;
+    }
+    
+    // Inverse of the mapping paintEvent uses
+    QRect shown = shownSceneRect();
+    QRectF target = targetRect(shown);
+    qreal scale = target.width() / shown.width();
+    QPointF scenePos = QPointF(shown.topLeft()) + (QPointF(widgetPos) - target.topLeft()) / scale;
+    m_canvas->centerOn(scenePos.toPoint());
+}
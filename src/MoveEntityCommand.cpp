@@ -2,38 +2,46 @@
 #include "Canvas.h"
 
 MoveEntityCommand::MoveEntityCommand(Canvas *canvas, int entityIndex, const QPoint &oldPos, const QPoint &newPos, QUndoCommand *parent)
-    : QUndoCommand(parent)
+    : EditorCommand(parent)
     , m_canvas(canvas)
+    , m_entityId(-1)
     , m_entityIndex(entityIndex)
     , m_oldPos(oldPos)
     , m_newPos(newPos)
 {
     setText("Move Entity");
+    
+    if (const Entity *entity = canvas ? canvas->getEntity(entityIndex) : nullptr) {
+        m_entityId = entity->id();
+    }
 }
 
 void MoveEntityCommand::undo()
 {
-    if (!m_canvas || m_entityIndex < 0) return;
+    if (!m_canvas || m_entityId < 0) return;
     
+    m_entityIndex = m_canvas->residentIndexOf(m_entityId, m_newPos, m_entityIndex);
     Entity *entity = m_canvas->getEntity(m_entityIndex);
-    if (entity) {
-        entity->setPosition(m_oldPos);
-        m_canvas->update();
+    if (!entity) {
+        setObsolete(true);
+        m_canvas->reportCommandFailure(text());
+        return;
     }
+    entity->setPosition(m_oldPos);
+    m_canvas->notifyEntityChanged(m_entityIndex);
 }
 
 void MoveEntityCommand::redo()
 {
-    if (!m_canvas || m_entityIndex < 0) return;
+    if (!m_canvas || m_entityId < 0) return;
     
+    m_entityIndex = m_canvas->residentIndexOf(m_entityId, m_oldPos, m_entityIndex);
     Entity *entity = m_canvas->getEntity(m_entityIndex);
-    if (entity) {
-        entity->setPosition(m_newPos);
-        m_canvas->update();
+    if (!entity) {
+        setObsolete(true);
+        m_canvas->reportCommandFailure(text());
+        return;
     }
-}
-
-void MoveEntityCommand::setNewPosition(const QPoint &newPos)
-{
-    m_newPos = newPos;
+    entity->setPosition(m_newPos);
+    m_canvas->notifyEntityChanged(m_entityIndex);
 }
\ No newline at end of file
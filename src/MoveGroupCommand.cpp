@@ -0,0 +1,31 @@
+#include "MoveGroupCommand.h"
+#include "Canvas.h"
+
+MoveGroupCommand::MoveGroupCommand(Canvas *canvas, int groupId, const QPoint &delta, QUndoCommand *parent)
+    : EditorCommand(parent)
+    , m_canvas(canvas)
+    , m_groupId(groupId)
+    , m_delta(delta)
+{
+    setText("Move Group");
+}
+
+void MoveGroupCommand::undo()
+{
+    if (!m_canvas) return;
+    
+    if (!m_canvas->translateGroup(m_groupId, -m_delta)) {
+        setObsolete(true);
+        m_canvas->reportCommandFailure(text());
+    }
+}
+
+void MoveGroupCommand::redo()
+{
+    if (!m_canvas) return;
+    
+    if (!m_canvas->translateGroup(m_groupId, m_delta)) {
+        setObsolete(true);
+        m_canvas->reportCommandFailure(text());
+    }
+}
@@ -0,0 +1,201 @@
+#include "NamePool.h"
+#include <QReadLocker>
+#include <QWriteLocker>
+
+NamePool &NamePool::instance()
+{
+    // Never destroyed: names may still be released during static destruction
+    static NamePool *pool = new NamePool;
+    return *pool;
+}
+
+NamePool::NamePool()
+{
+    for (std::atomic<Entry *> &chunk : m_chunks) {
+        chunk.store(nullptr, std::memory_order_relaxed);
+    }
+    QWriteLocker locker(&m_lock);
+    allocate(QString());  // EMPTY, never counted
+}
+
+quint32 NamePool::allocate(const QString &str)
+{
+    quint32 index;
+    if (!m_free.empty()) {
+        index = m_free.back();
+        m_free.pop_back();
+    } else {
+        index = m_used++;
+        Q_ASSERT(index < quint32(MAX_CHUNKS) * CHUNK_SIZE);
+        std::atomic<Entry *> &chunk = m_chunks[index >> CHUNK_BITS];
+        if (!chunk.load(std::memory_order_relaxed)) {
+            chunk.store(new Entry[CHUNK_SIZE], std::memory_order_release);
+        }
+    }
+    Entry &slot = entry(index);
+    slot.text = str;
+    slot.refs.storeRelaxed(0);
+    return index;
+}
+
+PooledName NamePool::intern(const QString &name)
+{
+    if (name.isEmpty()) {
+        return PooledName();
+    }
+    
+    // Fast path: most names are already interned. The reference is taken
+    // under the lock so a concurrent release can't free the slot in between.
+    {
+        QReadLocker locker(&m_lock);
+        auto it = m_lookup.constFind(name);
+        if (it != m_lookup.constEnd()) {
+            entry(it.value()).refs.ref();
+            return PooledName(it.value(), PooledName::Adopt());
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    auto it = m_lookup.constFind(name);  // Another thread may have added it
+    quint32 index = it != m_lookup.constEnd() ? it.value() : allocate(name);
+    m_lookup.insert(name, index);
+    entry(index).refs.ref();
+    return PooledName(index, PooledName::Adopt());
+}
+
+NameRef NamePool::internPattern(const QString &pattern)
+{
+    {
+        QReadLocker locker(&m_lock);
+        auto it = m_patternLookup.constFind(pattern);
+        if (it != m_patternLookup.constEnd()) {
+            return it.value() | PATTERN_BIT;
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    auto it = m_patternLookup.constFind(pattern);
+    if (it != m_patternLookup.constEnd()) {
+        return it.value() | PATTERN_BIT;
+    }
+    quint32 index = allocate(pattern);
+    m_patternLookup.insert(pattern, index);
+    return index | PATTERN_BIT;
+}
+
+NameRef NamePool::defaultPattern()
+{
+    {
+        QReadLocker locker(&m_lock);
+        if (m_hasDefaultPattern) {
+            return m_defaultPattern;
+        }
+    }
+
+    NameRef ref = internPattern("Entity_%1");
+    QWriteLocker locker(&m_lock);
+    m_defaultPattern = ref;
+    m_hasDefaultPattern = true;
+    return ref;
+}
+
+void NamePool::retain(NameRef ref)
+{
+    if (!isPattern(ref) && ref != EMPTY) {
+        entry(ref).refs.ref();
+    }
+}
+
+void NamePool::release(NameRef ref)
+{
+    if (isPattern(ref) || ref == EMPTY || entry(ref).refs.deref()) {
+        return;
+    }
+    
+    // Last reference gone. An intern() may have revived it meanwhile, and two
+    // releases may race here, so check again under the lock.
+    QWriteLocker locker(&m_lock);
+    Entry &slot = entry(ref);
+    auto it = m_lookup.find(slot.text);
+    if (slot.refs.loadAcquire() != 0 || it == m_lookup.end() || it.value() != ref) {
+        return;
+    }
+    m_lookup.erase(it);
+    slot.text = QString();
+    m_free.push_back(ref);
+}
+
+QString NamePool::text(NameRef ref) const
+{
+    // Live handles keep their slot unchanged, so no lock is needed
+    quint32 index = ref & ~PATTERN_BIT;
+    if (index >= CHUNK_SIZE * quint32(MAX_CHUNKS) || !m_chunks[index >> CHUNK_BITS].load(std::memory_order_acquire)) {
+        return QString();
+    }
+    return entry(index).text;
+}
+
+QString NamePool::resolve(NameRef ref, int id) const
+{
+    QString str = text(ref);
+    if (isPattern(ref)) {
+        return str.arg(id);
+    }
+    return str;
+}
+
+int NamePool::size() const
+{
+    QReadLocker locker(&m_lock);
+    return m_lookup.size() + m_patternLookup.size();
+}
+
+int NameTable::indexOf(NameRef ref)
+{
+    auto it = m_indexByRef.constFind(ref);
+    if (it != m_indexByRef.constEnd()) {
+        return it.value();
+    }
+    int index = m_strings.size();
+    m_strings.append(NamePool::instance().text(ref));
+    m_indexByRef.insert(ref, index);
+    return index;
+}
+
+QJsonArray NameTable::toJson() const
+{
+    return QJsonArray::fromStringList(m_strings);
+}
+
+NameTable NameTable::fromJson(const QJsonArray &array)
+{
+    NameTable table;
+    table.m_strings.reserve(array.size());
+    for (const QJsonValue &value : array) {
+        table.m_strings.append(value.toString());
+    }
+    return table;
+}
+
+NameRef NameTable::literalRef(int index) const
+{
+    // Cache per table slot so loading N entities costs one pool lookup per distinct name
+    if (m_literalRefs.size() != m_strings.size()) {
+        m_literalRefs.fill(PooledName(UNRESOLVED), m_strings.size());
+    }
+    if (NameRef(m_literalRefs[index]) == UNRESOLVED) {
+        m_literalRefs[index] = NamePool::instance().intern(m_strings.value(index));
+    }
+    return m_literalRefs[index];
+}
+
+NameRef NameTable::patternRef(int index) const
+{
+    if (m_patternRefs.size() != m_strings.size()) {
+        m_patternRefs.fill(UNRESOLVED, m_strings.size());
+    }
+    if (m_patternRefs[index] == UNRESOLVED) {
+        m_patternRefs[index] = NamePool::instance().internPattern(m_strings.value(index));
+    }
+    return m_patternRefs[index];
+}
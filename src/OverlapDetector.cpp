@@ -0,0 +1,236 @@
+#include "OverlapDetector.h"
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <functional>
+
+OverlapDetector::OverlapDetector()
+    : m_pairCount(0)
+{
+}
+
+void OverlapDetector::clear()
+{
+    m_cells.clear();
+    m_large.clear();
+    m_rects.clear();
+    m_neighbors.clear();
+    m_pairCount = 0;
+}
+
+bool OverlapDetector::isLarge(const QRect &rect)
+{
+    qint64 columns = cellOf(rect.right()) - cellOf(rect.left()) + 1;
+    qint64 rows = cellOf(rect.bottom()) - cellOf(rect.top()) + 1;
+    return columns * rows > MAX_CELLS_PER_BOX;
+}
+
+bool OverlapDetector::ownsPair(const QRect &a, const QRect &b, int cx, int cy)
+{
+    return cellOf(std::max(a.left(), b.left())) == cx && cellOf(std::max(a.top(), b.top())) == cy;
+}
+
+void OverlapDetector::insertBox(const Box &box)
+{
+    if (isLarge(box.rect)) {
+        m_large.push_back(box);
+        return;
+    }
+    for (int cy = cellOf(box.rect.top()); cy <= cellOf(box.rect.bottom()); ++cy) {
+        for (int cx = cellOf(box.rect.left()); cx <= cellOf(box.rect.right()); ++cx) {
+            m_cells[cellKey(cx, cy)].push_back(box);
+        }
+    }
+}
+
+void OverlapDetector::removeBox(const Box &box)
+{
+    if (isLarge(box.rect)) {
+        auto it = std::find_if(m_large.begin(), m_large.end(), [&box](const Box &other) { return other.id == box.id; });
+        if (it != m_large.end()) {
+            *it = m_large.back();
+            m_large.pop_back();
+        }
+        return;
+    }
+    for (int cy = cellOf(box.rect.top()); cy <= cellOf(box.rect.bottom()); ++cy) {
+        for (int cx = cellOf(box.rect.left()); cx <= cellOf(box.rect.right()); ++cx) {
+            auto cell = m_cells.find(cellKey(cx, cy));
+            if (cell == m_cells.end()) {
+                continue;
+            }
+            auto it = std::find_if(cell->begin(), cell->end(), [&box](const Box &other) { return other.id == box.id; });
+            if (it != cell->end()) {
+                *it = cell->back();
+                cell->pop_back();
+            }
+            if (cell->empty()) {
+                m_cells.erase(cell);
+            }
+        }
+    }
+}
+
+void OverlapDetector::addPair(int a, int b)
+{
+    QSet<int> &first = m_neighbors[a];
+    if (first.contains(b)) {
+        return;
+    }
+    first.insert(b);
+    m_neighbors[b].insert(a);
+    m_pairCount++;
+}
+
+void OverlapDetector::rebuild(const std::vector<Entity> &entities, int threadCount)
+{
+    clear();
+    m_rects.reserve(static_cast<qsizetype>(entities.size()));
+    for (const Entity &entity : entities) {
+        m_rects.insert(entity.id(), entity.rect());
+        insertBox({ entity.rect(), entity.id() });
+    }
+    
+    // Sweep a range of cells: each cell compares its boxes pairwise and keeps
+    // the pairs whose intersection starts inside it
+    struct CellRef {
+        const Cell *boxes;
+        int cx;
+        int cy;
+    };
+    std::vector<CellRef> cells;
+    cells.reserve(m_cells.size());
+    for (auto it = m_cells.constBegin(); it != m_cells.constEnd(); ++it) {
+        cells.push_back({ &it.value(), int(quint32(it.key() >> 32)), int(quint32(it.key())) });
+    }
+    
+    using Range = std::pair<size_t, size_t>;
+    using PairList = std::vector<std::pair<int, int>>;
+    std::function<PairList(const Range &)> sweep = [&cells](const Range &range) {
+        PairList found;
+        for (size_t c = range.first; c < range.second; ++c) {
+            const Cell &boxes = *cells[c].boxes;
+            for (size_t i = 0; i < boxes.size(); ++i) {
+                for (size_t j = i + 1; j < boxes.size(); ++j) {
+                    if (boxes[i].rect.intersects(boxes[j].rect) &&
+                        ownsPair(boxes[i].rect, boxes[j].rect, cells[c].cx, cells[c].cy)) {
+                        found.emplace_back(boxes[i].id, boxes[j].id);
+                    }
+                }
+            }
+        }
+        return found;
+    };
+    
+    std::vector<PairList> results;
+    if (threadCount == 1 || entities.size() < static_cast<size_t>(PARALLEL_THRESHOLD)) {
+        results.push_back(sweep(Range(0, cells.size())));
+    } else {
+        QThreadPool localPool;
+        QThreadPool *pool = QThreadPool::globalInstance();
+        if (threadCount > 0) {
+            localPool.setMaxThreadCount(threadCount);
+            pool = &localPool;
+        }
+        // A few ranges per worker: dense clusters make some ranges slower than others
+        size_t rangeCount = static_cast<size_t>(qMax(1, pool->maxThreadCount() * 4));
+        size_t rangeSize = qMax<size_t>(1, (cells.size() + rangeCount - 1) / rangeCount);
+        std::vector<Range> ranges;
+        for (size_t first = 0; first < cells.size(); first += rangeSize) {
+            ranges.emplace_back(first, std::min(first + rangeSize, cells.size()));
+        }
+        results = QtConcurrent::blockingMapped<std::vector<PairList>>(pool, ranges, sweep);
+    }
+    
+    for (const PairList &found : results) {
+        for (const auto &pair : found) {
+            addPair(pair.first, pair.second);
+        }
+    }
+    
+    // Large boxes are few: test each against everything
+    for (const Box &large : m_large) {
+        for (auto it = m_rects.constBegin(); it != m_rects.constEnd(); ++it) {
+            if (it.key() != large.id && large.rect.intersects(it.value())) {
+                addPair(large.id, it.key());
+            }
+        }
+    }
+}
+
+void OverlapDetector::update(int entityId, const QRect &rect)
+{
+    auto current = m_rects.constFind(entityId);
+    if (current != m_rects.constEnd() && current.value() == rect) {
+        return;  // Unchanged (e.g. only the name or color changed)
+    }
+    remove(entityId);
+    
+    Box box{ rect, entityId };
+    m_rects.insert(entityId, rect);
+    insertBox(box);
+    
+    if (isLarge(rect)) {
+        for (auto it = m_rects.constBegin(); it != m_rects.constEnd(); ++it) {
+            if (it.key() != entityId && rect.intersects(it.value())) {
+                addPair(entityId, it.key());
+            }
+        }
+        return;
+    }
+    
+    // Only the cells under the new rect can hold overlapping boxes
+    for (int cy = cellOf(rect.top()); cy <= cellOf(rect.bottom()); ++cy) {
+        for (int cx = cellOf(rect.left()); cx <= cellOf(rect.right()); ++cx) {
+            const Cell &cell = m_cells[cellKey(cx, cy)];
+            for (const Box &other : cell) {
+                if (other.id != entityId && rect.intersects(other.rect) && ownsPair(rect, other.rect, cx, cy)) {
+                    addPair(entityId, other.id);
+                }
+            }
+        }
+    }
+    for (const Box &large : m_large) {
+        if (rect.intersects(large.rect)) {
+            addPair(entityId, large.id);
+        }
+    }
+}
+
+void OverlapDetector::remove(int entityId)
+{
+    auto rect = m_rects.find(entityId);
+    if (rect == m_rects.end()) {
+        return;
+    }
+    
+    removeBox({ rect.value(), entityId });
+    m_rects.erase(rect);
+    
+    const QSet<int> neighbors = m_neighbors.take(entityId);
+    for (int other : neighbors) {
+        auto otherNeighbors = m_neighbors.find(other);
+        if (otherNeighbors != m_neighbors.end()) {
+            otherNeighbors->remove(entityId);
+            if (otherNeighbors->isEmpty()) {
+                m_neighbors.erase(otherNeighbors);
+            }
+        }
+    }
+    m_pairCount -= neighbors.size();
+}
+
+std::vector<std::pair<int, int>> OverlapDetector::pairs() const
+{
+    std::vector<std::pair<int, int>> result;
+    result.reserve(m_pairCount);
+    for (auto it = m_neighbors.constBegin(); it != m_neighbors.constEnd(); ++it) {
+        for (int other : it.value()) {
+            if (it.key() < other) {
+                result.emplace_back(it.key(), other);
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
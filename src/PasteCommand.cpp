@@ -0,0 +1,43 @@
+#include "PasteCommand.h"
+#include "Canvas.h"
+#include <QSet>
+
+PasteCommand::PasteCommand(Canvas *canvas, std::vector<Entity> &&entities, const std::vector<ComponentType> &types,
+                           QHash<int, ComponentStore::Values> &&components, QUndoCommand *parent)
+    : EditorCommand(parent)
+    , m_canvas(canvas)
+    , m_entities(std::move(entities))
+    , m_types(types)
+    , m_components(std::move(components))
+{
+    setText(m_entities.size() == 1 ? QString("Paste Entity") : QString("Paste %1 Entities").arg(m_entities.size()));
+}
+
+void PasteCommand::redo()
+{
+    if (!m_canvas || m_entities.empty()) return;
+    
+    // A type whose name was taken meanwhile (hot reload) just loses its values
+    for (const ComponentType &type : m_types) {
+        m_canvas->setComponentTypeDefined(type, true);
+    }
+    m_canvas->appendEntityBlock(m_entities, m_components);
+    
+    // The pasted entities become the selection
+    QSet<int> ids;
+    ids.reserve(static_cast<int>(m_entities.size()));
+    for (const Entity &entity : m_entities) {
+        ids.insert(entity.id());
+    }
+    m_canvas->selectEntityIds(ids);
+}
+
+void PasteCommand::undo()
+{
+    if (!m_canvas || m_entities.empty()) return;
+    
+    m_canvas->removeEntityBlock(m_entities.front().id(), static_cast<int>(m_entities.size()));
+    for (auto it = m_types.rbegin(); it != m_types.rend(); ++it) {
+        m_canvas->setComponentTypeDefined(*it, false);
+    }
+}
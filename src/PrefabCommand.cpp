@@ -0,0 +1,30 @@
+#include "PrefabCommand.h"
+#include "Canvas.h"
+
+PrefabCommand::PrefabCommand(Canvas *canvas, int prefabId, const Prefab &before, const Prefab &after,
+                             std::vector<Entity> &&entitiesBefore, std::vector<Entity> &&entitiesAfter,
+                             const QString &text, QUndoCommand *parent)
+    : EditorCommand(parent)
+    , m_canvas(canvas)
+    , m_prefabId(prefabId)
+    , m_before(before)
+    , m_after(after)
+    , m_entitiesBefore(std::move(entitiesBefore))
+    , m_entitiesAfter(std::move(entitiesAfter))
+{
+    setText(text);
+}
+
+void PrefabCommand::redo()
+{
+    if (!m_canvas) return;
+    
+    m_canvas->setPrefabState(m_prefabId, m_after, m_entitiesAfter);
+}
+
+void PrefabCommand::undo()
+{
+    if (!m_canvas) return;
+    
+    m_canvas->setPrefabState(m_prefabId, m_before, m_entitiesBefore);
+}
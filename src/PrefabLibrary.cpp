@@ -0,0 +1,137 @@
+#include "PrefabLibrary.h"
+#include <QJsonObject>
+#include <algorithm>
+
+int PrefabLibrary::add(const Prefab &prefab)
+{
+    Prefab stored = prefab;
+    stored.id = m_nextId++;
+    m_prefabs.insert(stored.id, stored);
+    return stored.id;
+}
+
+bool PrefabLibrary::update(const Prefab &prefab)
+{
+    auto it = m_prefabs.find(prefab.id);
+    if (it == m_prefabs.end()) {
+        return false;
+    }
+    it.value() = prefab;
+    return true;
+}
+
+void PrefabLibrary::insert(const Prefab &prefab)
+{
+    m_prefabs.insert(prefab.id, prefab);
+    m_nextId = std::max(m_nextId, prefab.id + 1);
+}
+
+bool PrefabLibrary::remove(int id)
+{
+    // Ids are not handed out again, so a redo can bring the prefab back under its id
+    return m_prefabs.remove(id) > 0;
+}
+
+void PrefabLibrary::clear()
+{
+    m_prefabs.clear();
+    m_nextId = 1;
+}
+
+const Prefab *PrefabLibrary::find(int id) const
+{
+    auto it = m_prefabs.constFind(id);
+    return it != m_prefabs.constEnd() ? &it.value() : nullptr;
+}
+
+QList<Prefab> PrefabLibrary::prefabs() const
+{
+    QList<Prefab> result = m_prefabs.values();
+    std::sort(result.begin(), result.end(), [](const Prefab &a, const Prefab &b) { return a.id < b.id; });
+    return result;
+}
+
+void PrefabLibrary::merge(const PrefabLibrary &other)
+{
+    for (const Prefab &prefab : other.m_prefabs) {
+        if (!m_prefabs.contains(prefab.id)) {
+            m_prefabs.insert(prefab.id, prefab);
+            m_nextId = std::max(m_nextId, prefab.id + 1);
+        }
+    }
+}
+
+int PrefabLibrary::resolve(std::vector<Entity> *entities) const
+{
+    if (m_prefabs.isEmpty()) {
+        return 0;
+    }
+    int touched = 0;
+    for (Entity &entity : *entities) {
+        if (entity.isPrefabInstance()) {
+            if (const Prefab *prefab = find(entity.prefabId())) {
+                entity.applyPrefab(*prefab);
+                ++touched;
+            }
+        }
+    }
+    return touched;
+}
+
+int PrefabLibrary::resolve(std::vector<Entity> *entities, int prefabId) const
+{
+    const Prefab *prefab = find(prefabId);
+    if (!prefab) {
+        return 0;
+    }
+    int touched = 0;
+    for (Entity &entity : *entities) {
+        if (entity.prefabId() == prefabId) {
+            entity.applyPrefab(*prefab);
+            ++touched;
+        }
+    }
+    return touched;
+}
+
+QJsonArray PrefabLibrary::toJson() const
+{
+    QJsonArray array;
+    for (const Prefab &prefab : prefabs()) {
+        NamePool &pool = NamePool::instance();
+        QJsonObject json;
+        json["id"] = prefab.id;
+        json[NamePool::isPattern(prefab.nameRef) ? "name_pattern" : "name"] = pool.text(prefab.nameRef);
+        json["width"] = prefab.size.width();
+        json["height"] = prefab.size.height();
+        json["color_r"] = prefab.color.red();
+        json["color_g"] = prefab.color.green();
+        json["color_b"] = prefab.color.blue();
+        array.append(json);
+    }
+    return array;
+}
+
+PrefabLibrary PrefabLibrary::fromJson(const QJsonArray &array)
+{
+    NamePool &pool = NamePool::instance();
+    PrefabLibrary library;
+    for (const QJsonValue &value : array) {
+        QJsonObject json = value.toObject();
+        Prefab prefab;
+        prefab.id = json["id"].toInt(-1);
+        if (prefab.id < 0) {
+            continue;
+        }
+        if (json.contains("name_pattern")) {
+            prefab.nameRef = pool.internPattern(json["name_pattern"].toString());
+        } else {
+            prefab.nameRef = pool.intern(json["name"].toString());
+        }
+        prefab.size = QSize(json["width"].toInt(), json["height"].toInt());
+        prefab.color = QColor(json["color_r"].toInt(), json["color_g"].toInt(), json["color_b"].toInt());
+        library.m_prefabs.insert(prefab.id, prefab);
+        library.m_nextId = std::max(library.m_nextId, prefab.id + 1);
+    }
+    return library;
+}
@@ -0,0 +1,36 @@
+#include "RemoveEntitiesCommand.h"
+#include "Canvas.h"
+
+RemoveEntitiesCommand::RemoveEntitiesCommand(Canvas *canvas, const QSet<int> &entityIds, const QString &text,
+                                             QUndoCommand *parent)
+    : EditorCommand(parent)
+    , m_canvas(canvas)
+    , m_entityIds(entityIds)
+{
+    setText(text);
+}
+
+void RemoveEntitiesCommand::redo()
+{
+    if (!m_canvas) return;
+    
+    // By id: only what is resident is taken (world chunks may be unloaded)
+    const ComponentStore &components = m_canvas->components();
+    m_components.clear();
+    for (int id : m_entityIds) {
+        if (components.hasAny(id)) {
+            m_components.insert(id, components.valuesOf(id));
+        }
+    }
+    m_removed = m_canvas->takeEntities(m_entityIds);
+}
+
+void RemoveEntitiesCommand::undo()
+{
+    if (!m_canvas || m_removed.empty()) return;
+    
+    m_canvas->restoreEntities(m_removed, m_components);
+    m_removed.clear();
+    m_components.clear();
+    m_canvas->selectEntityIds(m_entityIds);
+}
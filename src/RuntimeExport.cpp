@@ -0,0 +1,151 @@
+#include "RuntimeExport.h"
+#include "RuntimeScene.h"
+#include <QHash>
+#include <QSaveFile>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+quint32 alignUp(qsizetype offset)
+{
+    return static_cast<quint32>((offset + RuntimeExport::ALIGNMENT - 1) & ~qsizetype(RuntimeExport::ALIGNMENT - 1));
+}
+
+} // namespace
+
+QByteArray RuntimeExport::build(const std::vector<Entity> &entities)
+{
+    // Name table: one UTF-8 string per distinct name, in first-use order
+    QHash<QString, quint32> nameIndex;
+    std::vector<quint32> entityNames;
+    QByteArray strings;
+    std::vector<quint32> nameOffsets{0};
+    entityNames.reserve(entities.size());
+    for (const Entity &entity : entities) {
+        QString name = entity.name();
+        if (name.isEmpty()) {
+            entityNames.push_back(RuntimeScene::NO_NAME);
+            continue;
+        }
+        auto it = nameIndex.constFind(name);
+        if (it == nameIndex.constEnd()) {
+            it = nameIndex.insert(name, static_cast<quint32>(nameOffsets.size() - 1));
+            strings += name.toUtf8();
+            strings += '\0';
+            nameOffsets.push_back(static_cast<quint32>(strings.size()));
+        }
+        entityNames.push_back(it.value());
+    }
+    
+    quint32 entityCount = static_cast<quint32>(entities.size());
+    quint32 nameCount = static_cast<quint32>(nameOffsets.size() - 1);
+    quint32 entitiesAt = alignUp(RuntimeScene::HEADER_SIZE);
+    quint32 offsetsAt = alignUp(entitiesAt + qsizetype(entityCount) * RuntimeScene::ENTITY_SIZE);
+    quint32 stringsAt = alignUp(offsetsAt + qsizetype(nameOffsets.size()) * 4);
+    quint32 totalSize = alignUp(stringsAt + strings.size());
+    
+    // Zero-filled, so padding and alignment gaps are deterministic
+    QByteArray blob(totalSize, '\0');
+    uchar *data = reinterpret_cast<uchar *>(blob.data());
+    
+    qToLittleEndian<quint32>(RuntimeScene::MAGIC, data + RuntimeScene::H_MAGIC);
+    qToLittleEndian<quint16>(RuntimeScene::VERSION, data + RuntimeScene::H_VERSION);
+    qToLittleEndian<quint16>(RuntimeScene::ENTITY_SIZE, data + RuntimeScene::H_ENTITY_SIZE);
+    qToLittleEndian<quint32>(entityCount, data + RuntimeScene::H_ENTITY_COUNT);
+    qToLittleEndian<quint32>(entitiesAt, data + RuntimeScene::H_ENTITIES);
+    qToLittleEndian<quint32>(nameCount, data + RuntimeScene::H_NAME_COUNT);
+    qToLittleEndian<quint32>(offsetsAt, data + RuntimeScene::H_NAME_OFFSETS);
+    qToLittleEndian<quint32>(stringsAt, data + RuntimeScene::H_STRINGS);
+    qToLittleEndian<quint32>(totalSize, data + RuntimeScene::H_TOTAL_SIZE);
+    
+    for (quint32 i = 0; i < entityCount; ++i) {
+        writeEntity(entities[i], entityNames[i], data + entitiesAt + qsizetype(i) * RuntimeScene::ENTITY_SIZE);
+    }
+    
+    for (size_t i = 0; i < nameOffsets.size(); ++i) {
+        qToLittleEndian<quint32>(nameOffsets[i], data + offsetsAt + qsizetype(i) * 4);
+    }
+    memcpy(data + stringsAt, strings.constData(), strings.size());
+    return blob;
+}
+
+void RuntimeExport::writeEntity(const Entity &entity, quint32 nameField, uchar *record)
+{
+    qToLittleEndian<qint32>(entity.id(), record + RuntimeScene::E_ID);
+    qToLittleEndian<qint32>(entity.position().x(), record + RuntimeScene::E_X);
+    qToLittleEndian<qint32>(entity.position().y(), record + RuntimeScene::E_Y);
+    qToLittleEndian<qint32>(entity.rect().width(), record + RuntimeScene::E_WIDTH);
+    qToLittleEndian<qint32>(entity.rect().height(), record + RuntimeScene::E_HEIGHT);
+    qToLittleEndian<quint32>(entity.color().rgba(), record + RuntimeScene::E_COLOR);
+    qToLittleEndian<quint32>(nameField, record + RuntimeScene::E_NAME);
+    qToLittleEndian<qint32>(entity.prefabId(), record + RuntimeScene::E_PREFAB);
+    qToLittleEndian<qint32>(entity.layerId(), record + RuntimeScene::E_LAYER);
+    qToLittleEndian<qint32>(entity.groupId(), record + RuntimeScene::E_GROUP);
+    record[RuntimeScene::E_OVERRIDES] = entity.overrides();
+    record[RuntimeScene::E_OVERRIDES + 1] = 0;  // Padding
+    record[RuntimeScene::E_OVERRIDES + 2] = 0;
+    record[RuntimeScene::E_OVERRIDES + 3] = 0;
+}
+
+bool RuntimeExport::verify(const QByteArray &blob, const std::vector<Entity> &entities, QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+    
+    RuntimeScene scene;
+    if (!scene.open(blob.constData(), static_cast<size_t>(blob.size()))) {
+        return fail("blob header or name table is malformed");
+    }
+    if (scene.entityCount() != entities.size()) {
+        return fail(QString("blob holds %1 entities instead of %2").arg(scene.entityCount()).arg(entities.size()));
+    }
+    
+    for (quint32 i = 0; i < scene.entityCount(); ++i) {
+        const Entity &entity = entities[i];
+        RuntimeScene::EntityView view = scene.entity(i);
+        std::string_view name = view.name();
+        
+        const char *field = nullptr;
+        if (view.id() != entity.id()) {
+            field = "id";
+        } else if (QString::fromUtf8(name.data(), static_cast<qsizetype>(name.size())) != entity.name()) {
+            field = "name";
+        } else if (QPoint(view.x(), view.y()) != entity.position()) {
+            field = "position";
+        } else if (QRect(view.x(), view.y(), view.width(), view.height()) != entity.rect()) {
+            field = "size";
+        } else if (view.color() != entity.color().rgba()) {
+            field = "color";
+        } else if (view.prefabId() != entity.prefabId()) {
+            field = "prefab";
+        } else if (view.overrides() != entity.overrides()) {
+            field = "overrides";
+        } else if (view.layerId() != entity.layerId()) {
+            field = "layer";
+        } else if (view.groupId() != entity.groupId()) {
+            field = "group";
+        }
+        if (field) {
+            return fail(QString("entity %1 (id %2): %3 does not round-trip").arg(i).arg(entity.id()).arg(field));
+        }
+    }
+    return true;
+}
+
+bool RuntimeExport::save(const QString &filePath, const std::vector<Entity> &entities, QString *error)
+{
+    QByteArray blob = build(entities);
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(blob) != blob.size() || !file.commit()) {
+        if (error) {
+            *error = "cannot write " + filePath;
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,197 @@
+#include "SceneCodec.h"
+#include <QBuffer>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+const char MAGIC[4] = { 'Q', 'L', 'E', 'Z' };
+const int HEADER_SIZE = 8;        // Magic, version, 3 reserved bytes
+const int BLOCK_HEADER_SIZE = 4;  // Packed size (big-endian)
+
+bool readExactly(QIODevice *device, char *data, qint64 size)
+{
+    qint64 done = 0;
+    while (done < size) {
+        qint64 n = device->read(data + done, size - done);
+        if (n <= 0) {
+            if (n < 0 || !device->waitForReadyRead(-1)) {
+                return false;
+            }
+            continue;
+        }
+        done += n;
+    }
+    return true;
+}
+
+} // namespace
+
+SceneCodec::Writer::Writer(QIODevice *device, int level)
+    : m_device(device)
+    , m_level(level)
+    , m_headerWritten(false)
+    , m_ok(device != nullptr)
+{
+    m_buffer.reserve(BLOCK_SIZE);
+    open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+}
+
+qint64 SceneCodec::Writer::writeData(const char *data, qint64 size)
+{
+    qint64 written = 0;
+    while (m_ok && written < size) {
+        qsizetype n = qMin<qint64>(size - written, BLOCK_SIZE - m_buffer.size());
+        m_buffer.append(data + written, n);
+        written += n;
+        if (m_buffer.size() == BLOCK_SIZE) {
+            m_ok = writeBlock();
+        }
+    }
+    return m_ok ? written : -1;
+}
+
+bool SceneCodec::Writer::writeBlock()
+{
+    if (!m_headerWritten) {
+        char header[HEADER_SIZE] = { MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3], FORMAT_VERSION, 0, 0, 0 };
+        if (m_device->write(header, HEADER_SIZE) != HEADER_SIZE) {
+            return false;
+        }
+        m_headerWritten = true;
+    }
+    if (m_buffer.isEmpty()) {
+        return true;
+    }
+    
+    // qCompress() output already carries the raw size, so the frame only needs the packed size
+    QByteArray packed = qCompress(m_buffer, m_level);
+    m_buffer.clear();
+    
+    char frame[BLOCK_HEADER_SIZE];
+    qToBigEndian<quint32>(static_cast<quint32>(packed.size()), frame);
+    return m_device->write(frame, BLOCK_HEADER_SIZE) == BLOCK_HEADER_SIZE &&
+           m_device->write(packed) == packed.size();
+}
+
+bool SceneCodec::Writer::finish()
+{
+    if (!m_ok || !writeBlock()) {
+        m_ok = false;
+        return false;
+    }
+    
+    char terminator[BLOCK_HEADER_SIZE] = { 0, 0, 0, 0 };
+    m_ok = m_device->write(terminator, BLOCK_HEADER_SIZE) == BLOCK_HEADER_SIZE;
+    return m_ok;
+}
+
+bool SceneCodec::isCompressed(const QByteArray &head)
+{
+    return head.size() >= 4 && std::memcmp(head.constData(), MAGIC, 4) == 0;
+}
+
+SceneCodec::Reader::Reader(QIODevice *device)
+    : m_device(device)
+    , m_blockPos(0)
+    , m_started(false)
+    , m_compressed(false)
+    , m_finished(false)
+{
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+qint64 SceneCodec::Reader::readData(char *data, qint64 maxSize)
+{
+    if (!m_started) {
+        m_started = true;
+        m_compressed = isCompressed(m_device->peek(4));
+        if (m_compressed) {
+            char header[HEADER_SIZE];
+            if (!readExactly(m_device, header, HEADER_SIZE) || header[4] != FORMAT_VERSION) {
+                return -1;
+            }
+        }
+    }
+    if (!m_compressed) {
+        return m_device->read(data, maxSize);
+    }
+    
+    // Hand out the current block, inflating the next one once it is used up
+    while (m_blockPos == m_block.size()) {
+        if (m_finished) {
+            return 0;
+        }
+        if (!readBlock()) {
+            return -1;
+        }
+    }
+    qint64 n = qMin<qint64>(maxSize, m_block.size() - m_blockPos);
+    std::memcpy(data, m_block.constData() + m_blockPos, n);
+    m_blockPos += n;
+    return n;
+}
+
+bool SceneCodec::Reader::readBlock()
+{
+    m_block.clear();
+    m_blockPos = 0;
+    
+    char frame[BLOCK_HEADER_SIZE];
+    if (!readExactly(m_device, frame, BLOCK_HEADER_SIZE)) {
+        return false;  // Truncated: no terminator
+    }
+    quint32 packedSize = qFromBigEndian<quint32>(frame);
+    if (packedSize == 0) {
+        m_finished = true;
+        return true;
+    }
+    if (packedSize < 4 || packedSize > quint32(BLOCK_SIZE) * 2) {
+        return false;
+    }
+    
+    QByteArray packed(packedSize, Qt::Uninitialized);
+    if (!readExactly(m_device, packed.data(), packedSize)) {
+        return false;
+    }
+    // Refuse blocks claiming more than BLOCK_SIZE before inflating them
+    if (qFromBigEndian<quint32>(packed.constData()) > quint32(BLOCK_SIZE)) {
+        return false;
+    }
+    m_block = qUncompress(packed);
+    return !m_block.isEmpty();
+}
+
+QByteArray SceneCodec::compress(const QByteArray &data, int level)
+{
+    QByteArray result;
+    QBuffer buffer(&result);
+    buffer.open(QIODevice::WriteOnly);
+    
+    Writer writer(&buffer, level);
+    if (writer.write(data) != data.size() || !writer.finish()) {
+        return QByteArray();
+    }
+    return result;
+}
+
+bool SceneCodec::decompress(const QByteArray &data, QByteArray *out)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    
+    Reader reader(&buffer);
+    out->clear();
+    char chunk[64 * 1024];
+    for (;;) {
+        qint64 n = reader.read(chunk, sizeof(chunk));
+        if (n < 0) {
+            return false;
+        }
+        if (n == 0) {
+            return true;
+        }
+        out->append(chunk, n);
+    }
+}
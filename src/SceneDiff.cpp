@@ -0,0 +1,343 @@
+#include "SceneDiff.h"
+#include <QHash>
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+
+// The Entity fields (components live in the scene's store)
+constexpr quint8 ALL_FIELDS = SceneDiff::Name | SceneDiff::Position | SceneDiff::Size | SceneDiff::Color |
+                              SceneDiff::Layer | SceneDiff::Group | SceneDiff::Prefab;
+
+QHash<int, int> indexById(const std::vector<Entity> &entities)
+{
+    QHash<int, int> index;
+    index.reserve(static_cast<int>(entities.size()));
+    for (int i = 0; i < static_cast<int>(entities.size()); ++i) {
+        index.insert(entities[i].id(), i);
+    }
+    return index;
+}
+
+// Copy the given fields of `source` into `target`
+void takeFields(const Entity &source, quint8 fields, Entity *target)
+{
+    if (!fields) {
+        return;
+    }
+    quint8 overrides = target->overrides();
+    if (fields & SceneDiff::Name) {
+        target->setNameRef(source.nameRef());
+    }
+    if (fields & SceneDiff::Position) {
+        target->setPosition(source.position());
+    }
+    if (fields & SceneDiff::Size) {
+        target->setSize(source.rect().width(), source.rect().height());
+    }
+    if (fields & SceneDiff::Color) {
+        target->setColor(source.color());
+    }
+    if (fields & SceneDiff::Layer) {
+        target->setLayerId(source.layerId());
+    }
+    if (fields & SceneDiff::Group) {
+        target->setGroupId(source.groupId());
+    }
+    
+    // The setters mark prefab overrides; each field keeps the override
+    // state of the side its value came from
+    quint8 taken = 0;
+    if (fields & SceneDiff::Name) {
+        taken |= Entity::OverrideName;
+    }
+    if (fields & SceneDiff::Size) {
+        taken |= Entity::OverrideSize;
+    }
+    if (fields & SceneDiff::Color) {
+        taken |= Entity::OverrideColor;
+    }
+    if (fields & SceneDiff::Prefab) {
+        target->setPrefab(source.prefabId(), source.overrides());
+    } else {
+        target->setPrefab(target->prefabId(), (overrides & ~taken) | (source.overrides() & taken));
+    }
+}
+
+bool samePrefab(const Prefab &a, const Prefab &b)
+{
+    return a.nameRef == b.nameRef && a.color == b.color && a.size == b.size;
+}
+
+// Ours' layers plus those only theirs has, on top. Theirs' layers get new
+// ids in the merged stack; the returned map takes theirs' ids to them.
+QHash<int, int> mergeLayers(const LayerStack &base, const LayerStack &ours, const LayerStack &theirs,
+                            LayerStack *merged)
+{
+    QHash<int, int> ids;
+    *merged = ours;
+    for (const Layer &layer : theirs.layers()) {
+        if (base.contains(layer.id)) {
+            continue;  // Shared, or removed by ours
+        }
+        const Layer *mine = ours.find(layer.id);
+        if (mine && mine->name == layer.name) {
+            continue;  // Both added the same layer
+        }
+        int id = merged->add(layer.name);
+        merged->setVisible(id, layer.visible);
+        merged->setLocked(id, layer.locked);
+        ids.insert(layer.id, id);
+    }
+    return ids;
+}
+
+// Ours' prefabs plus those only theirs has. A prefab only theirs edited
+// takes theirs' definition; one both sides added under the same id is
+// renumbered on theirs' side (the returned map).
+QHash<int, int> mergePrefabs(const PrefabLibrary &base, const PrefabLibrary &ours, const PrefabLibrary &theirs,
+                             PrefabLibrary *merged)
+{
+    QHash<int, int> ids;
+    *merged = ours;
+    QList<Prefab> colliding;
+    for (const Prefab &prefab : theirs.prefabs()) {
+        const Prefab *mine = ours.find(prefab.id);
+        const Prefab *original = base.find(prefab.id);
+        if (!mine) {
+            merged->insert(prefab);  // Added by theirs, or removed by ours but still used there
+        } else if (original) {
+            if (samePrefab(*mine, *original) && !samePrefab(prefab, *original)) {
+                merged->insert(prefab);
+            }
+        } else if (!samePrefab(*mine, prefab)) {
+            colliding.push_back(prefab);
+        }
+    }
+    
+    // After the inserts, so the new ids can't be taken by one of theirs
+    for (const Prefab &prefab : colliding) {
+        ids.insert(prefab.id, merged->add(prefab));
+    }
+    return ids;
+}
+
+} // namespace
+
+QString SceneDiff::Result::summary() const
+{
+    return QString("%1 added, %2 removed, %3 changed").arg(added.size()).arg(removed.size()).arg(changed.size());
+}
+
+quint8 SceneDiff::changedFields(const Entity &a, const Entity &b, const ComponentStore *aComponents,
+                                const ComponentStore *bComponents)
+{
+    quint8 fields = 0;
+    if (a.nameRef() != b.nameRef() && a.name() != b.name()) {
+        fields |= Name;
+    }
+    if (a.position() != b.position()) {
+        fields |= Position;
+    }
+    if (a.rect().size() != b.rect().size()) {
+        fields |= Size;
+    }
+    if (a.color() != b.color()) {
+        fields |= Color;
+    }
+    if (a.layerId() != b.layerId()) {
+        fields |= Layer;
+    }
+    if (a.groupId() != b.groupId()) {
+        fields |= Group;
+    }
+    if (a.prefabId() != b.prefabId()) {
+        fields |= Prefab;
+    }
+    if (aComponents && bComponents && componentsDiffer(*aComponents, a.id(), *bComponents, b.id())) {
+        fields |= Components;
+    }
+    return fields;
+}
+
+bool SceneDiff::componentsDiffer(const ComponentStore &a, int aId, const ComponentStore &b, int bId)
+{
+    // Type ids are per store, so what is compared is the by-name form
+    bool aHas = a.hasAny(aId);
+    bool bHas = b.hasAny(bId);
+    if (!aHas && !bHas) {
+        return false;
+    }
+    return aHas != bHas || a.valuesToJson(aId) != b.valuesToJson(bId);
+}
+
+QString SceneDiff::fieldNames(quint8 fields)
+{
+    static const std::pair<Field, const char *> names[] = {
+        {Name, "name"}, {Position, "position"}, {Size, "size"}, {Color, "color"},
+        {Layer, "layer"}, {Group, "group"}, {Prefab, "prefab"}, {Components, "components"}};
+    QStringList list;
+    for (const auto &name : names) {
+        if (fields & name.first) {
+            list << name.second;
+        }
+    }
+    return list.join(", ");
+}
+
+SceneDiff::Result SceneDiff::diff(const std::vector<Entity> &base, const std::vector<Entity> &other,
+                                  const ComponentStore *baseComponents, const ComponentStore *otherComponents)
+{
+    Result result;
+    QHash<int, int> baseIndex = indexById(base);
+    QHash<int, int> otherIndex = indexById(other);
+    
+    for (const Entity &entity : other) {
+        auto it = baseIndex.constFind(entity.id());
+        if (it == baseIndex.constEnd()) {
+            result.added.push_back(entity.id());
+        } else if (quint8 fields = changedFields(base[it.value()], entity, baseComponents, otherComponents)) {
+            result.changed.push_back({entity.id(), fields});
+        }
+    }
+    for (const Entity &entity : base) {
+        if (!otherIndex.contains(entity.id())) {
+            result.removed.push_back(entity.id());
+        }
+    }
+    return result;
+}
+
+SceneDiff::MergeResult SceneDiff::merge(const SceneData &base, const SceneData &ours, const SceneData &theirs)
+{
+    MergeResult result;
+    SceneData &merged = result.scene;
+    merged.tiles = ours.tiles;
+    merged.groups = ours.groups;
+    
+    // Ours' component values, with types only theirs has defined too
+    // (matched by name); values are then taken per entity like any field
+    merged.components = ours.components;
+    for (const ComponentType &type : theirs.components.registry().types()) {
+        if (merged.components.registry().idOf(type.name) == 0) {
+            merged.components.registry().add(type.name, type.fields);
+        }
+    }
+    auto takeComponents = [&merged, &theirs](int theirsId, int mergedId) {
+        merged.components.setValuesJson(mergedId, theirs.components.valuesToJson(theirsId));
+    };
+    
+    // Theirs' entities are read through the layer and prefab renumbering
+    QHash<int, int> layerIds = mergeLayers(base.layers, ours.layers, theirs.layers, &merged.layers);
+    QHash<int, int> prefabIds = mergePrefabs(base.prefabs, ours.prefabs, theirs.prefabs, &merged.prefabs);
+    auto remapped = [&layerIds, &prefabIds](const Entity &entity) {
+        Entity copy = entity;
+        copy.setLayerId(layerIds.value(entity.layerId(), entity.layerId()));
+        if (entity.isPrefabInstance()) {
+            copy.setPrefab(prefabIds.value(entity.prefabId(), entity.prefabId()), entity.overrides());
+        }
+        return copy;
+    };
+    
+    QHash<int, int> baseIndex = indexById(base.entities);
+    QHash<int, int> oursIndex = indexById(ours.entities);
+    QHash<int, int> theirsIndex = indexById(theirs.entities);
+    
+    // Renumbered entities get ids above everything either side used
+    int nextId = std::max(ours.nextEntityId, theirs.nextEntityId);
+    for (const Entity &entity : ours.entities) {
+        nextId = std::max(nextId, entity.id() + 1);
+    }
+    for (const Entity &entity : theirs.entities) {
+        nextId = std::max(nextId, entity.id() + 1);
+    }
+    
+    merged.entities.reserve(ours.entities.size() + theirs.entities.size() / 8);
+    
+    // Ours, in ours' order
+    for (const Entity &mine : ours.entities) {
+        auto baseIt = baseIndex.constFind(mine.id());
+        if (baseIt == baseIndex.constEnd()) {
+            merged.entities.push_back(mine);  // Added by ours
+            continue;
+        }
+        const Entity &original = base.entities[baseIt.value()];
+        quint8 oursFields = changedFields(original, mine, &base.components, &ours.components);
+        
+        auto theirsIt = theirsIndex.constFind(mine.id());
+        if (theirsIt == theirsIndex.constEnd()) {
+            // Removed by theirs: stays removed unless ours edited it
+            if (!oursFields) {
+                merged.components.removeEntity(mine.id());
+            } else {
+                merged.entities.push_back(mine);
+                result.conflicts.push_back({Conflict::ChangedRemoved, mine.id(), oursFields,
+                                            QString("Entity %1: %2 edited here but removed in theirs (kept)")
+                                                .arg(mine.id()).arg(fieldNames(oursFields))});
+            }
+            continue;
+        }
+        
+        const Entity yours = remapped(theirs.entities[theirsIt.value()]);
+        quint8 theirsFields = changedFields(original, theirs.entities[theirsIt.value()], &base.components,
+                                            &theirs.components);
+        Entity entity = mine;
+        takeFields(yours, theirsFields & ~oursFields, &entity);
+        if (theirsFields & ~oursFields & Components) {
+            takeComponents(yours.id(), entity.id());
+        }
+        merged.entities.push_back(entity);
+        
+        quint8 conflicting = oursFields & theirsFields & changedFields(mine, yours, &ours.components, &theirs.components);
+        if (conflicting) {
+            result.conflicts.push_back({Conflict::BothChanged, mine.id(), conflicting,
+                                        QString("Entity %1: %2 edited on both sides (kept ours)")
+                                            .arg(mine.id()).arg(fieldNames(conflicting))});
+        }
+    }
+    
+    // Then what only theirs has, in theirs' order
+    for (const Entity &raw : theirs.entities) {
+        const Entity yours = remapped(raw);
+        auto oursIt = oursIndex.constFind(yours.id());
+        bool inBase = baseIndex.contains(yours.id());
+        if (oursIt != oursIndex.constEnd()) {
+            // Both added an entity under this id: keep theirs too, renumbered
+            if (!inBase && changedFields(ours.entities[oursIt.value()], yours, &ours.components, &theirs.components)) {
+                Entity entity(nextId++, yours.nameRef(), yours.position());
+                takeFields(yours, ALL_FIELDS, &entity);
+                takeComponents(yours.id(), entity.id());
+                merged.entities.push_back(entity);
+                ++result.renumbered;
+            }
+            continue;
+        }
+        if (inBase) {
+            // Removed by ours: stays removed unless theirs edited it
+            quint8 theirsFields = changedFields(base.entities[baseIndex.value(yours.id())], raw, &base.components,
+                                                &theirs.components);
+            if (theirsFields) {
+                merged.entities.push_back(yours);
+                takeComponents(yours.id(), yours.id());
+                result.conflicts.push_back({Conflict::RemovedChanged, yours.id(), theirsFields,
+                                            QString("Entity %1: removed here but %2 edited in theirs (kept theirs)")
+                                                .arg(yours.id()).arg(fieldNames(theirsFields))});
+            }
+            continue;
+        }
+        merged.entities.push_back(yours);  // Added by theirs
+        takeComponents(yours.id(), yours.id());
+    }
+    merged.nextEntityId = nextId;
+    
+    // Groups are ours; members of groups only theirs has become ungrouped
+    for (Entity &entity : merged.entities) {
+        if (entity.groupId() != GroupTree::NO_GROUP && !merged.groups.contains(entity.groupId())) {
+            entity.setGroupId(GroupTree::NO_GROUP);
+        }
+    }
+    
+    // Instances follow the merged prefab definitions
+    merged.prefabs.resolve(&merged.entities);
+    return result;
+}
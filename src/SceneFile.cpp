@@ -0,0 +1,580 @@
+#include "SceneFile.h"
+#include <QBuffer>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QFile>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+#include <deque>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+const qsizetype WRITE_CHUNK_SIZE = 64 * 1024;  // Bytes buffered before each device write
+const qsizetype READ_CHUNK_SIZE = 64 * 1024;
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+QByteArray compactJson(const QJsonArray &array)
+{
+    return QJsonDocument(array).toJson(QJsonDocument::Compact);
+}
+
+QByteArray compactJson(const QJsonObject &object)
+{
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+// Everything in the root object except the names and the entities
+void readHeader(const QJsonObject &root, SceneData *scene)
+{
+    // Restore next entity ID if present
+    if (root.contains("next_entity_id")) {
+        scene->nextEntityId = root["next_entity_id"].toInt();
+    } else {
+        scene->nextEntityId = 1;
+    }
+    scene->journalSeq = static_cast<qint64>(root["journal_seq"].toDouble());
+    scene->prefabs = PrefabLibrary::fromJson(root["prefabs"].toArray());
+    scene->tiles = root.contains("tiles") ? TileLayer::fromJson(root["tiles"].toObject()) : TileLayer();
+    scene->layers = LayerStack::fromJson(root["layers"].toArray());
+    scene->groups = GroupTree::fromJson(root["groups"].toArray());
+    scene->components = ComponentStore::fromJson(root["components"].toObject());
+}
+
+struct BatchResult {
+    bool ok = false;
+    std::vector<Entity> entities;
+};
+
+// Convert one batch (a JSON array of entity objects)
+BatchResult convertBatch(const QByteArray &text, const NameTable &names)
+{
+    BatchResult result;
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(text, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isArray()) {
+        return result;
+    }
+    QJsonArray array = doc.array();
+    result.entities.reserve(array.size());
+    for (const QJsonValue &value : array) {
+        if (value.isObject()) {
+            result.entities.push_back(Entity::fromJson(value.toObject(), &names));
+        }
+    }
+    result.ok = true;
+    return result;
+}
+
+// Incremental reader for the scene format. Splits the root object into its
+// members as bytes arrive: elements of "entities" are gathered into batches
+// that are converted (on a thread pool unless threadCount is 1) as soon as
+// the name table is known, every other member is kept as text and parsed once
+// the document ends. Files written before the table was moved to the front
+// hold their batches back until it turns up.
+class SceneParser
+{
+public:
+    explicit SceneParser(int threadCount);
+
+    bool feed(const char *data, qsizetype size);
+    bool finish(SceneData *scene);
+
+private:
+    enum class State {
+        BeforeRoot,
+        BeforeKey,
+        InKey,
+        BeforeColon,
+        BeforeValue,
+        InValue,      // A root member other than "entities"
+        AfterValue,
+        BeforeEntity,
+        InEntity,     // An element of "entities"
+        AfterEntity,
+        Done
+    };
+    enum class Scan {
+        More,      // Value continues
+        Complete,  // Value ends with this character
+        Ended      // Value ended before this character
+    };
+
+    Scan scan(char c);
+    void startValue();
+    bool endValue();
+    bool endEntity();
+    bool flushBatch();
+    bool convert(QByteArray batch);
+    bool convertHeldBatches();
+    bool collect(BatchResult result);
+
+    State m_state = State::BeforeRoot;
+    QByteArray m_key;
+    QByteArray m_value;
+    int m_depth = 0;
+    bool m_inString = false;
+    bool m_escape = false;
+    int m_members = 0;          // Root members seen
+    int m_elements = 0;         // Elements of "entities" seen
+
+    QByteArray m_header;        // Root members other than names and entities, as an object
+    NameTable m_names;
+    bool m_hasNames = false;
+    QByteArray m_batch;         // Entities being gathered, as a JSON array without its ']'
+    std::vector<QByteArray> m_heldBatches;  // Waiting for the name table
+
+    QThreadPool m_localPool;
+    QThreadPool *m_pool = nullptr;  // Null: convert on the calling thread
+    std::deque<QFuture<BatchResult>> m_pending;
+    std::vector<Entity> m_entities;
+};
+
+SceneParser::SceneParser(int threadCount)
+{
+    if (threadCount == 0) {
+        m_pool = QThreadPool::globalInstance();
+    } else if (threadCount > 1) {
+        m_localPool.setMaxThreadCount(threadCount);
+        m_pool = &m_localPool;
+    }
+}
+
+SceneParser::Scan SceneParser::scan(char c)
+{
+    if (m_inString) {
+        if (m_escape) {
+            m_escape = false;
+        } else if (c == '\\') {
+            m_escape = true;
+        } else if (c == '"') {
+            m_inString = false;
+            return m_depth == 0 ? Scan::Complete : Scan::More;
+        }
+        return Scan::More;
+    }
+    
+    switch (c) {
+    case '"':
+        m_inString = true;
+        return Scan::More;
+    case '{':
+    case '[':
+        ++m_depth;
+        return Scan::More;
+    case '}':
+    case ']':
+        if (m_depth == 0) {
+            return Scan::Ended;  // Scalar closed by its container
+        }
+        return --m_depth == 0 ? Scan::Complete : Scan::More;
+    case ',':
+        return m_depth == 0 ? Scan::Ended : Scan::More;
+    default:
+        return Scan::More;
+    }
+}
+
+void SceneParser::startValue()
+{
+    m_depth = 0;
+    m_inString = false;
+    m_escape = false;
+}
+
+bool SceneParser::feed(const char *data, qsizetype size)
+{
+    for (qsizetype i = 0; i < size; ++i) {
+        char c = data[i];
+        switch (m_state) {
+        case State::BeforeRoot:
+            if (c == '{') {
+                m_state = State::BeforeKey;
+            } else if (!isSpace(c)) {
+                return false;
+            }
+            break;
+        case State::BeforeKey:
+            if (c == '"') {
+                m_key.clear();
+                m_state = State::InKey;
+            } else if (c == '}' && m_members == 0) {
+                m_state = State::Done;
+            } else if (!isSpace(c)) {
+                return false;
+            }
+            break;
+        case State::InKey:
+            // Keys are kept escaped; they are only compared and copied
+            if (m_escape) {
+                m_escape = false;
+            } else if (c == '\\') {
+                m_escape = true;
+            } else if (c == '"') {
+                m_state = State::BeforeColon;
+                break;
+            }
+            m_key.append(c);
+            break;
+        case State::BeforeColon:
+            if (c == ':') {
+                m_state = State::BeforeValue;
+            } else if (!isSpace(c)) {
+                return false;
+            }
+            break;
+        case State::BeforeValue:
+            if (isSpace(c)) {
+                break;
+            }
+            ++m_members;
+            if (c == '[' && m_key == "entities") {
+                m_state = State::BeforeEntity;
+                break;
+            }
+            m_value.clear();
+            startValue();
+            m_state = State::InValue;
+            --i;  // Scan this character as part of the value
+            break;
+        case State::AfterValue:
+            if (c == ',') {
+                m_state = State::BeforeKey;
+            } else if (c == '}') {
+                m_state = State::Done;
+            } else if (!isSpace(c)) {
+                return false;
+            }
+            break;
+        case State::BeforeEntity:
+            if (c == ']' && m_elements == 0) {
+                m_state = State::AfterValue;
+            } else if (!isSpace(c)) {
+                m_batch.append(m_batch.isEmpty() ? '[' : ',');
+                startValue();
+                m_state = State::InEntity;
+                --i;
+            }
+            break;
+        case State::AfterEntity:
+            if (c == ',') {
+                m_state = State::BeforeEntity;
+            } else if (c == ']') {
+                m_state = State::AfterValue;
+            } else if (!isSpace(c)) {
+                return false;
+            }
+            break;
+        case State::InValue:
+        case State::InEntity: {
+            // Copy the value in one piece per chunk rather than per character
+            QByteArray *target = m_state == State::InValue ? &m_value : &m_batch;
+            qsizetype start = i;
+            Scan result = Scan::More;
+            for (; i < size; ++i) {
+                result = scan(data[i]);
+                if (result != Scan::More) {
+                    break;
+                }
+            }
+            if (result == Scan::More) {
+                target->append(data + start, size - start);
+                return true;
+            }
+            if (result == Scan::Complete) {
+                target->append(data + start, i + 1 - start);
+            } else {
+                target->append(data + start, i - start);
+                --i;  // The terminator belongs to the container
+            }
+            if (!(m_state == State::InValue ? endValue() : endEntity())) {
+                return false;
+            }
+            break;
+        }
+        case State::Done:
+            if (!isSpace(c)) {
+                return false;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+bool SceneParser::endValue()
+{
+    QByteArray value = m_value.trimmed();
+    m_value.clear();
+    m_state = State::AfterValue;
+    if (value.isEmpty()) {
+        return false;
+    }
+    
+    if (m_key == "names") {
+        QJsonParseError error;
+        QJsonDocument doc = QJsonDocument::fromJson("{\"names\":" + value + "}", &error);
+        if (error.error != QJsonParseError::NoError) {
+            return false;
+        }
+        m_names = NameTable::fromJson(doc.object()["names"].toArray());
+        m_hasNames = true;
+        return convertHeldBatches();
+    }
+    
+    m_header.append(m_header.isEmpty() ? '{' : ',');
+    m_header.append('"').append(m_key).append("\":").append(value);
+    return true;
+}
+
+bool SceneParser::endEntity()
+{
+    ++m_elements;
+    m_state = State::AfterEntity;
+    return m_batch.size() < SceneFile::LOAD_BATCH_SIZE || flushBatch();
+}
+
+bool SceneParser::flushBatch()
+{
+    if (m_batch.isEmpty()) {
+        return true;
+    }
+    m_batch.append(']');
+    QByteArray batch = std::exchange(m_batch, QByteArray());
+    if (!m_hasNames) {
+        m_heldBatches.push_back(std::move(batch));
+        return true;
+    }
+    return convert(std::move(batch));
+}
+
+bool SceneParser::convert(QByteArray batch)
+{
+    if (!m_pool) {
+        return collect(convertBatch(batch, m_names));
+    }
+    
+    // Each task gets its own copy of the name table since it caches lookups.
+    // Bound the JSON queued behind busy workers.
+    m_pending.push_back(QtConcurrent::run(m_pool, convertBatch, std::move(batch), m_names));
+    while (m_pending.size() > static_cast<size_t>(qMax(1, m_pool->maxThreadCount()) * 2)) {
+        BatchResult result = m_pending.front().takeResult();
+        m_pending.pop_front();
+        if (!collect(std::move(result))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SceneParser::convertHeldBatches()
+{
+    for (QByteArray &batch : m_heldBatches) {
+        if (!convert(std::move(batch))) {
+            return false;
+        }
+    }
+    m_heldBatches.clear();
+    return true;
+}
+
+bool SceneParser::collect(BatchResult result)
+{
+    if (!result.ok) {
+        return false;
+    }
+    if (m_entities.empty()) {
+        m_entities = std::move(result.entities);
+    } else {
+        std::move(result.entities.begin(), result.entities.end(), std::back_inserter(m_entities));
+    }
+    return true;
+}
+
+bool SceneParser::finish(SceneData *scene)
+{
+    if (m_state != State::Done || !flushBatch()) {
+        return false;
+    }
+    // Files without a name table (before version 1.1) inline their names
+    m_hasNames = true;
+    if (!convertHeldBatches()) {
+        return false;
+    }
+    
+    // Merge in file order
+    while (!m_pending.empty()) {
+        BatchResult result = m_pending.front().takeResult();
+        m_pending.pop_front();
+        if (!collect(std::move(result))) {
+            return false;
+        }
+    }
+    
+    QJsonParseError error;
+    QJsonDocument headerDoc = QJsonDocument::fromJson(m_header.isEmpty() ? QByteArray("{}") : m_header + '}', &error);
+    if (error.error != QJsonParseError::NoError) {
+        return false;
+    }
+    
+    SceneData result;
+    readHeader(headerDoc.object(), &result);
+    result.entities = std::move(m_entities);
+    
+    // Fill in what prefab instances don't override
+    result.prefabs.resolve(&result.entities);
+    
+    *scene = std::move(result);
+    return true;
+}
+
+} // namespace
+
+bool SceneFile::write(QIODevice *device, const SceneParts &scene, QJsonDocument::JsonFormat format)
+{
+    const std::vector<Entity> &entities = *scene.entities;
+    // Indented files put each root member and each entity on its own line
+    const bool indented = format == QJsonDocument::Indented;
+    QByteArray out;
+    out.reserve(WRITE_CHUNK_SIZE + 4096);
+    auto member = [&out, indented](const char *key, const QByteArray &value) {
+        if (out.isEmpty()) {
+            out.append(indented ? "{\n    " : "{");
+        } else {
+            out.append(indented ? ",\n    " : ",");
+        }
+        out.append('"').append(key).append(indented ? "\": " : "\":").append(value);
+    };
+    auto flush = [&out, device]() {
+        bool ok = device->write(out) == out.size();
+        out.resize(0);  // Keeps the capacity
+        return ok;
+    };
+    
+    member("version", "\"1.1\"");
+    member("next_entity_id", QByteArray::number(scene.nextEntityId));
+    if (scene.journalSeq > 0) {
+        member("journal_seq", QByteArray::number(scene.journalSeq));
+    }
+    
+    // Names go into a shared table written once, ahead of the entities so a
+    // reader can convert entities as they arrive
+    NameTable names;
+    for (const Entity &entity : entities) {
+        entity.registerName(&names);
+    }
+    member("names", compactJson(names.toJson()));
+    if (scene.prefabs && !scene.prefabs->isEmpty()) {
+        member("prefabs", compactJson(scene.prefabs->toJson()));
+    }
+    if (scene.tiles && !scene.tiles->isEmpty()) {
+        member("tiles", compactJson(scene.tiles->toJson()));
+    }
+    if (scene.layers && !scene.layers->isDefault()) {
+        member("layers", compactJson(scene.layers->toJson()));
+    }
+    if (scene.groups && !scene.groups->isEmpty()) {
+        member("groups", compactJson(scene.groups->toJson()));
+    }
+    if (scene.components && !scene.components->isEmpty()) {
+        member("components", compactJson(scene.components->toJson()));
+    }
+    
+    member("entities", "[");
+    for (size_t i = 0; i < entities.size(); ++i) {
+        if (i > 0) {
+            out.append(',');
+        }
+        if (indented) {
+            out.append("\n        ");
+        }
+        out.append(compactJson(entities[i].toJson(&names)));
+        if (out.size() >= WRITE_CHUNK_SIZE && !flush()) {
+            return false;
+        }
+    }
+    out.append(indented ? (entities.empty() ? "]\n}\n" : "\n    ]\n}\n") : "]}");
+    return flush();
+}
+
+bool SceneFile::read(QIODevice *device, SceneData *scene, int threadCount)
+{
+    // Decompresses block by block if the data is compressed
+    SceneCodec::Reader reader(device);
+    SceneParser parser(threadCount);
+    QByteArray chunk(READ_CHUNK_SIZE, Qt::Uninitialized);
+    for (;;) {
+        qint64 n = reader.read(chunk.data(), chunk.size());
+        if (n < 0) {
+            return false;
+        }
+        if (n == 0) {
+            return parser.finish(scene);
+        }
+        if (!parser.feed(chunk.constData(), n)) {
+            return false;
+        }
+    }
+}
+
+QByteArray SceneFile::toJson(const SceneParts &scene, QJsonDocument::JsonFormat format)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    write(&buffer, scene, format);
+    return data;
+}
+
+bool SceneFile::fromJson(const QByteArray &data, SceneData *scene, int threadCount)
+{
+    SceneParser parser(threadCount);
+    return parser.feed(data.constData(), data.size()) && parser.finish(scene);
+}
+
+bool SceneFile::save(const QString &filePath, const SceneParts &scene, SceneCodec::Compression compression)
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    
+    bool ok;
+    if (compression == SceneCodec::Compression::None) {
+        ok = write(&file, scene, QJsonDocument::Indented);
+    } else {
+        // Indentation is pure overhead once compressed
+        SceneCodec::Writer writer(&file);
+        ok = write(&writer, scene, QJsonDocument::Compact) && writer.finish();
+    }
+    if (!ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool SceneFile::load(const QString &filePath, SceneData *scene, int threadCount)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    return read(&file, scene, threadCount);
+}
+
+SceneCodec::Compression SceneFile::compressionOf(const QString &filePath)
+{
+    QFile file(filePath);
+    if (file.open(QIODevice::ReadOnly) && SceneCodec::isCompressed(file.peek(4))) {
+        return SceneCodec::Compression::Zlib;
+    }
+    return SceneCodec::Compression::None;
+}
@@ -0,0 +1,492 @@
+#include "SceneJournal.h"
+#include "SceneFile.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace {
+
+bool writeFileAtomically(const QString &path, const QByteArray &data)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(data);
+    return file.commit();
+}
+
+void indexEntities(const SceneData &scene, QHash<int, int> *indexById)
+{
+    indexById->clear();
+    indexById->reserve(static_cast<int>(scene.entities.size()));
+    for (int i = 0; i < static_cast<int>(scene.entities.size()); ++i) {
+        indexById->insert(scene.entities[i].id(), i);
+    }
+}
+
+// Apply one journal record to a scene. Changed entities are updated in place;
+// new entities are placed right after the entity that preceded them ("after")
+// when the record was written, so draw order survives a replay.
+void applyRecord(const QJsonObject &record, SceneData *scene, QHash<int, int> *indexById)
+{
+    NameTable names = NameTable::fromJson(record["names"].toArray());
+    if (record.contains("prefabs")) {
+        scene->prefabs = PrefabLibrary::fromJson(record["prefabs"].toArray());
+    }
+    if (record.contains("tiles")) {
+        scene->tiles.applyChunksJson(record["tiles"].toArray());
+    }
+    if (record.contains("layers")) {
+        scene->layers = LayerStack::fromJson(record["layers"].toArray());
+    }
+    if (record.contains("groups")) {
+        scene->groups = GroupTree::fromJson(record["groups"].toArray());
+    }
+    
+    // Upserted entities get exactly the components listed for them
+    bool hasComponents = record.contains("component_types");
+    if (hasComponents) {
+        scene->components.registry() = ComponentRegistry::fromJson(record["component_types"].toArray());
+    }
+    QJsonObject componentValues = record["components"].toObject();
+    if (record.contains("next_entity_id")) {
+        scene->nextEntityId = record["next_entity_id"].toInt();
+    }
+    
+    QSet<int> removed;
+    for (const QJsonValue &value : record["remove"].toArray()) {
+        removed.insert(value.toInt());
+        scene->components.removeEntity(value.toInt());
+    }
+    
+    QHash<int, std::vector<Entity>> addedAfter;  // anchor id -> new entities in order
+    bool structureChanged = false;
+    for (const QJsonValue &value : record["upsert"].toArray()) {
+        QJsonObject json = value.toObject();
+        Entity entity = Entity::fromJson(json, &names);
+        if (hasComponents) {
+            scene->components.setValuesJson(entity.id(), componentValues[QString::number(entity.id())].toObject());
+        }
+        auto it = indexById->constFind(entity.id());
+        if (it != indexById->constEnd()) {
+            scene->entities[it.value()] = entity;
+        } else {
+            addedAfter[json["after"].toInt(-1)].push_back(entity);
+            structureChanged = true;
+        }
+    }
+    
+    for (int id : removed) {
+        if (indexById->contains(id)) {
+            structureChanged = true;
+            break;
+        }
+    }
+    if (!structureChanged) {
+        return;
+    }
+    
+    // Rebuild the order: survivors, each followed by the entities added after it.
+    // Added entities can anchor on each other, so walk them depth-first.
+    std::vector<Entity> result;
+    result.reserve(scene->entities.size());
+    auto emitWithFollowers = [&](const Entity &first) {
+        std::vector<Entity> stack{first};
+        while (!stack.empty()) {
+            Entity entity = stack.back();
+            stack.pop_back();
+            result.push_back(entity);
+            auto it = addedAfter.find(entity.id());
+            if (it != addedAfter.end()) {
+                std::vector<Entity> followers = std::move(it.value());
+                addedAfter.erase(it);
+                stack.insert(stack.end(), followers.rbegin(), followers.rend());
+            }
+        }
+    };
+    
+    std::vector<Entity> front = addedAfter.take(-1);
+    for (const Entity &entity : front) {
+        emitWithFollowers(entity);
+    }
+    for (const Entity &entity : scene->entities) {
+        if (!removed.contains(entity.id())) {
+            emitWithFollowers(entity);
+        }
+    }
+    // Anchors that no longer exist: keep the entities, at the end
+    for (auto it = addedAfter.begin(); it != addedAfter.end(); ++it) {
+        result.insert(result.end(), it.value().begin(), it.value().end());
+    }
+    
+    scene->entities = std::move(result);
+    indexEntities(*scene, indexById);
+}
+
+// Apply the records in `data` that are newer than the scene's base file.
+// Stops at the first torn or corrupt line and returns the bytes before it;
+// `lastSeq` is raised to the newest applied sequence, `records` counts the
+// intact lines.
+qsizetype applyJournal(const QByteArray &data, SceneData *scene, qint64 *lastSeq, int *records)
+{
+    QHash<int, int> indexById;
+    indexEntities(*scene, &indexById);
+    bool replayed = false;
+    
+    qsizetype validBytes = 0;
+    while (validBytes < data.size()) {
+        qsizetype end = data.indexOf('\n', validBytes);
+        if (end < 0) {
+            break;  // Torn record without its newline
+        }
+        QJsonParseError error;
+        QJsonDocument doc = QJsonDocument::fromJson(data.mid(validBytes, end - validBytes), &error);
+        if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+            break;
+        }
+        validBytes = end + 1;
+        (*records)++;
+        
+        QJsonObject record = doc.object();
+        qint64 seq = static_cast<qint64>(record["seq"].toDouble());
+        if (seq <= scene->journalSeq) {
+            continue;  // Already part of the base file
+        }
+        applyRecord(record, scene, &indexById);
+        *lastSeq = qMax(*lastSeq, seq);
+        replayed = true;
+    }
+    
+    // Replayed instances (and any prefab edits) need their prefab fields
+    if (replayed) {
+        scene->prefabs.resolve(&scene->entities);
+    }
+    return validBytes;
+}
+
+} // namespace
+
+SceneJournal::SceneJournal(QObject *parent)
+    : QObject(parent)
+    , m_seq(0)
+    , m_records(0)
+    , m_journalBytes(0)
+    , m_baseBytes(0)
+    , m_compression(SceneCodec::Compression::None)
+    , m_prefabsChanged(false)
+    , m_prefabs(nullptr)
+    , m_tiles(nullptr)
+    , m_layersChanged(false)
+    , m_layers(nullptr)
+    , m_groupsChanged(false)
+    , m_groups(nullptr)
+    , m_componentTypesChanged(false)
+    , m_components(nullptr)
+    , m_compactionWatcher(new QFutureWatcher<bool>(this))
+    , m_compactingSeq(-1)
+{
+    connect(m_compactionWatcher, &QFutureWatcher<bool>::finished,
+            this, &SceneJournal::onCompactionFinished);
+}
+
+SceneJournal::~SceneJournal()
+{
+    waitForCompaction();
+}
+
+QString SceneJournal::journalPathFor(const QString &scenePath)
+{
+    return scenePath + ".journal";
+}
+
+bool SceneJournal::discard(const QString &scenePath)
+{
+    QString path = journalPathFor(scenePath);
+    return !QFile::exists(path) || QFile::remove(path);
+}
+
+void SceneJournal::markChanged(int entityId)
+{
+    m_removedIds.remove(entityId);
+    m_changedIds.insert(entityId);
+}
+
+void SceneJournal::markRemoved(int entityId)
+{
+    m_changedIds.remove(entityId);
+    m_removedIds.insert(entityId);
+}
+
+void SceneJournal::clearPending()
+{
+    m_changedIds.clear();
+    m_removedIds.clear();
+    m_prefabsChanged = false;
+    m_changedTileChunks.clear();
+    m_layersChanged = false;
+    m_groupsChanged = false;
+    m_componentTypesChanged = false;
+}
+
+bool SceneJournal::isAttachedTo(const QString &scenePath) const
+{
+    return !m_scenePath.isEmpty() && m_scenePath == scenePath;
+}
+
+void SceneJournal::detach()
+{
+    waitForCompaction();
+    m_scenePath.clear();
+    m_seq = 0;
+    m_records = 0;
+    m_journalBytes = 0;
+    m_baseBytes = 0;
+}
+
+bool SceneJournal::checkpoint(const QString &scenePath, const std::vector<Entity> &entities, int nextEntityId,
+                              SceneCodec::Compression compression)
+{
+    waitForCompaction();
+    if (!isAttachedTo(scenePath)) {
+        m_seq = 0;
+    }
+    
+    // Base first: if we crash before the journal is truncated, the old
+    // records are all <= journal_seq and get skipped on load
+    SceneParts scene(entities, nextEntityId, m_seq);
+    scene.prefabs = m_prefabs;
+    scene.tiles = m_tiles;
+    scene.layers = m_layers;
+    scene.groups = m_groups;
+    scene.components = m_components;
+    if (!SceneFile::save(scenePath, scene, compression)) {
+        return false;
+    }
+    m_scenePath = scenePath;
+    m_compression = compression;
+    if (!writeFileAtomically(journalPathFor(scenePath), QByteArray())) {
+        return false;
+    }
+    
+    m_records = 0;
+    m_journalBytes = 0;
+    m_baseBytes = QFileInfo(scenePath).size();
+    clearPending();
+    return true;
+}
+
+bool SceneJournal::appendChanges(const std::vector<Entity> &entities, int nextEntityId)
+{
+    if (m_scenePath.isEmpty()) {
+        return false;
+    }
+    if (!hasPendingChanges()) {
+        return true;  // Nothing to write
+    }
+    
+    // Collect changed entities with the id of their predecessor for ordering
+    NameTable names;
+    QJsonArray upserts;
+    if (!m_changedIds.isEmpty()) {
+        int previousId = -1;
+        for (const Entity &entity : entities) {
+            if (m_changedIds.contains(entity.id())) {
+                QJsonObject json = entity.toJson(&names);
+                json["after"] = previousId;
+                upserts.append(json);
+            }
+            previousId = entity.id();
+        }
+    }
+    
+    QJsonArray removals;
+    for (int id : m_removedIds) {
+        removals.append(id);
+    }
+    
+    QJsonObject record;
+    record["seq"] = m_seq + 1;
+    record["next_entity_id"] = nextEntityId;
+    record["names"] = names.toJson();
+    if (m_prefabs && !m_prefabs->isEmpty()) {
+        record["prefabs"] = m_prefabs->toJson();  // Small: one entry per unique prefab
+    }
+    if (m_tiles && !m_changedTileChunks.isEmpty()) {
+        record["tiles"] = m_tiles->chunksToJson(m_changedTileChunks);
+    }
+    if (m_layers && (m_layersChanged || !m_layers->isDefault())) {
+        record["layers"] = m_layers->toJson();  // Whole stack: a handful of entries
+    }
+    if (m_groups && (m_groupsChanged || !m_groups->isEmpty())) {
+        record["groups"] = m_groups->toJson();
+    }
+    if (m_components && (m_componentTypesChanged || !m_components->registry().isEmpty())) {
+        record["component_types"] = m_components->registry().toJson();
+        QJsonObject values;
+        for (int id : m_changedIds) {
+            QJsonObject entityValues = m_components->valuesToJson(id);
+            if (!entityValues.isEmpty()) {
+                values[QString::number(id)] = entityValues;
+            }
+        }
+        record["components"] = values;
+    }
+    record["upsert"] = upserts;
+    record["remove"] = removals;
+    
+    // One line per record; the newline marks the record as complete
+    QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    
+    QFile file(journalPathFor(m_scenePath));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return false;
+    }
+    if (file.write(line) != line.size() || !file.flush()) {
+        return false;
+    }
+    file.close();
+    
+    m_seq++;
+    m_records++;
+    m_journalBytes += line.size();
+    clearPending();
+    
+    compactIfNeeded(entities, nextEntityId);
+    return true;
+}
+
+bool SceneJournal::replay(const QString &scenePath, SceneData *scene)
+{
+    detach();
+    m_seq = scene->journalSeq;
+    m_baseBytes = QFileInfo(scenePath).size();
+    m_compression = SceneFile::compressionOf(scenePath);  // Compaction keeps the base's format
+    
+    QFile file(journalPathFor(scenePath));
+    if (file.exists()) {
+        if (!file.open(QIODevice::ReadWrite)) {
+            return false;
+        }
+        QByteArray data = file.readAll();
+        qsizetype validBytes = applyJournal(data, scene, &m_seq, &m_records);
+        
+        // Trim a torn tail so later appends start on a clean line
+        if (validBytes < data.size()) {
+            file.resize(validBytes);
+        }
+        m_journalBytes = validBytes;
+    }
+    
+    m_scenePath = scenePath;
+    clearPending();
+    return true;
+}
+
+bool SceneJournal::replayReadOnly(const QString &scenePath, SceneData *scene)
+{
+    QFile file(journalPathFor(scenePath));
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    
+    qint64 seq = scene->journalSeq;
+    int records = 0;
+    applyJournal(file.readAll(), scene, &seq, &records);
+    scene->journalSeq = seq;
+    return true;
+}
+
+void SceneJournal::compactIfNeeded(const std::vector<Entity> &entities, int nextEntityId)
+{
+    if (m_scenePath.isEmpty() || m_compactingSeq >= 0) {
+        return;
+    }
+    qint64 byteBudget = qMax(MIN_COMPACT_BYTES, m_baseBytes / 4);
+    if (m_records < MAX_RECORDS && m_journalBytes < byteBudget) {
+        return;
+    }
+    
+    // Snapshot on this thread; the worker never touches live editor state
+    QString path = m_scenePath;
+    SceneCodec::Compression compression = m_compression;
+    SceneData snapshot;
+    snapshot.entities = entities;
+    snapshot.nextEntityId = nextEntityId;
+    snapshot.journalSeq = m_seq;
+    snapshot.prefabs = m_prefabs ? *m_prefabs : PrefabLibrary();
+    snapshot.tiles = m_tiles ? *m_tiles : TileLayer();
+    snapshot.layers = m_layers ? *m_layers : LayerStack();
+    snapshot.groups = m_groups ? *m_groups : GroupTree();
+    snapshot.components = m_components ? *m_components : ComponentStore();
+    m_compactingPath = path;
+    m_compactingSeq = m_seq;
+    
+    m_compactionWatcher->setFuture(QtConcurrent::run([path, snapshot = std::move(snapshot), compression]() {
+        return SceneFile::save(path, snapshot, compression);
+    }));
+}
+
+void SceneJournal::waitForCompaction()
+{
+    if (m_compactingSeq < 0) {
+        return;
+    }
+    m_compactionWatcher->waitForFinished();
+    finishCompaction();
+}
+
+void SceneJournal::onCompactionFinished()
+{
+    finishCompaction();
+}
+
+void SceneJournal::finishCompaction()
+{
+    if (m_compactingSeq < 0) {
+        return;  // Already handled by waitForCompaction()
+    }
+    qint64 compactedSeq = m_compactingSeq;
+    QString path = m_compactingPath;
+    m_compactingSeq = -1;
+    m_compactingPath.clear();
+    
+    bool success = m_compactionWatcher->result();
+    if (success) {
+        // Keep only records written after the snapshot was taken
+        QString journalPath = journalPathFor(path);
+        QFile file(journalPath);
+        QByteArray kept;
+        int keptRecords = 0;
+        if (file.open(QIODevice::ReadOnly)) {
+            QByteArray data = file.readAll();
+            file.close();
+            for (const QByteArray &line : data.split('\n')) {
+                QJsonDocument doc = QJsonDocument::fromJson(line);
+                if (doc.isObject() && static_cast<qint64>(doc.object()["seq"].toDouble()) > compactedSeq) {
+                    kept.append(line);
+                    kept.append('\n');
+                    keptRecords++;
+                }
+            }
+        }
+        success = writeFileAtomically(journalPath, kept);
+        
+        if (success && isAttachedTo(path)) {
+            m_records = keptRecords;
+            m_journalBytes = kept.size();
+            m_baseBytes = QFileInfo(path).size();
+        }
+    }
+    
+    emit compactionFinished(success);
+}
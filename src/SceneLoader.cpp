@@ -0,0 +1,137 @@
+#include "SceneLoader.h"
+#include "Canvas.h"
+#include "SceneJournal.h"
+#include <QElapsedTimer>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <numeric>
+
+SceneLoader::SceneLoader(Canvas *canvas, QObject *parent)
+    : QObject(parent)
+    , m_canvas(canvas)
+    , m_state(Idle)
+    , m_generation(0)
+    , m_parseGeneration(0)
+    , m_parseWatcher(new QFutureWatcher<ParseResult>(this))
+    , m_next(0)
+{
+    m_batchTimer.setSingleShot(true);
+    m_batchTimer.setInterval(0);
+    connect(&m_batchTimer, &QTimer::timeout, this, &SceneLoader::streamNextBatch);
+    connect(m_parseWatcher, &QFutureWatcher<ParseResult>::finished,
+            this, &SceneLoader::onParseFinished);
+}
+
+void SceneLoader::load(const QString &filePath)
+{
+    cancel();
+    
+    m_filePath = filePath;
+    m_state = Parsing;
+    m_parseGeneration = ++m_generation;
+    emit started();
+    emit progressChanged(0, 0);
+    
+    // Parse (itself parallel for large files), apply the journal and report
+    // what the file got wrong, all off the GUI thread. The replay on attach
+    // then skips the records already applied here.
+    m_parseWatcher->setFuture(QtConcurrent::run([filePath]() {
+        ParseResult result;
+        auto scene = std::make_shared<SceneData>();
+        if (!SceneFile::load(filePath, scene.get()) || !SceneJournal::replayReadOnly(filePath, scene.get())) {
+            return result;
+        }
+        result.validation = SceneValidator::validate(*scene, 0, SceneValidator::EDITOR_BUDGET_MS);
+        result.scene = scene;
+        return result;
+    }));
+}
+
+void SceneLoader::cancel()
+{
+    if (m_state == Idle) {
+        return;
+    }
+    
+    // A running parse can't be interrupted; its result is dropped when it arrives
+    ++m_generation;
+    m_batchTimer.stop();
+    if (m_state == Streaming) {
+        m_canvas->cancelStreaming();
+    }
+    m_state = Idle;
+    m_scene.reset();
+    m_order.clear();
+    emit canceled();
+}
+
+void SceneLoader::onParseFinished()
+{
+    if (m_state != Parsing || m_parseGeneration != m_generation) {
+        return;  // Cancelled or superseded
+    }
+    
+    ParseResult result = m_parseWatcher->result();
+    m_scene = std::move(result.scene);
+    if (!m_scene || !m_canvas->attachLoadedScene(m_filePath, m_scene.get())) {
+        m_state = Idle;
+        m_scene.reset();
+        emit finished(false);
+        return;
+    }
+    
+    // The file's issues don't stop it from loading
+    m_validation = std::move(result.validation);
+    
+    // Entities in (or near) the view go first, the rest in file order
+    QRect view = m_canvas->visibleSceneRect();
+    QRect nearView = view.adjusted(-view.width() / 2, -view.height() / 2,
+                                   view.width() / 2, view.height() / 2);
+    const std::vector<Entity> &entities = m_scene->entities;
+    m_order.resize(entities.size());
+    std::iota(m_order.begin(), m_order.end(), 0);
+    std::stable_partition(m_order.begin(), m_order.end(), [&entities, &nearView](int index) {
+        return entities[index].rect().intersects(nearView);
+    });
+    m_next = 0;
+    
+    m_state = Streaming;
+    m_canvas->beginStreaming(*m_scene);
+    streamNextBatch();
+}
+
+void SceneLoader::streamNextBatch()
+{
+    if (m_state != Streaming) {
+        return;
+    }
+    
+    // Hand over batches until this slice's time budget is used up
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<Entity> batch;
+    batch.reserve(BATCH_SIZE);
+    while (m_next < m_order.size() && timer.elapsed() < BATCH_BUDGET_MS) {
+        batch.clear();
+        size_t end = std::min(m_next + BATCH_SIZE, m_order.size());
+        for (; m_next < end; ++m_next) {
+            batch.push_back(m_scene->entities[m_order[m_next]]);
+        }
+        m_canvas->appendEntities(batch);
+    }
+    
+    int total = static_cast<int>(m_order.size());
+    emit progressChanged(static_cast<int>(m_next), total);
+    
+    if (m_next < m_order.size()) {
+        m_batchTimer.start();  // Let the event loop run (paint, input) first
+        return;
+    }
+    
+    // Done: switch to the file's draw order
+    m_canvas->endStreaming(std::move(m_scene->entities));
+    m_scene.reset();
+    m_order.clear();
+    m_state = Idle;
+    emit finished(true);
+}
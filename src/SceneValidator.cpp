@@ -0,0 +1,157 @@
+#include "SceneValidator.h"
+#include "SceneFile.h"
+#include <QDeadlineTimer>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+// Result of checking one contiguous chunk of entities
+struct ChunkResult {
+    std::vector<ValidationIssue> issues;
+    std::vector<std::pair<int, int>> ids;  // (id, entity index), sorted
+    bool timedOut = false;
+};
+
+void checkEntity(const Entity &entity, std::vector<ValidationIssue> *issues)
+{
+    int id = entity.id();
+    if (id <= 0) {
+        issues->push_back({ ValidationIssue::InvalidId, id,
+                            QString("Entity %1: id must be positive").arg(id) });
+    }
+    QRect rect = entity.rect();
+    if (rect.width() <= 0 || rect.height() <= 0) {
+        issues->push_back({ ValidationIssue::NonPositiveSize, id,
+                            QString("Entity %1: size %2x%3 is not positive")
+                                .arg(id).arg(rect.width()).arg(rect.height()) });
+    }
+    // QColor refuses components outside 0-255 and stays invalid
+    if (!entity.color().isValid()) {
+        issues->push_back({ ValidationIssue::InvalidColor, id,
+                            QString("Entity %1: color component out of range 0-255").arg(id) });
+    }
+}
+
+} // namespace
+
+SceneValidator::Report SceneValidator::validate(const std::vector<Entity> &entities, int nextEntityId,
+                                                int threadCount, int budgetMs)
+{
+    QDeadlineTimer deadline = budgetMs > 0 ? QDeadlineTimer(budgetMs) : QDeadlineTimer(QDeadlineTimer::Forever);
+    
+    using Range = std::pair<size_t, size_t>;
+    std::function<ChunkResult(const Range &)> checkRange = [&entities, deadline](const Range &range) {
+        ChunkResult result;
+        result.ids.reserve(range.second - range.first);
+        for (size_t i = range.first; i < range.second; ++i) {
+            if ((i - range.first) % DEADLINE_STRIDE == 0 && deadline.hasExpired()) {
+                result.timedOut = true;
+                break;
+            }
+            checkEntity(entities[i], &result.issues);
+            result.ids.emplace_back(entities[i].id(), static_cast<int>(i));
+        }
+        std::sort(result.ids.begin(), result.ids.end());
+        return result;
+    };
+    
+    std::vector<ChunkResult> chunks;
+    if (threadCount == 1 || entities.size() < static_cast<size_t>(PARALLEL_THRESHOLD)) {
+        chunks.push_back(checkRange(Range(0, entities.size())));
+    } else {
+        QThreadPool localPool;
+        QThreadPool *pool = QThreadPool::globalInstance();
+        if (threadCount > 0) {
+            localPool.setMaxThreadCount(threadCount);
+            pool = &localPool;
+        }
+        size_t rangeCount = static_cast<size_t>(qMax(1, pool->maxThreadCount()));
+        size_t rangeSize = (entities.size() + rangeCount - 1) / rangeCount;
+        std::vector<Range> ranges;
+        for (size_t first = 0; first < entities.size(); first += rangeSize) {
+            ranges.emplace_back(first, std::min(first + rangeSize, entities.size()));
+        }
+        chunks = QtConcurrent::blockingMapped<std::vector<ChunkResult>>(pool, ranges, checkRange);
+    }
+    
+    // Merge the sorted id runs; equal neighbours are duplicates
+    std::vector<std::pair<int, int>> ids;
+    ids.reserve(entities.size());
+    std::vector<size_t> runEnds;
+    for (ChunkResult &chunk : chunks) {
+        ids.insert(ids.end(), chunk.ids.begin(), chunk.ids.end());
+        runEnds.push_back(ids.size());
+        chunk.ids.clear();
+        chunk.ids.shrink_to_fit();
+    }
+    for (size_t width = 1; width < runEnds.size(); width *= 2) {
+        for (size_t run = 0; run + width < runEnds.size(); run += 2 * width) {
+            size_t begin = run == 0 ? 0 : runEnds[run - 1];
+            size_t middle = runEnds[run + width - 1];
+            size_t end = runEnds[std::min(run + 2 * width, runEnds.size()) - 1];
+            std::inplace_merge(ids.begin() + begin, ids.begin() + middle, ids.begin() + end);
+        }
+    }
+    
+    Report report;
+    report.entityCount = static_cast<int>(entities.size());
+    bool timedOut = false;
+    for (ChunkResult &chunk : chunks) {
+        std::move(chunk.issues.begin(), chunk.issues.end(), std::back_inserter(report.issues));
+        timedOut = timedOut || chunk.timedOut;
+    }
+    
+    // What was checked still stands: duplicates among the checked ids are real
+    // and their largest id is a lower bound for next_entity_id
+    if (timedOut) {
+        report.issues.push_back({ ValidationIssue::TimedOut, -1,
+                                  QString("Time budget used up after %1 of %2 entities")
+                                      .arg(ids.size()).arg(entities.size()) });
+    }
+    
+    for (size_t i = 1; i < ids.size(); ++i) {
+        if (ids[i].first == ids[i - 1].first) {
+            report.issues.push_back({ ValidationIssue::DuplicateId, ids[i].first,
+                                      QString("Entity %1: id also used by the entity at index %2")
+                                          .arg(ids[i].first).arg(ids[i - 1].second) });
+        }
+    }
+    
+    if (!ids.empty() && nextEntityId <= ids.back().first) {
+        report.issues.push_back({ ValidationIssue::NextIdTooSmall, ids.back().first,
+                                  QString("next_entity_id %1 is not above the largest id %2")
+                                      .arg(nextEntityId).arg(ids.back().first) });
+    }
+    
+    // Stable order regardless of how the work was split
+    std::stable_sort(report.issues.begin(), report.issues.end(),
+                     [](const ValidationIssue &a, const ValidationIssue &b) { return a.entityId < b.entityId; });
+    return report;
+}
+
+SceneValidator::Report SceneValidator::validate(const SceneData &scene, int threadCount, int budgetMs)
+{
+    return validate(scene.entities, scene.nextEntityId, threadCount, budgetMs);
+}
+
+QString SceneValidator::Report::summary(int maxIssues) const
+{
+    if (issues.empty()) {
+        return QString("No issues in %1 entities").arg(entityCount);
+    }
+    
+    QStringList lines;
+    lines << QString("%1 issue(s) in %2 entities:").arg(issues.size()).arg(entityCount);
+    for (int i = 0; i < static_cast<int>(issues.size()) && i < maxIssues; ++i) {
+        lines << issues[i].message;
+    }
+    if (static_cast<int>(issues.size()) > maxIssues) {
+        lines << QString("... and %1 more").arg(static_cast<int>(issues.size()) - maxIssues);
+    }
+    return lines.join('\n');
+}
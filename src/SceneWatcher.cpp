@@ -0,0 +1,137 @@
+#include "SceneWatcher.h"
+#include "SceneJournal.h"
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QtConcurrent/QtConcurrentRun>
+
+SceneWatcher::SceneWatcher(QObject *parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_generation(0)
+    , m_parseGeneration(0)
+    , m_parsing(false)
+    , m_changedWhileParsing(false)
+    , m_parseWatcher(new QFutureWatcher<std::shared_ptr<SceneData>>(this))
+{
+    m_settleTimer.setSingleShot(true);
+    m_settleTimer.setInterval(SETTLE_MS);
+    connect(&m_settleTimer, &QTimer::timeout, this, &SceneWatcher::onSettled);
+    
+    // The directory is watched too: a file replaced through a rename stops
+    // being watched, and its new version shows up as a directory change
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &SceneWatcher::onPathChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &SceneWatcher::onPathChanged);
+    connect(m_parseWatcher, &QFutureWatcher<std::shared_ptr<SceneData>>::finished,
+            this, &SceneWatcher::onParseFinished);
+}
+
+SceneWatcher::~SceneWatcher()
+{
+    m_parseWatcher->waitForFinished();
+}
+
+void SceneWatcher::watch(const QString &filePath)
+{
+    QString path = filePath.isEmpty() ? QString() : QFileInfo(filePath).absoluteFilePath();
+    if (path == m_filePath) {
+        return;
+    }
+    
+    if (!m_watcher->files().isEmpty()) {
+        m_watcher->removePaths(m_watcher->files());
+    }
+    if (!m_watcher->directories().isEmpty()) {
+        m_watcher->removePaths(m_watcher->directories());
+    }
+    ++m_generation;
+    m_settleTimer.stop();
+    m_changedWhileParsing = false;
+    m_scene.reset();
+    
+    m_filePath = path;
+    if (m_filePath.isEmpty()) {
+        return;
+    }
+    m_known = stampOf(m_filePath);
+    m_watcher->addPath(QFileInfo(m_filePath).absolutePath());
+    rewatch();
+}
+
+void SceneWatcher::noteOwnWrite()
+{
+    if (!m_filePath.isEmpty()) {
+        m_known = stampOf(m_filePath);
+        rewatch();
+    }
+}
+
+SceneWatcher::Stamp SceneWatcher::stampOf(const QString &filePath)
+{
+    Stamp stamp;
+    QFileInfo info(filePath);
+    if (info.exists()) {
+        stamp.modified = info.lastModified();
+        stamp.size = info.size();
+    }
+    return stamp;
+}
+
+void SceneWatcher::rewatch()
+{
+    if (!m_watcher->files().contains(m_filePath) && QFileInfo::exists(m_filePath)) {
+        m_watcher->addPath(m_filePath);
+    }
+}
+
+void SceneWatcher::onPathChanged()
+{
+    // Wait for the writer to finish
+    m_settleTimer.start();
+}
+
+void SceneWatcher::onSettled()
+{
+    rewatch();
+    
+    Stamp stamp = stampOf(m_filePath);
+    if (stamp.size < 0 || stamp == m_known) {
+        return;  // Gone (mid-replace) or not actually changed
+    }
+    if (m_parsing) {
+        m_changedWhileParsing = true;  // Picked up when the running parse ends
+        return;
+    }
+    m_known = stamp;
+    
+    m_parsing = true;
+    m_parseGeneration = m_generation;
+    QString filePath = m_filePath;
+    m_parseWatcher->setFuture(QtConcurrent::run([filePath]() {
+        // Read-only: the editor owns the journal and may be appending to it
+        auto scene = std::make_shared<SceneData>();
+        if (!SceneFile::load(filePath, scene.get()) || !SceneJournal::replayReadOnly(filePath, scene.get())) {
+            return std::shared_ptr<SceneData>();
+        }
+        return scene;
+    }));
+}
+
+void SceneWatcher::onParseFinished()
+{
+    m_parsing = false;
+    std::shared_ptr<SceneData> scene = m_parseWatcher->result();
+    
+    if (m_parseGeneration == m_generation) {
+        if (scene) {
+            m_scene = std::move(scene);
+            emit sceneChanged();
+        } else {
+            emit reloadFailed();
+        }
+    }
+    
+    if (m_changedWhileParsing) {
+        m_changedWhileParsing = false;
+        onSettled();
+    }
+}
@@ -0,0 +1,97 @@
+#include "SnapIndex.h"
+#include <algorithm>
+#include <cstdlib>
+
+void SnapIndex::build(const std::vector<Entity> &entities, int excludedId)
+{
+    clear();
+    m_xEdges.reserve(entities.size() * 3);
+    m_yEdges.reserve(entities.size() * 3);
+    
+    for (const Entity &entity : entities) {
+        if (entity.id() == excludedId) {
+            continue;
+        }
+        // Edges as the canvas draws them: right/bottom are exclusive
+        QRect r = entity.rect();
+        int left = r.x();
+        int right = r.x() + r.width();
+        int top = r.y();
+        int bottom = r.y() + r.height();
+        
+        m_xEdges.push_back({ left, top, bottom });
+        m_xEdges.push_back({ (left + right) / 2, top, bottom });
+        m_xEdges.push_back({ right, top, bottom });
+        m_yEdges.push_back({ top, left, right });
+        m_yEdges.push_back({ (top + bottom) / 2, left, right });
+        m_yEdges.push_back({ bottom, left, right });
+    }
+    
+    std::sort(m_xEdges.begin(), m_xEdges.end());
+    std::sort(m_yEdges.begin(), m_yEdges.end());
+}
+
+void SnapIndex::clear()
+{
+    m_xEdges.clear();
+    m_yEdges.clear();
+}
+
+int SnapIndex::closest(const std::vector<Edge> &edges, const int *features, int featureCount,
+                       int distance, int *offset)
+{
+    int best = -1;
+    int bestDistance = distance + 1;
+    
+    for (int f = 0; f < featureCount; ++f) {
+        int value = features[f];
+        // The nearest edge is either the first one at/after the value or the one before it
+        int next = static_cast<int>(std::lower_bound(edges.begin(), edges.end(), Edge{ value, 0, 0 }) - edges.begin());
+        for (int candidate : { next, next - 1 }) {
+            if (candidate < 0 || candidate >= static_cast<int>(edges.size())) {
+                continue;
+            }
+            int d = std::abs(edges[candidate].coord - value);
+            if (d < bestDistance) {
+                bestDistance = d;
+                best = candidate;
+                *offset = edges[candidate].coord - value;
+            }
+        }
+    }
+    return best;
+}
+
+SnapIndex::Result SnapIndex::snap(const QPoint &position, const QSize &size, int distance) const
+{
+    Result result;
+    result.position = position;
+    if (isEmpty()) {
+        return result;
+    }
+    
+    int xFeatures[3] = { position.x(), position.x() + size.width() / 2, position.x() + size.width() };
+    int yFeatures[3] = { position.y(), position.y() + size.height() / 2, position.y() + size.height() };
+    
+    int dx = 0;
+    int dy = 0;
+    int xHit = closest(m_xEdges, xFeatures, 3, distance, &dx);
+    int yHit = closest(m_yEdges, yFeatures, 3, distance, &dy);
+    result.position += QPoint(xHit >= 0 ? dx : 0, yHit >= 0 ? dy : 0);
+    
+    // Guides run from the target entity to the snapped rect
+    QRect moved(result.position, size);
+    if (xHit >= 0) {
+        const Edge &edge = m_xEdges[xHit];
+        result.snappedX = true;
+        result.guides.append(QLine(edge.coord, std::min(edge.spanStart, moved.top()),
+                                   edge.coord, std::max(edge.spanEnd, moved.top() + moved.height())));
+    }
+    if (yHit >= 0) {
+        const Edge &edge = m_yEdges[yHit];
+        result.snappedY = true;
+        result.guides.append(QLine(std::min(edge.spanStart, moved.left()), edge.coord,
+                                   std::max(edge.spanEnd, moved.left() + moved.width()), edge.coord));
+    }
+    return result;
+}
@@ -0,0 +1,26 @@
+#include "TileEditCommand.h"
+#include "Canvas.h"
+
+TileEditCommand::TileEditCommand(Canvas *canvas, std::vector<TileLayer::Change> &&changes, const QString &text,
+                                 QUndoCommand *parent)
+    : EditorCommand(parent)
+    , m_canvas(canvas)
+    , m_changes(std::move(changes))
+{
+    setText(text);
+}
+
+void TileEditCommand::redo()
+{
+    // The edit is already on the layer when first pushed; reapplying is a no-op
+    if (m_canvas) {
+        m_canvas->applyTileChanges(m_changes, false);
+    }
+}
+
+void TileEditCommand::undo()
+{
+    if (m_canvas) {
+        m_canvas->applyTileChanges(m_changes, true);
+    }
+}
@@ -0,0 +1,479 @@
+#include "TileLayer.h"
+#include <QPainter>
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+int floorDiv(int value, int divisor)
+{
+    int result = value / divisor;
+    if (value < 0 && result * divisor != value) {
+        --result;
+    }
+    return result;
+}
+
+} // namespace
+
+TileLayer::TileLayer()
+    : m_tileSize(DEFAULT_TILE_SIZE)
+    , m_palette(defaultPalette())
+{
+}
+
+void TileLayer::setTileSize(int size)
+{
+    m_tileSize = qMax(1, size);
+}
+
+QPoint TileLayer::cellAt(const QPoint &scenePos) const
+{
+    return QPoint(floorDiv(scenePos.x(), m_tileSize), floorDiv(scenePos.y(), m_tileSize));
+}
+
+QRect TileLayer::cellRect(const QPoint &cell) const
+{
+    return QRect(cell.x() * m_tileSize, cell.y() * m_tileSize, m_tileSize, m_tileSize);
+}
+
+QRect TileLayer::cellsIn(const QRect &sceneRect) const
+{
+    return QRect(cellAt(sceneRect.topLeft()), cellAt(sceneRect.bottomRight()));
+}
+
+QPoint TileLayer::chunkOf(const QPoint &cell)
+{
+    return QPoint(floorDiv(cell.x(), CHUNK_TILES), floorDiv(cell.y(), CHUNK_TILES));
+}
+
+int TileLayer::localIndex(const QPoint &cell)
+{
+    int x = cell.x() - floorDiv(cell.x(), CHUNK_TILES) * CHUNK_TILES;
+    int y = cell.y() - floorDiv(cell.y(), CHUNK_TILES) * CHUNK_TILES;
+    return y * CHUNK_TILES + x;
+}
+
+TileLayer::Chunk *TileLayer::chunkFor(const QPoint &chunk, bool create)
+{
+    auto it = m_chunks.find(chunk);
+    if (it != m_chunks.end()) {
+        return &it.value();
+    }
+    if (!create) {
+        return nullptr;
+    }
+    Chunk fresh;
+    fresh.cells.assign(CHUNK_TILES * CHUNK_TILES, 0);
+    return &m_chunks.insert(chunk, std::move(fresh)).value();
+}
+
+void TileLayer::releaseIfEmpty(const QPoint &chunk)
+{
+    auto it = m_chunks.find(chunk);
+    if (it != m_chunks.end() && it->filled == 0) {
+        m_chunks.erase(it);
+    }
+}
+
+TileLayer::TileId TileLayer::tileAt(const QPoint &cell) const
+{
+    auto it = m_chunks.constFind(chunkOf(cell));
+    if (it == m_chunks.constEnd()) {
+        return 0;
+    }
+    return it->cells[localIndex(cell)];
+}
+
+int TileLayer::setTile(const QPoint &cell, TileId id, std::vector<Change> *changes)
+{
+    QPoint chunkPos = chunkOf(cell);
+    Chunk *chunk = chunkFor(chunkPos, id != 0);
+    if (!chunk) {
+        return 0;  // Erasing a cell that was never painted
+    }
+
+    TileId &slot = chunk->cells[localIndex(cell)];
+    if (slot == id) {
+        return 0;
+    }
+    if (changes) {
+        changes->push_back({cell, slot, id});
+    }
+    chunk->filled += (slot == 0) - (id == 0);
+    slot = id;
+    chunk->imageStale = true;
+
+    releaseIfEmpty(chunkPos);
+    return 1;
+}
+
+int TileLayer::fillRect(const QRect &cells, TileId id, std::vector<Change> *changes)
+{
+    QRect area = cells.normalized();
+    if (area.isEmpty()) {
+        return 0;
+    }
+
+    // Walk chunk by chunk so each chunk is looked up once, not once per cell
+    int changed = 0;
+    QPoint firstChunk = chunkOf(area.topLeft());
+    QPoint lastChunk = chunkOf(area.bottomRight());
+    for (int cy = firstChunk.y(); cy <= lastChunk.y(); ++cy) {
+        for (int cx = firstChunk.x(); cx <= lastChunk.x(); ++cx) {
+            QPoint chunkPos(cx, cy);
+            Chunk *chunk = chunkFor(chunkPos, id != 0);
+            if (!chunk) {
+                continue;
+            }
+            QRect chunkCells(cx * CHUNK_TILES, cy * CHUNK_TILES, CHUNK_TILES, CHUNK_TILES);
+            QRect part = area.intersected(chunkCells);
+            for (int y = part.top(); y <= part.bottom(); ++y) {
+                int row = (y - chunkCells.top()) * CHUNK_TILES;
+                for (int x = part.left(); x <= part.right(); ++x) {
+                    TileId &slot = chunk->cells[row + x - chunkCells.left()];
+                    if (slot == id) {
+                        continue;
+                    }
+                    if (changes) {
+                        changes->push_back({QPoint(x, y), slot, id});
+                    }
+                    chunk->filled += (slot == 0) - (id == 0);
+                    slot = id;
+                    ++changed;
+                }
+            }
+            chunk->imageStale = true;
+            releaseIfEmpty(chunkPos);
+        }
+    }
+    return changed;
+}
+
+int TileLayer::paintLine(const QPoint &from, const QPoint &to, TileId id, std::vector<Change> *changes)
+{
+    // Bresenham, so fast strokes leave no gaps between sampled mouse positions
+    int dx = std::abs(to.x() - from.x());
+    int dy = -std::abs(to.y() - from.y());
+    int stepX = from.x() < to.x() ? 1 : -1;
+    int stepY = from.y() < to.y() ? 1 : -1;
+    int error = dx + dy;
+
+    int changed = 0;
+    QPoint cell = from;
+    while (true) {
+        changed += setTile(cell, id, changes);
+        if (cell == to) {
+            break;
+        }
+        int doubled = 2 * error;
+        if (doubled >= dy) {
+            error += dy;
+            cell.rx() += stepX;
+        }
+        if (doubled <= dx) {
+            error += dx;
+            cell.ry() += stepY;
+        }
+    }
+    return changed;
+}
+
+int TileLayer::floodFill(const QPoint &cell, TileId id, const QRect &bounds, std::vector<Change> *changes)
+{
+    QRect area = bounds.normalized();
+    TileId target = tileAt(cell);
+    if (target == id || !area.contains(cell)) {
+        return 0;
+    }
+
+    // Scanline fill: fill a whole horizontal run, then seed the rows above
+    // and below once per run of matching cells
+    int changed = 0;
+    std::vector<QPoint> seeds{cell};
+    while (!seeds.empty()) {
+        QPoint seed = seeds.back();
+        seeds.pop_back();
+        if (tileAt(seed) != target) {
+            continue;
+        }
+
+        int y = seed.y();
+        int left = seed.x();
+        int right = seed.x();
+        while (left > area.left() && tileAt(QPoint(left - 1, y)) == target) {
+            --left;
+        }
+        while (right < area.right() && tileAt(QPoint(right + 1, y)) == target) {
+            ++right;
+        }
+        changed += fillRect(QRect(QPoint(left, y), QPoint(right, y)), id, changes);
+
+        for (int ny : {y - 1, y + 1}) {
+            if (ny < area.top() || ny > area.bottom()) {
+                continue;
+            }
+            bool inRun = false;
+            for (int x = left; x <= right; ++x) {
+                bool matches = tileAt(QPoint(x, ny)) == target;
+                if (matches && !inRun) {
+                    seeds.push_back(QPoint(x, ny));
+                }
+                inRun = matches;
+            }
+        }
+    }
+    return changed;
+}
+
+void TileLayer::apply(const std::vector<Change> &changes, bool undo)
+{
+    if (undo) {
+        for (auto it = changes.rbegin(); it != changes.rend(); ++it) {
+            setTile(it->cell, it->before);
+        }
+    } else {
+        for (const Change &change : changes) {
+            setTile(change.cell, change.after);
+        }
+    }
+}
+
+void TileLayer::clear()
+{
+    m_chunks.clear();
+}
+
+qint64 TileLayer::filledCellCount() const
+{
+    qint64 count = 0;
+    for (const Chunk &chunk : m_chunks) {
+        count += chunk.filled;
+    }
+    return count;
+}
+
+void TileLayer::setPalette(const QVector<QColor> &palette)
+{
+    m_palette = palette;
+    for (Chunk &chunk : m_chunks) {
+        chunk.imageStale = true;
+    }
+}
+
+QColor TileLayer::tileColor(TileId id) const
+{
+    if (id == 0 || id > m_palette.size()) {
+        return QColor(Qt::transparent);
+    }
+    return m_palette[id - 1];
+}
+
+QVector<QColor> TileLayer::defaultPalette()
+{
+    return {
+        QColor(110, 170, 80),   // Grass
+        QColor(140, 110, 70),   // Dirt
+        QColor(70, 130, 200),   // Water
+        QColor(220, 200, 140),  // Sand
+        QColor(120, 120, 125),  // Stone
+        QColor(60, 60, 70),     // Wall
+    };
+}
+
+void TileLayer::rebuildImage(Chunk *chunk) const
+{
+    if (chunk->image.isNull()) {
+        chunk->image = QImage(CHUNK_TILES, CHUNK_TILES, QImage::Format_ARGB32_Premultiplied);
+    }
+
+    // Palette lookups resolved once per rebuild, not per cell
+    QVector<QRgb> colors(m_palette.size() + 1, 0);
+    for (int i = 0; i < m_palette.size(); ++i) {
+        colors[i + 1] = qPremultiply(m_palette[i].rgba());
+    }
+
+    for (int y = 0; y < CHUNK_TILES; ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(chunk->image.scanLine(y));
+        const TileId *row = chunk->cells.data() + y * CHUNK_TILES;
+        for (int x = 0; x < CHUNK_TILES; ++x) {
+            line[x] = row[x] < colors.size() ? colors[row[x]] : 0;
+        }
+    }
+    chunk->imageStale = false;
+}
+
+void TileLayer::draw(QPainter *painter, const QRect &sceneRect)
+{
+    if (m_chunks.isEmpty()) {
+        return;
+    }
+
+    QRect cells = cellsIn(sceneRect);
+    QPoint firstChunk = chunkOf(cells.topLeft());
+    QPoint lastChunk = chunkOf(cells.bottomRight());
+    int chunkPixels = CHUNK_TILES * m_tileSize;
+
+    // Nearest-neighbour scaling keeps tile edges crisp
+    bool smooth = painter->testRenderHint(QPainter::SmoothPixmapTransform);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+
+    auto drawChunk = [&](const QPoint &chunkPos, Chunk &chunk) {
+        if (chunk.imageStale) {
+            rebuildImage(&chunk);
+        }
+        QRect target(chunkPos.x() * chunkPixels, chunkPos.y() * chunkPixels, chunkPixels, chunkPixels);
+        painter->drawImage(target, chunk.image);
+    };
+
+    // Iterate whichever is smaller: the visible chunk range or the stored chunks
+    qint64 visibleChunks = qint64(lastChunk.x() - firstChunk.x() + 1) * (lastChunk.y() - firstChunk.y() + 1);
+    if (visibleChunks <= m_chunks.size()) {
+        for (int cy = firstChunk.y(); cy <= lastChunk.y(); ++cy) {
+            for (int cx = firstChunk.x(); cx <= lastChunk.x(); ++cx) {
+                auto it = m_chunks.find(QPoint(cx, cy));
+                if (it != m_chunks.end()) {
+                    drawChunk(it.key(), it.value());
+                }
+            }
+        }
+    } else {
+        QRect visibleRange(firstChunk, lastChunk);
+        for (auto it = m_chunks.begin(); it != m_chunks.end(); ++it) {
+            if (visibleRange.contains(it.key())) {
+                drawChunk(it.key(), it.value());
+            }
+        }
+    }
+
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, smooth);
+}
+
+QJsonArray TileLayer::encodeRuns(const Chunk &chunk)
+{
+    QJsonArray runs;
+    int i = 0;
+    int total = static_cast<int>(chunk.cells.size());
+    while (i < total) {
+        TileId id = chunk.cells[i];
+        int start = i;
+        while (i < total && chunk.cells[i] == id) {
+            ++i;
+        }
+        runs.append(i - start);
+        runs.append(id);
+    }
+    return runs;
+}
+
+void TileLayer::decodeRuns(const QPoint &chunk, const QJsonArray &runs, int chunkTiles)
+{
+    QPoint origin(chunk.x() * chunkTiles, chunk.y() * chunkTiles);
+
+    if (chunkTiles == CHUNK_TILES) {
+        // Same chunking as ours: rebuild the chunk's cells directly
+        m_chunks.remove(chunk);
+        Chunk *target = nullptr;
+        int index = 0;
+        int total = CHUNK_TILES * CHUNK_TILES;
+        for (int i = 0; i + 1 < runs.size() && index < total; i += 2) {
+            int count = qMin(runs[i].toInt(), total - index);
+            TileId id = static_cast<TileId>(runs[i + 1].toInt());
+            if (id != 0 && count > 0) {
+                if (!target) {
+                    target = chunkFor(chunk, true);
+                }
+                std::fill(target->cells.begin() + index, target->cells.begin() + index + count, id);
+                target->filled += count;
+            }
+            index += qMax(0, count);
+        }
+        return;
+    }
+
+    // Written with a different chunk size: place cell by cell
+    int index = 0;
+    int total = chunkTiles * chunkTiles;
+    for (int i = 0; i + 1 < runs.size() && index < total; i += 2) {
+        int count = qMin(runs[i].toInt(), total - index);
+        TileId id = static_cast<TileId>(runs[i + 1].toInt());
+        for (int n = 0; n < count; ++n, ++index) {
+            setTile(origin + QPoint(index % chunkTiles, index / chunkTiles), id);
+        }
+    }
+}
+
+QJsonObject TileLayer::toJson() const
+{
+    QJsonArray palette;
+    for (const QColor &color : m_palette) {
+        palette.append(QJsonArray{color.red(), color.green(), color.blue()});
+    }
+
+    QSet<QPoint> all;
+    for (auto it = m_chunks.constBegin(); it != m_chunks.constEnd(); ++it) {
+        all.insert(it.key());
+    }
+
+    QJsonObject json;
+    json["tile_size"] = m_tileSize;
+    json["chunk_tiles"] = CHUNK_TILES;
+    json["palette"] = palette;
+    json["chunks"] = chunksToJson(all);
+    return json;
+}
+
+TileLayer TileLayer::fromJson(const QJsonObject &json)
+{
+    TileLayer layer;
+    layer.setTileSize(json["tile_size"].toInt(DEFAULT_TILE_SIZE));
+
+    if (json.contains("palette")) {
+        QVector<QColor> palette;
+        for (const QJsonValue &value : json["palette"].toArray()) {
+            QJsonArray rgb = value.toArray();
+            palette.append(QColor(rgb[0].toInt(), rgb[1].toInt(), rgb[2].toInt()));
+        }
+        layer.m_palette = palette;
+    }
+
+    int chunkTiles = json["chunk_tiles"].toInt(CHUNK_TILES);
+    if (chunkTiles < 1) {
+        return layer;
+    }
+    for (const QJsonValue &value : json["chunks"].toArray()) {
+        QJsonObject chunk = value.toObject();
+        layer.decodeRuns(QPoint(chunk["x"].toInt(), chunk["y"].toInt()), chunk["runs"].toArray(), chunkTiles);
+    }
+    return layer;
+}
+
+QJsonArray TileLayer::chunksToJson(const QSet<QPoint> &chunks) const
+{
+    // Sorted so identical layers always serialize identically
+    QList<QPoint> ordered = chunks.values();
+    std::sort(ordered.begin(), ordered.end(), [](const QPoint &a, const QPoint &b) {
+        return a.y() != b.y() ? a.y() < b.y() : a.x() < b.x();
+    });
+
+    QJsonArray array;
+    for (const QPoint &chunkPos : ordered) {
+        QJsonObject json;
+        json["x"] = chunkPos.x();
+        json["y"] = chunkPos.y();
+        auto it = m_chunks.constFind(chunkPos);
+        json["runs"] = it != m_chunks.constEnd() ? encodeRuns(it.value()) : QJsonArray();
+        array.append(json);
+    }
+    return array;
+}
+
+void TileLayer::applyChunksJson(const QJsonArray &chunks)
+{
+    for (const QJsonValue &value : chunks) {
+        QJsonObject chunk = value.toObject();
+        QPoint chunkPos(chunk["x"].toInt(), chunk["y"].toInt());
+        m_chunks.remove(chunkPos);
+        decodeRuns(chunkPos, chunk["runs"].toArray(), CHUNK_TILES);
+    }
+}
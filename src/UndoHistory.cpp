@@ -0,0 +1,14 @@
+#include "UndoHistory.h"
+
+UndoHistory::UndoHistory(QObject *parent)
+    : QUndoStack(parent)
+{
+}
+
+UndoHistory::~UndoHistory()
+{
+    // Delete commands now, while the arena they live in still exists. Nothing
+    // may react to the resulting index/clean signals of a stack being destroyed.
+    disconnect();
+    clear();
+}
@@ -0,0 +1,503 @@
+#include "WorldStreamer.h"
+#include "Canvas.h"
+#include "SceneFile.h"
+#include "PrefabLibrary.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSet>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+
+namespace {
+
+int floorDiv(int value, int divisor)
+{
+    int result = value / divisor;
+    if (value < 0 && result * divisor != value) {
+        --result;
+    }
+    return result;
+}
+
+} // namespace
+
+WorldStreamer::WorldStreamer(Canvas *canvas)
+    : QObject(canvas)
+    , m_canvas(canvas)
+    , m_chunkSize(DEFAULT_CHUNK_SIZE)
+    , m_memoryBudget(DEFAULT_MEMORY_BUDGET)
+    , m_tick(0)
+    , m_residentEntities(0)
+{
+}
+
+WorldStreamer::~WorldStreamer()
+{
+    close();
+}
+
+QPoint WorldStreamer::chunkOf(const QPoint &pos) const
+{
+    return QPoint(floorDiv(pos.x(), m_chunkSize), floorDiv(pos.y(), m_chunkSize));
+}
+
+QString WorldStreamer::chunkPath(const QString &manifestPath, const QPoint &chunk)
+{
+    return QString("%1.chunks/c_%2_%3.json").arg(manifestPath).arg(chunk.x()).arg(chunk.y());
+}
+
+QString WorldStreamer::chunkPath(const QPoint &chunk) const
+{
+    return chunkPath(m_manifestPath, chunk);
+}
+
+bool WorldStreamer::writeManifest(const QString &manifestPath, int chunkSize, int nextEntityId,
+                                  const QHash<QPoint, int> &chunkCounts, const PrefabLibrary *prefabs,
+                                  const LayerStack *layers, const GroupTree *groups)
+{
+    QJsonArray chunks;
+    for (auto it = chunkCounts.constBegin(); it != chunkCounts.constEnd(); ++it) {
+        QJsonObject chunk;
+        chunk["x"] = it.key().x();
+        chunk["y"] = it.key().y();
+        chunk["count"] = it.value();
+        chunks.append(chunk);
+    }
+    
+    QJsonObject root;
+    root["version"] = "1.0";
+    root["format"] = "chunked-world";
+    root["chunk_size"] = chunkSize;
+    root["next_entity_id"] = nextEntityId;
+    root["chunks"] = chunks;
+    if (prefabs && !prefabs->isEmpty()) {
+        root["prefabs"] = prefabs->toJson();
+    }
+    if (layers && !layers->isDefault()) {
+        root["layers"] = layers->toJson();
+    }
+    if (groups && !groups->isEmpty()) {
+        root["groups"] = groups->toJson();
+    }
+    
+    QSaveFile file(manifestPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return file.commit();
+}
+
+bool WorldStreamer::exportWorld(const QString &manifestPath, const std::vector<Entity> &entities,
+                                int nextEntityId, int chunkSize, const PrefabLibrary *prefabs,
+                                const LayerStack *layers, const GroupTree *groups)
+{
+    if (chunkSize < 1) {
+        return false;
+    }
+    
+    // Bucket entities by the chunk containing their top-left corner
+    QHash<QPoint, std::vector<Entity>> buckets;
+    for (const Entity &entity : entities) {
+        QPoint chunk(floorDiv(entity.position().x(), chunkSize), floorDiv(entity.position().y(), chunkSize));
+        buckets[chunk].push_back(entity);
+    }
+    
+    if (!QDir().mkpath(manifestPath + ".chunks")) {
+        return false;
+    }
+    
+    QHash<QPoint, int> counts;
+    for (auto it = buckets.constBegin(); it != buckets.constEnd(); ++it) {
+        SceneParts chunk(it.value(), nextEntityId);
+        chunk.prefabs = prefabs;
+        if (!SceneFile::save(chunkPath(manifestPath, it.key()), chunk)) {
+            return false;
+        }
+        counts.insert(it.key(), static_cast<int>(it.value().size()));
+    }
+    
+    return writeManifest(manifestPath, chunkSize, nextEntityId, counts, prefabs, layers, groups);
+}
+
+bool WorldStreamer::open(const QString &manifestPath)
+{
+    QFile file(manifestPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        return false;
+    }
+    QJsonObject root = doc.object();
+    if (root["format"].toString() != "chunked-world" || root["chunk_size"].toInt() < 1) {
+        return false;
+    }
+    
+    close();
+    
+    m_manifestPath = manifestPath;
+    m_chunkSize = root["chunk_size"].toInt();
+    for (const QJsonValue &value : root["chunks"].toArray()) {
+        QJsonObject chunk = value.toObject();
+        ChunkState &state = m_chunks[QPoint(chunk["x"].toInt(), chunk["y"].toInt())];
+        state.diskCount = chunk["count"].toInt();
+        state.onDisk = true;
+    }
+    
+    m_canvas->resetScene(root["next_entity_id"].toInt(1), PrefabLibrary::fromJson(root["prefabs"].toArray()),
+                         LayerStack::fromJson(root["layers"].toArray()),
+                         GroupTree::fromJson(root["groups"].toArray()));
+    updateResidency();
+    return true;
+}
+
+void WorldStreamer::close()
+{
+    // Abandon in-flight loads; their results are never applied
+    for (ChunkState &state : m_chunks) {
+        if (state.loader) {
+            state.loader->disconnect(this);
+            state.loader->waitForFinished();
+            state.loader->deleteLater();
+            state.loader = nullptr;
+        }
+    }
+    m_chunks.clear();
+    m_entityChunk.clear();
+    m_residentEntities = 0;
+    m_manifestPath.clear();
+}
+
+void WorldStreamer::setMemoryBudget(int maxResidentEntities)
+{
+    m_memoryBudget = qMax(1, maxResidentEntities);
+    evictIfOverBudget();
+}
+
+int WorldStreamer::residentChunkCount() const
+{
+    int count = 0;
+    for (const ChunkState &state : m_chunks) {
+        if (state.resident) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+QRect WorldStreamer::wantedChunks() const
+{
+    // The view plus one chunk of prefetch margin on every side
+    QRect view = m_canvas->visibleSceneRect();
+    QPoint topLeft = chunkOf(view.topLeft()) - QPoint(1, 1);
+    QPoint bottomRight = chunkOf(view.bottomRight()) + QPoint(1, 1);
+    return QRect(topLeft, bottomRight);
+}
+
+void WorldStreamer::updateResidency()
+{
+    if (!isOpen()) {
+        return;
+    }
+    
+    ++m_tick;
+    QRect wanted = wantedChunks();
+    for (int cy = wanted.top(); cy <= wanted.bottom(); ++cy) {
+        for (int cx = wanted.left(); cx <= wanted.right(); ++cx) {
+            auto it = m_chunks.find(QPoint(cx, cy));
+            if (it == m_chunks.end()) {
+                continue;  // Empty region
+            }
+            it->lastUsed = m_tick;
+            if (!it->resident && !it->loader && it->onDisk) {
+                startLoad(it.key());
+            }
+        }
+    }
+    
+    evictIfOverBudget();
+}
+
+void WorldStreamer::startLoad(const QPoint &chunk)
+{
+    ChunkState &state = m_chunks[chunk];
+    LoadWatcher *watcher = new LoadWatcher(this);
+    state.loader = watcher;
+    connect(watcher, &LoadWatcher::finished, this, [this, chunk, watcher]() {
+        finishLoad(chunk, watcher);
+    });
+    
+    QString path = chunkPath(chunk);
+    watcher->setFuture(QtConcurrent::run([path]() {
+        auto scene = std::make_shared<SceneData>();
+        if (!SceneFile::load(path, scene.get())) {
+            return std::shared_ptr<SceneData>();
+        }
+        return scene;
+    }));
+}
+
+void WorldStreamer::finishLoad(const QPoint &chunk, LoadWatcher *watcher)
+{
+    auto it = m_chunks.find(chunk);
+    if (it == m_chunks.end() || it->loader != watcher) {
+        return;  // Already handled (see waitForLoads) or world closed
+    }
+    it->loader = nullptr;
+    watcher->deleteLater();
+    
+    std::shared_ptr<SceneData> scene = watcher->result();
+    if (!scene) {
+        it->onDisk = false;  // Unreadable chunk: don't retry on every pan
+        return;
+    }
+    
+    // Skip anything already in memory (e.g. moved here before the load finished)
+    std::vector<Entity> fresh;
+    fresh.reserve(scene->entities.size());
+    // Chunks written by an older session may know prefabs the manifest lost;
+    // the canvas library wins for ids both define
+    m_canvas->mergePrefabs(scene->prefabs);
+    
+    for (const Entity &entity : scene->entities) {
+        if (!m_entityChunk.contains(entity.id())) {
+            m_entityChunk.insert(entity.id(), chunk);
+            fresh.push_back(entity);
+        }
+    }
+    
+    it->resident = true;
+    it->residentCount += static_cast<int>(fresh.size());
+    m_residentEntities += static_cast<int>(fresh.size());
+    m_canvas->prefabs().resolve(&fresh);
+    m_canvas->appendEntities(fresh);
+    
+    emit chunkLoaded(chunk);
+    evictIfOverBudget();
+}
+
+bool WorldStreamer::ensureResident(const QPoint &scenePos)
+{
+    if (!isOpen()) {
+        return false;
+    }
+    QPoint chunk = chunkOf(scenePos);
+    ChunkState &state = m_chunks[chunk];
+    state.lastUsed = m_tick;  // Keeps it out of the eviction that follows the load
+    if (state.resident) {
+        return true;
+    }
+    if (!state.onDisk) {
+        return false;
+    }
+    if (!state.loader) {
+        startLoad(chunk);
+    }
+    LoadWatcher *watcher = m_chunks[chunk].loader;
+    watcher->waitForFinished();
+    finishLoad(chunk, watcher);
+    return m_chunks.value(chunk).resident;
+}
+
+void WorldStreamer::waitForLoads()
+{
+    QList<QPoint> loading;
+    for (auto it = m_chunks.constBegin(); it != m_chunks.constEnd(); ++it) {
+        if (it->loader) {
+            loading.append(it.key());
+        }
+    }
+    for (const QPoint &chunk : loading) {
+        LoadWatcher *watcher = m_chunks[chunk].loader;
+        watcher->waitForFinished();
+        finishLoad(chunk, watcher);
+    }
+}
+
+void WorldStreamer::evictIfOverBudget()
+{
+    if (m_residentEntities <= m_memoryBudget) {
+        return;
+    }
+    
+    // Candidates: clean, resident chunks the view doesn't currently need,
+    // least recently needed first
+    QList<QPoint> candidates;
+    for (auto it = m_chunks.constBegin(); it != m_chunks.constEnd(); ++it) {
+        if (it->resident && !it->dirty && !it->loader && it->lastUsed != m_tick) {
+            candidates.append(it.key());
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](const QPoint &a, const QPoint &b) {
+        return m_chunks[a].lastUsed < m_chunks[b].lastUsed;
+    });
+    
+    QSet<QPoint> evicted;
+    int remaining = m_residentEntities;
+    for (const QPoint &chunk : candidates) {
+        if (remaining <= m_memoryBudget) {
+            break;
+        }
+        remaining -= m_chunks[chunk].residentCount;
+        evicted.insert(chunk);
+    }
+    if (evicted.isEmpty()) {
+        return;
+    }
+    
+    // One pass over the resident entities and one removal from the canvas
+    QSet<int> ids;
+    for (auto it = m_entityChunk.begin(); it != m_entityChunk.end();) {
+        if (evicted.contains(it.value())) {
+            ids.insert(it.key());
+            it = m_entityChunk.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_canvas->unloadEntities(ids);
+    
+    for (const QPoint &chunk : evicted) {
+        ChunkState &state = m_chunks[chunk];
+        state.resident = false;
+        state.residentCount = 0;
+        emit chunkEvicted(chunk);
+    }
+    m_residentEntities = remaining;
+}
+
+void WorldStreamer::markDirty(const QPoint &chunk)
+{
+    ChunkState &state = m_chunks[chunk];
+    state.dirty = true;
+    state.lastUsed = m_tick;
+    if (!state.resident && !state.loader) {
+        if (state.onDisk) {
+            // Edits landed in a chunk whose file isn't loaded yet: bring it in
+            // so saving merges with what's on disk instead of replacing it
+            startLoad(chunk);
+        } else {
+            state.resident = true;  // Brand new chunk
+        }
+    }
+}
+
+void WorldStreamer::entityChanged(const Entity &entity)
+{
+    if (!isOpen()) {
+        return;
+    }
+    
+    QPoint chunk = chunkOf(entity.position());
+    auto it = m_entityChunk.find(entity.id());
+    if (it == m_entityChunk.end()) {
+        // New entity
+        m_entityChunk.insert(entity.id(), chunk);
+        markDirty(chunk);
+        m_chunks[chunk].residentCount++;
+        m_residentEntities++;
+    } else if (it.value() != chunk) {
+        // Moved across a chunk border: both chunk files change
+        QPoint oldChunk = it.value();
+        it.value() = chunk;
+        markDirty(oldChunk);
+        markDirty(chunk);
+        m_chunks[oldChunk].residentCount--;
+        m_chunks[chunk].residentCount++;
+    } else {
+        markDirty(chunk);
+    }
+}
+
+void WorldStreamer::entityRemoved(const Entity &entity)
+{
+    if (!isOpen()) {
+        return;
+    }
+    
+    auto it = m_entityChunk.find(entity.id());
+    if (it != m_entityChunk.end()) {
+        QPoint chunk = it.value();
+        m_entityChunk.erase(it);
+        markDirty(chunk);
+        m_chunks[chunk].residentCount--;
+        m_residentEntities--;
+    }
+}
+
+bool WorldStreamer::save()
+{
+    if (!isOpen()) {
+        return false;
+    }
+    
+    // Dirty chunks must be merged with their file contents first
+    waitForLoads();
+    
+    QHash<QPoint, std::vector<Entity>> dirtyContents;
+    for (auto it = m_chunks.constBegin(); it != m_chunks.constEnd(); ++it) {
+        if (it->dirty) {
+            dirtyContents.insert(it.key(), std::vector<Entity>());
+        }
+    }
+    
+    // Gather each dirty chunk's entities in canvas (draw) order
+    for (int i = 0; i < m_canvas->entityCount(); ++i) {
+        const Entity *entity = m_canvas->getEntity(i);
+        auto chunk = m_entityChunk.constFind(entity->id());
+        if (chunk != m_entityChunk.constEnd()) {
+            auto contents = dirtyContents.find(chunk.value());
+            if (contents != dirtyContents.end()) {
+                contents->push_back(*entity);
+            }
+        }
+    }
+    
+    if (!QDir().mkpath(m_manifestPath + ".chunks")) {
+        return false;
+    }
+    
+    int nextEntityId = m_canvas->nextEntityId();
+    const PrefabLibrary *prefabs = &m_canvas->prefabs();
+    for (auto it = dirtyContents.constBegin(); it != dirtyContents.constEnd(); ++it) {
+        ChunkState &state = m_chunks[it.key()];
+        if (it.value().empty()) {
+            // Chunk emptied by edits: drop its file
+            QFile::remove(chunkPath(it.key()));
+            state.onDisk = false;
+            state.diskCount = 0;
+        } else {
+            SceneParts chunk(it.value(), nextEntityId);
+            chunk.prefabs = prefabs;
+            if (!SceneFile::save(chunkPath(it.key()), chunk)) {
+                return false;
+            }
+            state.onDisk = true;
+            state.diskCount = static_cast<int>(it.value().size());
+        }
+        state.dirty = false;
+    }
+    
+    QHash<QPoint, int> counts;
+    for (auto it = m_chunks.constBegin(); it != m_chunks.constEnd(); ++it) {
+        if (it->onDisk) {
+            counts.insert(it.key(), it->diskCount);
+        }
+    }
+    if (!writeManifest(m_manifestPath, m_chunkSize, nextEntityId, counts, prefabs, &m_canvas->layers(),
+                       &m_canvas->groups())) {
+        return false;
+    }
+    
+    // Saved chunks are clean and may now be evicted
+    evictIfOverBudget();
+    return true;
+}
@@ -1,12 +1,29 @@
 #include <QApplication>
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <cstring>
 #include "MainWindow.h"
+#include "BatchProcessor.h"
 
 int main(int argc, char *argv[])
 {
+    // Command-line mode (no widgets): see BatchProcessor for commands.
+    // "--validate <paths>" is shorthand for "--batch validate <paths>".
+    if (argc > 1 && (std::strcmp(argv[1], "--batch") == 0 || std::strcmp(argv[1], "--validate") == 0)) {
+        QCoreApplication app(argc, argv);
+        QStringList arguments = app.arguments().mid(2);
+        if (std::strcmp(argv[1], "--validate") == 0) {
+            arguments.prepend("validate");
+        }
+        QTextStream out(stdout);
+        return BatchProcessor::run(arguments, out);
+    }
+    
     QApplication app(argc, argv);
     
     MainWindow window;
     window.show();
     
     return app.exec();
-}
\ No newline at end of file
+}
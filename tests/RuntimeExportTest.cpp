@@ -0,0 +1,139 @@
+// Runtime export round trip: builds blobs with RuntimeExport and reads every
+// entity field back through RuntimeScene, the reader the game ships with.
+// Also checks that names are stored once and that damaged blobs are refused.
+//
+// Usage: RuntimeExportTest (exit code 1 on failure)
+
+#include <QColor>
+#include <QPoint>
+#include <QString>
+#include <QTextStream>
+#include <QtEndian>
+#include <string_view>
+#include <vector>
+#include "Entity.h"
+#include "NamePool.h"
+#include "RuntimeExport.h"
+#include "RuntimeScene.h"
+
+static int failures = 0;
+
+static void check(bool condition, const QString &what)
+{
+    if (!condition) {
+        QTextStream(stderr) << "FAIL  " << what << "\n";
+        ++failures;
+    }
+}
+
+static QString nameOf(const RuntimeScene::EntityView &view)
+{
+    std::string_view name = view.name();
+    return QString::fromUtf8(name.data(), static_cast<qsizetype>(name.size()));
+}
+
+// One entity per kind of value each field can hold
+static std::vector<Entity> sampleEntities()
+{
+    std::vector<Entity> entities;
+
+    Entity instance(1, QString("Tree"), QPoint(-40, 25));
+    instance.setSize(33, 17);
+    instance.setColor(QColor(10, 20, 30, 128));
+    instance.setLayerId(2);
+    instance.setGroupId(5);
+    instance.setPrefab(3, Entity::OverrideName | Entity::OverrideColor);
+    entities.push_back(instance);
+
+    Entity unnamed(2, QString(), QPoint(0, 0));
+    entities.push_back(unnamed);
+
+    Entity generated(7, NamePool::instance().defaultPattern(), QPoint(1000000, -1000000));
+    generated.setSize(1, 1);
+    generated.setColor(QColor(255, 255, 255));
+    entities.push_back(generated);
+
+    Entity shared(8, QString("Tree"), QPoint(20, 20));
+    shared.setPrefab(3, Entity::OverrideSize);
+    entities.push_back(shared);
+
+    Entity unicode(9, QString::fromUtf8("Br\xc3\xbc" "cke \xe2\x98\x83"), QPoint(-7, 3));
+    unicode.setColor(QColor(0, 0, 0, 0));
+    unicode.setLayerId(-1);
+    entities.push_back(unicode);
+
+    return entities;
+}
+
+static void testRoundTrip()
+{
+    std::vector<Entity> entities = sampleEntities();
+    QByteArray blob = RuntimeExport::build(entities);
+    check(blob.size() % RuntimeExport::ALIGNMENT == 0, "blob size is aligned");
+
+    RuntimeScene scene;
+    check(scene.open(blob.constData(), static_cast<size_t>(blob.size())), "blob opens");
+    check(scene.entityCount() == entities.size(), "entity count");
+    check(scene.nameCount() == 3, "each distinct name is stored once");
+    if (scene.entityCount() != entities.size()) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < scene.entityCount(); ++i) {
+        const Entity &entity = entities[i];
+        RuntimeScene::EntityView view = scene.entity(i);
+        QString at = QString("entity %1: ").arg(entity.id());
+        check(view.id() == entity.id(), at + "id");
+        check(view.x() == entity.position().x() && view.y() == entity.position().y(), at + "position");
+        check(view.width() == entity.rect().width() && view.height() == entity.rect().height(), at + "size");
+        check(view.color() == entity.color().rgba(), at + "color");
+        check(nameOf(view) == entity.name(), at + "name");
+        check((view.nameIndex() == RuntimeScene::NO_NAME) == entity.name().isEmpty(), at + "unnamed");
+        check(view.prefabId() == entity.prefabId(), at + "prefab");
+        check(view.overrides() == entity.overrides(), at + "overrides");
+        check(view.layerId() == entity.layerId(), at + "layer");
+        check(view.groupId() == entity.groupId(), at + "group");
+    }
+    check(scene.entity(0).nameIndex() == scene.entity(3).nameIndex(), "shared name has one index");
+
+    QString error;
+    check(RuntimeExport::verify(blob, entities, &error), "verify accepts the blob: " + error);
+}
+
+static void testEmpty()
+{
+    QByteArray blob = RuntimeExport::build({});
+    RuntimeScene scene;
+    check(scene.open(blob.constData(), static_cast<size_t>(blob.size())), "empty blob opens");
+    check(scene.entityCount() == 0 && scene.nameCount() == 0, "empty blob is empty");
+}
+
+static void testDamaged()
+{
+    std::vector<Entity> entities = sampleEntities();
+    QByteArray blob = RuntimeExport::build(entities);
+    RuntimeScene scene;
+
+    QByteArray truncated = blob.left(blob.size() - 1);
+    check(!scene.open(truncated.constData(), static_cast<size_t>(truncated.size())), "truncated blob is refused");
+
+    QByteArray badMagic = blob;
+    badMagic[0] = 'X';
+    check(!scene.open(badMagic.constData(), static_cast<size_t>(badMagic.size())), "bad magic is refused");
+
+    QByteArray changed = blob;
+    quint32 entitiesAt = qFromLittleEndian<quint32>(blob.constData() + RuntimeScene::H_ENTITIES);
+    changed[entitiesAt + RuntimeScene::E_LAYER] = 42;
+    check(!RuntimeExport::verify(changed, entities), "verify reports a changed field");
+}
+
+int main()
+{
+    testRoundTrip();
+    testEmpty();
+    testDamaged();
+
+    QTextStream out(stdout);
+    out << (failures == 0 ? "RuntimeExportTest passed\n" : "RuntimeExportTest failed\n");
+    return failures == 0 ? 0 : 1;
+}